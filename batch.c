@@ -0,0 +1,371 @@
+/**
+ * Filename: batch.c
+ * 
+ * Description: Size aware scheduler solving the maps of a batch on a pool of workers
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "batch.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "checkpoint.h"
+#include "io.h"
+#include "map.h"
+#include "pool.h"
+#include "solver.h"
+
+/** maps read but not written yet, reading waits once this many are in flight */
+#define BATCH_WINDOW 4096
+/** maps read are handed to workers in groups of this many, so that they pick among many */
+#define BATCH_LOOKAHEAD 256
+/** a candidate cell weighs as much as this many cells read and preprocessed */
+#define BATCH_CANDIDATE_WEIGHT 16
+
+typedef struct {
+    int index;
+    long long offset;
+    map *mptr;
+    int lines;
+    int columns;
+    int result;
+    double cost;
+    int done;
+    double arrival;
+    double latency;
+} job;
+
+/**
+ * Jobs of the window are kept in a ring by input index, the ones waiting for a worker in a
+ * binary heap by cost. Every pool task solves the cheapest waiting job, not a given one.
+ */
+typedef struct {
+    pool *pptr;
+    workspace **workspaces;
+    solverOptions options;
+    job jobs[BATCH_WINDOW];
+    job *heap[BATCH_WINDOW];
+    int heapSize;
+    int readCount;
+    int writeCount;
+    FILE *fpOut;
+    FILE *log;
+    checkpoint *cptr;
+    double *latencies;
+    struct timespec start;
+    double finish;
+    pthread_mutex_t lock;
+    pthread_cond_t room;
+} scheduler;
+
+void runCheapestJob(void *arg, int worker);
+void writeReadyJobs(scheduler *sptr);
+double estimateCost(map *mptr, int lines, int columns, mapCounts *counts);
+void pushJob(scheduler *sptr, job *jptr);
+job *popJob(scheduler *sptr);
+int cheaper(job *a, job *b);
+double elapsedSeconds(struct timespec *start);
+int compareLatencies(const void *a, const void *b);
+
+/**
+ * Function: runBatch
+ * 
+ * Description: solves every map of a file on a pool of workers, each keeping its own warm
+ *              workspace. Maps are read ahead (up to a window of maps not yet written) and
+ *              the cheapest one by estimated cost is solved first, so that a few huge maps do
+ *              not hold back the small ones behind them. Solutions are still written in input
+ *              order as soon as every map before them is written
+ * 
+ * Arguments:
+ *     FILE *fpIn - file with the maps
+ *     FILE *fpOut - file where solutions are written
+ *     FILE *log - file where a line "lines columns result cost seconds" is written per map, in
+ *                 input order, with the median latency and the makespan at the end (or NULL)
+ *     int workers - number of worker threads
+ *     solverOptions *optr - solver options
+ *     checkpoint *cptr - checkpoint told about every map written (or NULL)
+ *     long long maps - number of maps to be read (-1 for every map of file)
+ * 
+ * Return value:
+ *     1 - if every map was read
+ *     READ_ERROR - if input is malformed (maps before it are written)
+ */
+int runBatch(FILE *fpIn, FILE *fpOut, FILE *log, int workers, solverOptions *optr, checkpoint *cptr, long long maps) {
+    scheduler *sptr;
+    mapCounts counts;
+    job *jptr;
+    int ret, poolWorkers, full, pending = 0, latencyCapacity = BATCH_WINDOW;
+
+    sptr = (scheduler *) malloc(sizeof(scheduler));
+    if (sptr == NULL) exit(EXIT_FAILURE);
+
+    sptr->pptr = newPool(workers);
+    if (sptr->pptr == NULL) exit(EXIT_FAILURE);
+
+    poolWorkers = getPoolWorkers(sptr->pptr);
+    sptr->workspaces = (workspace **) malloc(poolWorkers * sizeof(workspace *));
+    if (sptr->workspaces == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < poolWorkers; i++) {
+        sptr->workspaces[i] = newWorkspace();
+        if (sptr->workspaces[i] == NULL) exit(EXIT_FAILURE);
+        /** workers already solve maps side by side, a huge map is preprocessed by its own worker */
+        setWorkspaceThreads(sptr->workspaces[i], 1);
+    }
+
+    sptr->latencies = (double *) malloc(latencyCapacity * sizeof(double));
+    if (sptr->latencies == NULL) exit(EXIT_FAILURE);
+
+    sptr->options = *optr;
+    sptr->heapSize = 0;
+    sptr->readCount = 0;
+    sptr->writeCount = 0;
+    sptr->fpOut = fpOut;
+    sptr->log = log;
+    sptr->cptr = cptr;
+    sptr->finish = 0;
+    pthread_mutex_init(&sptr->lock, NULL);
+    pthread_cond_init(&sptr->room, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &sptr->start);
+
+    while (1) {
+        pthread_mutex_lock(&sptr->lock);
+        full = sptr->readCount - sptr->writeCount >= BATCH_WINDOW;
+        pthread_mutex_unlock(&sptr->lock);
+
+        /** every job is handed out before waiting, the one holding back the window may be among them */
+        if (full || pending == BATCH_LOOKAHEAD) {
+            for (; pending > 0; pending--) submitTask(sptr->pptr, runCheapestJob, sptr);
+        }
+        pthread_mutex_lock(&sptr->lock);
+        while (sptr->readCount - sptr->writeCount >= BATCH_WINDOW) {
+            pthread_cond_wait(&sptr->room, &sptr->lock);
+        }
+        pthread_mutex_unlock(&sptr->lock);
+
+        /** the slot is free, the job it held was written */
+        jptr = &sptr->jobs[sptr->readCount % BATCH_WINDOW];
+        ret = sptr->readCount == maps ? 0 : readMapCounts(fpIn, &jptr->mptr, &jptr->lines, &jptr->columns, &jptr->result, &counts);
+        if (ret != 1) break;
+
+        jptr->index = sptr->readCount;
+        jptr->offset = ftell(fpIn);
+        jptr->cost = estimateCost(jptr->mptr, jptr->lines, jptr->columns, &counts);
+        jptr->done = 0;
+        jptr->arrival = elapsedSeconds(&sptr->start);
+
+        pthread_mutex_lock(&sptr->lock);
+        if (sptr->readCount == latencyCapacity) {
+            latencyCapacity *= 2;
+            sptr->latencies = (double *) realloc(sptr->latencies, latencyCapacity * sizeof(double));
+            if (sptr->latencies == NULL) exit(EXIT_FAILURE);
+        }
+        pushJob(sptr, jptr);
+        sptr->readCount++;
+        pthread_mutex_unlock(&sptr->lock);
+        pending++;
+    }
+    for (; pending > 0; pending--) submitTask(sptr->pptr, runCheapestJob, sptr);
+    waitPool(sptr->pptr);
+
+    if (log != NULL && sptr->readCount > 0) {
+        qsort(sptr->latencies, sptr->readCount, sizeof(double), compareLatencies);
+        fprintf(log, "# maps %d workers %d median latency %.6f makespan %.6f\n", sptr->readCount, poolWorkers, sptr->latencies[sptr->readCount / 2], sptr->finish);
+    }
+
+    deletePool(sptr->pptr);
+    for (int i = 0; i < poolWorkers; i++) {
+        deleteWorkspace(sptr->workspaces[i]);
+    }
+    free(sptr->workspaces);
+    free(sptr->latencies);
+    pthread_mutex_destroy(&sptr->lock);
+    pthread_cond_destroy(&sptr->room);
+    free(sptr);
+
+    return ret == READ_ERROR ? READ_ERROR : 1;
+}
+
+/**
+ * Function: runCheapestJob
+ * 
+ * Description: pool task solving the cheapest job waiting, then writing every job that is
+ *              ready in input order
+ * 
+ * Arguments:
+ *     void *arg - pointer to scheduler
+ *     int worker - index of worker running the task
+ * 
+ * Return value: none
+ */
+void runCheapestJob(void *arg, int worker) {
+    scheduler *sptr = (scheduler *) arg;
+    job *jptr;
+
+    pthread_mutex_lock(&sptr->lock);
+    jptr = popJob(sptr);
+    pthread_mutex_unlock(&sptr->lock);
+
+    if (jptr->mptr != NULL) jptr->result = solveMapWithOptions(jptr->mptr, sptr->workspaces[worker], &sptr->options);
+
+    pthread_mutex_lock(&sptr->lock);
+    jptr->done = 1;
+    jptr->latency = elapsedSeconds(&sptr->start) - jptr->arrival;
+    sptr->latencies[jptr->index] = jptr->latency;
+    writeReadyJobs(sptr);
+    pthread_mutex_unlock(&sptr->lock);
+}
+
+/**
+ * Function: writeReadyJobs
+ * 
+ * Description: writes solutions of the jobs done next in input order, freeing their slots
+ *              (called with the lock held)
+ * 
+ * Arguments:
+ *     scheduler *sptr - scheduler pointer
+ * 
+ * Return value: none
+ */
+void writeReadyJobs(scheduler *sptr) {
+    job *jptr;
+
+    while (sptr->writeCount < sptr->readCount) {
+        jptr = &sptr->jobs[sptr->writeCount % BATCH_WINDOW];
+        if (!jptr->done) break;
+
+        if (sptr->log != NULL) fprintf(sptr->log, "%d %d %d %.0f %.6f\n", jptr->lines, jptr->columns, jptr->result, jptr->cost, jptr->latency);
+        writeSolution(sptr->fpOut, jptr->mptr, jptr->lines, jptr->columns, jptr->result);
+        markWritten(sptr->cptr, jptr->offset);
+        sptr->writeCount++;
+        sptr->finish = elapsedSeconds(&sptr->start);
+        pthread_cond_signal(&sptr->room);
+    }
+}
+
+/**
+ * Function: estimateCost
+ * 
+ * Description: estimates cost of solving a map, cells read and preprocessed (trees of sparse
+ *              maps, which are only preprocessed around them) plus weighted candidate cells,
+ *              where search happens
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (NULL if already known to be impossible)
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     mapCounts *counts - trees and candidate cells of map
+ * 
+ * Return value:
+ *     estimated cost
+ */
+double estimateCost(map *mptr, int lines, int columns, mapCounts *counts) {
+    double cells = (double) lines * columns;
+
+    if (mptr == NULL) return 0;
+    if (isSparseMap(mptr)) cells = (double) counts->trees;
+
+    return cells + BATCH_CANDIDATE_WEIGHT * (double) counts->candidates;
+}
+
+/**
+ * Function: pushJob
+ * 
+ * Description: adds a job to the heap of waiting jobs (called with the lock held)
+ * 
+ * Arguments:
+ *     scheduler *sptr - scheduler pointer
+ *     job *jptr - job pointer
+ * 
+ * Return value: none
+ */
+void pushJob(scheduler *sptr, job *jptr) {
+    int i = sptr->heapSize++;
+
+    while (i > 0 && cheaper(jptr, sptr->heap[(i - 1) / 2])) {
+        sptr->heap[i] = sptr->heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    sptr->heap[i] = jptr;
+}
+
+/**
+ * Function: popJob
+ * 
+ * Description: removes the cheapest job from the heap of waiting jobs (called with the lock
+ *              held, heap is never empty as there is a task per job)
+ * 
+ * Arguments:
+ *     scheduler *sptr - scheduler pointer
+ * 
+ * Return value:
+ *     cheapest job
+ */
+job *popJob(scheduler *sptr) {
+    job *top = sptr->heap[0], *last = sptr->heap[--sptr->heapSize];
+    int i = 0, child;
+
+    while ((child = 2 * i + 1) < sptr->heapSize) {
+        if (child + 1 < sptr->heapSize && cheaper(sptr->heap[child + 1], sptr->heap[child])) child++;
+        if (!cheaper(sptr->heap[child], last)) break;
+        sptr->heap[i] = sptr->heap[child];
+        i = child;
+    }
+    sptr->heap[i] = last;
+
+    return top;
+}
+
+/**
+ * Function: cheaper
+ * 
+ * Description: orders jobs by estimated cost, then by input order
+ * 
+ * Arguments:
+ *     job *a - first job
+ *     job *b - second job
+ * 
+ * Return value:
+ *     1 - if a goes before b
+ *     0 - otherwise
+ */
+int cheaper(job *a, job *b) {
+    if (a->cost != b->cost) return a->cost < b->cost;
+    return a->index < b->index;
+}
+
+/**
+ * Function: elapsedSeconds
+ * 
+ * Description: gets seconds elapsed since start
+ * 
+ * Arguments:
+ *     struct timespec *start - start time
+ * 
+ * Return value:
+ *     elapsed seconds
+ */
+double elapsedSeconds(struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/**
+ * Function: compareLatencies
+ * 
+ * Description: qsort comparison of latencies
+ * 
+ * Arguments:
+ *     const void *a - first latency
+ *     const void *b - second latency
+ * 
+ * Return value:
+ *     negative, zero or positive as a is smaller, equal or greater than b
+ */
+int compareLatencies(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
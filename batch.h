@@ -0,0 +1,39 @@
+/**
+ * Filename: batch.h
+ * 
+ * Description: Size aware scheduler solving the maps of a batch on a pool of workers
+ */
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdio.h>
+#include "checkpoint.h"
+#include "solver.h"
+
+/**
+ * Function: runBatch
+ * 
+ * Description: solves every map of a file on a pool of workers, each keeping its own warm
+ *              workspace. Maps are read ahead (up to a window of maps not yet written) and
+ *              the cheapest one by estimated cost is solved first, so that a few huge maps do
+ *              not hold back the small ones behind them. Solutions are still written in input
+ *              order as soon as every map before them is written
+ * 
+ * Arguments:
+ *     FILE *fpIn - file with the maps
+ *     FILE *fpOut - file where solutions are written
+ *     FILE *log - file where a line "lines columns result cost seconds" is written per map, in
+ *                 input order, with the median latency and the makespan at the end (or NULL)
+ *     int workers - number of worker threads
+ *     solverOptions *optr - solver options
+ *     checkpoint *cptr - checkpoint told about every map written (or NULL)
+ *     long long maps - number of maps to be read (-1 for every map of file)
+ * 
+ * Return value:
+ *     1 - if every map was read
+ *     READ_ERROR - if input is malformed (maps before it are written)
+ */
+int runBatch(FILE *fpIn, FILE *fpOut, FILE *log, int workers, solverOptions *optr, checkpoint *cptr, long long maps);
+
+#endif
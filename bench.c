@@ -0,0 +1,164 @@
+/**
+ * Filename: bench.c
+ * 
+ * Synopsis: Load generator for the tents and trees solver daemon, a number of concurrent
+ *           clients repeatedly send the same .camp file and the latency of every request
+ *           is reported as percentiles
+ * 
+ * Usage: tentsbench socket file.camp [clients] [requests]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "net.h"
+
+#define DEFAULT_CLIENTS 8
+#define DEFAULT_REQUESTS 1000
+
+typedef struct {
+    char *socketPath;
+    char *request;
+    size_t length;
+    int requests;
+    double *latencies;
+    int failures;
+} client;
+
+void *clientLoop(void *arg);
+double elapsedSeconds(struct timespec *start);
+int compareLatencies(const void *a, const void *b);
+
+int main(int argc, char *argv[]) {
+    struct timespec start;
+    pthread_t *threads;
+    client *clients;
+    double *latencies, total;
+    char *request;
+    size_t length;
+    int clientCount, requests, done = 0, failures = 0;
+    FILE *fp;
+
+    if (argc < 3 || argc > 5) {
+        fprintf(stderr, "usage: %s socket file.camp [clients] [requests]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    clientCount = argc > 3 ? atoi(argv[3]) : DEFAULT_CLIENTS;
+    requests = argc > 4 ? atoi(argv[4]) : DEFAULT_REQUESTS;
+    if (clientCount < 1 || requests < 1) return EXIT_FAILURE;
+
+    fp = fopen(argv[2], "rb");
+    if (fp == NULL) {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+    fseek(fp, 0, SEEK_END);
+    length = ftell(fp);
+    rewind(fp);
+    request = (char *) malloc(length + 1);
+    if (request == NULL || fread(request, 1, length, fp) != length) return EXIT_FAILURE;
+    fclose(fp);
+
+    signal(SIGPIPE, SIG_IGN);
+
+    threads = (pthread_t *) malloc(clientCount * sizeof(pthread_t));
+    clients = (client *) malloc(clientCount * sizeof(client));
+    latencies = (double *) malloc(requests * sizeof(double));
+    if (threads == NULL || clients == NULL || latencies == NULL) return EXIT_FAILURE;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (int i = 0; i < clientCount; i++) {
+        clients[i].socketPath = argv[1];
+        clients[i].request = request;
+        clients[i].length = length;
+        clients[i].requests = requests / clientCount + (i < requests % clientCount);
+        clients[i].latencies = latencies + done;
+        clients[i].failures = 0;
+        done += clients[i].requests;
+        if (pthread_create(&threads[i], NULL, clientLoop, &clients[i])) return EXIT_FAILURE;
+    }
+    for (int i = 0; i < clientCount; i++) {
+        pthread_join(threads[i], NULL);
+        failures += clients[i].failures;
+    }
+    total = elapsedSeconds(&start);
+
+    qsort(latencies, requests, sizeof(double), compareLatencies);
+    printf("requests: %d (%d failed) clients: %d\n", requests, failures, clientCount);
+    printf("throughput: %.1f requests/s\n", requests / total);
+    printf("latency p50: %.3f ms p99: %.3f ms max: %.3f ms\n",
+           latencies[requests / 2] * 1e3, latencies[(int) (requests * 0.99)] * 1e3, latencies[requests - 1] * 1e3);
+
+    free(threads);
+    free(clients);
+    free(latencies);
+    free(request);
+
+    return failures ? EXIT_FAILURE : 0;
+}
+
+/**
+ * Function: clientLoop
+ * 
+ * Description: body of every client thread, sends its requests one after the other
+ * 
+ * Arguments:
+ *     void *arg - pointer to client
+ * 
+ * Return value: NULL
+ */
+void *clientLoop(void *arg) {
+    client *cptr = (client *) arg;
+    struct timespec start;
+    int fd;
+
+    for (int i = 0; i < cptr->requests; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        fd = connectSocket(cptr->socketPath);
+        if (fd < 0 || exchangeRequest(fd, cptr->request, cptr->length, NULL) <= 0) cptr->failures++;
+        if (fd >= 0) close(fd);
+        cptr->latencies[i] = elapsedSeconds(&start);
+    }
+
+    return NULL;
+}
+
+/**
+ * Function: elapsedSeconds
+ * 
+ * Description: gets seconds elapsed since start
+ * 
+ * Arguments:
+ *     struct timespec *start - start time
+ * 
+ * Return value:
+ *     elapsed seconds
+ */
+double elapsedSeconds(struct timespec *start) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/**
+ * Function: compareLatencies
+ * 
+ * Description: qsort comparison of latencies
+ * 
+ * Arguments:
+ *     const void *a - first latency
+ *     const void *b - second latency
+ * 
+ * Return value:
+ *     negative, zero or positive as a is smaller, equal or greater than b
+ */
+int compareLatencies(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
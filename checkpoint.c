@@ -0,0 +1,179 @@
+/**
+ * Filename: checkpoint.c
+ * 
+ * Description: Checkpoints of the progress of a run, so that it can be resumed
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "checkpoint.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * A checkpoint is written to a temporary file, synced and renamed over the last one, so that
+ * the file always holds a whole checkpoint. Output is synced first, a checkpoint never counts
+ * a map that is not on disk.
+ */
+struct checkpointStruct {
+    char *filename;
+    char *temporary;
+    FILE *fpOut;
+    long long maps;
+    long long inputOffset;
+    double seconds;
+    struct timespec last;
+};
+
+void saveCheckpoint(checkpoint *cptr);
+
+/**
+ * Function: readCheckpoint
+ * 
+ * Description: reads the last checkpoint saved in a file, a line "maps input output" with the
+ *              number of maps fully written and the byte offsets in input and output after them
+ * 
+ * Arguments:
+ *     char *filename - name of checkpoint file
+ *     long long *maps - returns number of maps written
+ *     long long *inputOffset - returns input offset after the last map written
+ *     long long *outputOffset - returns output offset after the last map written
+ * 
+ * Return value:
+ *     1 - if a checkpoint was read
+ *     0 - if there is no checkpoint
+ */
+int readCheckpoint(char *filename, long long *maps, long long *inputOffset, long long *outputOffset) {
+    FILE *fp;
+    int ret;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL) return 0;
+
+    ret = fscanf(fp, "%lld %lld %lld", maps, inputOffset, outputOffset) == 3;
+    fclose(fp);
+
+    return ret && *maps >= 0 && *inputOffset >= 0 && *outputOffset >= 0;
+}
+
+/**
+ * Function: newCheckpoint
+ * 
+ * Description: starts recording the progress of a run in a checkpoint file
+ * 
+ * Arguments:
+ *     char *filename - name of checkpoint file
+ *     FILE *fpOut - output of the run, synced to disk before every checkpoint
+ *     long long maps - number of maps already written (0 unless resuming)
+ *     double seconds - seconds between checkpoints
+ * 
+ * Return value:
+ *     pointer to new checkpoint if successful
+ *     NULL if error ocurred
+ */
+checkpoint *newCheckpoint(char *filename, FILE *fpOut, long long maps, double seconds) {
+    checkpoint *cptr;
+
+    cptr = (checkpoint *) malloc(sizeof(checkpoint));
+    if (cptr == NULL) return NULL;
+
+    cptr->filename = (char *) malloc((strlen(filename) + 1) * sizeof(char));
+    if (cptr->filename == NULL) return NULL;
+    strcpy(cptr->filename, filename);
+
+    cptr->temporary = (char *) malloc((strlen(filename) + 5) * sizeof(char));
+    if (cptr->temporary == NULL) return NULL;
+    strcpy(cptr->temporary, filename);
+    strcat(cptr->temporary, ".tmp");
+
+    cptr->fpOut = fpOut;
+    cptr->maps = maps;
+    cptr->inputOffset = -1;
+    cptr->seconds = seconds;
+    clock_gettime(CLOCK_MONOTONIC, &cptr->last);
+
+    return cptr;
+}
+
+/**
+ * Function: markWritten
+ * 
+ * Description: records that one more map was fully written, saving a checkpoint if the last
+ *              one is older than the interval
+ * 
+ * Arguments:
+ *     checkpoint *cptr - checkpoint pointer (nothing is done if NULL)
+ *     long long inputOffset - input offset after the map
+ * 
+ * Return value: none
+ */
+void markWritten(checkpoint *cptr, long long inputOffset) {
+    struct timespec now;
+
+    if (cptr == NULL) return;
+
+    cptr->maps++;
+    cptr->inputOffset = inputOffset;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if ((now.tv_sec - cptr->last.tv_sec) + (now.tv_nsec - cptr->last.tv_nsec) * 1e-9 < cptr->seconds) return;
+
+    saveCheckpoint(cptr);
+    cptr->last = now;
+}
+
+/**
+ * Function: deleteCheckpoint
+ * 
+ * Description: saves a last checkpoint and stops recording
+ * 
+ * Arguments:
+ *     checkpoint *cptr - pointer to checkpoint to be deleted (nothing is done if NULL)
+ * 
+ * Return value: none
+ */
+void deleteCheckpoint(checkpoint *cptr) {
+    if (cptr == NULL) return;
+
+    saveCheckpoint(cptr);
+
+    free(cptr->filename);
+    free(cptr->temporary);
+    free(cptr);
+}
+
+/**
+ * Function: saveCheckpoint
+ * 
+ * Description: syncs output and replaces the checkpoint file with the current progress
+ * 
+ * Arguments:
+ *     checkpoint *cptr - checkpoint pointer
+ * 
+ * Return value: none
+ */
+void saveCheckpoint(checkpoint *cptr) {
+    FILE *fp;
+    long long outputOffset;
+
+    /** nothing was written since the run started */
+    if (cptr->inputOffset < 0) return;
+
+    if (fflush(cptr->fpOut) || fsync(fileno(cptr->fpOut))) return;
+    outputOffset = ftell(cptr->fpOut);
+    if (outputOffset < 0) return;
+
+    fp = fopen(cptr->temporary, "w");
+    if (fp == NULL) return;
+    fprintf(fp, "%lld %lld %lld\n", cptr->maps, cptr->inputOffset, outputOffset);
+    if (fflush(fp) || fsync(fileno(fp))) {
+        fclose(fp);
+        return;
+    }
+    fclose(fp);
+
+    rename(cptr->temporary, cptr->filename);
+}
@@ -0,0 +1,78 @@
+/**
+ * Filename: checkpoint.h
+ * 
+ * Description: Checkpoints of the progress of a run, so that it can be resumed
+ */
+
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <stdio.h>
+
+/** seconds between checkpoints unless told otherwise */
+#define CHECKPOINT_SECONDS 10
+
+typedef struct checkpointStruct checkpoint;
+
+/**
+ * Function: readCheckpoint
+ * 
+ * Description: reads the last checkpoint saved in a file, a line "maps input output" with the
+ *              number of maps fully written and the byte offsets in input and output after them
+ * 
+ * Arguments:
+ *     char *filename - name of checkpoint file
+ *     long long *maps - returns number of maps written
+ *     long long *inputOffset - returns input offset after the last map written
+ *     long long *outputOffset - returns output offset after the last map written
+ * 
+ * Return value:
+ *     1 - if a checkpoint was read
+ *     0 - if there is no checkpoint
+ */
+int readCheckpoint(char *filename, long long *maps, long long *inputOffset, long long *outputOffset);
+
+/**
+ * Function: newCheckpoint
+ * 
+ * Description: starts recording the progress of a run in a checkpoint file
+ * 
+ * Arguments:
+ *     char *filename - name of checkpoint file
+ *     FILE *fpOut - output of the run, synced to disk before every checkpoint
+ *     long long maps - number of maps already written (0 unless resuming)
+ *     double seconds - seconds between checkpoints
+ * 
+ * Return value:
+ *     pointer to new checkpoint if successful
+ *     NULL if error ocurred
+ */
+checkpoint *newCheckpoint(char *filename, FILE *fpOut, long long maps, double seconds);
+
+/**
+ * Function: markWritten
+ * 
+ * Description: records that one more map was fully written, saving a checkpoint if the last
+ *              one is older than the interval
+ * 
+ * Arguments:
+ *     checkpoint *cptr - checkpoint pointer (nothing is done if NULL)
+ *     long long inputOffset - input offset after the map
+ * 
+ * Return value: none
+ */
+void markWritten(checkpoint *cptr, long long inputOffset);
+
+/**
+ * Function: deleteCheckpoint
+ * 
+ * Description: saves a last checkpoint and stops recording
+ * 
+ * Arguments:
+ *     checkpoint *cptr - pointer to checkpoint to be deleted (nothing is done if NULL)
+ * 
+ * Return value: none
+ */
+void deleteCheckpoint(checkpoint *cptr);
+
+#endif
@@ -0,0 +1,66 @@
+/**
+ * Filename: client.c
+ * 
+ * Synopsis: Command line client for the tents and trees solver daemon, sends the maps of a
+ *           .camp file (or standard input) and writes the solutions to standard output
+ * 
+ * Usage: tentsclient socket [file.camp]
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "net.h"
+
+#define READ_CHUNK 65536
+
+int main(int argc, char *argv[]) {
+    FILE *fpIn;
+    char *request;
+    size_t length = 0, capacity = READ_CHUNK, n;
+    int fd;
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "usage: %s socket [file.camp]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    fpIn = argc == 3 ? fopen(argv[2], "rb") : stdin;
+    if (fpIn == NULL) {
+        perror(argv[2]);
+        return EXIT_FAILURE;
+    }
+
+    request = (char *) malloc(capacity);
+    if (request == NULL) return EXIT_FAILURE;
+    while ((n = fread(request + length, 1, capacity - length, fpIn)) > 0) {
+        length += n;
+        if (length == capacity) {
+            capacity *= 2;
+            request = (char *) realloc(request, capacity);
+            if (request == NULL) return EXIT_FAILURE;
+        }
+    }
+    if (fpIn != stdin) fclose(fpIn);
+
+    signal(SIGPIPE, SIG_IGN);
+
+    fd = connectSocket(argv[1]);
+    if (fd < 0) {
+        perror(argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    if (exchangeRequest(fd, request, length, stdout) < 0) {
+        perror("request");
+        return EXIT_FAILURE;
+    }
+
+    close(fd);
+    free(request);
+
+    return 0;
+}
@@ -0,0 +1,576 @@
+/**
+ * Filename: daemon.c
+ * 
+ * Description: Solver daemon serving requests over a Unix domain socket
+ * 
+ * A single IO thread accepts connections, reads their bytes and parses every map as soon as
+ * it has arrived. Each map is one task of the pool, so maps of concurrent requests are solved
+ * side by side and an idle connection holds no worker. Solutions are sent back by the IO
+ * thread in the order the maps of a connection were sent.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "daemon.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "io.h"
+#include "map.h"
+#include "net.h"
+#include "pool.h"
+#include "solver.h"
+
+/** bytes read from a connection at a time */
+#define DAEMON_CHUNK 65536
+
+/** record sent in place of a solution when a map is malformed, the connection ends after it */
+#define DAEMON_ERROR "error malformed map\n\n"
+
+typedef struct daemonStruct daemonState;
+typedef struct connectionStruct connection;
+
+/** map of a connection, solved by a pool task into a solution of its own */
+typedef struct requestStruct {
+    connection *cptr;
+    map *mptr;
+    int lines;
+    int columns;
+    int result;
+    char *output;
+    size_t outputLength;
+    int done;
+    struct requestStruct *next;
+} request;
+
+/**
+ * Connection: bytes received and not parsed yet, maps in flight in input order and bytes of
+ * solutions not sent yet. Only the IO thread touches it, except for the cancelled flag and the
+ * requests, which are shared with the workers under the daemon lock
+ */
+struct connectionStruct {
+    daemonState *dptr;
+    int fd;
+    char *input;
+    size_t inputLength;
+    size_t inputCapacity;
+    size_t retryLength;
+    int inputClosed;
+    int failed;
+    int cancelled;
+    request *head;
+    request *tail;
+    char *output;
+    size_t outputLength;
+    size_t outputCapacity;
+    size_t sent;
+    struct connectionStruct *next;
+};
+
+struct daemonStruct {
+    pool *pptr;
+    workspace **workspaces;
+    connection *connections;
+    int connectionCount;
+    int wakeFd[2];
+    pthread_mutex_t lock;
+};
+
+volatile sig_atomic_t stopDaemon = 0;
+
+/** write end of the wake pipe, so that a stop signal also ends a poll already waiting */
+int daemonWakeFd = -1;
+
+void acceptConnections(daemonState *dptr, int listenFd);
+void receiveRequests(connection *cptr);
+void parseRequests(connection *cptr);
+void solveRequest(void *arg, int worker);
+void collectSolutions(connection *cptr);
+void appendOutput(connection *cptr, char *bytes, size_t length);
+void sendSolutions(connection *cptr);
+void cancelConnection(connection *cptr);
+void deleteConnection(connection *cptr);
+int setNonBlocking(int fd);
+void handleStopSignal(int signalNumber);
+
+/**
+ * Function: runDaemon
+ * 
+ * Description: serves solve requests on a Unix domain socket until SIGINT or SIGTERM,
+ *              every connection sends maps (.camp text or binary form) and closes its
+ *              sending side, solutions are streamed back in .tents form, in the order the
+ *              maps were sent, as soon as they are solved. Connections are read by a single
+ *              IO thread and every map is a task of a pool of workers, each one keeping its
+ *              own warm solver workspace. A malformed map gets an error record after the
+ *              solutions before it and ends the connection
+ * 
+ * Arguments:
+ *     char *socketPath - path of the socket
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     0 - if daemon stopped normally
+ *     1 - if socket could not be created
+ */
+int runDaemon(char *socketPath, int workers) {
+    struct sigaction action;
+    struct pollfd *events = NULL;
+    connection **polled = NULL, *cptr, **link;
+    daemonState *dptr;
+    int listenFd, poolWorkers, count, capacity = 0;
+    char drain[256];
+
+    listenFd = listenSocket(socketPath);
+    if (listenFd < 0) {
+        perror(socketPath);
+        return 1;
+    }
+
+    dptr = (daemonState *) malloc(sizeof(daemonState));
+    if (dptr == NULL) exit(EXIT_FAILURE);
+    dptr->connections = NULL;
+    dptr->connectionCount = 0;
+    pthread_mutex_init(&dptr->lock, NULL);
+
+    if (pipe(dptr->wakeFd) || !setNonBlocking(dptr->wakeFd[0]) || !setNonBlocking(dptr->wakeFd[1]) || !setNonBlocking(listenFd)) {
+        perror("daemon");
+        return 1;
+    }
+    daemonWakeFd = dptr->wakeFd[1];
+
+    action.sa_handler = handleStopSignal;
+    action.sa_flags = 0;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    dptr->pptr = newPool(workers);
+    if (dptr->pptr == NULL) exit(EXIT_FAILURE);
+
+    poolWorkers = getPoolWorkers(dptr->pptr);
+    dptr->workspaces = (workspace **) malloc(poolWorkers * sizeof(workspace *));
+    if (dptr->workspaces == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < poolWorkers; i++) {
+        dptr->workspaces[i] = newWorkspace();
+        if (dptr->workspaces[i] == NULL) exit(EXIT_FAILURE);
+        /** workers already solve maps side by side, a huge map is preprocessed by its own worker */
+        setWorkspaceThreads(dptr->workspaces[i], 1);
+    }
+
+    while (!stopDaemon) {
+        if (dptr->connectionCount + 2 > capacity) {
+            capacity = 2 * (dptr->connectionCount + 2);
+            events = (struct pollfd *) realloc(events, capacity * sizeof(struct pollfd));
+            polled = (connection **) realloc(polled, capacity * sizeof(connection *));
+            if (events == NULL || polled == NULL) exit(EXIT_FAILURE);
+        }
+
+        events[0].fd = listenFd;
+        events[0].events = POLLIN;
+        events[1].fd = dptr->wakeFd[0];
+        events[1].events = POLLIN;
+        count = 2;
+        for (cptr = dptr->connections; cptr != NULL; cptr = cptr->next) {
+            events[count].events = (cptr->inputClosed ? 0 : POLLIN) | (cptr->sent < cptr->outputLength ? POLLOUT : 0);
+
+            /** a connection waiting for its maps is left out, its hang up would wake poll at once */
+            events[count].fd = events[count].events ? cptr->fd : -1;
+            polled[count++] = cptr;
+        }
+
+        if (poll(events, count, -1) < 0) {
+            if (errno == EINTR) continue;
+            perror("poll");
+            break;
+        }
+
+        if (events[1].revents & POLLIN) {
+            while (read(dptr->wakeFd[0], drain, sizeof(drain)) > 0);
+        }
+        for (int i = 2; i < count; i++) {
+            if ((events[i].revents & (POLLIN | POLLHUP | POLLERR)) && !polled[i]->inputClosed) receiveRequests(polled[i]);
+        }
+        if (events[0].revents & POLLIN) acceptConnections(dptr, listenFd);
+
+        /** solutions are sent in order, a connection ends once its last one is sent */
+        for (link = &dptr->connections; *link != NULL;) {
+            cptr = *link;
+            collectSolutions(cptr);
+            sendSolutions(cptr);
+            if (cptr->head == NULL && (cptr->cancelled || (cptr->inputClosed && cptr->sent == cptr->outputLength))) {
+                *link = cptr->next;
+                dptr->connectionCount--;
+                deleteConnection(cptr);
+            } else {
+                link = &cptr->next;
+            }
+        }
+    }
+
+    close(listenFd);
+    unlink(socketPath);
+
+    /** maps still queued are not solved, the pool only waits for the ones being solved */
+    for (cptr = dptr->connections; cptr != NULL; cptr = cptr->next) cancelConnection(cptr);
+    deletePool(dptr->pptr);
+    while (dptr->connections != NULL) {
+        cptr = dptr->connections;
+        dptr->connections = cptr->next;
+        collectSolutions(cptr);
+        deleteConnection(cptr);
+    }
+
+    for (int i = 0; i < poolWorkers; i++) {
+        deleteWorkspace(dptr->workspaces[i]);
+    }
+    free(dptr->workspaces);
+    daemonWakeFd = -1;
+    close(dptr->wakeFd[0]);
+    close(dptr->wakeFd[1]);
+    pthread_mutex_destroy(&dptr->lock);
+    free(dptr);
+    free(events);
+    free(polled);
+
+    return 0;
+}
+
+/**
+ * Function: acceptConnections
+ * 
+ * Description: accepts every pending connection
+ * 
+ * Arguments:
+ *     daemonState *dptr - daemon pointer
+ *     int listenFd - listening file descriptor
+ * 
+ * Return value: none
+ */
+void acceptConnections(daemonState *dptr, int listenFd) {
+    connection *cptr;
+    int fd;
+
+    while ((fd = accept(listenFd, NULL, NULL)) >= 0) {
+        if (!setNonBlocking(fd)) {
+            close(fd);
+            continue;
+        }
+
+        cptr = (connection *) calloc(1, sizeof(connection));
+        if (cptr == NULL) exit(EXIT_FAILURE);
+        cptr->dptr = dptr;
+        cptr->fd = fd;
+        cptr->next = dptr->connections;
+        dptr->connections = cptr;
+        dptr->connectionCount++;
+    }
+}
+
+/**
+ * Function: receiveRequests
+ * 
+ * Description: reads the bytes a connection has sent and parses the maps they complete
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ * 
+ * Return value: none
+ */
+void receiveRequests(connection *cptr) {
+    ssize_t n;
+
+    if (cptr->inputCapacity - cptr->inputLength < DAEMON_CHUNK) {
+        cptr->inputCapacity = 2 * cptr->inputCapacity + DAEMON_CHUNK;
+        cptr->input = (char *) realloc(cptr->input, cptr->inputCapacity);
+        if (cptr->input == NULL) exit(EXIT_FAILURE);
+    }
+
+    n = read(cptr->fd, cptr->input + cptr->inputLength, cptr->inputCapacity - cptr->inputLength);
+    if (n < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return;
+        cancelConnection(cptr);
+        cptr->inputClosed = 1;
+        return;
+    }
+
+    if (n == 0)
+        cptr->inputClosed = 1;
+    else
+        cptr->inputLength += n;
+
+    /** bytes sent after the client is gone are dropped */
+    if (cptr->cancelled)
+        cptr->inputLength = 0;
+    else
+        parseRequests(cptr);
+}
+
+/**
+ * Function: parseRequests
+ * 
+ * Description: parses every map whose bytes have all arrived and submits it to the pool. A map
+ *              cut short by the end of what has arrived is parsed again once its bytes
+ *              doubled, or when the sending side is closed
+ * 
+ * Side-effects: drops the parsed bytes from the input, marks the connection failed if a map is
+ *               malformed
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ * 
+ * Return value: none
+ */
+void parseRequests(connection *cptr) {
+    request *rptr;
+    FILE *fp;
+    size_t parsed = 0, end, start;
+    int ret;
+
+    while (parsed < cptr->inputLength) {
+        end = cptr->inputLength;
+        if (!cptr->inputClosed) {
+            if (end < cptr->retryLength) break;
+
+            /** a text map is only parsed up to a line end, so that no number is cut short */
+            for (start = parsed; start < end && strchr(" \t\r\n", cptr->input[start]) != NULL; start++);
+            if (start < end && cptr->input[start] != 'T') {
+                while (end > parsed && cptr->input[end - 1] != '\n') end--;
+                if (end == parsed) break;
+            }
+        }
+
+        rptr = (request *) calloc(1, sizeof(request));
+        if (rptr == NULL) exit(EXIT_FAILURE);
+        fp = fmemopen(cptr->input + parsed, end - parsed, "r");
+        if (fp == NULL) exit(EXIT_FAILURE);
+        ret = readMap(fp, &rptr->mptr, &rptr->lines, &rptr->columns, &rptr->result);
+
+        if (ret == 1) {
+            parsed += ftell(fp);
+            fclose(fp);
+            rptr->cptr = cptr;
+            if (cptr->tail == NULL)
+                cptr->head = rptr;
+            else
+                cptr->tail->next = rptr;
+            cptr->tail = rptr;
+            submitTask(cptr->dptr->pptr, solveRequest, rptr);
+            cptr->retryLength = 0;
+            continue;
+        }
+
+        fclose(fp);
+        free(rptr);
+        if (cptr->inputClosed) {
+            if (ret == READ_ERROR) cptr->failed = 1;
+            parsed = cptr->inputLength;
+        } else {
+            cptr->retryLength = 2 * (cptr->inputLength - parsed) + parsed;
+        }
+        break;
+    }
+
+    memmove(cptr->input, cptr->input + parsed, cptr->inputLength - parsed);
+    cptr->inputLength -= parsed;
+    cptr->retryLength = cptr->retryLength > parsed ? cptr->retryLength - parsed : 0;
+}
+
+/**
+ * Function: solveRequest
+ * 
+ * Description: solves the map of a request and writes its solution, then wakes the IO thread
+ * 
+ * Arguments:
+ *     void *arg - pointer to request
+ *     int worker - index of worker running the task
+ * 
+ * Return value: none
+ */
+void solveRequest(void *arg, int worker) {
+    request *rptr = (request *) arg;
+    daemonState *dptr = rptr->cptr->dptr;
+    FILE *fp;
+    int cancelled;
+
+    pthread_mutex_lock(&dptr->lock);
+    cancelled = rptr->cptr->cancelled;
+    pthread_mutex_unlock(&dptr->lock);
+
+    if (cancelled) {
+        deleteMap(rptr->mptr);
+    } else {
+        if (rptr->mptr != NULL) rptr->result = solveMapInWorkspace(rptr->mptr, dptr->workspaces[worker]);
+        fp = open_memstream(&rptr->output, &rptr->outputLength);
+        if (fp == NULL) exit(EXIT_FAILURE);
+        writeSolution(fp, rptr->mptr, rptr->lines, rptr->columns, rptr->result);
+        fclose(fp);
+    }
+    rptr->mptr = NULL;
+
+    pthread_mutex_lock(&dptr->lock);
+    rptr->done = 1;
+    pthread_mutex_unlock(&dptr->lock);
+
+    /** a full pipe already holds a wake up */
+    if (write(dptr->wakeFd[1], "", 1) < 0 && errno != EAGAIN) perror("daemon");
+}
+
+/**
+ * Function: collectSolutions
+ * 
+ * Description: moves the solutions of the first requests of a connection that are solved to
+ *              its output, followed by an error record once every map before a malformed one
+ *              is solved
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ * 
+ * Return value: none
+ */
+void collectSolutions(connection *cptr) {
+    request *rptr;
+    int done;
+
+    while ((rptr = cptr->head) != NULL) {
+        pthread_mutex_lock(&cptr->dptr->lock);
+        done = rptr->done;
+        pthread_mutex_unlock(&cptr->dptr->lock);
+        if (!done) return;
+
+        if (!cptr->cancelled) appendOutput(cptr, rptr->output, rptr->outputLength);
+        cptr->head = rptr->next;
+        if (cptr->head == NULL) cptr->tail = NULL;
+        free(rptr->output);
+        free(rptr);
+    }
+
+    if (cptr->failed == 1 && !cptr->cancelled) {
+        appendOutput(cptr, DAEMON_ERROR, strlen(DAEMON_ERROR));
+        cptr->failed = 2;
+    }
+}
+
+/**
+ * Function: appendOutput
+ * 
+ * Description: appends bytes to the output of a connection
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ *     char *bytes - bytes to be appended
+ *     size_t length - number of bytes
+ * 
+ * Return value: none
+ */
+void appendOutput(connection *cptr, char *bytes, size_t length) {
+    if (cptr->sent == cptr->outputLength) cptr->sent = cptr->outputLength = 0;
+
+    if (cptr->outputLength + length > cptr->outputCapacity) {
+        cptr->outputCapacity = 2 * (cptr->outputLength + length);
+        cptr->output = (char *) realloc(cptr->output, cptr->outputCapacity);
+        if (cptr->output == NULL) exit(EXIT_FAILURE);
+    }
+    memcpy(cptr->output + cptr->outputLength, bytes, length);
+    cptr->outputLength += length;
+}
+
+/**
+ * Function: sendSolutions
+ * 
+ * Description: sends as much of the output of a connection as the socket takes without
+ *              blocking, a client that is gone cancels the connection
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ * 
+ * Return value: none
+ */
+void sendSolutions(connection *cptr) {
+    ssize_t n;
+
+    while (cptr->sent < cptr->outputLength && !cptr->cancelled) {
+        n = write(cptr->fd, cptr->output + cptr->sent, cptr->outputLength - cptr->sent);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) cancelConnection(cptr);
+            return;
+        }
+        cptr->sent += n;
+    }
+}
+
+/**
+ * Function: cancelConnection
+ * 
+ * Description: drops the output of a connection, its maps still queued are not solved
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ * 
+ * Return value: none
+ */
+void cancelConnection(connection *cptr) {
+    pthread_mutex_lock(&cptr->dptr->lock);
+    cptr->cancelled = 1;
+    pthread_mutex_unlock(&cptr->dptr->lock);
+
+    cptr->sent = cptr->outputLength = 0;
+}
+
+/**
+ * Function: deleteConnection
+ * 
+ * Description: closes a connection whose requests are all solved and deletes it
+ * 
+ * Arguments:
+ *     connection *cptr - connection pointer
+ * 
+ * Return value: none
+ */
+void deleteConnection(connection *cptr) {
+    close(cptr->fd);
+    free(cptr->input);
+    free(cptr->output);
+    free(cptr);
+}
+
+/**
+ * Function: setNonBlocking
+ * 
+ * Description: makes reads and writes of a file descriptor return instead of blocking
+ * 
+ * Arguments:
+ *     int fd - file descriptor
+ * 
+ * Return value:
+ *     1 - if successful
+ *     0 - if error ocurred
+ */
+int setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL);
+
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+/**
+ * Function: handleStopSignal
+ * 
+ * Description: asks IO loop to stop
+ * 
+ * Arguments:
+ *     int signalNumber - signal number
+ * 
+ * Return value: none
+ */
+void handleStopSignal(int signalNumber) {
+    stopDaemon = 1;
+    if (daemonWakeFd >= 0 && write(daemonWakeFd, "", 1) < 0) return;
+}
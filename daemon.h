@@ -0,0 +1,31 @@
+/**
+ * Filename: daemon.h
+ * 
+ * Description: solver daemon listening on a Unix domain socket
+ */
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+/**
+ * Function: runDaemon
+ * 
+ * Description: serves solve requests on a Unix domain socket until SIGINT or SIGTERM,
+ *              every connection sends maps (.camp text or binary form) and closes its
+ *              sending side, solutions are streamed back in .tents form, in the order the
+ *              maps were sent, as soon as they are solved. Connections are read by a single
+ *              IO thread and every map is a task of a pool of workers, each one keeping its
+ *              own warm solver workspace. A malformed map gets an error record after the
+ *              solutions before it and ends the connection
+ * 
+ * Arguments:
+ *     char *socketPath - path of the socket
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     0 - if daemon stopped normally
+ *     1 - if socket could not be created
+ */
+int runDaemon(char *socketPath, int workers);
+
+#endif
@@ -0,0 +1,916 @@
+/**
+ * Filename: decomposition.c
+ * 
+ * Description: Tree decomposition dynamic programming engine for maps with few trees
+ */
+
+#include "decomposition.h"
+#include <stdlib.h>
+#include <string.h>
+#include "map.h"
+#include "search.h"
+#include "table.h"
+
+/** bits of state, an order wider than this is not even tried */
+#define DECOMPOSITION_MAX_WIDTH 256
+/** a step opens at most 7 constraints before closing any, each of them takes a bit or more */
+#define DECOMPOSITION_MAX_SLOTS (DECOMPOSITION_MAX_WIDTH + 8)
+/** bytes of keys of a layer of states, two layers are kept at once */
+#define DECOMPOSITION_MAX_LAYER_BYTES (1L << 27)
+#define DECOMPOSITION_MAX_HISTORY (1L << 25)
+#define DECOMPOSITION_MAX_HINT 65535
+
+struct {
+    int dx;
+    int dy;
+} decompositionAdjacents[] = {{-1, -1}, {-1, 0}, {-1, 1}, {0, -1}, {0, 1}, {1, -1}, {1, 0}, {1, 1}},
+  decompositionOrtogonals[] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+
+/**
+ * A step decides one cell. Slots are positions in a state of the constraints open around it,
+ * -1 for a line, column or tree that opens and closes at this step (nothing to remember),
+ * released slots are the neighbours whose last undecided neighbour is this cell. Left is the
+ * number of cells of line and column decided after this one.
+ */
+typedef struct {
+    int cell;
+    int line;
+    int column;
+    int lineSlot;
+    int columnSlot;
+    int lineLeft;
+    int columnLeft;
+    int trees;
+    int treeSlot[4];
+    int treeCloses[4];
+    int neighbours;
+    int neighbourSlot[8];
+    int ownSlot;
+    int released;
+    int releasedSlot[8];
+} step;
+
+/**
+ * Neighbours (8 per cell), adjacent trees (4 per cell) and tree cells (4 per tree) hold -1
+ * where there is no uncertain cell or tree. Lines, columns and groups list their cells from
+ * lineStart, columnStart and groupStart. The rest, up to steps, is only used while the order
+ * is built: left counters, fringes of cells and groups, marks, slot of every open constraint
+ * and free slots.
+ */
+typedef struct {
+    map *mptr;
+    cell *cells;
+    int cellCount;
+    cell *trees;
+    int treeCount;
+    int highSeason;
+    int *neighbours;
+    int *adjacentTrees;
+    int *treeCells;
+    int *treeSize;
+    int *lineStart;
+    int *lineCells;
+    int *columnStart;
+    int *columnCells;
+    int *groupOf;
+    int *groupStart;
+    int *groupCells;
+    int groupCount;
+    int *cellLeft;
+    int *treeLeft;
+    int *lineLeft;
+    int *columnLeft;
+    int *fringe;
+    int *fringePosition;
+    int fringeSize;
+    int *groupFringe;
+    int *groupPosition;
+    int groupFringeSize;
+    int *lineMark;
+    int *columnMark;
+    int *lineSlots;
+    int *columnSlots;
+    int *treeSlots;
+    int *cellSlots;
+    int freeSlots[DECOMPOSITION_MAX_SLOTS];
+    int freeCount;
+    int width;
+    step *steps;
+    int slots;
+    int keySize;
+    table *current;
+    table *next;
+    int *parents;
+    unsigned char *decisions;
+    long historySize;
+    long historyCapacity;
+    int overflow;
+} decomposition;
+
+int buildGraph(decomposition *dptr);
+int orderCells(decomposition *dptr);
+void findGroups(decomposition *dptr);
+int findRoot(int *parent, int x);
+int decideCell(decomposition *dptr, int x, step *st);
+int takeSlot(decomposition *dptr, int bits);
+void addToFringe(decomposition *dptr, int x);
+void addGroups(decomposition *dptr, int *start, int *members, int index);
+int groupCost(decomposition *dptr, int g);
+int cellCost(decomposition *dptr, int x);
+int hintBits(int hint);
+void advanceState(decomposition *dptr, step *st, int parent, unsigned short *key, unsigned short *work);
+void storeDecision(decomposition *dptr, step *st, int parent, unsigned short *key, unsigned short *work, int lineCount, int columnCount, int *used, int tent);
+void deleteDecomposition(decomposition *dptr);
+
+/**
+ * Function: decompositionFits
+ * 
+ * Description: checks if trees of a preprocessed map are spread enough for the decomposition
+ *              engine, i.e. map is sparse or has few trees for its area
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (preprocessed)
+ * 
+ * Return value:
+ *     1 - if decomposition engine may be used
+ *     0 - otherwise
+ */
+int decompositionFits(map *mptr) {
+    if (isSparseMap(mptr)) return 1;
+    return (long long) getTreesNumber(mptr) * DECOMPOSITION_MIN_SPREAD <= (long long) getMapLines(mptr) * getMapColumns(mptr);
+}
+
+/**
+ * Function: decompositionSolve
+ * 
+ * Description: solves a preprocessed map deciding its uncertain cells in an elimination order
+ *              picked greedily so that few constraints are open at once. A constraint is open
+ *              while some of its cells are decided and some are not: a state holds the tent
+ *              of every decided cell with undecided neighbours, whether every open tree has
+ *              got its tent and the tents placed so far in every open line and column. Equal
+ *              states are merged, so independent groups of trees are solved one after another
+ *              and the time is polynomial in the number of trees for a bounded width. Gives up
+ *              before any search if the width (bits of state) of the order is too large
+ * 
+ * Side-effects: writes solution for mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (preprocessed)
+ *     workspace *wptr - workspace with uncertain and tree arrays
+ *     int *cancel - search stops once it is set by another thread (NULL if never)
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     0 - if map is impossible
+ *     DECOMPOSITION_GAVE_UP - if map is too wide, has too many states or search was cancelled
+ */
+int decompositionSolve(map *mptr, workspace *wptr, int *cancel) {
+    decomposition dec;
+    table *swap;
+    long *layerStart;
+    unsigned short *key, *work;
+    int result, found = -1;
+    long index;
+
+    if (!decompositionFits(mptr)) return DECOMPOSITION_GAVE_UP;
+
+    memset(&dec, 0, sizeof(dec));
+    dec.mptr = mptr;
+    dec.cells = wptr->uncertainArray;
+    dec.cellCount = getUncertainCount(mptr);
+    dec.trees = wptr->treeArray;
+    dec.treeCount = getTreesNumber(mptr);
+    dec.highSeason = getTreesNumber(mptr) == getTentsNumber(mptr);
+
+    result = buildGraph(&dec);
+    if (result == 1 && !orderCells(&dec)) result = DECOMPOSITION_GAVE_UP;
+    if (result != 1) {
+        deleteDecomposition(&dec);
+        return result;
+    }
+
+    dec.keySize = (dec.slots ? dec.slots : 1) * sizeof(unsigned short);
+    dec.current = newTable(dec.keySize);
+    dec.next = newTable(dec.keySize);
+    layerStart = (long *) malloc((dec.cellCount + 1) * sizeof(long));
+    work = (unsigned short *) malloc(dec.keySize);
+    if (dec.current == NULL || dec.next == NULL || layerStart == NULL || work == NULL) exit(EXIT_FAILURE);
+
+    /** initial state: nothing decided, nothing open */
+    memset(work, 0, dec.keySize);
+    insertKey(dec.current, work, &result);
+
+    for (int k = 0; k < dec.cellCount && !dec.overflow && getTableSize(dec.current); k++) {
+        if (cancel != NULL && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+            dec.overflow = 1;
+            break;
+        }
+        layerStart[k] = dec.historySize;
+        clearTable(dec.next);
+        for (int s = 0; s < getTableSize(dec.current) && !dec.overflow; s++) {
+            key = (unsigned short *) getKey(dec.current, s);
+            advanceState(&dec, &dec.steps[k], s, key, work);
+        }
+        swap = dec.current;
+        dec.current = dec.next;
+        dec.next = swap;
+    }
+
+    /** every constraint is closed in the end, leaving at most the empty state */
+    result = dec.overflow ? DECOMPOSITION_GAVE_UP : getTableSize(dec.current) > 0;
+    if (result == 1) found = 0;
+    for (int k = dec.cellCount - 1; k >= 0 && found != -1; k--) {
+        index = layerStart[k] + found;
+        setContentOfPosition(mptr, dec.steps[k].line, dec.steps[k].column, dec.decisions[index] ? 'T' : '.');
+        found = dec.parents[index];
+    }
+
+    free(layerStart);
+    free(work);
+    deleteDecomposition(&dec);
+
+    return result;
+}
+
+/**
+ * Function: buildGraph
+ * 
+ * Description: finds neighbour cells and adjacent trees of every uncertain cell, cells of
+ *              every tree and cells of every line and column
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition (map, cells and trees set)
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if a line can't get its tents or (in high season) a tree has no cell around
+ *     DECOMPOSITION_GAVE_UP - if a hint doesn't fit in a state
+ */
+int buildGraph(decomposition *dptr) {
+    map *mptr = dptr->mptr;
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr), n = dptr->cellCount;
+    table *cellIndex, *treeIndex;
+    int position[2], index, possible = 1;
+
+    for (int i = 0; i < lines; i++) {
+        if (getTentsInLine(mptr, i) > DECOMPOSITION_MAX_HINT) return DECOMPOSITION_GAVE_UP;
+    }
+    for (int j = 0; j < columns; j++) {
+        if (getTentsInColumn(mptr, j) > DECOMPOSITION_MAX_HINT) return DECOMPOSITION_GAVE_UP;
+    }
+
+    dptr->neighbours = (int *) malloc(((long) n * 8 + 1) * sizeof(int));
+    dptr->adjacentTrees = (int *) malloc(((long) n * 4 + 1) * sizeof(int));
+    dptr->treeCells = (int *) malloc(((long) dptr->treeCount * 4 + 1) * sizeof(int));
+    dptr->treeSize = (int *) malloc((dptr->treeCount + 1) * sizeof(int));
+    dptr->lineStart = (int *) calloc(lines + 1, sizeof(int));
+    dptr->lineCells = (int *) malloc((n + 1) * sizeof(int));
+    dptr->columnStart = (int *) calloc(columns + 1, sizeof(int));
+    dptr->columnCells = (int *) malloc((n + 1) * sizeof(int));
+    cellIndex = newTable(2 * sizeof(int));
+    treeIndex = newTable(2 * sizeof(int));
+    if (dptr->neighbours == NULL || dptr->adjacentTrees == NULL || dptr->treeCells == NULL || dptr->treeSize == NULL || dptr->lineStart == NULL || dptr->lineCells == NULL || dptr->columnStart == NULL || dptr->columnCells == NULL || cellIndex == NULL || treeIndex == NULL) exit(EXIT_FAILURE);
+
+    /** cells and trees are numbered in array order */
+    for (int x = 0; x < n; x++) {
+        position[0] = dptr->cells[x].line;
+        position[1] = dptr->cells[x].column;
+        insertKey(cellIndex, position, &index);
+    }
+    for (int t = 0; t < dptr->treeCount; t++) {
+        position[0] = dptr->trees[t].line;
+        position[1] = dptr->trees[t].column;
+        insertKey(treeIndex, position, &index);
+    }
+
+    for (int x = 0; x < n; x++) {
+        for (int k = 0; k < 8; k++) {
+            position[0] = dptr->cells[x].line + decompositionAdjacents[k].dx;
+            position[1] = dptr->cells[x].column + decompositionAdjacents[k].dy;
+            dptr->neighbours[8 * x + k] = findKey(cellIndex, position);
+        }
+        for (int k = 0; k < 4; k++) {
+            position[0] = dptr->cells[x].line + decompositionOrtogonals[k].dx;
+            position[1] = dptr->cells[x].column + decompositionOrtogonals[k].dy;
+            dptr->adjacentTrees[4 * x + k] = findKey(treeIndex, position);
+        }
+        dptr->lineStart[dptr->cells[x].line + 1]++;
+        dptr->columnStart[dptr->cells[x].column + 1]++;
+    }
+    for (int t = 0; t < dptr->treeCount; t++) {
+        dptr->treeSize[t] = 0;
+        for (int k = 0; k < 4; k++) {
+            position[0] = dptr->trees[t].line + decompositionOrtogonals[k].dx;
+            position[1] = dptr->trees[t].column + decompositionOrtogonals[k].dy;
+            dptr->treeCells[4 * t + k] = findKey(cellIndex, position);
+            if (dptr->treeCells[4 * t + k] != -1) dptr->treeSize[t]++;
+        }
+        if (dptr->highSeason && dptr->treeSize[t] == 0) possible = 0;
+    }
+    deleteTable(cellIndex);
+    deleteTable(treeIndex);
+    if (!possible) return 0;
+
+    /** counting sort of cells by line and by column */
+    for (int i = 0; i < lines; i++) {
+        if (getTentsInLine(mptr, i) > dptr->lineStart[i + 1]) return 0;
+        dptr->lineStart[i + 1] += dptr->lineStart[i];
+    }
+    for (int j = 0; j < columns; j++) {
+        if (getTentsInColumn(mptr, j) > dptr->columnStart[j + 1]) return 0;
+        dptr->columnStart[j + 1] += dptr->columnStart[j];
+    }
+    for (int x = 0; x < n; x++) {
+        dptr->lineCells[dptr->lineStart[dptr->cells[x].line]++] = x;
+        dptr->columnCells[dptr->columnStart[dptr->cells[x].column]++] = x;
+    }
+    for (int i = lines; i > 0; i--) dptr->lineStart[i] = dptr->lineStart[i - 1];
+    for (int j = columns; j > 0; j--) dptr->columnStart[j] = dptr->columnStart[j - 1];
+    dptr->lineStart[0] = 0;
+    dptr->columnStart[0] = 0;
+
+    return 1;
+}
+
+/**
+ * Function: orderCells
+ * 
+ * Description: builds the steps of the search group by group, a group being the cells linked
+ *              by trees and neighbours. Next group is the one sharing an open line or column
+ *              that opens the fewest bits of state and closes the most (or the first group left
+ *              once none shares one), inside a group next cell is the one of the fringe (cells
+ *              next to a decided one) that does the same
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition with graph
+ * 
+ * Return value:
+ *     1 - if width of order fits
+ *     0 - otherwise
+ */
+int orderCells(decomposition *dptr) {
+    map *mptr = dptr->mptr;
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr), n = dptr->cellCount;
+    int nextGroup = 0, fits = 1, s = 0, x, g, cost, bestCost;
+
+    dptr->cellLeft = (int *) malloc((n + 1) * sizeof(int));
+    dptr->treeLeft = (int *) malloc((dptr->treeCount + 1) * sizeof(int));
+    dptr->lineLeft = (int *) malloc((lines + 1) * sizeof(int));
+    dptr->columnLeft = (int *) malloc((columns + 1) * sizeof(int));
+    dptr->fringe = (int *) malloc((n + 1) * sizeof(int));
+    dptr->fringePosition = (int *) malloc((n + 1) * sizeof(int));
+    dptr->groupFringe = (int *) malloc((n + 1) * sizeof(int));
+    dptr->groupPosition = (int *) malloc((n + 1) * sizeof(int));
+    dptr->lineMark = (int *) malloc((lines + 1) * sizeof(int));
+    dptr->columnMark = (int *) malloc((columns + 1) * sizeof(int));
+    dptr->lineSlots = (int *) malloc((lines + 1) * sizeof(int));
+    dptr->columnSlots = (int *) malloc((columns + 1) * sizeof(int));
+    dptr->treeSlots = (int *) malloc((dptr->treeCount + 1) * sizeof(int));
+    dptr->cellSlots = (int *) malloc((n + 1) * sizeof(int));
+    dptr->steps = (step *) malloc((n + 1) * sizeof(step));
+    dptr->groupOf = (int *) malloc((n + 1) * sizeof(int));
+    dptr->groupStart = (int *) malloc((n + 1) * sizeof(int));
+    dptr->groupCells = (int *) malloc((n + 1) * sizeof(int));
+    if (dptr->groupOf == NULL || dptr->groupStart == NULL || dptr->groupCells == NULL || dptr->cellLeft == NULL || dptr->treeLeft == NULL || dptr->lineLeft == NULL || dptr->columnLeft == NULL || dptr->fringe == NULL || dptr->fringePosition == NULL || dptr->groupFringe == NULL || dptr->groupPosition == NULL || dptr->lineMark == NULL || dptr->columnMark == NULL || dptr->lineSlots == NULL || dptr->columnSlots == NULL || dptr->treeSlots == NULL || dptr->cellSlots == NULL || dptr->steps == NULL) exit(EXIT_FAILURE);
+
+    findGroups(dptr);
+
+    /** cell left is -1 while cell is undecided, group position is -2 once group is decided */
+    for (int i = 0; i < n; i++) {
+        dptr->cellLeft[i] = -1;
+        dptr->fringePosition[i] = -1;
+        dptr->groupPosition[i] = -1;
+    }
+    for (int i = 0; i < lines; i++) {
+        dptr->lineLeft[i] = dptr->lineStart[i + 1] - dptr->lineStart[i];
+        dptr->lineMark[i] = -1;
+    }
+    for (int j = 0; j < columns; j++) {
+        dptr->columnLeft[j] = dptr->columnStart[j + 1] - dptr->columnStart[j];
+        dptr->columnMark[j] = -1;
+    }
+    for (int t = 0; t < dptr->treeCount; t++) dptr->treeLeft[t] = dptr->treeSize[t];
+    dptr->fringeSize = 0;
+    dptr->groupFringeSize = 0;
+    dptr->freeCount = 0;
+    dptr->slots = 0;
+    dptr->width = 0;
+
+    while (s < n && fits) {
+        if (dptr->groupFringeSize == 0) {
+            while (dptr->groupPosition[nextGroup] == -2) nextGroup++;
+            g = nextGroup;
+        } else {
+            g = dptr->groupFringe[0];
+            bestCost = groupCost(dptr, g);
+            for (int f = 1; f < dptr->groupFringeSize; f++) {
+                cost = groupCost(dptr, dptr->groupFringe[f]);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    g = dptr->groupFringe[f];
+                }
+            }
+            dptr->groupFringe[dptr->groupPosition[g]] = dptr->groupFringe[--dptr->groupFringeSize];
+            dptr->groupPosition[dptr->groupFringe[dptr->groupFringeSize]] = dptr->groupPosition[g];
+        }
+        dptr->groupPosition[g] = -2;
+
+        /** groups are connected, so the fringe only empties once the group is decided */
+        x = dptr->groupCells[dptr->groupStart[g]];
+        for (int i = dptr->groupStart[g]; i < dptr->groupStart[g + 1] && fits; i++) {
+            if (i > dptr->groupStart[g]) {
+                x = dptr->fringe[0];
+                bestCost = cellCost(dptr, x);
+                for (int f = 1; f < dptr->fringeSize; f++) {
+                    cost = cellCost(dptr, dptr->fringe[f]);
+                    if (cost < bestCost) {
+                        bestCost = cost;
+                        x = dptr->fringe[f];
+                    }
+                }
+            }
+            if (dptr->fringePosition[x] != -1) {
+                dptr->fringe[dptr->fringePosition[x]] = dptr->fringe[--dptr->fringeSize];
+                dptr->fringePosition[dptr->fringe[dptr->fringeSize]] = dptr->fringePosition[x];
+                dptr->fringePosition[x] = -1;
+            }
+            fits = decideCell(dptr, x, &dptr->steps[s++]);
+        }
+    }
+
+    return fits;
+}
+
+/**
+ * Function: findGroups
+ * 
+ * Description: splits cells into groups linked by trees and neighbours (union find), listing
+ *              the cells of every group from groupStart
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition with graph
+ * 
+ * Return value: none
+ */
+void findGroups(decomposition *dptr) {
+    int n = dptr->cellCount, *parent = dptr->groupOf, first, y;
+
+    for (int x = 0; x < n; x++) parent[x] = x;
+    for (int x = 0; x < n; x++) {
+        for (int k = 0; k < 8; k++) {
+            if ((y = dptr->neighbours[8 * x + k]) != -1) parent[findRoot(parent, x)] = findRoot(parent, y);
+        }
+    }
+    for (int t = 0; t < dptr->treeCount; t++) {
+        first = -1;
+        for (int k = 0; k < 4; k++) {
+            if ((y = dptr->treeCells[4 * t + k]) == -1) continue;
+            if (first == -1)
+                first = y;
+            else
+                parent[findRoot(parent, y)] = findRoot(parent, first);
+        }
+    }
+
+    /** groups are numbered by their first cell (roots kept in fringe meanwhile), then cells are sorted by group */
+    dptr->groupCount = 0;
+    for (int x = 0; x < n; x++) {
+        dptr->fringe[x] = findRoot(parent, x);
+        if (dptr->fringe[x] == x) dptr->groupStart[x] = dptr->groupCount++;
+    }
+    for (int x = 0; x < n; x++) parent[x] = dptr->groupStart[dptr->fringe[x]];
+    for (int g = 0; g <= dptr->groupCount; g++) dptr->groupStart[g] = 0;
+    for (int x = 0; x < n; x++) dptr->groupStart[parent[x] + 1]++;
+    for (int g = 0; g < dptr->groupCount; g++) dptr->groupStart[g + 1] += dptr->groupStart[g];
+    for (int x = 0; x < n; x++) dptr->groupCells[dptr->groupStart[parent[x]]++] = x;
+    for (int g = dptr->groupCount; g > 0; g--) dptr->groupStart[g] = dptr->groupStart[g - 1];
+    dptr->groupStart[0] = 0;
+}
+
+/**
+ * Function: findRoot
+ * 
+ * Description: finds root of a cell in union find, halving the path
+ * 
+ * Arguments:
+ *     int *parent - parent of every cell
+ *     int x - cell
+ * 
+ * Return value: root of x
+ */
+int findRoot(int *parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+
+    return x;
+}
+
+/**
+ * Function: decideCell
+ * 
+ * Description: builds the step deciding a cell, opening the constraints it starts (with a
+ *              free slot each) and closing the ones it ends, and updates fringes
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     int x - undecided cell
+ *     step *st - returns step
+ * 
+ * Return value:
+ *     1 - if width still fits
+ *     0 - otherwise
+ */
+int decideCell(decomposition *dptr, int x, step *st) {
+    map *mptr = dptr->mptr;
+    int release[16], releaseCount = 0, releasedBits = 0, size, t, y;
+
+    st->cell = x;
+    st->line = dptr->cells[x].line;
+    st->column = dptr->cells[x].column;
+    dptr->cellLeft[x] = 0;
+
+    /** lines open at their first cell and close at their last */
+    size = dptr->lineStart[st->line + 1] - dptr->lineStart[st->line];
+    st->lineSlot = -1;
+    if (size > 1) {
+        if (dptr->lineLeft[st->line] == size) {
+            dptr->lineSlots[st->line] = takeSlot(dptr, hintBits(getTentsInLine(mptr, st->line)));
+            addGroups(dptr, dptr->lineStart, dptr->lineCells, st->line);
+        }
+        st->lineSlot = dptr->lineSlots[st->line];
+        if (dptr->lineLeft[st->line] == 1) {
+            release[releaseCount++] = st->lineSlot;
+            releasedBits += hintBits(getTentsInLine(mptr, st->line));
+        }
+    }
+    st->lineLeft = --dptr->lineLeft[st->line];
+
+    size = dptr->columnStart[st->column + 1] - dptr->columnStart[st->column];
+    st->columnSlot = -1;
+    if (size > 1) {
+        if (dptr->columnLeft[st->column] == size) {
+            dptr->columnSlots[st->column] = takeSlot(dptr, hintBits(getTentsInColumn(mptr, st->column)));
+            addGroups(dptr, dptr->columnStart, dptr->columnCells, st->column);
+        }
+        st->columnSlot = dptr->columnSlots[st->column];
+        if (dptr->columnLeft[st->column] == 1) {
+            release[releaseCount++] = st->columnSlot;
+            releasedBits += hintBits(getTentsInColumn(mptr, st->column));
+        }
+    }
+    st->columnLeft = --dptr->columnLeft[st->column];
+
+    /** trees keep whether they got their tent while some of their cells are undecided */
+    st->trees = 0;
+    for (int k = 0; k < 4; k++) {
+        if ((t = dptr->adjacentTrees[4 * x + k]) == -1) continue;
+        st->treeCloses[st->trees] = dptr->treeLeft[t] == 1;
+        st->treeSlot[st->trees] = -1;
+        if (dptr->treeSize[t] > 1) {
+            if (dptr->treeLeft[t] == dptr->treeSize[t]) {
+                dptr->treeSlots[t] = takeSlot(dptr, 1);
+                for (int l = 0; l < 4; l++) {
+                    if (dptr->treeCells[4 * t + l] != -1) addToFringe(dptr, dptr->treeCells[4 * t + l]);
+                }
+            }
+            st->treeSlot[st->trees] = dptr->treeSlots[t];
+            if (st->treeCloses[st->trees]) {
+                release[releaseCount++] = dptr->treeSlots[t];
+                releasedBits++;
+            }
+        }
+        dptr->treeLeft[t]--;
+        st->trees++;
+    }
+
+    /** decided neighbours keep their tent until their last neighbour is decided */
+    st->neighbours = 0;
+    st->released = 0;
+    for (int k = 0; k < 8; k++) {
+        if ((y = dptr->neighbours[8 * x + k]) == -1) continue;
+        if (dptr->cellLeft[y] == -1) {
+            dptr->cellLeft[x]++;
+            addToFringe(dptr, y);
+            continue;
+        }
+        st->neighbourSlot[st->neighbours++] = dptr->cellSlots[y];
+        if (--dptr->cellLeft[y] == 0) {
+            st->releasedSlot[st->released++] = dptr->cellSlots[y];
+            release[releaseCount++] = dptr->cellSlots[y];
+            releasedBits++;
+        }
+    }
+    st->ownSlot = -1;
+    if (dptr->cellLeft[x] > 0) st->ownSlot = dptr->cellSlots[x] = takeSlot(dptr, 1);
+
+    /** slots are released once the step has taken its new ones, so they never overlap */
+    if (dptr->width > DECOMPOSITION_MAX_WIDTH) return 0;
+    for (int r = 0; r < releaseCount; r++) dptr->freeSlots[dptr->freeCount++] = release[r];
+    dptr->width -= releasedBits;
+
+    return 1;
+}
+
+/**
+ * Function: takeSlot
+ * 
+ * Description: takes a free slot (or a new one) for a constraint that opens
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     int bits - bits of state taken by constraint
+ * 
+ * Return value: slot
+ */
+int takeSlot(decomposition *dptr, int bits) {
+    dptr->width += bits;
+    if (dptr->freeCount) return dptr->freeSlots[--dptr->freeCount];
+    return dptr->slots++;
+}
+
+/**
+ * Function: addToFringe
+ * 
+ * Description: adds an undecided cell to the fringe, unless it is already there
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     int x - cell
+ * 
+ * Return value: none
+ */
+void addToFringe(decomposition *dptr, int x) {
+    if (dptr->cellLeft[x] != -1 || dptr->fringePosition[x] != -1) return;
+    dptr->fringePosition[x] = dptr->fringeSize;
+    dptr->fringe[dptr->fringeSize++] = x;
+}
+
+/**
+ * Function: addGroups
+ * 
+ * Description: adds groups of the cells of a line or column that opens to the group fringe,
+ *              unless they are there or decided
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     int *start - first cell of every line (or column)
+ *     int *members - cells by line (or column)
+ *     int index - line (or column)
+ * 
+ * Return value: none
+ */
+void addGroups(decomposition *dptr, int *start, int *members, int index) {
+    int g;
+
+    for (int i = start[index]; i < start[index + 1]; i++) {
+        g = dptr->groupOf[members[i]];
+        if (dptr->groupPosition[g] != -1) continue;
+        dptr->groupPosition[g] = dptr->groupFringeSize;
+        dptr->groupFringe[dptr->groupFringeSize++] = g;
+    }
+}
+
+/**
+ * Function: groupCost
+ * 
+ * Description: finds bits of state of the lines and columns a group leaves open minus bits of
+ *              the ones it closes
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     int g - undecided group
+ * 
+ * Return value: cost of group
+ */
+int groupCost(decomposition *dptr, int g) {
+    map *mptr = dptr->mptr;
+    int cost = 0, line, column, size, x;
+
+    /** marks count the cells of every line and column in group */
+    for (int i = dptr->groupStart[g]; i < dptr->groupStart[g + 1]; i++) {
+        x = dptr->groupCells[i];
+        dptr->lineMark[dptr->cells[x].line] = 0;
+        dptr->columnMark[dptr->cells[x].column] = 0;
+    }
+    for (int i = dptr->groupStart[g]; i < dptr->groupStart[g + 1]; i++) {
+        x = dptr->groupCells[i];
+        dptr->lineMark[dptr->cells[x].line]++;
+        dptr->columnMark[dptr->cells[x].column]++;
+    }
+
+    for (int i = dptr->groupStart[g]; i < dptr->groupStart[g + 1]; i++) {
+        x = dptr->groupCells[i];
+        line = dptr->cells[x].line;
+        column = dptr->cells[x].column;
+        if (dptr->lineMark[line] > 0) {
+            size = dptr->lineStart[line + 1] - dptr->lineStart[line];
+            if (dptr->lineLeft[line] == size && dptr->lineMark[line] < size) cost += hintBits(getTentsInLine(mptr, line));
+            if (dptr->lineLeft[line] < size && dptr->lineMark[line] == dptr->lineLeft[line]) cost -= hintBits(getTentsInLine(mptr, line));
+            dptr->lineMark[line] = 0;
+        }
+        if (dptr->columnMark[column] > 0) {
+            size = dptr->columnStart[column + 1] - dptr->columnStart[column];
+            if (dptr->columnLeft[column] == size && dptr->columnMark[column] < size) cost += hintBits(getTentsInColumn(mptr, column));
+            if (dptr->columnLeft[column] < size && dptr->columnMark[column] == dptr->columnLeft[column]) cost -= hintBits(getTentsInColumn(mptr, column));
+            dptr->columnMark[column] = 0;
+        }
+    }
+
+    return cost;
+}
+
+/**
+ * Function: cellCost
+ * 
+ * Description: finds bits of state opened minus bits closed by deciding a cell next
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     int x - undecided cell
+ * 
+ * Return value: cost of cell
+ */
+int cellCost(decomposition *dptr, int x) {
+    map *mptr = dptr->mptr;
+    int line = dptr->cells[x].line, column = dptr->cells[x].column, cost = 0, size, t, y;
+
+    size = dptr->lineStart[line + 1] - dptr->lineStart[line];
+    if (size > 1 && dptr->lineLeft[line] == size) cost += hintBits(getTentsInLine(mptr, line));
+    if (size > 1 && dptr->lineLeft[line] == 1) cost -= hintBits(getTentsInLine(mptr, line));
+
+    size = dptr->columnStart[column + 1] - dptr->columnStart[column];
+    if (size > 1 && dptr->columnLeft[column] == size) cost += hintBits(getTentsInColumn(mptr, column));
+    if (size > 1 && dptr->columnLeft[column] == 1) cost -= hintBits(getTentsInColumn(mptr, column));
+
+    for (int k = 0; k < 4; k++) {
+        if ((t = dptr->adjacentTrees[4 * x + k]) == -1) continue;
+        size = dptr->treeSize[t];
+        if (size > 1 && dptr->treeLeft[t] == size) cost++;
+        if (size > 1 && dptr->treeLeft[t] == 1) cost--;
+    }
+
+    size = 0;
+    for (int k = 0; k < 8; k++) {
+        if ((y = dptr->neighbours[8 * x + k]) == -1) continue;
+        if (dptr->cellLeft[y] == -1)
+            size++;
+        else if (dptr->cellLeft[y] == 1)
+            cost--;
+    }
+    if (size) cost++;
+
+    return cost;
+}
+
+/**
+ * Function: hintBits
+ * 
+ * Description: finds bits needed by a count from 0 to hint
+ * 
+ * Arguments:
+ *     int hint - hint
+ * 
+ * Return value: number of bits
+ */
+int hintBits(int hint) {
+    int bits = 1;
+
+    while (bits < 31 && (1 << bits) <= hint) bits++;
+
+    return bits;
+}
+
+/**
+ * Function: advanceState
+ * 
+ * Description: stores the states reached from a state deciding the cell of a step as grass or
+ *              as a tent of every free tree around it
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     step *st - step
+ *     int parent - number of state in current layer
+ *     unsigned short *key - state
+ *     unsigned short *work - buffer for new states
+ * 
+ * Return value: none
+ */
+void advanceState(decomposition *dptr, step *st, int parent, unsigned short *key, unsigned short *work) {
+    int lineHint = getTentsInLine(dptr->mptr, st->line), columnHint = getTentsInColumn(dptr->mptr, st->column);
+    int lineCount = st->lineSlot == -1 ? 0 : key[st->lineSlot];
+    int columnCount = st->columnSlot == -1 ? 0 : key[st->columnSlot];
+    int used[4];
+
+    for (int i = 0; i < st->trees; i++) used[i] = st->treeSlot[i] == -1 ? 0 : key[st->treeSlot[i]];
+
+    /** grass, as long as the cells left can still meet line and column hints */
+    if (lineCount + st->lineLeft >= lineHint && columnCount + st->columnLeft >= columnHint)
+        storeDecision(dptr, st, parent, key, work, lineCount, columnCount, used, 0);
+
+    if (lineCount + 1 > lineHint || lineCount + 1 + st->lineLeft < lineHint) return;
+    if (columnCount + 1 > columnHint || columnCount + 1 + st->columnLeft < columnHint) return;
+    for (int i = 0; i < st->neighbours; i++) {
+        if (key[st->neighbourSlot[i]]) return;
+    }
+
+    for (int i = 0; i < st->trees; i++) {
+        if (used[i]) continue;
+        used[i] = 1;
+        storeDecision(dptr, st, parent, key, work, lineCount + 1, columnCount + 1, used, 1);
+        used[i] = 0;
+    }
+}
+
+/**
+ * Function: storeDecision
+ * 
+ * Description: merges the state reached by a decision into next layer, unless a tree without
+ *              tent closes in high season
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ *     step *st - step
+ *     int parent - number of state in current layer
+ *     unsigned short *key - state
+ *     unsigned short *work - buffer for new state
+ *     int lineCount - tents of line after decision
+ *     int columnCount - tents of column after decision
+ *     int *used - whether every tree around has got its tent after decision
+ *     int tent - 1 if cell is a tent, 0 if grass
+ * 
+ * Return value: none
+ */
+void storeDecision(decomposition *dptr, step *st, int parent, unsigned short *key, unsigned short *work, int lineCount, int columnCount, int *used, int tent) {
+    int index;
+
+    memcpy(work, key, dptr->keySize);
+    for (int i = 0; i < st->trees; i++) {
+        if (st->treeCloses[i] && dptr->highSeason && !used[i]) return;
+        if (st->treeSlot[i] != -1) work[st->treeSlot[i]] = st->treeCloses[i] ? 0 : used[i];
+    }
+    if (st->lineSlot != -1) work[st->lineSlot] = st->lineLeft ? lineCount : 0;
+    if (st->columnSlot != -1) work[st->columnSlot] = st->columnLeft ? columnCount : 0;
+    if (st->ownSlot != -1) work[st->ownSlot] = tent;
+    for (int i = 0; i < st->released; i++) work[st->releasedSlot[i]] = 0;
+
+    if (!insertKey(dptr->next, work, &index)) return;
+    if ((long) index * dptr->keySize >= DECOMPOSITION_MAX_LAYER_BYTES || dptr->historySize >= DECOMPOSITION_MAX_HISTORY) {
+        dptr->overflow = 1;
+        return;
+    }
+
+    if (dptr->historySize == dptr->historyCapacity) {
+        dptr->historyCapacity = dptr->historyCapacity ? 2 * dptr->historyCapacity : 1024;
+        dptr->parents = (int *) realloc(dptr->parents, dptr->historyCapacity * sizeof(int));
+        dptr->decisions = (unsigned char *) realloc(dptr->decisions, dptr->historyCapacity);
+        if (dptr->parents == NULL || dptr->decisions == NULL) exit(EXIT_FAILURE);
+    }
+    dptr->parents[dptr->historySize] = parent;
+    dptr->decisions[dptr->historySize] = (unsigned char) tent;
+    dptr->historySize++;
+}
+
+/**
+ * Function: deleteDecomposition
+ * 
+ * Description: frees memory held by decomposition
+ * 
+ * Arguments:
+ *     decomposition *dptr - decomposition
+ * 
+ * Return value: none
+ */
+void deleteDecomposition(decomposition *dptr) {
+    free(dptr->neighbours);
+    free(dptr->adjacentTrees);
+    free(dptr->treeCells);
+    free(dptr->treeSize);
+    free(dptr->lineStart);
+    free(dptr->lineCells);
+    free(dptr->columnStart);
+    free(dptr->columnCells);
+    free(dptr->cellLeft);
+    free(dptr->treeLeft);
+    free(dptr->lineLeft);
+    free(dptr->columnLeft);
+    free(dptr->fringe);
+    free(dptr->fringePosition);
+    free(dptr->groupOf);
+    free(dptr->groupStart);
+    free(dptr->groupCells);
+    free(dptr->groupFringe);
+    free(dptr->groupPosition);
+    free(dptr->lineMark);
+    free(dptr->columnMark);
+    free(dptr->lineSlots);
+    free(dptr->columnSlots);
+    free(dptr->treeSlots);
+    free(dptr->cellSlots);
+    free(dptr->steps);
+    free(dptr->parents);
+    free(dptr->decisions);
+    if (dptr->current != NULL) deleteTable(dptr->current);
+    if (dptr->next != NULL) deleteTable(dptr->next);
+}
@@ -0,0 +1,58 @@
+/**
+ * Filename: decomposition.h
+ * 
+ * Description: tree decomposition dynamic programming engine for maps with few trees
+ */
+
+#ifndef DECOMPOSITION_H
+#define DECOMPOSITION_H
+
+#include "map.h"
+#include "search.h"
+
+/** maps with more than one tree in DECOMPOSITION_MIN_SPREAD cells are left to other engines */
+#define DECOMPOSITION_MIN_SPREAD 16
+#define DECOMPOSITION_GAVE_UP -1
+
+/**
+ * Function: decompositionFits
+ * 
+ * Description: checks if trees of a preprocessed map are spread enough for the decomposition
+ *              engine, i.e. map is sparse or has few trees for its area
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (preprocessed)
+ * 
+ * Return value:
+ *     1 - if decomposition engine may be used
+ *     0 - otherwise
+ */
+int decompositionFits(map *mptr);
+
+/**
+ * Function: decompositionSolve
+ * 
+ * Description: solves a preprocessed map deciding its uncertain cells in an elimination order
+ *              picked greedily so that few constraints are open at once. A constraint is open
+ *              while some of its cells are decided and some are not: a state holds the tent
+ *              of every decided cell with undecided neighbours, whether every open tree has
+ *              got its tent and the tents placed so far in every open line and column. Equal
+ *              states are merged, so independent groups of trees are solved one after another
+ *              and the time is polynomial in the number of trees for a bounded width. Gives up
+ *              before any search if the width (bits of state) of the order is too large
+ * 
+ * Side-effects: writes solution for mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (preprocessed)
+ *     workspace *wptr - workspace with uncertain and tree arrays
+ *     int *cancel - search stops once it is set by another thread (NULL if never)
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     0 - if map is impossible
+ *     DECOMPOSITION_GAVE_UP - if map is too wide, has too many states or search was cancelled
+ */
+int decompositionSolve(map *mptr, workspace *wptr, int *cancel);
+
+#endif
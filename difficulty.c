@@ -0,0 +1,348 @@
+/**
+ * Filename: difficulty.c
+ * 
+ * Description: Cost model estimating, from cheap features of a preprocessed map, how long
+ *              every route of the solver would take on it
+ * 
+ * A model is linear per route: the log2 of the microseconds a route takes is predicted as the
+ * dot product of its weights with the features of the map.
+ */
+
+#include "difficulty.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** maps a route must be timed on before its weights are fitted instead of built in */
+#define TRAIN_MIN_MAPS (2 * FEATURE_COUNT)
+
+/** added to the diagonal of the normal equations, so that features constant in a stats file get no weight */
+#define TRAIN_RIDGE 1e-3
+
+struct costModelStruct {
+    double weights[ROUTE_COUNT][FEATURE_COUNT];
+};
+
+char *routeNames[ROUTE_COUNT] = {"profile", "decomposition", "lines", "constrained"};
+
+char *featureNames[FEATURE_COUNT] = {
+    "bias",
+    "cells",
+    "trees",
+    "uncertains",
+    "candidates",
+    "forced",
+    "slack",
+    "lowseason",
+    "components",
+    "largest",
+    "density",
+    "width"
+};
+
+/** weights of profile, decomposition, lines and constrained, fitted on stats of about 1200 random maps up to 60 by 60 (features in featureNames order) */
+costModel builtinModel = {{
+    {-15.0879, 0.5064, 5.1413, -6.1217, 7.2645, 2.1560, -8.1088, 0.6053, 4.6251, 0.0288, -6.6083, -0.7278},
+    {-7.9161, -3.0159, 8.1108, -8.7112, 12.9749, 4.5786, -14.1758, 1.4069, 7.7168, 0.0094, -2.6356, -0.3740},
+    {-16.6034, 0.0008, 6.2859, -6.2813, 7.8133, 2.3214, -10.0316, 0.4621, 4.8670, 0.0287, -6.4551, -0.4898},
+    {-20.2385, -0.4445, 5.0023, -4.1093, 9.9483, 4.0359, -13.9465, 0.5712, 4.5457, 0.0323, -7.7034, -0.3392}
+}};
+
+double predictCost(const costModel *model, int route, mapFeatures *fptr);
+int findRoute(char *name);
+int solveLinearSystem(double *matrix, double *vector, int size);
+
+/**
+ * Function: loadCostModel
+ * 
+ * Description: reads a cost model written by trainCostModel, routes it leaves out keep the
+ *              built-in weights
+ * 
+ * Arguments:
+ *     char *filename - name of model file
+ * 
+ * Return value:
+ *     pointer to new model if successful
+ *     NULL if file can't be opened or is malformed
+ */
+costModel *loadCostModel(char *filename) {
+    costModel *model;
+    FILE *fp;
+    char name[64];
+    int route, ok = 1, c;
+
+    fp = fopen(filename, "r");
+    if (fp == NULL) return NULL;
+
+    model = (costModel *) malloc(sizeof(costModel));
+    if (model == NULL) exit(EXIT_FAILURE);
+    *model = builtinModel;
+
+    while (ok && fscanf(fp, " %63s", name) == 1) {
+        if (name[0] == '#') {
+            while ((c = getc(fp)) != EOF && c != '\n');
+            continue;
+        }
+
+        route = findRoute(name);
+        if (route < 0) ok = 0;
+        for (int k = 0; ok && k < FEATURE_COUNT; k++) ok = fscanf(fp, "%lf", &model->weights[route][k]) == 1;
+    }
+    fclose(fp);
+
+    if (!ok) {
+        free(model);
+        return NULL;
+    }
+
+    return model;
+}
+
+/**
+ * Function: deleteCostModel
+ * 
+ * Description: deletes a cost model
+ * 
+ * Arguments:
+ *     costModel *model - pointer to model to be deleted (or NULL)
+ * 
+ * Return value: none
+ */
+void deleteCostModel(costModel *model) {
+    free(model);
+}
+
+/**
+ * Function: cheapestRoute
+ * 
+ * Description: predicts the time of every route that fits a map and picks the cheapest
+ * 
+ * Arguments:
+ *     const costModel *model - model pointer (NULL for the built-in model)
+ *     mapFeatures *fptr - features of map
+ * 
+ * Return value:
+ *     route with the lowest predicted time (ROUTE_LINES if no other route fits)
+ */
+int cheapestRoute(const costModel *model, mapFeatures *fptr) {
+    int best = ROUTE_LINES;
+    double cost, bestCost = predictCost(model, ROUTE_LINES, fptr);
+
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        if (r == ROUTE_LINES || !fptr->fits[r]) continue;
+        cost = predictCost(model, r, fptr);
+        if (cost < bestCost) {
+            best = r;
+            bestCost = cost;
+        }
+    }
+
+    return best;
+}
+
+/**
+ * Function: predictCost
+ * 
+ * Description: predicts the log2 of the microseconds a route takes on a map
+ * 
+ * Arguments:
+ *     const costModel *model - model pointer (NULL for the built-in model)
+ *     int route - route
+ *     mapFeatures *fptr - features of map
+ * 
+ * Return value:
+ *     predicted cost
+ */
+double predictCost(const costModel *model, int route, mapFeatures *fptr) {
+    double cost = 0;
+
+    if (model == NULL) model = &builtinModel;
+    for (int k = 0; k < FEATURE_COUNT; k++) cost += model->weights[route][k] * fptr->values[k];
+
+    return cost;
+}
+
+/**
+ * Function: findRoute
+ * 
+ * Description: finds a route by its name
+ * 
+ * Arguments:
+ *     char *name - name of route
+ * 
+ * Return value:
+ *     route
+ *     -1 if there is no route with that name
+ */
+int findRoute(char *name) {
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        if (!strcmp(name, routeNames[r])) return r;
+    }
+
+    return -1;
+}
+
+/**
+ * Function: writeStatsHeader
+ * 
+ * Description: writes a comment line naming the columns of a stats file
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ * 
+ * Return value: none
+ */
+void writeStatsHeader(FILE *fp) {
+    fprintf(fp, "# lines columns result");
+    for (int k = 0; k < FEATURE_COUNT; k++) fprintf(fp, " %s", featureNames[k]);
+    for (int r = 0; r < ROUTE_COUNT; r++) fprintf(fp, " %s", routeNames[r]);
+    fprintf(fp, "\n");
+}
+
+/**
+ * Function: writeStats
+ * 
+ * Description: writes a line "lines columns result features seconds" for a benchmarked map,
+ *              with the seconds taken by every route ('-' for routes that do not fit it)
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int result - result of map
+ *     mapFeatures *fptr - features of map
+ *     double *seconds - seconds taken by every route
+ * 
+ * Return value: none
+ */
+void writeStats(FILE *fp, int lines, int columns, int result, mapFeatures *fptr, double *seconds) {
+    fprintf(fp, "%d %d %d", lines, columns, result);
+    for (int k = 0; k < FEATURE_COUNT; k++) fprintf(fp, " %.6g", fptr->values[k]);
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        if (fptr->fits[r])
+            fprintf(fp, " %.6f", seconds[r]);
+        else
+            fprintf(fp, " -");
+    }
+    fprintf(fp, "\n");
+
+    /** maps take seconds each, lines are flushed so that an interrupted run keeps them */
+    fflush(fp);
+}
+
+/**
+ * Function: trainCostModel
+ * 
+ * Description: fits the weights of every route by least squares on the logarithm of the
+ *              times of a stats file and writes them as a model file. Routes timed on too few
+ *              maps keep the built-in weights
+ * 
+ * Arguments:
+ *     FILE *fpStats - stats file written by --stats
+ *     FILE *fpModel - file where the model is written
+ * 
+ * Return value:
+ *     number of maps read
+ */
+long trainCostModel(FILE *fpStats, FILE *fpModel) {
+    double matrix[ROUTE_COUNT][FEATURE_COUNT * FEATURE_COUNT] = {{0}}, vector[ROUTE_COUNT][FEATURE_COUNT] = {{0}};
+    double features[FEATURE_COUNT], target;
+    long samples[ROUTE_COUNT] = {0}, maps = 0;
+    int lines, columns, result, ok, c;
+    char time[64];
+
+    while ((c = getc(fpStats)) != EOF) {
+        if (c == '#' || c == '\n') {
+            while (c != '\n' && (c = getc(fpStats)) != EOF);
+            continue;
+        }
+        ungetc(c, fpStats);
+
+        ok = fscanf(fpStats, "%d %d %d", &lines, &columns, &result) == 3;
+        for (int k = 0; ok && k < FEATURE_COUNT; k++) ok = fscanf(fpStats, "%lf", &features[k]) == 1;
+        if (!ok) break;
+        maps++;
+
+        for (int r = 0; r < ROUTE_COUNT && fscanf(fpStats, " %63s", time) == 1; r++) {
+            if (time[0] == '-') continue;
+            target = log2(1e6 * atof(time) + 1);
+            for (int i = 0; i < FEATURE_COUNT; i++) {
+                for (int j = 0; j < FEATURE_COUNT; j++) matrix[r][i * FEATURE_COUNT + j] += features[i] * features[j];
+                vector[r][i] += features[i] * target;
+            }
+            samples[r]++;
+        }
+        while ((c = getc(fpStats)) != EOF && c != '\n');
+    }
+
+    fprintf(fpModel, "# route, weights of log2 microseconds:");
+    for (int k = 0; k < FEATURE_COUNT; k++) fprintf(fpModel, " %s", featureNames[k]);
+    fprintf(fpModel, "\n");
+
+    for (int r = 0; r < ROUTE_COUNT; r++) {
+        for (int i = 0; i < FEATURE_COUNT; i++) matrix[r][i * FEATURE_COUNT + i] += TRAIN_RIDGE * (samples[r] + 1);
+
+        if (samples[r] < TRAIN_MIN_MAPS || !solveLinearSystem(matrix[r], vector[r], FEATURE_COUNT)) {
+            fprintf(fpModel, "# %s timed on %ld maps, built-in weights kept\n", routeNames[r], samples[r]);
+            memcpy(vector[r], builtinModel.weights[r], sizeof(vector[r]));
+        }
+
+        fprintf(fpModel, "%s", routeNames[r]);
+        for (int k = 0; k < FEATURE_COUNT; k++) fprintf(fpModel, " %.9g", vector[r][k]);
+        fprintf(fpModel, "\n");
+    }
+
+    return maps;
+}
+
+/**
+ * Function: solveLinearSystem
+ * 
+ * Description: solves a square linear system by Gaussian elimination with partial pivoting
+ * 
+ * Side-effects: destroys matrix, vector is replaced by the solution
+ * 
+ * Arguments:
+ *     double *matrix - coefficients, row by row
+ *     double *vector - right hand side, returns solution
+ *     int size - number of unknowns
+ * 
+ * Return value:
+ *     1 - if system was solved
+ *     0 - if matrix is singular
+ */
+int solveLinearSystem(double *matrix, double *vector, int size) {
+    double factor, swap;
+    int pivot;
+
+    for (int k = 0; k < size; k++) {
+        pivot = k;
+        for (int i = k + 1; i < size; i++) {
+            if (fabs(matrix[i * size + k]) > fabs(matrix[pivot * size + k])) pivot = i;
+        }
+        if (fabs(matrix[pivot * size + k]) < 1e-12) return 0;
+
+        for (int j = 0; j < size; j++) {
+            swap = matrix[k * size + j];
+            matrix[k * size + j] = matrix[pivot * size + j];
+            matrix[pivot * size + j] = swap;
+        }
+        swap = vector[k];
+        vector[k] = vector[pivot];
+        vector[pivot] = swap;
+
+        for (int i = k + 1; i < size; i++) {
+            factor = matrix[i * size + k] / matrix[k * size + k];
+            for (int j = k; j < size; j++) matrix[i * size + j] -= factor * matrix[k * size + j];
+            vector[i] -= factor * vector[k];
+        }
+    }
+
+    for (int k = size - 1; k >= 0; k--) {
+        for (int j = k + 1; j < size; j++) vector[k] -= matrix[k * size + j] * vector[j];
+        vector[k] /= matrix[k * size + k];
+    }
+
+    return 1;
+}
@@ -0,0 +1,133 @@
+/**
+ * Filename: difficulty.h
+ * 
+ * Description: Cost model estimating, from cheap features of a preprocessed map, how long
+ *              every route of the solver would take on it
+ */
+
+#ifndef DIFFICULTY_H
+#define DIFFICULTY_H
+
+#include <stdio.h>
+
+/** routes of the solver: profile engine, decomposition engine, backtracking by lines or most constrained cells first */
+#define ROUTE_PROFILE 0
+#define ROUTE_DECOMPOSITION 1
+#define ROUTE_LINES 2
+#define ROUTE_CONSTRAINED 3
+#define ROUTE_COUNT 4
+
+/** features of a map, the first one is always 1 so that models have a constant term */
+#define FEATURE_BIAS 0
+#define FEATURE_CELLS 1
+#define FEATURE_TREES 2
+#define FEATURE_UNCERTAINS 3
+#define FEATURE_CANDIDATES 4
+#define FEATURE_FORCED 5
+#define FEATURE_SLACK 6
+#define FEATURE_LOW_SEASON 7
+#define FEATURE_COMPONENTS 8
+#define FEATURE_LARGEST 9
+#define FEATURE_DENSITY 10
+#define FEATURE_WIDTH 11
+#define FEATURE_COUNT 12
+
+typedef struct costModelStruct costModel;
+
+/**
+ * Features of a preprocessed map (see featureNames for their meaning) and the routes that may
+ * be used on it
+ */
+typedef struct {
+    double values[FEATURE_COUNT];
+    int fits[ROUTE_COUNT];
+} mapFeatures;
+
+/**
+ * Function: loadCostModel
+ * 
+ * Description: reads a cost model written by trainCostModel, routes it leaves out keep the
+ *              built-in weights
+ * 
+ * Arguments:
+ *     char *filename - name of model file
+ * 
+ * Return value:
+ *     pointer to new model if successful
+ *     NULL if file can't be opened or is malformed
+ */
+costModel *loadCostModel(char *filename);
+
+/**
+ * Function: deleteCostModel
+ * 
+ * Description: deletes a cost model
+ * 
+ * Arguments:
+ *     costModel *model - pointer to model to be deleted (or NULL)
+ * 
+ * Return value: none
+ */
+void deleteCostModel(costModel *model);
+
+/**
+ * Function: cheapestRoute
+ * 
+ * Description: predicts the time of every route that fits a map and picks the cheapest
+ * 
+ * Arguments:
+ *     const costModel *model - model pointer (NULL for the built-in model)
+ *     mapFeatures *fptr - features of map
+ * 
+ * Return value:
+ *     route with the lowest predicted time (ROUTE_LINES if no other route fits)
+ */
+int cheapestRoute(const costModel *model, mapFeatures *fptr);
+
+/**
+ * Function: writeStatsHeader
+ * 
+ * Description: writes a comment line naming the columns of a stats file
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ * 
+ * Return value: none
+ */
+void writeStatsHeader(FILE *fp);
+
+/**
+ * Function: writeStats
+ * 
+ * Description: writes a line "lines columns result features seconds" for a benchmarked map,
+ *              with the seconds taken by every route ('-' for routes that do not fit it)
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int result - result of map
+ *     mapFeatures *fptr - features of map
+ *     double *seconds - seconds taken by every route
+ * 
+ * Return value: none
+ */
+void writeStats(FILE *fp, int lines, int columns, int result, mapFeatures *fptr, double *seconds);
+
+/**
+ * Function: trainCostModel
+ * 
+ * Description: fits the weights of every route by least squares on the logarithm of the
+ *              times of a stats file and writes them as a model file. Routes timed on too few
+ *              maps keep the built-in weights
+ * 
+ * Arguments:
+ *     FILE *fpStats - stats file written by --stats
+ *     FILE *fpModel - file where the model is written
+ * 
+ * Return value:
+ *     number of maps read
+ */
+long trainCostModel(FILE *fpStats, FILE *fpModel);
+
+#endif
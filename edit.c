@@ -0,0 +1,671 @@
+/**
+ * Filename: edit.c
+ * 
+ * Description: Incremental re-solving of a solved map after small edits
+ */
+
+#include "edit.h"
+#include <stdlib.h>
+#include <string.h>
+#include "kernels.h"
+#include "map.h"
+#include "search.h"
+#include "solver.h"
+
+/** repairs search cells within this distance of the edits first, doubling it on every failure */
+#define REPAIR_FIRST_RADIUS 2
+
+/** windows over more than one cell in REPAIR_MAX_SHARE are left to the full solver */
+#define REPAIR_MAX_SHARE 4
+
+struct {
+    int dx;
+    int dy;
+} editOrtogonals[] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+
+/**
+ * The workspace keeps the trees of the map in line order with the tent linked to each of
+ * them whenever solved is set, i.e. while the map holds a solution for the map before the
+ * edits in the dirty lines and columns. The grid is saved in grid before every search, so a
+ * failed one leaves the map as it was. Dirty ranges are empty when top > bottom (or
+ * left > right), an empty range of lines (columns) with a non empty range of columns (lines)
+ * stands for every line (column), as after changing a column (line) hint.
+ */
+struct editorStruct {
+    map *mptr;
+    workspace *wptr;
+    char *grid;
+    int solved;
+    int columnSum;
+    int dirtyTop;
+    int dirtyBottom;
+    int dirtyLeft;
+    int dirtyRight;
+};
+
+int collectTrees(editor *eptr);
+void saveGrid(editor *eptr);
+void restoreGrid(editor *eptr);
+void markDirty(editor *eptr, int line, int column);
+void clearDirty(editor *eptr);
+int resolveEdited(editor *eptr);
+int repairWindow(editor *eptr, int top, int bottom, int left, int right);
+int nextToTree(map *mptr, int line, int column);
+int solveFromScratch(editor *eptr);
+void matchTents(editor *eptr);
+void unlinkCell(editor *eptr, int line, int column);
+void growTrees(workspace *wptr, int treesNumber);
+
+/**
+ * Function: newEditor
+ * 
+ * Description: starts editing a map already solved by solveMap, keeping its tree array and
+ *              the tree of every tent so that later edits only search around the cells they
+ *              changed
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (still owned by caller, must outlive the editor)
+ *     int result - value returned by solveMap for mptr
+ * 
+ * Return value:
+ *     pointer to new editor if successful
+ *     NULL if error ocurred
+ */
+editor *newEditor(map *mptr, int result) {
+    editor *eptr;
+
+    eptr = (editor *) malloc(sizeof(editor));
+    if (eptr == NULL) return NULL;
+
+    eptr->wptr = newWorkspace();
+    if (eptr->wptr == NULL) {
+        free(eptr);
+        return NULL;
+    }
+
+    eptr->grid = (char *) malloc(((size_t) getMapLines(mptr) * getMapColumns(mptr) + 1) * sizeof(char));
+    if (eptr->grid == NULL) {
+        deleteWorkspace(eptr->wptr);
+        free(eptr);
+        return NULL;
+    }
+
+    eptr->mptr = mptr;
+    eptr->columnSum = 0;
+    for (int j = 0; j < getMapColumns(mptr); j++) {
+        eptr->columnSum += getTentsInColumn(mptr, j);
+    }
+    clearDirty(eptr);
+
+    /** solveMap may give up before counting trees, so they are always counted again */
+    collectTrees(eptr);
+    eptr->solved = result == 1;
+    if (eptr->solved) matchTents(eptr);
+
+    return eptr;
+}
+
+/**
+ * Function: deleteEditor
+ * 
+ * Description: deletes an editor (but not its map)
+ * 
+ * Arguments:
+ *     editor *eptr - pointer to editor to be deleted
+ * 
+ * Return value: none
+ */
+void deleteEditor(editor *eptr) {
+    deleteWorkspace(eptr->wptr);
+    free(eptr->grid);
+    free(eptr);
+}
+
+/**
+ * Function: addTree
+ * 
+ * Description: places a tree on a cell and solves the edited map, repairing the previous
+ *              solution around the edits first and only searching the whole map if no repair
+ *              is found
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible
+ */
+int addTree(editor *eptr, int line, int column) {
+    map *mptr = eptr->mptr;
+    workspace *wptr = eptr->wptr;
+    int treesNumber = getTreesNumber(mptr), index;
+
+    if (getContentOfPosition(mptr, line, column) == 'A') return resolveEdited(eptr);
+
+    if (eptr->solved) {
+        /** a tent on the cell is gone, so is any link to it */
+        unlinkCell(eptr, line, column);
+        growTrees(wptr, treesNumber + 1);
+        index = findTreeIndex(wptr, treesNumber, line, column);
+        memmove(wptr->treeArray + index + 1, wptr->treeArray + index, (treesNumber - index) * sizeof(cell));
+        memmove(wptr->links + index + 1, wptr->links + index, (treesNumber - index) * sizeof(cell));
+        wptr->treeArray[index].line = line;
+        wptr->treeArray[index].column = column;
+        wptr->links[index].line = -1;
+        wptr->links[index].column = -1;
+    }
+
+    setContentOfPosition(mptr, line, column, 'A');
+    setTreesNumber(mptr, treesNumber + 1);
+    markDirty(eptr, line, column);
+
+    return resolveEdited(eptr);
+}
+
+/**
+ * Function: removeTree
+ * 
+ * Description: removes a tree from a cell and solves the edited map like addTree
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible
+ */
+int removeTree(editor *eptr, int line, int column) {
+    map *mptr = eptr->mptr;
+    workspace *wptr = eptr->wptr;
+    int treesNumber = getTreesNumber(mptr), index;
+
+    if (getContentOfPosition(mptr, line, column) != 'A') return resolveEdited(eptr);
+
+    /** a tent linked to the tree is next to it, so repairs always search it again */
+    if (eptr->solved) {
+        index = findTreeIndex(wptr, treesNumber, line, column);
+        memmove(wptr->treeArray + index, wptr->treeArray + index + 1, (treesNumber - index - 1) * sizeof(cell));
+        memmove(wptr->links + index, wptr->links + index + 1, (treesNumber - index - 1) * sizeof(cell));
+    }
+
+    setContentOfPosition(mptr, line, column, '.');
+    setTreesNumber(mptr, treesNumber - 1);
+    markDirty(eptr, line, column);
+
+    return resolveEdited(eptr);
+}
+
+/**
+ * Function: changeLineHint
+ * 
+ * Description: changes number of tents in a line and solves the edited map like addTree.
+ *              While line and column hints add up to different totals the map is impossible
+ *              without any search, so a line and a column can be changed one after the other
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - number of line
+ *     int tents - number of tents in line (negative hints are not applied)
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible or line is out of the map (the edit is not applied)
+ */
+int changeLineHint(editor *eptr, int line, int tents) {
+    map *mptr = eptr->mptr;
+
+    if (line < 0 || line >= getMapLines(mptr) || tents < 0) return -1;
+
+    setTentsNumber(mptr, getTentsNumber(mptr) - getTentsInLine(mptr, line) + tents);
+    setTentsInLine(mptr, line, tents);
+    markDirty(eptr, line, -1);
+
+    return resolveEdited(eptr);
+}
+
+/**
+ * Function: changeColumnHint
+ * 
+ * Description: changes number of tents in a column and solves the edited map like
+ *              changeLineHint
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int column - number of column
+ *     int tents - number of tents in column (negative hints are not applied)
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible or column is out of the map (the edit is not applied)
+ */
+int changeColumnHint(editor *eptr, int column, int tents) {
+    map *mptr = eptr->mptr;
+
+    if (column < 0 || column >= getMapColumns(mptr) || tents < 0) return -1;
+
+    eptr->columnSum += tents - getTentsInColumn(mptr, column);
+    setTentsInColumn(mptr, column, tents);
+    markDirty(eptr, -1, column);
+
+    return resolveEdited(eptr);
+}
+
+/**
+ * Function: markDirty
+ * 
+ * Description: adds a line and a column to the ranges changed since the last solution
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - line changed (-1 for none)
+ *     int column - column changed (-1 for none)
+ * 
+ * Return value: none
+ */
+void markDirty(editor *eptr, int line, int column) {
+    if (line >= 0) {
+        if (line < eptr->dirtyTop) eptr->dirtyTop = line;
+        if (line > eptr->dirtyBottom) eptr->dirtyBottom = line;
+    }
+    if (column >= 0) {
+        if (column < eptr->dirtyLeft) eptr->dirtyLeft = column;
+        if (column > eptr->dirtyRight) eptr->dirtyRight = column;
+    }
+}
+
+/**
+ * Function: clearDirty
+ * 
+ * Description: empties the ranges of lines and columns changed since the last solution
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ * 
+ * Return value: none
+ */
+void clearDirty(editor *eptr) {
+    eptr->dirtyTop = getMapLines(eptr->mptr);
+    eptr->dirtyBottom = -1;
+    eptr->dirtyLeft = getMapColumns(eptr->mptr);
+    eptr->dirtyRight = -1;
+}
+
+/**
+ * Function: resolveEdited
+ * 
+ * Description: solves the edited map. Maps whose hints do not add up or with fewer trees than
+ *              tents are impossible and keep the previous solution for later edits. Otherwise
+ *              the cells around the edits are searched again with the rest of the previous
+ *              solution fixed, in windows growing until they cover a good share of the map,
+ *              where the map is solved from scratch (with the engines a window search lacks)
+ * 
+ * Side-effects: writes solution for the edited map, an impossible one keeps its grid
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible
+ */
+int resolveEdited(editor *eptr) {
+    map *mptr = eptr->mptr;
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr);
+    int top, bottom, left, right;
+
+    if (getTentsNumber(mptr) != eptr->columnSum || getTreesNumber(mptr) < getTentsNumber(mptr)) return -1;
+    if (eptr->solved && eptr->dirtyTop > eptr->dirtyBottom && eptr->dirtyLeft > eptr->dirtyRight) return 1;
+
+    saveGrid(eptr);
+    if (!eptr->solved) return solveFromScratch(eptr);
+
+    for (int radius = REPAIR_FIRST_RADIUS;; radius *= 2) {
+        top = 0;
+        bottom = lines - 1;
+        left = 0;
+        right = columns - 1;
+        if (eptr->dirtyTop <= eptr->dirtyBottom) {
+            if (eptr->dirtyTop - radius > top) top = eptr->dirtyTop - radius;
+            if (eptr->dirtyBottom + radius < bottom) bottom = eptr->dirtyBottom + radius;
+        }
+        if (eptr->dirtyLeft <= eptr->dirtyRight) {
+            if (eptr->dirtyLeft - radius > left) left = eptr->dirtyLeft - radius;
+            if (eptr->dirtyRight + radius < right) right = eptr->dirtyRight + radius;
+        }
+        if ((long) (bottom - top + 1) * (right - left + 1) * REPAIR_MAX_SHARE > (long) lines * columns) return solveFromScratch(eptr);
+
+        if (repairWindow(eptr, top, bottom, left, right)) {
+            clearDirty(eptr);
+            return 1;
+        }
+    }
+}
+
+/**
+ * Function: repairWindow
+ * 
+ * Description: searches again the cells of a window, keeping tents and grass outside it.
+ *              Lines and columns crossing the window must still be able to meet their hints
+ *              and, in high season, trees next to it must keep a cell for their tent. Tents
+ *              outside the window keep their links, so they may still be moved to other trees
+ * 
+ * Side-effects: writes solution for mptr if found, otherwise leaves the window uncertain
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int top - first line of window
+ *     int bottom - last line of window
+ *     int left - first column of window
+ *     int right - last column of window
+ * 
+ * Return value:
+ *     1 - if a solution was found
+ *     0 - if there is no solution with the cells outside the window kept
+ */
+int repairWindow(editor *eptr, int top, int bottom, int left, int right) {
+    map *mptr = eptr->mptr;
+    workspace *wptr = eptr->wptr;
+    int count = 0, tents, uncertain, isolated;
+    search search;
+    char c;
+
+    reserveArrays(wptr, (bottom - top + 1) * (right - left + 1), getTreesNumber(mptr));
+
+    for (int i = top; i <= bottom; i++) {
+        for (int j = left; j <= right; j++) {
+            if (getContentOfPosition(mptr, i, j) == 'A') continue;
+            if (getTentsInLine(mptr, i) && getTentsInColumn(mptr, j) && nextToTree(mptr, i, j)) {
+                setContentOfPosition(mptr, i, j, 'U');
+                wptr->uncertainArray[count].line = i;
+                wptr->uncertainArray[count].column = j;
+                count++;
+            } else {
+                setContentOfPosition(mptr, i, j, '.');
+            }
+        }
+    }
+
+    for (int i = top; i <= bottom; i++) {
+        tents = 0;
+        uncertain = 0;
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if ((c = getContentOfPosition(mptr, i, j)) == 'T')
+                tents++;
+            else if (c == 'U')
+                uncertain++;
+        }
+        if (tents > getTentsInLine(mptr, i) || tents + uncertain < getTentsInLine(mptr, i)) return 0;
+    }
+
+    for (int j = left; j <= right; j++) {
+        tents = 0;
+        uncertain = 0;
+        for (int i = 0; i < getMapLines(mptr); i++) {
+            if ((c = getContentOfPosition(mptr, i, j)) == 'T')
+                tents++;
+            else if (c == 'U')
+                uncertain++;
+        }
+        if (tents > getTentsInColumn(mptr, j) || tents + uncertain < getTentsInColumn(mptr, j)) return 0;
+    }
+
+    if (getTentsNumber(mptr) == getTreesNumber(mptr)) {
+        for (int i = top - 1; i <= bottom + 1; i++) {
+            for (int j = left - 1; j <= right + 1; j++) {
+                if (getContentOfPosition(mptr, i, j) != 'A') continue;
+                isolated = 1;
+                for (int k = 0; k < 4; k++) {
+                    if ((c = getContentOfPosition(mptr, i + editOrtogonals[k].dx, j + editOrtogonals[k].dy)) == 'T' || c == 'U') isolated = 0;
+                }
+                if (isolated) return 0;
+            }
+        }
+    }
+
+    wptr->kernel = &genericKernels;
+    initSearch(&search, mptr, wptr, 1);
+    search.uncertainCount = count;
+    backtrackingSolve(mptr, &search, 0);
+
+    return search.count > 0;
+}
+
+/**
+ * Function: nextToTree
+ * 
+ * Description: checks if a cell is ortogonal to a tree
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     1 - if cell is next to a tree
+ *     0 - otherwise
+ */
+int nextToTree(map *mptr, int line, int column) {
+    for (int k = 0; k < 4; k++) {
+        if (getContentOfPosition(mptr, line + editOrtogonals[k].dx, column + editOrtogonals[k].dy) == 'A') return 1;
+    }
+    return 0;
+}
+
+/**
+ * Function: solveFromScratch
+ * 
+ * Description: clears every cell but trees and solves the map with the full solver, linking
+ *              the tents of its solution to trees for later repairs. An impossible map gets
+ *              back the grid saved by resolveEdited, with the tree array and links rebuilt for
+ *              it, so a solution before the edits is still repaired by later edits
+ * 
+ * Side-effects: writes solution for mptr
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int solveFromScratch(editor *eptr) {
+    map *mptr = eptr->mptr;
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) != 'A') setContentOfPosition(mptr, i, j, '.');
+        }
+    }
+    setUncertainCount(mptr, 0);
+
+    if (solveMapInWorkspace(mptr, eptr->wptr) != 1) {
+        restoreGrid(eptr);
+        collectTrees(eptr);
+        if (eptr->solved) matchTents(eptr);
+        return -1;
+    }
+
+    eptr->solved = 1;
+    collectTrees(eptr);
+    matchTents(eptr);
+    clearDirty(eptr);
+
+    return 1;
+}
+
+/**
+ * Function: collectTrees
+ * 
+ * Description: rebuilds the tree array of the editor in line order and sets the number of
+ *              trees of its map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ * 
+ * Return value: number of trees
+ */
+int collectTrees(editor *eptr) {
+    map *mptr = eptr->mptr;
+    int t = 0;
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) != 'A') continue;
+            growTrees(eptr->wptr, t + 1);
+            eptr->wptr->treeArray[t].line = i;
+            eptr->wptr->treeArray[t].column = j;
+            t++;
+        }
+    }
+    setTreesNumber(mptr, t);
+
+    return t;
+}
+
+/**
+ * Function: saveGrid
+ * 
+ * Description: saves every cell of the map before a search
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ * 
+ * Return value: none
+ */
+void saveGrid(editor *eptr) {
+    map *mptr = eptr->mptr;
+    int columns = getMapColumns(mptr);
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        memcpy(eptr->grid + (size_t) i * columns, getMapLine(mptr, i), columns);
+    }
+}
+
+/**
+ * Function: restoreGrid
+ * 
+ * Description: puts back the cells saved by saveGrid, writing only those that changed
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ * 
+ * Return value: none
+ */
+void restoreGrid(editor *eptr) {
+    map *mptr = eptr->mptr;
+    int columns = getMapColumns(mptr);
+    char *saved;
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        saved = eptr->grid + (size_t) i * columns;
+        for (int j = 0; j < columns; j++) {
+            if (getContentOfPosition(mptr, i, j) != saved[j]) setContentOfPosition(mptr, i, j, saved[j]);
+        }
+    }
+    setUncertainCount(mptr, 0);
+}
+
+/**
+ * Function: matchTents
+ * 
+ * Description: links every tent of a solved map to a different tree next to it
+ * 
+ * Arguments:
+ *     editor *eptr - editor with tree array of map
+ * 
+ * Return value: none
+ */
+void matchTents(editor *eptr) {
+    map *mptr = eptr->mptr;
+    workspace *wptr = eptr->wptr;
+    search search;
+    cell tent;
+
+    wptr->kernel = &genericKernels;
+    initSearch(&search, mptr, wptr, 1);
+
+    for (int i = 0; i < getTreesNumber(mptr); i++) {
+        wptr->links[i].line = -1;
+        wptr->links[i].column = -1;
+    }
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) != 'T') continue;
+            tent.line = i;
+            tent.column = j;
+            memset(wptr->visited, 0, getTreesNumber(mptr));
+            localInjectivity(mptr, tent, &search);
+        }
+    }
+}
+
+/**
+ * Function: unlinkCell
+ * 
+ * Description: drops links of trees to a cell, which are kept by its neighbours only
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value: none
+ */
+void unlinkCell(editor *eptr, int line, int column) {
+    workspace *wptr = eptr->wptr;
+    int treesNumber = getTreesNumber(eptr->mptr), index;
+    cell tree;
+
+    for (int k = 0; k < 4; k++) {
+        tree.line = line + editOrtogonals[k].dx;
+        tree.column = column + editOrtogonals[k].dy;
+        index = findTreeIndex(wptr, treesNumber, tree.line, tree.column);
+        if (index == treesNumber || wptr->treeArray[index].line != tree.line || wptr->treeArray[index].column != tree.column) continue;
+        if (wptr->links[index].line == line && wptr->links[index].column == column) {
+            wptr->links[index].line = -1;
+            wptr->links[index].column = -1;
+        }
+    }
+}
+
+/**
+ * Function: growTrees
+ * 
+ * Description: grows tree array, links, visited, trail and supports (with gained and freed) of a
+ *              contents, unlike reserveArrays
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int treesNumber - number of trees to be held
+ * 
+ * Return value: none
+ */
+void growTrees(workspace *wptr, int treesNumber) {
+    int capacity;
+
+    if (treesNumber <= wptr->treeCapacity) return;
+
+    capacity = 2 * treesNumber;
+    wptr->treeArray = (cell *) realloc(wptr->treeArray, capacity * sizeof(cell));
+    wptr->links = (cell *) realloc(wptr->links, capacity * sizeof(cell));
+    wptr->visited = (char *) realloc(wptr->visited, capacity * sizeof(char));
+    wptr->trail = (int *) realloc(wptr->trail, capacity * sizeof(int));
+    wptr->supports = (support *) realloc(wptr->supports, capacity * sizeof(support));
+    wptr->gained = (cell *) realloc(wptr->gained, capacity * sizeof(cell));
+    wptr->freed = (int *) realloc(wptr->freed, capacity * sizeof(int));
+    if (wptr->treeArray == NULL || wptr->links == NULL || wptr->visited == NULL || wptr->trail == NULL || wptr->supports == NULL || wptr->gained == NULL || wptr->freed == NULL) exit(EXIT_FAILURE);
+    wptr->treeCapacity = capacity;
+}
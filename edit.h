@@ -0,0 +1,120 @@
+/**
+ * Filename: edit.h
+ * 
+ * Description: Incremental re-solving of a solved map after small edits
+ */
+
+#ifndef EDIT_H
+#define EDIT_H
+
+#include "map.h"
+
+typedef struct editorStruct editor;
+
+/**
+ * Function: newEditor
+ * 
+ * Description: starts editing a map already solved by solveMap, keeping its tree array and
+ *              the tree of every tent so that later edits only search around the cells they
+ *              changed
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (still owned by caller, must outlive the editor)
+ *     int result - value returned by solveMap for mptr
+ * 
+ * Return value:
+ *     pointer to new editor if successful
+ *     NULL if error ocurred
+ */
+editor *newEditor(map *mptr, int result);
+
+/**
+ * Function: deleteEditor
+ * 
+ * Description: deletes an editor (but not its map)
+ * 
+ * Arguments:
+ *     editor *eptr - pointer to editor to be deleted
+ * 
+ * Return value: none
+ */
+void deleteEditor(editor *eptr);
+
+/**
+ * Function: addTree
+ * 
+ * Description: places a tree on a cell and solves the edited map, repairing the previous
+ *              solution around the edits first and only searching the whole map if no repair
+ *              is found
+ * 
+ * Side-effects: writes solution for the edited map, an impossible one keeps the grid it had
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible
+ */
+int addTree(editor *eptr, int line, int column);
+
+/**
+ * Function: removeTree
+ * 
+ * Description: removes a tree from a cell and solves the edited map like addTree
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible
+ */
+int removeTree(editor *eptr, int line, int column);
+
+/**
+ * Function: changeLineHint
+ * 
+ * Description: changes number of tents in a line and solves the edited map like addTree.
+ *              While line and column hints add up to different totals the map is impossible
+ *              without any search, so a line and a column can be changed one after the other
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int line - number of line
+ *     int tents - number of tents in line (negative hints are not applied)
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible or line is out of the map (the edit is not applied)
+ */
+int changeLineHint(editor *eptr, int line, int tents);
+
+/**
+ * Function: changeColumnHint
+ * 
+ * Description: changes number of tents in a column and solves the edited map like
+ *              changeLineHint
+ * 
+ * Side-effects: writes solution for the edited map
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     int column - number of column
+ *     int tents - number of tents in column (negative hints are not applied)
+ * 
+ * Return value:
+ *     1 - if edited map has solution
+ *     -1 - if edited map is impossible or column is out of the map (the edit is not applied)
+ */
+int changeColumnHint(editor *eptr, int column, int tents);
+
+#endif
@@ -4,85 +4,732 @@
  * Description: Interaction with files
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include "io.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include "lanes.h"
 #include "map.h"
+#include "portfolio.h"
+#include "rowscan.h"
 #include "solver.h"
+#include "trace.h"
+
+#define SPARSE_MIN_CELLS (1LL << 26)
+
+/** largest number of lines or columns read, so that lines + columns and columns + 1 fit an int */
+#define MAX_MAP_SIDE (INT_MAX / 2)
 
-#define READ_SYNC_FAILURE 5
+map *allocateMap(int lines, int columns, long long budget);
+long long estimateFootprint(int lines, int columns, long long trees, int sparse);
+int withinBudget(map **mptr, int lines, int columns, int readLines, long long trees, long long budget);
+long long lineCandidates(uint64_t *above, uint64_t *line, uint64_t *below, int columns);
+int parseMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, long long budget, mapCounts *counts, laneQueue *qptr);
+int parseLaneMap(FILE *fp, int lines, int columns, int binary, laneMap *lptr);
 
 /**
- * Function: readAndSolveMap
+ * Function: allocateMap
  * 
- * Description: reads problem from file calls apropriate solving functions
+ * Description: allocates map for a problem about to be read, huge maps start sparse (they turn
+ *              into a grid while lines are read if trees are not sparse after all). Maps whose
+ *              grid alone exceeds the memory budget are kept sparse
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     long long budget - memory budget in bytes (0 for no limit)
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred or even an empty map exceeds the budget
+ */
+map *allocateMap(int lines, int columns, long long budget) {
+    map *mptr;
+
+    if (budget > 0 && estimateMapBytes(lines, columns, -1) > budget) {
+        if (estimateFootprint(lines, columns, 0, 1) > budget) return NULL;
+        mptr = newSparseMap(lines, columns);
+        if (mptr == NULL) exit(EXIT_FAILURE);
+        keepMapSparse(mptr);
+        return mptr;
+    }
+
+    if ((long long) lines * columns >= SPARSE_MIN_CELLS) mptr = newSparseMap(lines, columns);
+    else mptr = newMap(lines, columns);
+    if (mptr == NULL) exit(EXIT_FAILURE);
+
+    return mptr;
+}
+
+/**
+ * Function: estimateFootprint
+ * 
+ * Description: estimates bytes taken by a map and the workspace solving it, a sparse map ends
+ *              up storing its trees and the uncertain cells around them
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     long long trees - number of trees
+ *     int sparse - 1 if map is sparse, 0 if it is a grid
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long estimateFootprint(int lines, int columns, long long trees, int sparse) {
+    long long cells = (long long) lines * columns;
+    long long storedCells = -1;
+
+    if (sparse) storedCells = 5 * trees < cells ? 5 * trees : cells;
+
+    return estimateMapBytes(lines, columns, storedCells) + estimateSolveBytes(lines, columns, trees);
+}
+
+/**
+ * Function: withinBudget
+ * 
+ * Description: checks the estimated footprint of a map being read against the memory budget,
+ *              a grid that exceeds it turns into a sparse map if that fits, otherwise the map
+ *              is dropped
+ * 
+ * Side-effects: replaces *mptr by its sparse copy or deletes it and sets it to NULL
  * 
  * Arguments:
- *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int readLines - number of lines read so far
+ *     long long trees - number of trees read so far
+ *     long long budget - memory budget in bytes (0 for no limit)
+ * 
+ * Return value:
+ *     1 - if map still fits
+ *     0 - if map was dropped
+ */
+int withinBudget(map **mptr, int lines, int columns, int readLines, long long trees, long long budget) {
+    map *sparse;
+
+    if (budget <= 0 || estimateFootprint(lines, columns, trees, isSparseMap(*mptr)) <= budget) return 1;
+
+    sparse = NULL;
+    if (!isSparseMap(*mptr) && estimateFootprint(lines, columns, trees, 1) <= budget) {
+        sparse = sparseCopyMap(*mptr, readLines);
+        if (sparse == NULL) exit(EXIT_FAILURE);
+    }
+    deleteMap(*mptr);
+    *mptr = sparse;
+
+    return sparse != NULL;
+}
+
+/**
+ * Function: lineCandidates
+ * 
+ * Description: counts candidate cells of a line i.e. cells that are not trees next to a tree
+ *              of the line or of the lines above and below
+ * 
+ * Arguments:
+ *     uint64_t *above - tree bitmask of line above (all clear for the first line)
+ *     uint64_t *line - tree bitmask of line
+ *     uint64_t *below - tree bitmask of line below (all clear for the last line)
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     number of candidate cells
+ */
+long long lineCandidates(uint64_t *above, uint64_t *line, uint64_t *below, int columns) {
+    uint64_t left, right, near;
+    long long count = 0;
+
+    for (int w = 0; w < ROW_WORDS(columns); w++) {
+        left = line[w] << 1 | (w > 0 ? line[w - 1] >> 63 : 0);
+        right = line[w] >> 1 | (w + 1 < ROW_WORDS(columns) ? line[w + 1] << 63 : 0);
+        near = (left | right | above[w] | below[w]) & ~line[w];
+        if (w == ROW_WORDS(columns) - 1 && columns % 64) near &= ((uint64_t) 1 << (columns % 64)) - 1;
+        count += __builtin_popcountll(near);
+    }
+
+    return count;
+}
+
+/**
+ * Function: readBinaryMap
+ * 
+ * Description: reads problem stored in binary form i.e. magic "TTB1", int32 lines and columns,
+ *              int32 hints per line and column and lines * columns bytes with the grid
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer (positioned after the magic)
  *     map **mptr - map pointer
  *     int *lines - returns number of lines
  *     int *columns - returns number of columns
  *     int *result - returns result
+ *     long long budget - memory budget in bytes (0 for no limit)
+ *     mapCounts *counts - returns number of trees and candidate cells (or NULL)
+ *     laneQueue *qptr - queue where a tiny map is read instead of a map (or NULL)
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     READ_QUEUED - if map was read into the queue
+ *     READ_ERROR - if input is malformed
+ */
+int readBinaryMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, long long budget, mapCounts *counts, laneQueue *qptr) {
+    int32_t header[2];
+    int32_t *hints;
+    int *lineHints, *columnHints;
+    int outOfRange = 0, wellFormed, others, overBudget = 0, words;
+    long long treeCount = 0, lineSum = 0, columnSum = 0;
+    size_t hintCount;
+    char *lineString;
+    uint64_t *rows, *trees;
+
+    if (fread(header, sizeof(int32_t), 2, fp) != 2) return READ_ERROR;
+    if (header[0] < 0 || header[1] < 0 || header[0] > MAX_MAP_SIDE || header[1] > MAX_MAP_SIDE) return READ_ERROR;
+    *lines = header[0];
+    *columns = header[1];
+    if (qptr != NULL && fitsLanes(*lines, *columns)) return parseLaneMap(fp, *lines, *columns, 1, nextLaneMap(qptr));
+
+    hintCount = (size_t) *lines + (size_t) *columns;
+    hints = (int32_t *) malloc(hintCount * sizeof(int32_t));
+    if (hints == NULL) exit(EXIT_FAILURE);
+
+    lineHints = (int *) malloc(hintCount * sizeof(int));
+    if (lineHints == NULL) exit(EXIT_FAILURE);
+    columnHints = lineHints + *lines;
+
+    lineString = (char *) malloc(((size_t) *columns + 1) * sizeof(char));
+    if (lineString == NULL) exit(EXIT_FAILURE);
+
+    /** tree bitmasks of the last three lines and an empty one, for counting candidates */
+    words = ROW_WORDS(*columns) + 1;
+    rows = (uint64_t *) calloc(4 * (size_t) words, sizeof(uint64_t));
+    if (rows == NULL) exit(EXIT_FAILURE);
+    lineString[*columns] = '\0';
+
+    wellFormed = fread(hints, sizeof(int32_t), hintCount, fp) == hintCount;
+    for (size_t i = 0; i < hintCount && wellFormed; i++) {
+        lineHints[i] = hints[i];
+        /** a hint larger than its line or column makes the map impossible */
+        if (hints[i] < 0 || hints[i] > (i < (size_t) *lines ? *columns : *lines)) outOfRange = 1;
+        if (i < (size_t) *lines)
+            lineSum += hints[i];
+        else
+            columnSum += hints[i];
+    }
+
+    *mptr = NULL;
+    if (wellFormed && lineSum == columnSum && lineSum <= INT_MAX && !outOfRange) {
+        *mptr = allocateMap(*lines, *columns, budget);
+        overBudget = *mptr == NULL;
+        if (*mptr != NULL) {
+            setTentsInfo(*mptr, lineHints, columnHints);
+            setTentsNumber(*mptr, (int) lineSum);
+        }
+    }
+    for (int i = 0; i < *lines && wellFormed; i++) {
+        wellFormed = fread(lineString, sizeof(char), *columns, fp) == (size_t) *columns;
+        trees = rows + (i % 3) * words;
+        if (wellFormed) {
+            treeCount += scanRow(lineString, *columns, trees, &others);
+            wellFormed = others == 0;
+        }
+        if (wellFormed && counts != NULL && i > 0) counts->candidates += lineCandidates(i > 1 ? rows + ((i - 2) % 3) * words : rows + 3 * words, rows + ((i - 1) % 3) * words, trees, *columns);
+        if (!wellFormed || *mptr == NULL) continue;
+        setMapLineTrees(*mptr, i, lineString, trees);
+        if (!withinBudget(mptr, *lines, *columns, i + 1, treeCount, budget)) overBudget = 1;
+    }
+    *result = overBudget ? SOLVE_OVER_BUDGET : -1;
+    if (counts != NULL && wellFormed && *lines > 0) {
+        counts->trees = treeCount;
+        counts->candidates += lineCandidates(*lines > 1 ? rows + ((*lines - 2) % 3) * words : rows + 3 * words, rows + ((*lines - 1) % 3) * words, rows + 3 * words, *columns);
+    }
+
+    free(hints);
+    free(lineHints);
+    free(lineString);
+    free(rows);
+
+    if (!wellFormed) {
+        deleteMap(*mptr);
+        *mptr = NULL;
+        return READ_ERROR;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: parseMap
+ * 
+ * Description: reads problem from file, either in .camp text form or in binary form. Grid
+ *              lines must have exactly one 'A' or '.' per column, their trees go to the map as
+ *              bitmasks and lines of text maps are preprocessed as they are read when a
+ *              workspace is given
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - returns map pointer (NULL if hints make map impossible)
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (-1 if map is already known to be impossible,
+ *                   SOLVE_OVER_BUDGET if it was dropped for exceeding the memory budget)
+ *     workspace *wptr - workspace that will solve the map (or NULL)
+ *     long long budget - memory budget in bytes (0 for no limit)
+ *     mapCounts *counts - returns number of trees and candidate cells (or NULL)
+ *     laneQueue *qptr - queue where a tiny map is read instead of a map (or NULL)
  * 
  * Return value: 
  *     1 - if map was read
  *     0 - if EOF
+ *     READ_QUEUED - if map was read into the queue
+ *     READ_ERROR - if input is malformed
  */
-int readAndSolveMap(FILE *fp, map **mptr, int *lines, int *columns, int *result) {
-    int ret, negative = 0;
+int parseMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, long long budget, mapCounts *counts, laneQueue *qptr) {
+    int ret, c, outOfRange = 0, wellFormed = 1, others, overBudget = 0, words;
+    long long treeCount = 0, lineSum = 0, columnSum = 0;
     int *lineHints, *columnHints;
-    int lineSum = 0, columnSum = 0;
+    map *streamed;
+    char magic[3];
     char *lineString;
+    uint64_t *rows, *trees;
+
+    if (counts != NULL) counts->trees = counts->candidates = 0;
+
+    while ((c = getc(fp)) != EOF && isspace(c))
+        ;
+    if (c == EOF) return 0;
+    if (c == 'T') {
+        if (fread(magic, sizeof(char), 3, fp) != 3 || memcmp(magic, "TB1", 3)) return READ_ERROR;
+        return readBinaryMap(fp, mptr, lines, columns, result, budget, counts, qptr);
+    }
+    ungetc(c, fp);
 
     ret = fscanf(fp, "%d %d", lines, columns);
     if (ret == EOF) return 0;
-    if (ret != 2) exit(READ_SYNC_FAILURE);
+    if (ret != 2 || *lines < 0 || *columns < 0 || *lines > MAX_MAP_SIDE || *columns > MAX_MAP_SIDE) return READ_ERROR;
+    if (qptr != NULL && fitsLanes(*lines, *columns)) return parseLaneMap(fp, *lines, *columns, 0, nextLaneMap(qptr));
 
-    lineHints = (int *) malloc(*lines * sizeof(int));
+    lineHints = (int *) malloc((size_t) *lines * sizeof(int));
     if (lineHints == NULL) exit(EXIT_FAILURE);
 
-    columnHints = (int *) malloc(*columns * sizeof(int));
+    columnHints = (int *) malloc((size_t) *columns * sizeof(int));
     if (columnHints == NULL) exit(EXIT_FAILURE);
 
-    lineString = (char *) malloc((*columns + 1) * sizeof(char));
+    lineString = (char *) malloc(((size_t) *columns + 1) * sizeof(char));
     if (lineString == NULL) exit(EXIT_FAILURE);
 
-    for (int i = 0; i < *lines; i++) {
-        ret = fscanf(fp, "%d", &lineHints[i]);
-        if (ret != 1) exit(READ_SYNC_FAILURE);
-        if (lineHints[i] < 0) negative = 1;
+    /** tree bitmasks of the last three lines and an empty one, for counting candidates */
+    words = ROW_WORDS(*columns) + 1;
+    rows = (uint64_t *) calloc(4 * (size_t) words, sizeof(uint64_t));
+    if (rows == NULL) exit(EXIT_FAILURE);
+
+    /** a hint larger than its line or column makes the map impossible */
+    for (int i = 0; i < *lines && wellFormed; i++) {
+        wellFormed = fscanf(fp, "%d", &lineHints[i]) == 1;
+        if (!wellFormed) break;
+        if (lineHints[i] < 0 || lineHints[i] > *columns) outOfRange = 1;
         lineSum += lineHints[i];
     }
 
-    for (int i = 0; i < *columns; i++) {
-        ret = fscanf(fp, "%d", &columnHints[i]);
-        if (ret != 1) exit(READ_SYNC_FAILURE);
-        if (columnHints[i] < 0) negative = 1;
+    for (int i = 0; i < *columns && wellFormed; i++) {
+        wellFormed = fscanf(fp, "%d", &columnHints[i]) == 1;
+        if (!wellFormed) break;
+        if (columnHints[i] < 0 || columnHints[i] > *lines) outOfRange = 1;
         columnSum += columnHints[i];
     }
 
-    if (lineSum == columnSum && !negative) {
-        *mptr = newMap(*lines, *columns);
-        if (*mptr == NULL) exit(EXIT_FAILURE);
-        setTentsInfo(*mptr, lineHints, columnHints);
-        setTentsNumber(*mptr, lineSum);
-        for (int i = 0; i < *lines; i++) {
-            ret = fscanf(fp, "%s", lineString);
-            if (ret != 1) exit(READ_SYNC_FAILURE);
-            setMapLine(*mptr, i, lineString);
+    *mptr = NULL;
+    if (wellFormed && lineSum == columnSum && lineSum <= INT_MAX && !outOfRange) {
+        *mptr = allocateMap(*lines, *columns, budget);
+        overBudget = *mptr == NULL;
+        if (*mptr != NULL) {
+            setTentsInfo(*mptr, lineHints, columnHints);
+            setTentsNumber(*mptr, (int) lineSum);
+            if (wptr != NULL) streamPreprocessing(*mptr, wptr);
         }
-        *result = solveMap(*mptr);
-    } else {
-        for (int i = 0; i < *lines; i++) {
-            ret = fscanf(fp, "%s", lineString);
-            if (ret != 1) exit(READ_SYNC_FAILURE);
+    }
+    for (int i = 0; i < *lines && wellFormed; i++) {
+        wellFormed = readGridLine(fp, lineString, *columns);
+        trees = rows + (i % 3) * words;
+        if (wellFormed) {
+            treeCount += scanRow(lineString, *columns, trees, &others);
+            wellFormed = others == 0;
         }
-        *mptr = NULL;
-        *result = -1;
+        if (wellFormed && counts != NULL && i > 0) counts->candidates += lineCandidates(i > 1 ? rows + ((i - 2) % 3) * words : rows + 3 * words, rows + ((i - 1) % 3) * words, trees, *columns);
+        if (!wellFormed || *mptr == NULL) continue;
+        setMapLineTrees(*mptr, i, lineString, trees);
+        /** checked before the line is preprocessed, which grows the workspace */
+        streamed = *mptr;
+        if (!withinBudget(mptr, *lines, *columns, i + 1, treeCount, budget)) {
+            overBudget = 1;
+            continue;
+        }
+        /** a grid turned sparse is preprocessed when it is solved */
+        if (*mptr != streamed && wptr != NULL) streamPreprocessing(*mptr, wptr);
+        if (wptr != NULL) preprocessReadLine(*mptr, wptr, i);
+    }
+    *result = overBudget ? SOLVE_OVER_BUDGET : -1;
+    if (counts != NULL && wellFormed && *lines > 0) {
+        counts->trees = treeCount;
+        counts->candidates += lineCandidates(*lines > 1 ? rows + ((*lines - 2) % 3) * words : rows + 3 * words, rows + ((*lines - 1) % 3) * words, rows + 3 * words, *columns);
     }
 
     free(lineHints);
     free(columnHints);
     free(lineString);
+    free(rows);
+
+    if (!wellFormed) {
+        deleteMap(*mptr);
+        *mptr = NULL;
+        return READ_ERROR;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: parseLaneMap
+ * 
+ * Description: reads the hints and grid of a tiny map (text or binary form, header already
+ *              read) straight into a board, with no map nor buffer allocated
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer (positioned after the header)
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int binary - 1 if map is in binary form, 0 if in text form
+ *     laneMap *lptr - returns map (result -1 if hints make it impossible)
+ * 
+ * Return value: 
+ *     READ_QUEUED - if map was read
+ *     READ_ERROR - if input is malformed
+ */
+int parseLaneMap(FILE *fp, int lines, int columns, int binary, laneMap *lptr) {
+    int32_t hints[2 * LANE_SIDE];
+    int hint, lineSum = 0, columnSum = 0, wellFormed = 1, others;
+    char lineString[LANE_SIDE + 1];
+    uint64_t trees;
+
+    lptr->lines = lines;
+    lptr->columns = columns;
+    lptr->result = 0;
+    lptr->trees = lptr->tents = lptr->lineHints = lptr->columnHints = 0;
+
+    if (binary) wellFormed = fread(hints, sizeof(int32_t), lines + columns, fp) == (size_t) (lines + columns);
+    for (int i = 0; i < lines + columns && wellFormed; i++) {
+        if (binary)
+            hint = hints[i];
+        else
+            wellFormed = fscanf(fp, "%d", &hint) == 1;
+        if (!wellFormed) break;
+
+        /** a hint no line or column of a board can meet makes the map impossible */
+        if (hint < 0 || hint > LANE_SIDE) {
+            lptr->result = -1;
+        } else if (i < lines) {
+            lptr->lineHints |= (uint64_t) hint << (LANE_SIDE * i);
+            lineSum += hint;
+        } else {
+            lptr->columnHints |= (uint64_t) hint << (LANE_SIDE * (i - lines));
+            columnSum += hint;
+        }
+    }
+    if (lineSum != columnSum) lptr->result = -1;
+
+    for (int i = 0; i < lines && wellFormed; i++) {
+        if (binary)
+            wellFormed = fread(lineString, sizeof(char), columns, fp) == (size_t) columns;
+        else
+            wellFormed = readGridLine(fp, lineString, columns);
+        if (!wellFormed) break;
+        scanRow(lineString, columns, &trees, &others);
+        wellFormed = others == 0;
+        lptr->trees |= trees << (LANE_SIDE * i);
+    }
+
+    return wellFormed ? READ_QUEUED : READ_ERROR;
+}
+
+/**
+ * Function: readMap
+ * 
+ * Description: reads problem from file, either in .camp text form or in binary form
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - returns map pointer (NULL if hints make map impossible)
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (-1 if map is already known to be impossible)
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ *     READ_ERROR - if input is malformed
+ */
+int readMap(FILE *fp, map **mptr, int *lines, int *columns, int *result) {
+    int ret;
+
+    TRACE_BEGIN("parse");
+    ret = parseMap(fp, mptr, lines, columns, result, NULL, 0, NULL, NULL);
+    TRACE_END("parse");
+
+    return ret;
+}
+
+/**
+ * Function: readMapCounts
+ * 
+ * Description: reads problem from file like readMap, also counting its trees and candidate
+ *              cells (cells next to a tree) while lines are read
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - returns map pointer (NULL if hints make map impossible)
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (-1 if map is already known to be impossible)
+ *     mapCounts *counts - returns number of trees and candidate cells
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ *     READ_ERROR - if input is malformed
+ */
+int readMapCounts(FILE *fp, map **mptr, int *lines, int *columns, int *result, mapCounts *counts) {
+    int ret;
+
+    TRACE_BEGIN("parse");
+    ret = parseMap(fp, mptr, lines, columns, result, NULL, 0, counts, NULL);
+    TRACE_END("parse");
+
+    return ret;
+}
+
+/**
+ * Function: scanMap
+ * 
+ * Description: reads past a problem (text or binary form) without keeping it, only taking its
+ *              size and counting its trees
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     long long *trees - returns number of trees
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ *     READ_ERROR - if input is malformed
+ */
+int scanMap(FILE *fp, int *lines, int *columns, long long *trees) {
+    int ret, c, hint, others, binary, wellFormed = 1;
+    int32_t header[2];
+    char magic[3];
+    char *lineString;
+    uint64_t *row;
+
+    while ((c = getc(fp)) != EOF && isspace(c))
+        ;
+    if (c == EOF) return 0;
+
+    binary = c == 'T';
+    if (binary) {
+        if (fread(magic, sizeof(char), 3, fp) != 3 || memcmp(magic, "TB1", 3)) return READ_ERROR;
+        if (fread(header, sizeof(int32_t), 2, fp) != 2 || header[0] < 0 || header[1] < 0 || header[0] > MAX_MAP_SIDE || header[1] > MAX_MAP_SIDE) return READ_ERROR;
+        *lines = header[0];
+        *columns = header[1];
+        wellFormed = fseek(fp, ((long) *lines + *columns) * (long) sizeof(int32_t), SEEK_CUR) == 0;
+    } else {
+        ungetc(c, fp);
+        ret = fscanf(fp, "%d %d", lines, columns);
+        if (ret == EOF) return 0;
+        if (ret != 2 || *lines < 0 || *columns < 0 || *lines > MAX_MAP_SIDE || *columns > MAX_MAP_SIDE) return READ_ERROR;
+        for (int i = 0; i < *lines + *columns && wellFormed; i++) wellFormed = fscanf(fp, "%d", &hint) == 1;
+    }
+
+    lineString = (char *) malloc(((size_t) *columns + 1) * sizeof(char));
+    if (lineString == NULL) exit(EXIT_FAILURE);
+
+    row = (uint64_t *) malloc(((size_t) ROW_WORDS(*columns) + 1) * sizeof(uint64_t));
+    if (row == NULL) exit(EXIT_FAILURE);
+
+    *trees = 0;
+    for (int i = 0; i < *lines && wellFormed; i++) {
+        if (binary)
+            wellFormed = fread(lineString, sizeof(char), *columns, fp) == (size_t) *columns;
+        else
+            wellFormed = readGridLine(fp, lineString, *columns);
+        if (wellFormed) *trees += scanRow(lineString, *columns, row, &others);
+        wellFormed = wellFormed && others == 0;
+    }
+
+    free(lineString);
+    free(row);
+
+    return wellFormed ? 1 : READ_ERROR;
+}
+
+/**
+ * Function: readAndSolveMap
+ * 
+ * Description: reads problem from file calls apropriate solving functions, preprocessing
+ *              the map in the same pass as its lines are read. Maps whose estimated memory
+ *              exceeds the budget of the options are read through but not kept nor solved
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (SOLVE_OVER_BUDGET if map exceeds the memory budget)
+ *     workspace *wptr - workspace reused from map to map
+ *     solverOptions *optr - solver options
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndSolveMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, solverOptions *optr) {
+    return readAndQueueMap(fp, mptr, lines, columns, result, wptr, optr, NULL);
+}
+
+/**
+ * Function: readAndQueueMap
+ * 
+ * Description: reads problem from file like readAndSolveMap, but a map that fits the lanes is
+ *              read into the queue instead, to be solved with the other tiny maps in it
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (SOLVE_OVER_BUDGET if map exceeds the memory budget)
+ *     workspace *wptr - workspace reused from map to map
+ *     solverOptions *optr - solver options
+ *     laneQueue *qptr - queue of tiny maps (or NULL to solve every map here)
+ * 
+ * Return value: 
+ *     1 - if map was read and solved
+ *     READ_QUEUED - if map was queued
+ *     0 - if EOF
+ */
+int readAndQueueMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, solverOptions *optr, laneQueue *qptr) {
+    int ret;
+
+    TRACE_BEGIN("parse");
+    ret = parseMap(fp, mptr, lines, columns, result, wptr, optr->memoryBudget, NULL, qptr);
+    TRACE_END("parse");
+    if (ret == READ_ERROR) exit(READ_SYNC_FAILURE);
+    if (ret == 0 || ret == READ_QUEUED) return ret;
+
+    if (*mptr != NULL) *result = solveMapWithOptions(*mptr, wptr, optr);
+
+    return 1;
+}
+
+/**
+ * Function: readAndCountMap
+ * 
+ * Description: reads problem from file and counts its solutions
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result
+ *     long long *count - returns number of solutions (at most limit)
+ *     long long limit - stop counting after this many solutions (0 for no limit)
+ *     int workers - number of threads used for counting
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndCountMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, long long *count, long long limit, int workers) {
+    int ret;
+
+    ret = readMap(fp, mptr, lines, columns, result);
+    if (ret == READ_ERROR) exit(READ_SYNC_FAILURE);
+    if (ret == 0) return 0;
+
+    *count = 0;
+    if (*mptr != NULL) *count = countSolutions(*mptr, limit, workers);
+    *result = *count > 0 ? 1 : -1;
+
+    return 1;
+}
+
+/**
+ * Function: readAndRaceMap
+ * 
+ * Description: reads problem from file and solves it racing the strategies of a portfolio
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result
+ *     portfolio *pfptr - portfolio pointer
+ *     FILE *log - file where the winner of the race is logged (or NULL)
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndRaceMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, portfolio *pfptr, FILE *log) {
+    int ret;
+
+    ret = readMap(fp, mptr, lines, columns, result);
+    if (ret == READ_ERROR) exit(READ_SYNC_FAILURE);
+    if (ret == 0) return 0;
+
+    if (*mptr != NULL) *result = racePortfolio(pfptr, mptr, log);
+
+    return 1;
+}
+
+/**
+ * Function: readAndBenchmarkMap
+ * 
+ * Description: reads problem from file and solves it with every route of the solver, timing
+ *              them. A map no route solves within BENCHMARK_SECONDS gets result
+ *              SOLVE_CANCELLED in the stats, and is then solved without deadline
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer
+ *     FILE *log - file where the features and times of the map are written
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndBenchmarkMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, solverOptions *optr, FILE *log) {
+    int ret;
+
+    /** routes solve copies of the map, so it is not preprocessed while read */
+    ret = readMap(fp, mptr, lines, columns, result);
+    if (ret == READ_ERROR) exit(READ_SYNC_FAILURE);
+    if (ret == 0) return 0;
+
+    if (*mptr != NULL) *result = benchmarkRoutes(mptr, wptr, optr, log);
 
     return 1;
 }
@@ -102,6 +749,7 @@ int readAndSolveMap(FILE *fp, map **mptr, int *lines, int *columns, int *result)
  * Return value: none
  */
 void writeSolution(FILE *fp, map *mptr, int lines, int columns, int result) {
+    TRACE_BEGIN("write");
     fprintf(fp, "%d %d %d\n", lines, columns, result);
 
     if (result == 1) {
@@ -112,4 +760,82 @@ void writeSolution(FILE *fp, map *mptr, int lines, int columns, int result) {
     fprintf(fp, "\n");
 
     deleteMap(mptr);
-}
\ No newline at end of file
+    TRACE_END("write");
+}
+
+/**
+ * Function: writeSolutionCount
+ * 
+ * Description: writes problem output to file with number of solutions in the header
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map *mptr - map pointer
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int result - result
+ *     long long count - number of solutions
+ * 
+ * Return value: none
+ */
+void writeSolutionCount(FILE *fp, map *mptr, int lines, int columns, int result, long long count) {
+    TRACE_BEGIN("write");
+    fprintf(fp, "%d %d %d %lld\n", lines, columns, result, count);
+
+    if (result == 1) {
+        for (int i = 0; i < lines; i++) {
+            fprintf(fp, "%s\n", getMapLine(mptr, i));
+        }
+    }
+    fprintf(fp, "\n");
+
+    deleteMap(mptr);
+    TRACE_END("write");
+}
+
+/**
+ * Function: writeMemoryUsage
+ * 
+ * Description: writes bytes held by a solved map and its workspace (line "lines columns result
+ *              bytes"), the workspace keeps its buffers so it counts the largest map so far
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map *mptr - map pointer (NULL if map was not kept)
+ *     workspace *wptr - workspace that solved the map
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int result - result
+ * 
+ * Return value:
+ *     number of bytes written in the line
+ */
+long long writeMemoryUsage(FILE *fp, map *mptr, workspace *wptr, int lines, int columns, int result) {
+    long long bytes = getWorkspaceBytes(wptr);
+
+    if (mptr != NULL) bytes += getMapBytes(mptr);
+    fprintf(fp, "%d %d %d %lld\n", lines, columns, result, bytes);
+
+    return bytes;
+}
+
+/**
+ * Function: writeMemorySummary
+ * 
+ * Description: writes the largest bytes of any map and the peak resident memory of the process
+ *              (line "peak bytes rss bytes")
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     long long peak - largest bytes written by writeMemoryUsage
+ * 
+ * Return value: none
+ */
+void writeMemorySummary(FILE *fp, long long peak) {
+    struct rusage usage;
+    long long rss = 0;
+
+    /** ru_maxrss is in kilobytes */
+    if (getrusage(RUSAGE_SELF, &usage) == 0) rss = (long long) usage.ru_maxrss * 1024;
+    fprintf(fp, "peak %lld rss %lld\n", peak, rss);
+}
@@ -8,12 +8,178 @@
 #define IO_H
 
 #include <stdio.h>
+#include "lanes.h"
 #include "map.h"
+#include "portfolio.h"
+#include "solver.h"
+
+#define READ_ERROR -1
+/** return value of a read that put a tiny map in a lane queue instead of a map */
+#define READ_QUEUED 2
+/** exit status of a run stopped by malformed input */
+#define READ_SYNC_FAILURE 5
+
+/**
+ * Counts taken while a map is read: trees and candidate cells (cells next to a tree, before
+ * hints rule any of them out)
+ */
+typedef struct {
+    long long trees;
+    long long candidates;
+} mapCounts;
+
+/**
+ * Function: readMap
+ * 
+ * Description: reads problem from file, either in .camp text form or in binary form
+ *              (magic "TTB1", int32 lines and columns, int32 hints and the grid bytes)
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - returns map pointer (NULL if hints make map impossible)
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (-1 if map is already known to be impossible)
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ *     READ_ERROR - if input is malformed
+ */
+int readMap(FILE *fp, map **mptr, int *lines, int *columns, int *result);
+
+/**
+ * Function: readMapCounts
+ * 
+ * Description: reads problem from file like readMap, also counting its trees and candidate
+ *              cells (cells next to a tree) while lines are read
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - returns map pointer (NULL if hints make map impossible)
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (-1 if map is already known to be impossible)
+ *     mapCounts *counts - returns number of trees and candidate cells
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ *     READ_ERROR - if input is malformed
+ */
+int readMapCounts(FILE *fp, map **mptr, int *lines, int *columns, int *result, mapCounts *counts);
+
+/**
+ * Function: scanMap
+ * 
+ * Description: reads past a problem (text or binary form) without keeping it, only taking its
+ *              size and counting its trees
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     long long *trees - returns number of trees
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ *     READ_ERROR - if input is malformed
+ */
+int scanMap(FILE *fp, int *lines, int *columns, long long *trees);
 
 /**
  * Function: readAndSolveMap
  * 
- * Description: reads problem from file calls apropriate solving functions
+ * Description: reads problem from file calls apropriate solving functions. Maps whose
+ *              estimated memory exceeds the budget of the options are read through but not
+ *              kept nor solved
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (SOLVE_OVER_BUDGET if map exceeds the memory budget)
+ *     workspace *wptr - workspace reused from map to map
+ *     solverOptions *optr - solver options
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndSolveMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, solverOptions *optr);
+
+/**
+ * Function: readAndQueueMap
+ * 
+ * Description: reads problem from file like readAndSolveMap, but a map that fits the lanes is
+ *              read into the queue instead, to be solved with the other tiny maps in it
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result (SOLVE_OVER_BUDGET if map exceeds the memory budget)
+ *     workspace *wptr - workspace reused from map to map
+ *     solverOptions *optr - solver options
+ *     laneQueue *qptr - queue of tiny maps (or NULL to solve every map here)
+ * 
+ * Return value: 
+ *     1 - if map was read and solved
+ *     READ_QUEUED - if map was queued
+ *     0 - if EOF
+ */
+int readAndQueueMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, solverOptions *optr, laneQueue *qptr);
+
+/**
+ * Function: readAndCountMap
+ * 
+ * Description: reads problem from file and counts its solutions
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result
+ *     long long *count - returns number of solutions (at most limit)
+ *     long long limit - stop counting after this many solutions (0 for no limit)
+ *     int workers - number of threads used for counting
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndCountMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, long long *count, long long limit, int workers);
+
+/**
+ * Function: readAndRaceMap
+ * 
+ * Description: reads problem from file and solves it racing the strategies of a portfolio
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map **mptr - map pointer
+ *     int *lines - returns number of lines
+ *     int *columns - returns number of columns
+ *     int *result - returns result
+ *     portfolio *pfptr - portfolio pointer
+ *     FILE *log - file where the winner of the race is logged (or NULL)
+ * 
+ * Return value: 
+ *     1 - if map was read
+ *     0 - if EOF
+ */
+int readAndRaceMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, portfolio *pfptr, FILE *log);
+
+/**
+ * Function: readAndBenchmarkMap
+ * 
+ * Description: reads problem from file and solves it with every route of the solver, timing
+ *              them. A map no route solves within BENCHMARK_SECONDS gets result
+ *              SOLVE_CANCELLED in the stats, and is then solved without deadline
  * 
  * Arguments:
  *     FILE *fp - file pointer
@@ -21,12 +187,15 @@
  *     int *lines - returns number of lines
  *     int *columns - returns number of columns
  *     int *result - returns result
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer
+ *     FILE *log - file where the features and times of the map are written
  * 
  * Return value: 
  *     1 - if map was read
  *     0 - if EOF
  */
-int readAndSolveMap(FILE *fp, map **mptr, int *lines, int *columns, int *result);
+int readAndBenchmarkMap(FILE *fp, map **mptr, int *lines, int *columns, int *result, workspace *wptr, solverOptions *optr, FILE *log);
 
 /**
  * Function: readAndSolveMap
@@ -44,4 +213,54 @@ int readAndSolveMap(FILE *fp, map **mptr, int *lines, int *columns, int *result)
  */
 void writeSolution(FILE *fp, map *mptr, int lines, int columns, int result);
 
+/**
+ * Function: writeSolutionCount
+ * 
+ * Description: writes problem output to file with number of solutions in the header
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map *mptr - map pointer
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int result - result
+ *     long long count - number of solutions
+ * 
+ * Return value: none
+ */
+void writeSolutionCount(FILE *fp, map *mptr, int lines, int columns, int result, long long count);
+
+/**
+ * Function: writeMemoryUsage
+ * 
+ * Description: writes bytes held by a solved map and its workspace (line "lines columns result
+ *              bytes"), the workspace keeps its buffers so it counts the largest map so far
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     map *mptr - map pointer (NULL if map was not kept)
+ *     workspace *wptr - workspace that solved the map
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     int result - result
+ * 
+ * Return value:
+ *     number of bytes written in the line
+ */
+long long writeMemoryUsage(FILE *fp, map *mptr, workspace *wptr, int lines, int columns, int result);
+
+/**
+ * Function: writeMemorySummary
+ * 
+ * Description: writes the largest bytes of any map and the peak resident memory of the process
+ *              (line "peak bytes rss bytes")
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     long long peak - largest bytes written by writeMemoryUsage
+ * 
+ * Return value: none
+ */
+void writeMemorySummary(FILE *fp, long long peak);
+
 #endif
\ No newline at end of file
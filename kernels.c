@@ -0,0 +1,71 @@
+/**
+ * Filename: kernels.c
+ * 
+ * Description: Width specialised solver kernels, generated from widthkernel.h
+ */
+
+#include "kernels.h"
+#include <stdint.h>
+#include <string.h>
+#include "map.h"
+#include "rowscan.h"
+#include "search.h"
+#include "sparse.h"
+
+#define KERNEL_NAME(name, width) name##width
+#define KERNEL_EXPAND(name, width) KERNEL_NAME(name, width)
+#define KERNEL(name) KERNEL_EXPAND(name, KERNEL_WIDTH)
+
+#define KERNEL_WIDTH 8
+#define ROW_TYPE uint8_t
+#include "widthkernel.h"
+#undef KERNEL_WIDTH
+#undef ROW_TYPE
+
+#define KERNEL_WIDTH 16
+#define ROW_TYPE uint16_t
+#include "widthkernel.h"
+#undef KERNEL_WIDTH
+#undef ROW_TYPE
+
+#define KERNEL_WIDTH 32
+#define ROW_TYPE uint32_t
+#include "widthkernel.h"
+#undef KERNEL_WIDTH
+#undef ROW_TYPE
+
+#define KERNEL_WIDTH 64
+#define ROW_TYPE uint64_t
+#include "widthkernel.h"
+#undef KERNEL_WIDTH
+#undef ROW_TYPE
+
+const kernels genericKernels = {0, 0, 0, preprocessCells, setCell, validTent, validGrass, treesAround};
+const kernels sparseKernels = {0, 0, 1, preprocessSparse, setSparseCell, validSparseTent, validSparseGrass, treesAround};
+const kernels widthKernels[] = {
+    {8, 1, 1, preprocess8, setCell8, validTent8, validGrass8, treesAround8},
+    {16, 1, 1, preprocess16, setCell16, validTent16, validGrass16, treesAround16},
+    {32, 1, 1, preprocess32, setCell32, validTent32, validGrass32, treesAround32},
+    {64, 1, 1, preprocess64, setCell64, validTent64, validGrass64, treesAround64}
+};
+
+/**
+ * Function: selectKernels
+ * 
+ * Description: picks kernels for a map, sparse maps get kernels that work on trees and
+ *              counters only, maps with 8, 16, 32 or 64 columns get one word per line and any
+ *              other width gets the generic cell by cell kernels
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     pointer to kernels for mptr
+ */
+const kernels *selectKernels(map *mptr) {
+    if (isSparseMap(mptr)) return &sparseKernels;
+    for (int i = 0; i < (int) (sizeof(widthKernels) / sizeof(widthKernels[0])); i++) {
+        if (widthKernels[i].width == getMapColumns(mptr)) return &widthKernels[i];
+    }
+    return &genericKernels;
+}
@@ -0,0 +1,43 @@
+/**
+ * Filename: kernels.h
+ * 
+ * Description: Runtime dispatch of solver kernels by map width
+ */
+
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include "map.h"
+#include "search.h"
+
+/** boards and counters tell which workspace state the kernels keep up to date during search */
+struct kernelsStruct {
+    int width;
+    int boards;
+    int counters;
+    int (*preprocess)(map *mptr, workspace *wptr);
+    void (*setCell)(map *mptr, search *sptr, cell Cell, char value);
+    int (*validTent)(map *mptr, cell Cell, search *sptr);
+    int (*validGrass)(map *mptr, cell Cell, search *sptr);
+    int (*treesAround)(map *mptr, search *sptr, cell Cell, int *around);
+};
+
+/** cell by cell kernels, they work on any map and need no state besides the map */
+extern const kernels genericKernels;
+
+/**
+ * Function: selectKernels
+ * 
+ * Description: picks kernels for a map, sparse maps get kernels that work on trees and
+ *              counters only, maps with 8, 16, 32 or 64 columns get one word per line and any
+ *              other width gets the generic cell by cell kernels
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     pointer to kernels for mptr
+ */
+const kernels *selectKernels(map *mptr);
+
+#endif
@@ -0,0 +1,583 @@
+/**
+ * Filename: lanes.c
+ * 
+ * Description: Lane parallel solver of tiny maps, many maps of up to 8 by 8 cells are solved
+ *              at once with one 64 bit word per board
+ * 
+ * Boards keep cell (i, j) in bit 8 * i + j, so a line is a byte and a column is a byte of the
+ * transposed board. Lanes are kept as structure of arrays: one propagation pass runs over all
+ * of them without branches (a lane that is not active holds an empty board and never changes),
+ * while deciding, backtracking and finishing are done lane by lane through the lane masks.
+ */
+
+#include "lanes.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "checkpoint.h"
+#include "trace.h"
+
+/** every decision settles at least one cell, so a lane never saves more boards than cells */
+#define LANE_DEPTH (LANE_SIDE * LANE_SIDE)
+
+#define FIRST_COLUMN 0x0101010101010101ULL
+#define LAST_COLUMN 0x8080808080808080ULL
+#define LOW_BITS 0x7F7F7F7F7F7F7F7FULL
+#define HIGH_BITS 0x8080808080808080ULL
+
+/**
+ * Lanes: board of every lane (trees, candidates i.e. cells next to a tree, tents and grass
+ * decided so far, packed hints and trees beyond the tents), boards saved at every decision,
+ * map each lane solves and mask of the lanes the last propagation pass found broken
+ */
+typedef struct {
+    uint64_t trees[LANE_COUNT];
+    uint64_t candidates[LANE_COUNT];
+    uint64_t tents[LANE_COUNT];
+    uint64_t grass[LANE_COUNT];
+    uint64_t lineHints[LANE_COUNT];
+    uint64_t columnHints[LANE_COUNT];
+    int spare[LANE_COUNT];
+    uint64_t failed;
+    int depth[LANE_COUNT];
+    int owner[LANE_COUNT];
+    uint64_t savedTents[LANE_COUNT][LANE_DEPTH];
+    uint64_t savedGrass[LANE_COUNT][LANE_DEPTH];
+} laneState;
+
+struct laneQueueStruct {
+    laneMap maps[LANE_QUEUE];
+    long long offsets[LANE_QUEUE];
+    int count;
+    laneState lanes;
+};
+
+uint64_t orthogonalCells(uint64_t cells);
+uint64_t surroundingCells(uint64_t cells);
+uint64_t transposeBoard(uint64_t board);
+uint64_t bytePopcount(uint64_t bytes);
+uint64_t byteGreater(uint64_t a, uint64_t b);
+uint64_t byteEqual(uint64_t a, uint64_t b);
+uint64_t propagateLanes(laneState *lsptr);
+void loadLane(laneState *lsptr, int lane, laneMap *lptr, int owner);
+void clearLane(laneState *lsptr, int lane);
+int matchLaneTents(uint64_t trees, uint64_t tents);
+int augmentLaneMatching(int tent, uint64_t trees, int *match, uint64_t *visited);
+
+/**
+ * Function: fitsLanes
+ * 
+ * Description: tells if a map is small enough to be solved in lanes
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     1 - if map fits a board of LANE_SIDE by LANE_SIDE cells
+ *     0 - otherwise
+ */
+int fitsLanes(int lines, int columns) {
+    return lines > 0 && columns > 0 && lines <= LANE_SIDE && columns <= LANE_SIDE;
+}
+
+/**
+ * Function: newLaneQueue
+ * 
+ * Description: allocates an empty queue of tiny maps together with the lanes solving them
+ * 
+ * Arguments: none
+ * 
+ * Return value:
+ *     pointer to new queue if successful
+ *     NULL if error ocurred
+ */
+laneQueue *newLaneQueue(void) {
+    laneQueue *qptr;
+
+    qptr = (laneQueue *) malloc(sizeof(laneQueue));
+    if (qptr == NULL) return NULL;
+
+    qptr->count = 0;
+    for (int l = 0; l < LANE_COUNT; l++) clearLane(&qptr->lanes, l);
+
+    return qptr;
+}
+
+/**
+ * Function: deleteLaneQueue
+ * 
+ * Description: deletes a queue of tiny maps (maps still queued are dropped)
+ * 
+ * Arguments:
+ *     laneQueue *qptr - pointer to queue to be deleted (or NULL)
+ * 
+ * Return value: none
+ */
+void deleteLaneQueue(laneQueue *qptr) {
+    free(qptr);
+}
+
+/**
+ * Function: nextLaneMap
+ * 
+ * Description: gets the slot where the next tiny map is read, it is only queued once
+ *              pushLaneMap is called
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer
+ * 
+ * Return value:
+ *     pointer to free slot
+ */
+laneMap *nextLaneMap(laneQueue *qptr) {
+    return &qptr->maps[qptr->count];
+}
+
+/**
+ * Function: pushLaneMap
+ * 
+ * Description: queues the map read into the slot of nextLaneMap
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer
+ *     long long inputOffset - input offset after the map
+ * 
+ * Return value:
+ *     1 - if queue is full and must be flushed
+ *     0 - otherwise
+ */
+int pushLaneMap(laneQueue *qptr, long long inputOffset) {
+    qptr->offsets[qptr->count++] = inputOffset;
+
+    return qptr->count == LANE_QUEUE;
+}
+
+/**
+ * Function: flushLaneQueue
+ * 
+ * Description: solves every queued map in lanes and writes their solutions in input order,
+ *              marking each one written for the checkpoint
+ * 
+ * Side-effects: empties the queue
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer (or NULL)
+ *     FILE *fp - file where solutions are written
+ *     checkpoint *cptr - checkpoint pointer (or NULL)
+ * 
+ * Return value: none
+ */
+void flushLaneQueue(laneQueue *qptr, FILE *fp, checkpoint *cptr) {
+    if (qptr == NULL || qptr->count == 0) return;
+
+    TRACE_BEGIN("lanes");
+    solveLaneMaps(qptr, qptr->maps, qptr->count);
+    TRACE_END("lanes");
+
+    TRACE_BEGIN("write");
+    for (int k = 0; k < qptr->count; k++) {
+        writeLaneSolution(fp, &qptr->maps[k]);
+        markWritten(cptr, qptr->offsets[k]);
+    }
+    TRACE_END("write");
+
+    qptr->count = 0;
+}
+
+/**
+ * Function: solveLaneMaps
+ * 
+ * Description: solves tiny maps LANE_COUNT at a time: every round runs one propagation pass
+ *              over all lanes, then each lane still active decides a cell, backtracks or
+ *              finishes, and a lane that finishes takes the next map at once
+ * 
+ * Side-effects: writes result and tents of every map whose result is 0
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer (its lanes are used)
+ *     laneMap *maps - maps to be solved
+ *     int count - number of maps
+ * 
+ * Return value: none
+ */
+void solveLaneMaps(laneQueue *qptr, laneMap *maps, int count) {
+    laneState *lsptr = &qptr->lanes;
+    uint64_t active = 0, idle, settled, unknown, cell;
+    int next = 0, lane, result;
+
+    while (1) {
+        /** lanes that finished take the next maps, maps known to be impossible need no lane */
+        for (idle = ~active; idle != 0 && next < count; next++) {
+            if (maps[next].result != 0) continue;
+            if ((int) (maps[next].lineHints * FIRST_COLUMN >> 56) > __builtin_popcountll(maps[next].trees)) {
+                maps[next].result = -1;
+                continue;
+            }
+            lane = __builtin_ctzll(idle);
+            idle &= idle - 1;
+            loadLane(lsptr, lane, &maps[next], next);
+            active |= (uint64_t) 1 << lane;
+        }
+        if (active == 0) break;
+
+        /** lanes still propagating wait for the next pass, the others act on their board */
+        for (settled = propagateLanes(lsptr) & active; settled != 0; settled &= settled - 1) {
+            lane = __builtin_ctzll(settled);
+            unknown = lsptr->candidates[lane] & ~lsptr->tents[lane] & ~lsptr->grass[lane];
+            result = 0;
+
+            if ((lsptr->failed >> lane & 1) || !matchLaneTents(lsptr->trees[lane], lsptr->tents[lane])) {
+                if (lsptr->depth[lane] == 0) {
+                    result = -1;
+                } else {
+                    lsptr->depth[lane]--;
+                    lsptr->tents[lane] = lsptr->savedTents[lane][lsptr->depth[lane]];
+                    lsptr->grass[lane] = lsptr->savedGrass[lane][lsptr->depth[lane]];
+                }
+            } else if (unknown == 0) {
+                result = 1;
+            } else {
+                /** a tent on the first unknown cell, grass there is tried when it fails */
+                cell = unknown & -unknown;
+                lsptr->savedTents[lane][lsptr->depth[lane]] = lsptr->tents[lane];
+                lsptr->savedGrass[lane][lsptr->depth[lane]] = lsptr->grass[lane] | cell;
+                lsptr->depth[lane]++;
+                lsptr->tents[lane] |= cell;
+            }
+
+            if (result != 0) {
+                maps[lsptr->owner[lane]].result = result;
+                maps[lsptr->owner[lane]].tents = lsptr->tents[lane];
+                clearLane(lsptr, lane);
+                active &= ~((uint64_t) 1 << lane);
+            }
+        }
+    }
+}
+
+/**
+ * Function: writeLaneSolution
+ * 
+ * Description: writes the output of a tiny map to file, in the same form as writeSolution
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     laneMap *lptr - solved map
+ * 
+ * Return value: none
+ */
+void writeLaneSolution(FILE *fp, laneMap *lptr) {
+    char line[LANE_SIDE + 2];
+    uint64_t bit;
+
+    fprintf(fp, "%d %d %d\n", lptr->lines, lptr->columns, lptr->result);
+
+    if (lptr->result == 1) {
+        for (int i = 0; i < lptr->lines; i++) {
+            for (int j = 0; j < lptr->columns; j++) {
+                bit = (uint64_t) 1 << (LANE_SIDE * i + j);
+                line[j] = lptr->trees & bit ? 'A' : lptr->tents & bit ? 'T' : '.';
+            }
+            line[lptr->columns] = '\n';
+            line[lptr->columns + 1] = '\0';
+            fputs(line, fp);
+        }
+    }
+    fputc('\n', fp);
+}
+
+/**
+ * Function: propagateLanes
+ * 
+ * Description: runs one propagation pass on every lane: cells around tents turn to grass,
+ *              lines and columns whose hint is met turn their unknown cells to grass and the
+ *              ones that need every unknown cell turn them to tents, and when there are no
+ *              spare trees a tree left with a single cell for its tent gets it
+ * 
+ * Side-effects: writes tents, grass and failed of every lane
+ * 
+ * Arguments:
+ *     laneState *lsptr - lanes pointer
+ * 
+ * Return value:
+ *     mask of the lanes that are settled: their board is broken or the pass changed nothing
+ */
+uint64_t propagateLanes(laneState *lsptr) {
+    uint64_t tents, grass, unknown, near, count, sum, full, tight, open, up, down, left, right, ones, twos, bad;
+    uint64_t failed = 0, settled = 0;
+
+    for (int l = 0; l < LANE_COUNT; l++) {
+        tents = lsptr->tents[l];
+        grass = lsptr->grass[l];
+        unknown = lsptr->candidates[l] & ~tents & ~grass;
+
+        near = surroundingCells(tents);
+        bad = near & tents;
+        grass |= near & unknown;
+        unknown &= ~near;
+
+        /** lines are the bytes of a board and columns the bytes of its transpose */
+        count = bytePopcount(tents);
+        sum = count + bytePopcount(unknown);
+        bad |= byteGreater(count, lsptr->lineHints[l]) | byteGreater(lsptr->lineHints[l], sum);
+        full = byteEqual(count, lsptr->lineHints[l]);
+        tight = byteEqual(sum, lsptr->lineHints[l]);
+
+        count = bytePopcount(transposeBoard(tents));
+        sum = count + bytePopcount(transposeBoard(unknown));
+        bad |= byteGreater(count, lsptr->columnHints[l]) | byteGreater(lsptr->columnHints[l], sum);
+        full |= transposeBoard(byteEqual(count, lsptr->columnHints[l]));
+        tight |= transposeBoard(byteEqual(sum, lsptr->columnHints[l]));
+
+        /** a cell whose line is met while its column needs it (or the other way) can't be decided */
+        bad |= unknown & full & tight;
+        grass |= unknown & full;
+        tents |= unknown & tight & ~full;
+        unknown &= ~full & ~tight;
+
+        /** cells each tree may still have its tent in, seen from the tree */
+        open = tents | unknown;
+        up = open << LANE_SIDE;
+        down = open >> LANE_SIDE;
+        left = (open << 1) & ~FIRST_COLUMN;
+        right = (open >> 1) & ~LAST_COLUMN;
+        ones = up | down | left | right;
+        twos = (up & down) | (left & right) | ((up | down) & (left | right));
+
+        bad |= (uint64_t) (__builtin_popcountll(lsptr->trees[l] & ~ones) > lsptr->spare[l]);
+        tents |= orthogonalCells(lsptr->trees[l] & ones & ~twos) & unknown & -(uint64_t) (lsptr->spare[l] == 0);
+
+        failed |= (uint64_t) (bad != 0) << l;
+        settled |= (uint64_t) (bad != 0 || (tents == lsptr->tents[l] && grass == lsptr->grass[l])) << l;
+        lsptr->tents[l] = tents;
+        lsptr->grass[l] = grass;
+    }
+    lsptr->failed = failed;
+
+    return settled;
+}
+
+/**
+ * Function: loadLane
+ * 
+ * Description: puts a map in a lane, with no cell decided
+ * 
+ * Arguments:
+ *     laneState *lsptr - lanes pointer
+ *     int lane - lane
+ *     laneMap *lptr - map
+ *     int owner - index of map
+ * 
+ * Return value: none
+ */
+void loadLane(laneState *lsptr, int lane, laneMap *lptr, int owner) {
+    uint64_t inside = 0;
+
+    for (int i = 0; i < lptr->lines; i++) inside |= (((uint64_t) 1 << lptr->columns) - 1) << (LANE_SIDE * i);
+
+    lsptr->trees[lane] = lptr->trees;
+    lsptr->candidates[lane] = orthogonalCells(lptr->trees) & inside & ~lptr->trees;
+    lsptr->tents[lane] = 0;
+    lsptr->grass[lane] = 0;
+    lsptr->lineHints[lane] = lptr->lineHints;
+    lsptr->columnHints[lane] = lptr->columnHints;
+    lsptr->spare[lane] = __builtin_popcountll(lptr->trees) - (int) (lptr->lineHints * FIRST_COLUMN >> 56);
+    lsptr->depth[lane] = 0;
+    lsptr->owner[lane] = owner;
+}
+
+/**
+ * Function: clearLane
+ * 
+ * Description: empties a lane, propagation leaves an empty board as it is
+ * 
+ * Arguments:
+ *     laneState *lsptr - lanes pointer
+ *     int lane - lane
+ * 
+ * Return value: none
+ */
+void clearLane(laneState *lsptr, int lane) {
+    lsptr->trees[lane] = 0;
+    lsptr->candidates[lane] = 0;
+    lsptr->tents[lane] = 0;
+    lsptr->grass[lane] = 0;
+    lsptr->lineHints[lane] = 0;
+    lsptr->columnHints[lane] = 0;
+    lsptr->spare[lane] = 0;
+    lsptr->depth[lane] = 0;
+    lsptr->owner[lane] = -1;
+}
+
+/**
+ * Function: matchLaneTents
+ * 
+ * Description: checks that every tent can be given a tree of its own next to it (augmenting
+ *              paths, trees and tents are few)
+ * 
+ * Arguments:
+ *     uint64_t trees - trees of board
+ *     uint64_t tents - tents of board
+ * 
+ * Return value:
+ *     1 - if tents can be matched
+ *     0 - otherwise
+ */
+int matchLaneTents(uint64_t trees, uint64_t tents) {
+    int match[LANE_DEPTH];
+    uint64_t visited;
+
+    for (uint64_t left = trees; left != 0; left &= left - 1) match[__builtin_ctzll(left)] = -1;
+
+    for (; tents != 0; tents &= tents - 1) {
+        visited = 0;
+        if (!augmentLaneMatching(__builtin_ctzll(tents), trees, match, &visited)) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: augmentLaneMatching
+ * 
+ * Description: looks for an augmenting path from a tent, taking a free tree next to it or
+ *              one whose tent can move to another tree
+ * 
+ * Side-effects: updates match along the path found
+ * 
+ * Arguments:
+ *     int tent - cell of tent
+ *     uint64_t trees - trees of board
+ *     int *match - tent cell of every tree cell (-1 if free)
+ *     uint64_t *visited - trees already on the path
+ * 
+ * Return value:
+ *     1 - if tent got a tree
+ *     0 - otherwise
+ */
+int augmentLaneMatching(int tent, uint64_t trees, int *match, uint64_t *visited) {
+    uint64_t next = orthogonalCells((uint64_t) 1 << tent) & trees & ~*visited;
+    int tree;
+
+    for (; next != 0; next &= next - 1) {
+        tree = __builtin_ctzll(next);
+        *visited |= (uint64_t) 1 << tree;
+        if (match[tree] < 0 || augmentLaneMatching(match[tree], trees, match, visited)) {
+            match[tree] = tent;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Function: orthogonalCells
+ * 
+ * Description: gets the cells above, below, left and right of some cells of a board
+ * 
+ * Arguments:
+ *     uint64_t cells - cells of board
+ * 
+ * Return value:
+ *     cells next to them (they are left out unless next to one another)
+ */
+uint64_t orthogonalCells(uint64_t cells) {
+    return cells << LANE_SIDE | cells >> LANE_SIDE | ((cells << 1) & ~FIRST_COLUMN) | ((cells >> 1) & ~LAST_COLUMN);
+}
+
+/**
+ * Function: surroundingCells
+ * 
+ * Description: gets the eight cells around some cells of a board
+ * 
+ * Arguments:
+ *     uint64_t cells - cells of board
+ * 
+ * Return value:
+ *     cells around them (they are left out unless next to one another)
+ */
+uint64_t surroundingCells(uint64_t cells) {
+    uint64_t sides = ((cells << 1) & ~FIRST_COLUMN) | ((cells >> 1) & ~LAST_COLUMN);
+
+    return sides | (sides | cells) << LANE_SIDE | (sides | cells) >> LANE_SIDE;
+}
+
+/**
+ * Function: transposeBoard
+ * 
+ * Description: swaps lines and columns of a board, cell (i, j) goes to (j, i)
+ * 
+ * Arguments:
+ *     uint64_t board - board
+ * 
+ * Return value:
+ *     transposed board
+ */
+uint64_t transposeBoard(uint64_t board) {
+    uint64_t swap;
+
+    swap = (board ^ (board >> 7)) & 0x00AA00AA00AA00AAULL;
+    board ^= swap ^ (swap << 7);
+    swap = (board ^ (board >> 14)) & 0x0000CCCC0000CCCCULL;
+    board ^= swap ^ (swap << 14);
+    swap = (board ^ (board >> 28)) & 0x00000000F0F0F0F0ULL;
+    board ^= swap ^ (swap << 28);
+
+    return board;
+}
+
+/**
+ * Function: bytePopcount
+ * 
+ * Description: counts the bits set in every byte of a word
+ * 
+ * Arguments:
+ *     uint64_t bytes - word
+ * 
+ * Return value:
+ *     word whose byte i holds the number of bits set in byte i
+ */
+uint64_t bytePopcount(uint64_t bytes) {
+    bytes -= (bytes >> 1) & 0x5555555555555555ULL;
+    bytes = (bytes & 0x3333333333333333ULL) + ((bytes >> 2) & 0x3333333333333333ULL);
+
+    return (bytes + (bytes >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+}
+
+/**
+ * Function: byteGreater
+ * 
+ * Description: compares two words byte by byte (bytes below 128)
+ * 
+ * Arguments:
+ *     uint64_t a - first word
+ *     uint64_t b - second word
+ * 
+ * Return value:
+ *     word with the high bit of byte i set where byte i of a is greater than the one of b
+ */
+uint64_t byteGreater(uint64_t a, uint64_t b) {
+    return ~((b | HIGH_BITS) - a) & HIGH_BITS;
+}
+
+/**
+ * Function: byteEqual
+ * 
+ * Description: compares two words byte by byte
+ * 
+ * Arguments:
+ *     uint64_t a - first word
+ *     uint64_t b - second word
+ * 
+ * Return value:
+ *     word with every bit of byte i set where byte i of a equals the one of b
+ */
+uint64_t byteEqual(uint64_t a, uint64_t b) {
+    uint64_t diff = a ^ b;
+
+    diff = ~(((diff & LOW_BITS) + LOW_BITS) | diff | LOW_BITS);
+
+    return (diff >> 7) * 0xFF;
+}
@@ -0,0 +1,157 @@
+/**
+ * Filename: lanes.h
+ * 
+ * Description: Lane parallel solver of tiny maps, many maps of up to 8 by 8 cells are solved
+ *              at once with one 64 bit word per board
+ */
+
+#ifndef LANES_H
+#define LANES_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "checkpoint.h"
+
+/** largest number of lines and columns of a map solved in lanes, line i of a board is byte i of its word */
+#define LANE_SIDE 8
+
+/** maps solved in lockstep, one bit of a lane mask each */
+#define LANE_COUNT 64
+
+/** tiny maps read ahead before the queue is solved and written */
+#define LANE_QUEUE 4096
+
+/**
+ * Tiny map as read: size, trees and hints (byte i holds the hint of line or column i), result
+ * (0 until solved, -1 if already known to be impossible) and tents of its solution
+ */
+typedef struct {
+    int lines;
+    int columns;
+    int result;
+    uint64_t trees;
+    uint64_t tents;
+    uint64_t lineHints;
+    uint64_t columnHints;
+} laneMap;
+
+typedef struct laneQueueStruct laneQueue;
+
+/**
+ * Function: fitsLanes
+ * 
+ * Description: tells if a map is small enough to be solved in lanes
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     1 - if map fits a board of LANE_SIDE by LANE_SIDE cells
+ *     0 - otherwise
+ */
+int fitsLanes(int lines, int columns);
+
+/**
+ * Function: newLaneQueue
+ * 
+ * Description: allocates an empty queue of tiny maps together with the lanes solving them
+ * 
+ * Arguments: none
+ * 
+ * Return value:
+ *     pointer to new queue if successful
+ *     NULL if error ocurred
+ */
+laneQueue *newLaneQueue(void);
+
+/**
+ * Function: deleteLaneQueue
+ * 
+ * Description: deletes a queue of tiny maps (maps still queued are dropped)
+ * 
+ * Arguments:
+ *     laneQueue *qptr - pointer to queue to be deleted (or NULL)
+ * 
+ * Return value: none
+ */
+void deleteLaneQueue(laneQueue *qptr);
+
+/**
+ * Function: nextLaneMap
+ * 
+ * Description: gets the slot where the next tiny map is read, it is only queued once
+ *              pushLaneMap is called
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer
+ * 
+ * Return value:
+ *     pointer to free slot
+ */
+laneMap *nextLaneMap(laneQueue *qptr);
+
+/**
+ * Function: pushLaneMap
+ * 
+ * Description: queues the map read into the slot of nextLaneMap
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer
+ *     long long inputOffset - input offset after the map
+ * 
+ * Return value:
+ *     1 - if queue is full and must be flushed
+ *     0 - otherwise
+ */
+int pushLaneMap(laneQueue *qptr, long long inputOffset);
+
+/**
+ * Function: flushLaneQueue
+ * 
+ * Description: solves every queued map in lanes and writes their solutions in input order,
+ *              marking each one written for the checkpoint
+ * 
+ * Side-effects: empties the queue
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer (or NULL)
+ *     FILE *fp - file where solutions are written
+ *     checkpoint *cptr - checkpoint pointer (or NULL)
+ * 
+ * Return value: none
+ */
+void flushLaneQueue(laneQueue *qptr, FILE *fp, checkpoint *cptr);
+
+/**
+ * Function: solveLaneMaps
+ * 
+ * Description: solves tiny maps LANE_COUNT at a time: every round runs one propagation pass
+ *              over all lanes, then each lane still active decides a cell, backtracks or
+ *              finishes, and a lane that finishes takes the next map at once
+ * 
+ * Side-effects: writes result and tents of every map whose result is 0
+ * 
+ * Arguments:
+ *     laneQueue *qptr - queue pointer (its lanes are used)
+ *     laneMap *maps - maps to be solved
+ *     int count - number of maps
+ * 
+ * Return value: none
+ */
+void solveLaneMaps(laneQueue *qptr, laneMap *maps, int count);
+
+/**
+ * Function: writeLaneSolution
+ * 
+ * Description: writes the output of a tiny map to file, in the same form as writeSolution
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     laneMap *lptr - solved map
+ * 
+ * Return value: none
+ */
+void writeLaneSolution(FILE *fp, laneMap *lptr);
+
+#endif
@@ -9,43 +9,457 @@
  *           evaluation of the Algorithms and Data Structures course from
  *           Electrical and Computer Engineering degree, at Instituto Superior Técnico, Portugal.
  * 
+ * Usage:
+ *     tentsandtrees file.camp - solves every map of file.camp into file.tents
+ *     tentsandtrees --restarts [--seed n] file.camp - restarts searches that run into too many
+ *                                                     dead ends, reproducibly for a given seed
+ *     tentsandtrees --count file.camp - also writes the number of solutions in every header
+ *     tentsandtrees --unique file.camp - counts solutions up to two (2 means not unique)
+ *     tentsandtrees --batch [--workers n] file.camp - solves maps on n workers, cheapest first,
+ *                                                 writing solutions in input order and logging
+ *                                                 latencies in file.batch
+ *     tentsandtrees --portfolio file.camp - races several strategies per map, logging winners
+ *                                           in file.portfolio
+ *     tentsandtrees --daemon socket [--workers n] - serves solve requests on a Unix domain socket
+ *     tentsandtrees --memory n file.camp - skips maps estimated to need more than n MiB (result -2,
+ *                                          0 for no limit) and logs memory of every map in
+ *                                          file.memory
+ *     tentsandtrees --checkpoint s file.camp - saves progress in file.checkpoint every s seconds
+ *     tentsandtrees --resume file.camp - goes on from the last checkpoint, appending to file.tents
+ *     tentsandtrees --verify [--workers n] file.camp - checks file.tents against file.camp into file.verify
+ *     tentsandtrees --compress gzip|zstd file.camp - writes file.tents.gz or file.tents.zst, gzip
+ *                                                   and zstd maps (file.camp.gz) are read as well
+ *     tentsandtrees --index file.camp - writes offset, size and trees of every map in file.index
+ *     tentsandtrees --shard i/n file.camp - solves shard i (from 0) of n into file.i-of-n.tents
+ *     tentsandtrees --range first-last file.camp - solves maps first to last (from 0) into
+ *                                                  file.first-last.tents
+ *     tentsandtrees --merge n file.camp - joins the n shards of file.camp into file.tents
+ *     tentsandtrees --stats file.camp - times every route of the solver on every map, writing the
+ *                                       features and times of the maps in file.stats
+ *     tentsandtrees --train file.camp - fits the cost model to file.stats, writing file.model
+ *     tentsandtrees --model file.model file.camp - routes maps with the cost model of file.model
+ *     tentsandtrees --trace file.json file.camp - writes Chrome trace events of every phase, with
+ *                                                 hardware counters per solve (needs "make trace")
+ * 
  */
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "batch.h"
+#include "checkpoint.h"
+#include "daemon.h"
 #include "io.h"
+#include "lanes.h"
 #include "map.h"
+#include "mapindex.h"
+#include "portfolio.h"
+#include "solver.h"
+#include "stream.h"
+#include "trace.h"
+#include "verify.h"
 
 int main(int argc, char *argv[]) {
-    char *resultFilename;
-    FILE *fpIn, *fpOut;
+    char *inputFilename = NULL, *socketPath = NULL;
+    char *campFilename, *resultFilename, *logFilename, *checkpointFilename, *indexFilename, *temporaryFilename, *logMode = "w", *suffix = "";
+    FILE *fpIn, *fpOut, *fpLog, *fpMemory = NULL, *fpIndex;
+    struct stat campStat, indexStat;
+    indexEntry entry;
+    stream *mapStream, *solutionStream;
+    checkpoint *cptr = NULL;
     map *currentMap;
-    int lines, columns, result;
+    portfolio *pfptr;
+    workspace *wptr;
+    laneQueue *qptr = NULL;
+    solverOptions options;
+    costModel *model = NULL;
+    int lines, columns, result, ret, portfolioMode = 0, batchMode = 0, memoryMode = 0, resumeMode = 0, verifyMode = 0, compression = STREAM_PLAIN, closed;
+    int indexMode = 0, shard = 0, shards = 0, merge = 0, statsMode = 0, trainMode = 0;
+    long long count, countLimit = -1, bytes, peak = 0, maps = 0, inputOffset, outputOffset;
+    long long firstMap = 0, endMap = -1, mapsLeft = -1, firstOffset = -1;
+    double checkpointSeconds = -1;
+    int workers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+    defaultSolverOptions(&options);
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--daemon") && i + 1 < argc)
+            socketPath = argv[++i];
+        else if (!strcmp(argv[i], "--count"))
+            countLimit = 0;
+        else if (!strcmp(argv[i], "--unique"))
+            countLimit = 2;
+        else if (!strcmp(argv[i], "--portfolio"))
+            portfolioMode = 1;
+        else if (!strcmp(argv[i], "--batch"))
+            batchMode = 1;
+        else if (!strcmp(argv[i], "--verify"))
+            verifyMode = 1;
+        else if (!strcmp(argv[i], "--compress") && i + 1 < argc) {
+            i++;
+            compression = !strcmp(argv[i], "gzip") ? STREAM_GZIP : !strcmp(argv[i], "zstd") ? STREAM_ZSTD : -1;
+            if (!streamSupports(compression)) return EXIT_FAILURE;
+        } else if (!strcmp(argv[i], "--index"))
+            indexMode = 1;
+        else if (!strcmp(argv[i], "--shard") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%d/%d", &shard, &shards) != 2 || shard < 0 || shard >= shards) return 0;
+        } else if (!strcmp(argv[i], "--range") && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lld-%lld", &firstMap, &endMap) != 2 || firstMap < 0 || endMap < firstMap) return 0;
+            endMap++;
+        } else if (!strcmp(argv[i], "--merge") && i + 1 < argc) {
+            merge = atoi(argv[++i]);
+            if (merge <= 0) return 0;
+        } else if (!strcmp(argv[i], "--stats"))
+            statsMode = 1;
+        else if (!strcmp(argv[i], "--train"))
+            trainMode = 1;
+        else if (!strcmp(argv[i], "--model") && i + 1 < argc) {
+            model = loadCostModel(argv[++i]);
+            if (model == NULL) return EXIT_FAILURE;
+            options.model = model;
+        } else if (!strcmp(argv[i], "--workers") && i + 1 < argc)
+            workers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--restarts"))
+            options.restarts = 1;
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc)
+            options.seed = (unsigned int) strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--checkpoint") && i + 1 < argc)
+            checkpointSeconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--resume"))
+            resumeMode = 1;
+        else if (!strcmp(argv[i], "--memory") && i + 1 < argc) {
+            memoryMode = 1;
+            options.memoryBudget = strtoll(argv[++i], NULL, 10) * 1024 * 1024;
+        }
+#ifdef TRACE
+        else if (!strcmp(argv[i], "--trace") && i + 1 < argc) {
+            if (!openTrace(argv[++i])) return 0;
+        }
+#endif
+        else if (inputFilename == NULL)
+            inputFilename = argv[i];
+        else
+            return 0;
+    }
+
+    if (socketPath != NULL) return runDaemon(socketPath, workers);
+
+    if (inputFilename == NULL) return 0;
+
+    /** the index keeps offsets in the plain file, a decompression pipe can't seek to them */
+    if ((indexMode || shards > 0 || endMap >= 0) && fileCompression(inputFilename) != STREAM_PLAIN) {
+        fprintf(stderr, "--index, --shard and --range need an uncompressed .camp file\n");
+        return EXIT_FAILURE;
+    }
+
+    /** checkpoints keep offsets in input and output, which pipes of compressed streams don't have */
+    if ((checkpointSeconds >= 0 || resumeMode) && (compression != STREAM_PLAIN || fileCompression(inputFilename) != STREAM_PLAIN)) {
+        fprintf(stderr, "--checkpoint and --resume need uncompressed maps and solutions\n");
+        return EXIT_FAILURE;
+    }
+
+    campFilename = (char *) malloc((strlen(inputFilename) + 1) * sizeof(char));
+    if (campFilename == NULL) return EXIT_FAILURE;
+
+    /** a compressed file is named after the .camp it holds */
+    strcpy(campFilename, inputFilename);
+    if (strrchr(campFilename, '.') != NULL && (!strcmp(strrchr(campFilename, '.'), ".gz") || !strcmp(strrchr(campFilename, '.'), ".zst"))) *(strrchr(campFilename, '.')) = '\0';
+    if (strrchr(campFilename, '.') == NULL || strcmp(strrchr(campFilename, '.'), ".camp")) return 0;
+    if (compression == STREAM_GZIP) suffix = ".gz";
+    if (compression == STREAM_ZSTD) suffix = ".zst";
+
+    /** the model is fitted to the stats of an earlier run on the same maps */
+    if (trainMode) {
+        logFilename = (char *) malloc((strlen(campFilename) + 2) * sizeof(char));
+        resultFilename = (char *) malloc((strlen(campFilename) + 2) * sizeof(char));
+        if (logFilename == NULL || resultFilename == NULL) return EXIT_FAILURE;
+
+        strcpy(logFilename, campFilename);
+        *(strrchr(logFilename, '.')) = '\0';
+        strcpy(resultFilename, logFilename);
+        strcat(logFilename, ".stats");
+        strcat(resultFilename, ".model");
 
-    if (argc != 2) return 0;
-    if (strcmp(strrchr(argv[1], '.'), ".camp")) return 0;
+        fpLog = fopen(logFilename, "r");
+        if (fpLog == NULL) return EXIT_FAILURE;
+        fpOut = fopen(resultFilename, "w");
+        if (fpOut == NULL) return EXIT_FAILURE;
+
+        count = trainCostModel(fpLog, fpOut);
+
+        fclose(fpLog);
+        closed = fclose(fpOut) == 0;
+        free(campFilename);
+        free(logFilename);
+        free(resultFilename);
+        deleteCostModel(model);
+
+        return count > 0 && closed ? 0 : EXIT_FAILURE;
+    }
+
+    /** shards are appended in order, they hold consecutive maps */
+    if (merge > 0) {
+        resultFilename = (char *) malloc((strlen(campFilename) + 40) * sizeof(char));
+        if (resultFilename == NULL) return EXIT_FAILURE;
+
+        strcpy(resultFilename, campFilename);
+        *(strrchr(resultFilename, '.')) = '\0';
+        strcat(resultFilename, ".tents");
+        strcat(resultFilename, suffix);
+        solutionStream = openOutputStream(resultFilename, "w", compression);
+        if (solutionStream == NULL) return EXIT_FAILURE;
+
+        closed = 1;
+        for (int i = 0; i < merge && closed; i++) {
+            strcpy(resultFilename, campFilename);
+            sprintf(strrchr(resultFilename, '.'), ".%d-of-%d.tents%s", i, merge, suffix);
+            closed = appendFile(getStreamFile(solutionStream), resultFilename);
+        }
+        closed = closeStream(solutionStream) && closed;
+        free(campFilename);
+        free(resultFilename);
+
+        return closed ? 0 : EXIT_FAILURE;
+    }
+
+    /** the index is rebuilt when older than the maps, through a temporary file of its own as shards may run at once */
+    if (indexMode || ((shards > 0 || endMap >= 0) && !verifyMode)) {
+        indexFilename = (char *) malloc((strlen(campFilename) + 7) * sizeof(char));
+        temporaryFilename = (char *) malloc((strlen(campFilename) + 35) * sizeof(char));
+        if (indexFilename == NULL || temporaryFilename == NULL) return EXIT_FAILURE;
+
+        strcpy(indexFilename, campFilename);
+        *(strrchr(indexFilename, '.')) = '\0';
+        strcat(indexFilename, ".index");
+        sprintf(temporaryFilename, "%s.%ld.tmp", indexFilename, (long) getpid());
+        if (stat(inputFilename, &campStat)) return 0;
+        if (indexMode || stat(indexFilename, &indexStat) || indexStat.st_mtime < campStat.st_mtime) {
+            fpIn = fopen(inputFilename, "r");
+            fpIndex = fopen(temporaryFilename, "w");
+            if (fpIn == NULL || fpIndex == NULL) return EXIT_FAILURE;
+            if (buildMapIndex(fpIn, fpIndex) == READ_ERROR) {
+                fclose(fpIndex);
+                remove(temporaryFilename);
+                exit(READ_SYNC_FAILURE);
+            }
+            fclose(fpIn);
+            if (fclose(fpIndex) || rename(temporaryFilename, indexFilename)) return EXIT_FAILURE;
+        }
+        free(temporaryFilename);
+        if (indexMode) {
+            free(campFilename);
+            free(indexFilename);
+            return 0;
+        }
+
+        /** everything a shard writes is named as if it was a file of its own */
+        campFilename = (char *) realloc(campFilename, (strlen(campFilename) + 50) * sizeof(char));
+        if (campFilename == NULL) return EXIT_FAILURE;
+        if (shards > 0)
+            sprintf(strrchr(campFilename, '.'), ".%d-of-%d.camp", shard, shards);
+        else
+            sprintf(strrchr(campFilename, '.'), ".%lld-%lld.camp", firstMap, endMap - 1);
+
+        fpIndex = fopen(indexFilename, "r");
+        if (fpIndex == NULL) return EXIT_FAILURE;
+        if (shards > 0) findShard(fpIndex, shard, shards, &firstMap, &endMap);
+        if (endMap > countIndexEntries(fpIndex)) endMap = countIndexEntries(fpIndex);
+        if (endMap < firstMap) endMap = firstMap;
+        mapsLeft = endMap - firstMap;
+        if (mapsLeft > 0 && readIndexEntry(fpIndex, firstMap, &entry)) firstOffset = entry.offset;
+        fclose(fpIndex);
+        free(indexFilename);
+    }
 
-    resultFilename = (char *) malloc((strlen(argv[1]) + 2) * sizeof(char));
+    resultFilename = (char *) malloc((strlen(campFilename) + 6) * sizeof(char));
     if (resultFilename == NULL) return EXIT_FAILURE;
 
-    strcpy(resultFilename, argv[1]);
+    strcpy(resultFilename, campFilename);
     *(strrchr(resultFilename, '.')) = '\0';
     strcat(resultFilename, ".tents");
+    strcat(resultFilename, suffix);
+
+    checkpointFilename = (char *) malloc((strlen(campFilename) + 7) * sizeof(char));
+    if (checkpointFilename == NULL) return EXIT_FAILURE;
+
+    strcpy(checkpointFilename, campFilename);
+    *(strrchr(checkpointFilename, '.')) = '\0';
+    strcat(checkpointFilename, ".checkpoint");
+
+    mapStream = openInputStream(inputFilename);
+    if (mapStream == NULL) return 0;
+    fpIn = getStreamFile(mapStream);
+    if (firstOffset >= 0 && fseek(fpIn, firstOffset, SEEK_SET)) return EXIT_FAILURE;
+
+    if (verifyMode) {
+        solutionStream = openInputStream(resultFilename);
+        if (solutionStream == NULL) return EXIT_FAILURE;
+        fpOut = getStreamFile(solutionStream);
+
+        logFilename = (char *) malloc((strlen(campFilename) + 3) * sizeof(char));
+        if (logFilename == NULL) return EXIT_FAILURE;
+        strcpy(logFilename, campFilename);
+        *(strrchr(logFilename, '.')) = '\0';
+        strcat(logFilename, ".verify");
+
+        fpLog = fopen(logFilename, "w");
+        if (fpLog == NULL) return EXIT_FAILURE;
+
+        result = runVerify(fpIn, fpOut, fpLog, workers);
+        if (result == READ_ERROR) exit(READ_SYNC_FAILURE);
+
+        fclose(fpLog);
+        closed = closeStream(mapStream);
+        closed = closeStream(solutionStream) && closed;
+        free(logFilename);
+        free(campFilename);
+        free(resultFilename);
+        free(checkpointFilename);
+
+        return result && closed ? 0 : EXIT_FAILURE;
+    }
+
+    /** solutions after the checkpoint may be partly written, they are cut off and solved again */
+    if (resumeMode && readCheckpoint(checkpointFilename, &maps, &inputOffset, &outputOffset)) {
+        if (fseek(fpIn, inputOffset, SEEK_SET) || truncate(resultFilename, outputOffset)) return EXIT_FAILURE;
+        solutionStream = openOutputStream(resultFilename, "a", compression);
+        if (solutionStream == NULL || fseek(getStreamFile(solutionStream), 0, SEEK_END)) return EXIT_FAILURE;
+        logMode = "a";
+        if (mapsLeft >= 0) mapsLeft -= maps;
+    } else {
+        maps = 0;
+        solutionStream = openOutputStream(resultFilename, "w", compression);
+        if (solutionStream == NULL) return EXIT_FAILURE;
+    }
+    fpOut = getStreamFile(solutionStream);
+
+    if (resumeMode && checkpointSeconds < 0) checkpointSeconds = CHECKPOINT_SECONDS;
+    if (checkpointSeconds >= 0) {
+        cptr = newCheckpoint(checkpointFilename, fpOut, maps, checkpointSeconds);
+        if (cptr == NULL) return EXIT_FAILURE;
+    }
+
+    if (portfolioMode) {
+        logFilename = (char *) malloc((strlen(campFilename) + 6) * sizeof(char));
+        if (logFilename == NULL) return EXIT_FAILURE;
+        strcpy(logFilename, campFilename);
+        *(strrchr(logFilename, '.')) = '\0';
+        strcat(logFilename, ".portfolio");
+
+        fpLog = fopen(logFilename, logMode);
+        if (fpLog == NULL) return EXIT_FAILURE;
+
+        pfptr = newPortfolio(workers);
+        if (pfptr == NULL) return EXIT_FAILURE;
+
+        while (mapsLeft-- != 0 && readAndRaceMap(fpIn, &currentMap, &lines, &columns, &result, pfptr, fpLog)) {
+            writeSolution(fpOut, currentMap, lines, columns, result);
+            markWritten(cptr, ftell(fpIn));
+        }
+        writePortfolioSummary(pfptr, fpLog);
+
+        deletePortfolio(pfptr);
+        fclose(fpLog);
+        free(logFilename);
+    } else if (batchMode) {
+        logFilename = (char *) malloc((strlen(campFilename) + 2) * sizeof(char));
+        if (logFilename == NULL) return EXIT_FAILURE;
+        strcpy(logFilename, campFilename);
+        *(strrchr(logFilename, '.')) = '\0';
+        strcat(logFilename, ".batch");
+
+        fpLog = fopen(logFilename, logMode);
+        if (fpLog == NULL) return EXIT_FAILURE;
+
+        if (runBatch(fpIn, fpOut, fpLog, workers, &options, cptr, mapsLeft) == READ_ERROR) exit(READ_SYNC_FAILURE);
+
+        fclose(fpLog);
+        free(logFilename);
+    } else if (statsMode) {
+        logFilename = (char *) malloc((strlen(campFilename) + 2) * sizeof(char));
+        if (logFilename == NULL) return EXIT_FAILURE;
+        strcpy(logFilename, campFilename);
+        *(strrchr(logFilename, '.')) = '\0';
+        strcat(logFilename, ".stats");
+
+        fpLog = fopen(logFilename, logMode);
+        if (fpLog == NULL) return EXIT_FAILURE;
+        if (maps == 0) writeStatsHeader(fpLog);
+
+        wptr = newWorkspace();
+        if (wptr == NULL) return EXIT_FAILURE;
+        setWorkspaceThreads(wptr, workers);
+
+        while (mapsLeft-- != 0 && readAndBenchmarkMap(fpIn, &currentMap, &lines, &columns, &result, wptr, &options, fpLog)) {
+            writeSolution(fpOut, currentMap, lines, columns, result);
+            markWritten(cptr, ftell(fpIn));
+        }
+
+        deleteWorkspace(wptr);
+        fclose(fpLog);
+        free(logFilename);
+    } else if (countLimit >= 0) {
+        while (mapsLeft-- != 0 && readAndCountMap(fpIn, &currentMap, &lines, &columns, &result, &count, countLimit, workers)) {
+            writeSolutionCount(fpOut, currentMap, lines, columns, result, count);
+            markWritten(cptr, ftell(fpIn));
+        }
+    } else {
+        if (memoryMode) {
+            logFilename = (char *) malloc((strlen(campFilename) + 3) * sizeof(char));
+            if (logFilename == NULL) return EXIT_FAILURE;
+            strcpy(logFilename, campFilename);
+            *(strrchr(logFilename, '.')) = '\0';
+            strcat(logFilename, ".memory");
+
+            fpMemory = fopen(logFilename, logMode);
+            if (fpMemory == NULL) return EXIT_FAILURE;
+            free(logFilename);
+        }
+
+        wptr = newWorkspace();
+        if (wptr == NULL) return EXIT_FAILURE;
+        setWorkspaceThreads(wptr, workers);
 
-    fpIn = fopen(argv[1], "r");
-    if (fpIn == NULL) return 0;
+        /** tiny maps wait in lanes, the ones before a map solved alone are written first */
+        if (!memoryMode) {
+            qptr = newLaneQueue();
+            if (qptr == NULL) return EXIT_FAILURE;
+        }
 
-    fpOut = fopen(resultFilename, "w");
-    if (fpOut == NULL) return EXIT_FAILURE;
+        while (mapsLeft-- != 0 && (ret = readAndQueueMap(fpIn, &currentMap, &lines, &columns, &result, wptr, &options, qptr))) {
+            if (ret == READ_QUEUED) {
+                if (pushLaneMap(qptr, ftell(fpIn))) flushLaneQueue(qptr, fpOut, cptr);
+                continue;
+            }
+            flushLaneQueue(qptr, fpOut, cptr);
+            if (fpMemory != NULL) {
+                bytes = writeMemoryUsage(fpMemory, currentMap, wptr, lines, columns, result);
+                if (bytes > peak) peak = bytes;
+            }
+            writeSolution(fpOut, currentMap, lines, columns, result);
+            markWritten(cptr, ftell(fpIn));
+        }
+        flushLaneQueue(qptr, fpOut, cptr);
 
-    while (readAndSolveMap(fpIn, &currentMap, &lines, &columns, &result)) {
-        writeSolution(fpOut, currentMap, lines, columns, result);
+        if (fpMemory != NULL) {
+            writeMemorySummary(fpMemory, peak);
+            fclose(fpMemory);
+        }
+        deleteWorkspace(wptr);
+        deleteLaneQueue(qptr);
     }
 
-    fclose(fpIn);
-    fclose(fpOut);
+    deleteCheckpoint(cptr);
+    closed = closeStream(mapStream);
+    closed = closeStream(solutionStream) && closed;
+    free(campFilename);
     free(resultFilename);
+    free(checkpointFilename);
+    deleteCostModel(model);
 
-    return 0;
+    return closed ? 0 : EXIT_FAILURE;
 }
\ No newline at end of file
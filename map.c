@@ -5,9 +5,27 @@
  */
 
 #include "map.h"
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include "table.h"
 
+/** a sparse map becomes a grid once more than one cell in SPARSE_MAX_DENSITY is stored */
+#define SPARSE_MAX_DENSITY 16
+/** bytes malloc keeps next to every block, counted by memory estimates */
+#define ALLOCATION_OVERHEAD 16
+
+typedef struct {
+    int32_t line;
+    int32_t column;
+} position;
+
+/**
+ * Sparse maps have no grid (map is NULL), only cells that are not '.' are kept in a table of
+ * positions with their contents in values. Lines are materialised one at a time in lineBuffer
+ * from a per line index of stored cells, rebuilt whenever cells were added since. A sparse map
+ * with keepSparse set never turns into a grid.
+ */
 struct mapStruct {
     int lines;
     int columns;
@@ -17,8 +35,20 @@ struct mapStruct {
     int tentsNumber;
     int treesNumber;
     int uncertainCount;
+    table *cells;
+    char *values;
+    int valueCapacity;
+    int *lineStart;
+    int *lineCells;
+    int indexedCells;
+    char *lineBuffer;
+    int keepSparse;
 };
 
+char getSparseContent(map *mptr, int line, int column);
+void densifyMap(map *mptr);
+void indexLines(map *mptr);
+
 /**
  * Function: newMap
  * 
@@ -43,6 +73,14 @@ map *newMap(int lines, int columns) {
     mptr->lines = lines;
     mptr->columns = columns;
     mptr->uncertainCount = 0;
+    mptr->cells = NULL;
+    mptr->values = NULL;
+    mptr->valueCapacity = 0;
+    mptr->lineStart = NULL;
+    mptr->lineCells = NULL;
+    mptr->indexedCells = -1;
+    mptr->lineBuffer = NULL;
+    mptr->keepSparse = 0;
 
     mptr->map = (char **) malloc(lines * sizeof(char *));
     if (mptr->map == NULL) return NULL;
@@ -60,6 +98,57 @@ map *newMap(int lines, int columns) {
 
     return mptr;
 }
+/**
+ * Function: newSparseMap
+ * 
+ * Description: allocates new map that keeps only the cells that are not '.', memory then grows
+ *              with the number of trees (and cells around them) instead of the area of the map.
+ *              While lines are set, the map turns into a plain grid if it is not sparse after all
+ *              (unless it is kept sparse)
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred
+ */
+map *newSparseMap(int lines, int columns) {
+    map *mptr;
+
+    if (lines < 0 || columns < 0) return NULL;
+
+    mptr = (map *) malloc(sizeof(map));
+    if (mptr == NULL) return NULL;
+
+    mptr->lines = lines;
+    mptr->columns = columns;
+    mptr->uncertainCount = 0;
+    mptr->map = NULL;
+    mptr->values = NULL;
+    mptr->valueCapacity = 0;
+    mptr->lineStart = NULL;
+    mptr->lineCells = NULL;
+    mptr->indexedCells = -1;
+    mptr->keepSparse = 0;
+
+    mptr->cells = newTable(sizeof(position));
+    if (mptr->cells == NULL) return NULL;
+
+    mptr->lineBuffer = (char *) malloc(columns + 1 * sizeof(char));
+    if (mptr->lineBuffer == NULL) return NULL;
+    mptr->lineBuffer[columns] = '\0';
+
+    mptr->tentsInLine = (int *) malloc(lines * sizeof(int));
+    if (mptr->tentsInLine == NULL) return NULL;
+
+    mptr->tentsInColumn = (int *) malloc(columns * sizeof(int));
+    if (mptr->tentsInColumn == NULL) return NULL;
+
+    return mptr;
+}
+
 /**
  * Function: deleteMap
  * 
@@ -73,10 +162,18 @@ map *newMap(int lines, int columns) {
 void deleteMap(map *mptr) {
     if (mptr == NULL) return;
 
-    for (int i = 0; i < mptr->lines; i++) {
-        free(mptr->map[i]);
+    if (mptr->map != NULL) {
+        for (int i = 0; i < mptr->lines; i++) {
+            free(mptr->map[i]);
+        }
+        free(mptr->map);
     }
-    free(mptr->map);
+
+    deleteTable(mptr->cells);
+    free(mptr->values);
+    free(mptr->lineStart);
+    free(mptr->lineCells);
+    free(mptr->lineBuffer);
 
     free(mptr->tentsInLine);
     free(mptr->tentsInColumn);
@@ -84,6 +181,79 @@ void deleteMap(map *mptr) {
     free(mptr);
 }
 
+/**
+ * Function: copyMap
+ * 
+ * Description: allocates a new map with the same contents as another
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map to be copied
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred
+ */
+map *copyMap(map *mptr) {
+    map *copy;
+    position *cell;
+
+    if (mptr->map == NULL) {
+        copy = newSparseMap(mptr->lines, mptr->columns);
+        if (copy == NULL) return NULL;
+        copy->keepSparse = mptr->keepSparse;
+
+        for (int i = 0; i < getTableSize(mptr->cells); i++) {
+            cell = (position *) getKey(mptr->cells, i);
+            setContentOfPosition(copy, cell->line, cell->column, mptr->values[i]);
+        }
+    } else {
+        copy = newMap(mptr->lines, mptr->columns);
+        if (copy == NULL) return NULL;
+
+        for (int i = 0; i < mptr->lines; i++) {
+            memcpy(copy->map[i], mptr->map[i], mptr->columns + 1);
+        }
+    }
+    setTentsInfo(copy, mptr->tentsInLine, mptr->tentsInColumn);
+    copy->tentsNumber = mptr->tentsNumber;
+    copy->treesNumber = mptr->treesNumber;
+    copy->uncertainCount = mptr->uncertainCount;
+
+    return copy;
+}
+
+/**
+ * Function: sparseCopyMap
+ * 
+ * Description: allocates a sparse map, kept sparse, with the hints of a grid map and the trees
+ *              in its first lines (the ones already read, other marks are left behind)
+ * 
+ * Arguments:
+ *     map *mptr - pointer to grid map
+ *     int lines - number of lines to be copied
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred
+ */
+map *sparseCopyMap(map *mptr, int lines) {
+    map *copy;
+
+    copy = newSparseMap(mptr->lines, mptr->columns);
+    if (copy == NULL) return NULL;
+    copy->keepSparse = 1;
+
+    for (int i = 0; i < lines; i++) {
+        for (int j = 0; j < mptr->columns; j++) {
+            if (mptr->map[i][j] == 'A') setContentOfPosition(copy, i, j, 'A');
+        }
+    }
+    setTentsInfo(copy, mptr->tentsInLine, mptr->tentsInColumn);
+    copy->tentsNumber = mptr->tentsNumber;
+
+    return copy;
+}
+
 /**
  * Function: getMapLines
  * 
@@ -114,6 +284,119 @@ int getMapColumns(map *mptr) {
     return mptr->columns;
 }
 
+/**
+ * Function: isSparseMap
+ * 
+ * Description: tells if map keeps only the cells that are not '.'
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ * 
+ * Return value:
+ *     1 - if map is sparse
+ *     0 - if map is a grid
+ */
+int isSparseMap(map *mptr) {
+    return mptr->map == NULL;
+}
+
+/**
+ * Function: keepMapSparse
+ * 
+ * Description: keeps a sparse map sparse whatever the number of cells set, for maps whose grid
+ *              would not fit in memory
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ * 
+ * Return value: none
+ */
+void keepMapSparse(map *mptr) {
+    mptr->keepSparse = 1;
+}
+
+/**
+ * Function: estimateMapBytes
+ * 
+ * Description: estimates bytes held by a map of a given size, either a grid or a sparse map
+ *              storing a number of cells (with room for its tables to double)
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     long long storedCells - number of cells stored by a sparse map (-1 for a grid)
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long estimateMapBytes(int lines, int columns, long long storedCells) {
+    long long bytes = sizeof(map) + ((long long) lines + columns) * sizeof(int);
+
+    if (storedCells < 0) return bytes + (long long) lines * (columns + 1 + sizeof(char *) + ALLOCATION_OVERHEAD);
+
+    bytes += columns + 1 + ((long long) lines + 1) * sizeof(int);
+    return bytes + 2 * storedCells * (sizeof(position) + sizeof(char) + 2 * sizeof(int)) + storedCells * sizeof(int);
+}
+
+/**
+ * Function: getMapBytes
+ * 
+ * Description: gets bytes held by a map, its grid or its tables and line index
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long getMapBytes(map *mptr) {
+    long long bytes = sizeof(map) + ((long long) mptr->lines + mptr->columns) * sizeof(int);
+
+    if (mptr->map != NULL) return bytes + (long long) mptr->lines * (mptr->columns + 1 + sizeof(char *) + ALLOCATION_OVERHEAD);
+
+    bytes += getTableBytes(mptr->cells) + mptr->valueCapacity + mptr->columns + 1;
+    if (mptr->lineStart != NULL) bytes += ((long long) mptr->lines + 1 + mptr->indexedCells) * sizeof(int);
+    return bytes;
+}
+
+/**
+ * Function: getStoredCells
+ * 
+ * Description: gets number of cells stored by a sparse map
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ * 
+ * Return value:
+ *     number of stored cells
+ */
+int getStoredCells(map *mptr) {
+    return getTableSize(mptr->cells);
+}
+
+/**
+ * Function: getStoredCell
+ * 
+ * Description: gets a cell stored by a sparse map, cells are numbered from 0 in the order they
+ *              were first set (so trees of a map read line by line come first, in line order)
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ *     int index - number of cell
+ *     int *line - returns line of cell
+ *     int *column - returns column of cell
+ * 
+ * Return value:
+ *     content of cell
+ */
+char getStoredCell(map *mptr, int index, int *line, int *column) {
+    position *cell = (position *) getKey(mptr->cells, index);
+
+    *line = cell->line;
+    *column = cell->column;
+    return mptr->values[index];
+}
+
 /**
  * Function: setContentOfPosition
  * 
@@ -128,7 +411,29 @@ int getMapColumns(map *mptr) {
  * Return value: none
  */
 void setContentOfPosition(map *mptr, int line, int column, char val) {
-    mptr->map[line][column] = val;
+    position cell;
+    int index;
+
+    if (mptr->map != NULL) {
+        mptr->map[line][column] = val;
+        return;
+    }
+
+    cell.line = line;
+    cell.column = column;
+    if (val == '.') {
+        index = findKey(mptr->cells, &cell);
+        if (index != -1) mptr->values[index] = val;
+        return;
+    }
+
+    insertKey(mptr->cells, &cell, &index);
+    if (index == mptr->valueCapacity) {
+        mptr->valueCapacity = mptr->valueCapacity ? 2 * mptr->valueCapacity : 1024;
+        mptr->values = (char *) realloc(mptr->values, mptr->valueCapacity * sizeof(char));
+        if (mptr->values == NULL) exit(EXIT_FAILURE);
+    }
+    mptr->values[index] = val;
 }
 
 /**
@@ -148,9 +453,34 @@ void setContentOfPosition(map *mptr, int line, int column, char val) {
 char getContentOfPosition(map *mptr, int line, int column) {
     if (line >= mptr->lines || column >= mptr->columns) return '\0';
     if (line < 0 || column < 0) return '\0';
+    if (mptr->map == NULL) return getSparseContent(mptr, line, column);
     return mptr->map[line][column];
 }
 
+/**
+ * Function: getSparseContent
+ * 
+ * Description: gets content of position inside a sparse map
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ *     int line - line of coordinate
+ *     int column - column of coordinate
+ * 
+ * Return value:
+ *     content of position with specified coordinates of map
+ */
+char getSparseContent(map *mptr, int line, int column) {
+    position cell;
+    int index;
+
+    cell.line = line;
+    cell.column = column;
+    index = findKey(mptr->cells, &cell);
+
+    return index == -1 ? '.' : mptr->values[index];
+}
+
 /**
  * Function: setMapLine
  * 
@@ -164,13 +494,53 @@ char getContentOfPosition(map *mptr, int line, int column) {
  * Return value: none
  */
 void setMapLine(map *mptr, int line, char *lineString) {
-    strcpy(mptr->map[line], lineString);
+    if (mptr->map != NULL) {
+        strcpy(mptr->map[line], lineString);
+        return;
+    }
+
+    for (int j = 0; j < mptr->columns && lineString[j] != '\0'; j++) {
+        if (lineString[j] != '.') setContentOfPosition(mptr, line, j, lineString[j]);
+    }
+    if (mptr->keepSparse) return;
+    if ((long long) getTableSize(mptr->cells) * SPARSE_MAX_DENSITY > (long long) mptr->lines * mptr->columns) densifyMap(mptr);
+}
+
+/**
+ * Function: setMapLineTrees
+ * 
+ * Description: sets content of entire line as a string whose trees are already known as a
+ *              bitmask (see scanRow), sparse maps store the trees without looking at the string
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int line - line of coordinate
+ *     char *lineString - string containing entire line (only 'A' and '.')
+ *     uint64_t *trees - tree bitmask of line
+ * 
+ * Return value: none
+ */
+void setMapLineTrees(map *mptr, int line, char *lineString, uint64_t *trees) {
+    uint64_t bits;
+
+    if (mptr->map != NULL) {
+        memcpy(mptr->map[line], lineString, mptr->columns + 1);
+        return;
+    }
+
+    for (int w = 0; w < (mptr->columns + 63) / 64; w++) {
+        for (bits = trees[w]; bits; bits &= bits - 1) setContentOfPosition(mptr, line, 64 * w + __builtin_ctzll(bits), 'A');
+    }
+    if (mptr->keepSparse) return;
+    if ((long long) getTableSize(mptr->cells) * SPARSE_MAX_DENSITY > (long long) mptr->lines * mptr->columns) densifyMap(mptr);
 }
 
 /**
  * Function: getMapLine
  * 
- * Description: gets content of entire line as a string
+ * Description: gets content of entire line as a string, lines of a sparse map are materialised
+ *              on request in a buffer of the map, overwritten by the next call (and writes to it
+ *              are not kept)
  * 
  * Arguments:
  *     map *mptr - pointer to map
@@ -179,7 +549,100 @@ void setMapLine(map *mptr, int line, char *lineString) {
  * Return value: string containing entire line
  */
 char *getMapLine(map *mptr, int line) {
-    return mptr->map[line];
+    int index;
+
+    if (mptr->map != NULL) return mptr->map[line];
+
+    if (mptr->indexedCells != getTableSize(mptr->cells)) indexLines(mptr);
+
+    memset(mptr->lineBuffer, '.', mptr->columns);
+    for (int k = mptr->lineStart[line]; k < mptr->lineStart[line + 1]; k++) {
+        index = mptr->lineCells[k];
+        mptr->lineBuffer[((position *) getKey(mptr->cells, index))->column] = mptr->values[index];
+    }
+
+    return mptr->lineBuffer;
+}
+
+/**
+ * Function: densifyMap
+ * 
+ * Description: turns a sparse map into a grid
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ * 
+ * Return value: none
+ */
+void densifyMap(map *mptr) {
+    position *cell;
+
+    mptr->map = (char **) malloc(mptr->lines * sizeof(char *));
+    if (mptr->map == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < mptr->lines; i++) {
+        mptr->map[i] = (char *) malloc(mptr->columns + 1 * sizeof(char));
+        if (mptr->map[i] == NULL) exit(EXIT_FAILURE);
+        memset(mptr->map[i], '.', mptr->columns);
+        mptr->map[i][mptr->columns] = '\0';
+    }
+
+    for (int i = 0; i < getTableSize(mptr->cells); i++) {
+        cell = (position *) getKey(mptr->cells, i);
+        mptr->map[cell->line][cell->column] = mptr->values[i];
+    }
+
+    deleteTable(mptr->cells);
+    free(mptr->values);
+    free(mptr->lineStart);
+    free(mptr->lineCells);
+    free(mptr->lineBuffer);
+    mptr->cells = NULL;
+    mptr->values = NULL;
+    mptr->valueCapacity = 0;
+    mptr->lineStart = NULL;
+    mptr->lineCells = NULL;
+    mptr->indexedCells = -1;
+    mptr->lineBuffer = NULL;
+}
+
+/**
+ * Function: indexLines
+ * 
+ * Description: sorts stored cells of a sparse map by line (counting sort), lineCells from
+ *              lineStart[i] to lineStart[i + 1] are then the cells of line i
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ * 
+ * Return value: none
+ */
+void indexLines(map *mptr) {
+    int size = getTableSize(mptr->cells);
+    int line;
+
+    free(mptr->lineStart);
+    free(mptr->lineCells);
+    mptr->lineStart = (int *) calloc(mptr->lines + 1, sizeof(int));
+    mptr->lineCells = (int *) malloc(size * sizeof(int) + 1);
+    if (mptr->lineStart == NULL || mptr->lineCells == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < size; i++) {
+        mptr->lineStart[((position *) getKey(mptr->cells, i))->line + 1]++;
+    }
+    for (int i = 0; i < mptr->lines; i++) {
+        mptr->lineStart[i + 1] += mptr->lineStart[i];
+    }
+    for (int i = size - 1; i >= 0; i--) {
+        line = ((position *) getKey(mptr->cells, i))->line;
+        mptr->lineCells[--mptr->lineStart[line + 1]] = i;
+    }
+    for (int i = 0; i < mptr->lines; i++) {
+        mptr->lineStart[i] = mptr->lineStart[i + 1];
+    }
+    mptr->lineStart[mptr->lines] = size;
+
+    mptr->indexedCells = size;
 }
 
 /**
@@ -231,6 +694,38 @@ int getTentsInColumn(map *mptr, int column) {
     return mptr->tentsInColumn[column];
 }
 
+/**
+ * Function: setTentsInLine
+ * 
+ * Description: sets hint about number of tents in line
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int line - number of line
+ *     int tents - number of tents in line
+ * 
+ * Return value: none
+ */
+void setTentsInLine(map *mptr, int line, int tents) {
+    mptr->tentsInLine[line] = tents;
+}
+
+/**
+ * Function: setTentsInColumn
+ * 
+ * Description: sets hint about number of tents in column
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int column - number of column
+ *     int tents - number of tents in column
+ * 
+ * Return value: none
+ */
+void setTentsInColumn(map *mptr, int column, int tents) {
+    mptr->tentsInColumn[column] = tents;
+}
+
 /**
  * Function: getTentsNumber
  * 
@@ -306,6 +801,21 @@ int getUncertainCount(map *mptr) {
     return mptr->uncertainCount;
 }
 
+/**
+ * Function: setUncertainCount
+ * 
+ * Description: sets uncertain count
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int uncertainCount - uncertain count
+ * 
+ * Return value: none
+ */
+void setUncertainCount(map *mptr, int uncertainCount) {
+    mptr->uncertainCount = uncertainCount;
+}
+
 /**
  * Function: incrementUncertainCount
  * 
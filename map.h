@@ -7,6 +7,8 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include <stdint.h>
+
 typedef struct mapStruct map;
 
 /**
@@ -24,6 +26,24 @@ typedef struct mapStruct map;
  */
 map *newMap(int lines, int columns);
 
+/**
+ * Function: newSparseMap
+ * 
+ * Description: allocates new map that keeps only the cells that are not '.', memory then grows
+ *              with the number of trees (and cells around them) instead of the area of the map.
+ *              While lines are set, the map turns into a plain grid if it is not sparse after all
+ *              (unless it is kept sparse)
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred
+ */
+map *newSparseMap(int lines, int columns);
+
 /**
  * Function: deleteMap
  * 
@@ -36,6 +56,36 @@ map *newMap(int lines, int columns);
  */
 void deleteMap(map *mptr);
 
+/**
+ * Function: copyMap
+ * 
+ * Description: allocates a new map with the same contents as another
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map to be copied
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred
+ */
+map *copyMap(map *mptr);
+
+/**
+ * Function: sparseCopyMap
+ * 
+ * Description: allocates a sparse map, kept sparse, with the hints of a grid map and the trees
+ *              in its first lines (the ones already read, other marks are left behind)
+ * 
+ * Arguments:
+ *     map *mptr - pointer to grid map
+ *     int lines - number of lines to be copied
+ * 
+ * Return value:
+ *     pointer to new map if successful
+ *     NULL if error ocurred
+ */
+map *sparseCopyMap(map *mptr, int lines);
+
 /**
  * Function: getMapLines
  * 
@@ -62,6 +112,92 @@ int getMapLines(map *mptr);
  */
 int getMapColumns(map *mptr);
 
+/**
+ * Function: isSparseMap
+ * 
+ * Description: tells if map keeps only the cells that are not '.'
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ * 
+ * Return value:
+ *     1 - if map is sparse
+ *     0 - if map is a grid
+ */
+int isSparseMap(map *mptr);
+
+/**
+ * Function: keepMapSparse
+ * 
+ * Description: keeps a sparse map sparse whatever the number of cells set, for maps whose grid
+ *              would not fit in memory
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ * 
+ * Return value: none
+ */
+void keepMapSparse(map *mptr);
+
+/**
+ * Function: estimateMapBytes
+ * 
+ * Description: estimates bytes held by a map of a given size, either a grid or a sparse map
+ *              storing a number of cells (with room for its tables to double)
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     long long storedCells - number of cells stored by a sparse map (-1 for a grid)
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long estimateMapBytes(int lines, int columns, long long storedCells);
+
+/**
+ * Function: getMapBytes
+ * 
+ * Description: gets bytes held by a map, its grid or its tables and line index
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long getMapBytes(map *mptr);
+
+/**
+ * Function: getStoredCells
+ * 
+ * Description: gets number of cells stored by a sparse map
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ * 
+ * Return value:
+ *     number of stored cells
+ */
+int getStoredCells(map *mptr);
+
+/**
+ * Function: getStoredCell
+ * 
+ * Description: gets a cell stored by a sparse map, cells are numbered from 0 in the order they
+ *              were first set (so trees of a map read line by line come first, in line order)
+ * 
+ * Arguments:
+ *     map *mptr - pointer to sparse map
+ *     int index - number of cell
+ *     int *line - returns line of cell
+ *     int *column - returns column of cell
+ * 
+ * Return value:
+ *     content of cell
+ */
+char getStoredCell(map *mptr, int index, int *line, int *column);
+
 /**
  * Function: setContentOfPosition
  * 
@@ -107,10 +243,28 @@ char getContentOfPosition(map *mptr, int line, int column);
  */
 void setMapLine(map *mptr, int line, char *lineString);
 
+/**
+ * Function: setMapLineTrees
+ * 
+ * Description: sets content of entire line as a string whose trees are already known as a
+ *              bitmask (see scanRow), sparse maps store the trees without looking at the string
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int line - line of coordinate
+ *     char *lineString - string containing entire line (only 'A' and '.')
+ *     uint64_t *trees - tree bitmask of line
+ * 
+ * Return value: none
+ */
+void setMapLineTrees(map *mptr, int line, char *lineString, uint64_t *trees);
+
 /**
  * Function: getMapLine
  * 
- * Description: gets content of entire line as a string
+ * Description: gets content of entire line as a string, lines of a sparse map are materialised
+ *              on request in a buffer of the map, overwritten by the next call (and writes to it
+ *              are not kept)
  * 
  * Arguments:
  *     map *mptr - pointer to map
@@ -162,6 +316,34 @@ int getTentsInLine(map *mptr, int line);
  */
 int getTentsInColumn(map *mptr, int column);
 
+/**
+ * Function: setTentsInLine
+ * 
+ * Description: sets hint about number of tents in line
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int line - number of line
+ *     int tents - number of tents in line
+ * 
+ * Return value: none
+ */
+void setTentsInLine(map *mptr, int line, int tents);
+
+/**
+ * Function: setTentsInColumn
+ * 
+ * Description: sets hint about number of tents in column
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int column - number of column
+ *     int tents - number of tents in column
+ * 
+ * Return value: none
+ */
+void setTentsInColumn(map *mptr, int column, int tents);
+
 /**
  * Function: getTentsNumber
  * 
@@ -227,6 +409,19 @@ void setTreesNumber(map *mptr, int treesNumber);
  */
 int getUncertainCount(map *mptr);
 
+/**
+ * Function: setUncertainCount
+ * 
+ * Description: sets uncertain count
+ * 
+ * Arguments:
+ *     map *mptr - pointer to map
+ *     int uncertainCount - uncertain count
+ * 
+ * Return value: none
+ */
+void setUncertainCount(map *mptr, int uncertainCount);
+
 /**
  * Function: incrementUncertainCount
  * 
@@ -0,0 +1,185 @@
+/**
+ * Filename: mapindex.c
+ * 
+ * Description: Sidecar index of the maps of a file (offset, size and trees of every map), for
+ *              jumping to a map and splitting a file into shards
+ */
+
+#include "mapindex.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include "io.h"
+#include "stream.h"
+
+/** weight of a tree against a cell when splitting shards, as up to 4 candidates surround it */
+#define SHARD_TREE_WEIGHT 64
+
+/** bytes copied at a time when appending files */
+#define APPEND_CHUNK (1 << 16)
+
+int readNextEntry(FILE *fpIndex, indexEntry *eptr);
+double entryCost(indexEntry *eptr);
+
+/**
+ * Function: buildMapIndex
+ * 
+ * Description: scans every map of a file, without keeping them, and writes a record
+ *              "offset lines columns trees" per map
+ * 
+ * Arguments:
+ *     FILE *fpIn - file with the maps (must be seekable)
+ *     FILE *fpIndex - file where records are written
+ * 
+ * Return value:
+ *     number of maps indexed
+ *     READ_ERROR - if input is malformed or can't tell offsets
+ */
+long long buildMapIndex(FILE *fpIn, FILE *fpIndex) {
+    long long maps = 0, offset, trees;
+    int lines, columns, ret;
+
+    while ((offset = ftell(fpIn)) >= 0 && (ret = scanMap(fpIn, &lines, &columns, &trees)) == 1) {
+        fprintf(fpIndex, "%20lld %10d %10d %20lld\n", offset, lines, columns, trees);
+        maps++;
+    }
+    if (offset < 0 || ret == READ_ERROR) return READ_ERROR;
+
+    return maps;
+}
+
+/**
+ * Function: countIndexEntries
+ * 
+ * Description: gets the number of maps of an index file
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ * 
+ * Return value:
+ *     number of maps
+ */
+long long countIndexEntries(FILE *fpIndex) {
+    if (fseek(fpIndex, 0, SEEK_END)) return 0;
+
+    return ftell(fpIndex) / INDEX_RECORD;
+}
+
+/**
+ * Function: readIndexEntry
+ * 
+ * Description: reads the record of a map, seeking straight to it
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ *     long long number - number of map (from 0)
+ *     indexEntry *eptr - returns record of map
+ * 
+ * Return value:
+ *     1 - if record was read
+ *     0 - if there is no such map
+ */
+int readIndexEntry(FILE *fpIndex, long long number, indexEntry *eptr) {
+    if (number < 0 || fseek(fpIndex, number * INDEX_RECORD, SEEK_SET)) return 0;
+
+    return readNextEntry(fpIndex, eptr);
+}
+
+/**
+ * Function: findShard
+ * 
+ * Description: finds the maps of a shard of a file split in shards of consecutive maps with
+ *              about the same estimated cost (cells plus weighted trees)
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ *     int shard - number of shard (from 0)
+ *     int shards - number of shards
+ *     long long *first - returns number of first map of shard
+ *     long long *end - returns number of first map after shard
+ * 
+ * Return value: none
+ */
+void findShard(FILE *fpIndex, int shard, int shards, long long *first, long long *end) {
+    long long count = countIndexEntries(fpIndex);
+    double total = 0, prefix = 0;
+    indexEntry entry;
+
+    rewind(fpIndex);
+    for (long long k = 0; k < count && readNextEntry(fpIndex, &entry); k++) total += entryCost(&entry);
+
+    /** a shard starts at the first map whose cost before it reaches its share, like the next ends */
+    *first = *end = count;
+    rewind(fpIndex);
+    for (long long k = 0; k < count && readNextEntry(fpIndex, &entry); k++) {
+        if (*first == count && prefix >= total * shard / shards) *first = k;
+        if (shard + 1 < shards && prefix >= total * (shard + 1) / shards) {
+            *end = k;
+            break;
+        }
+        prefix += entryCost(&entry);
+    }
+}
+
+/**
+ * Function: appendFile
+ * 
+ * Description: copies a whole file (decompressed if it is gzip or zstd) at the end of another
+ * 
+ * Arguments:
+ *     FILE *fpOut - file where bytes are written
+ *     char *filename - name of file to be copied
+ * 
+ * Return value:
+ *     1 - if file was copied
+ *     0 - if it can't be opened or read
+ */
+int appendFile(FILE *fpOut, char *filename) {
+    stream *sptr;
+    char *bytes;
+    size_t count;
+    int ok = 1;
+
+    sptr = openInputStream(filename);
+    if (sptr == NULL) return 0;
+
+    bytes = (char *) malloc(APPEND_CHUNK * sizeof(char));
+    if (bytes == NULL) exit(EXIT_FAILURE);
+
+    while (ok && (count = fread(bytes, sizeof(char), APPEND_CHUNK, getStreamFile(sptr))) > 0) ok = fwrite(bytes, sizeof(char), count, fpOut) == count;
+    ok = closeStream(sptr) && ok;
+    free(bytes);
+
+    return ok;
+}
+
+/**
+ * Function: readNextEntry
+ * 
+ * Description: reads the record after the last one read
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ *     indexEntry *eptr - returns record of map
+ * 
+ * Return value:
+ *     1 - if record was read
+ *     0 - otherwise
+ */
+int readNextEntry(FILE *fpIndex, indexEntry *eptr) {
+    return fscanf(fpIndex, "%lld %d %d %lld", &eptr->offset, &eptr->lines, &eptr->columns, &eptr->trees) == 4;
+}
+
+/**
+ * Function: entryCost
+ * 
+ * Description: estimates cost of solving a map from its record
+ * 
+ * Arguments:
+ *     indexEntry *eptr - record of map
+ * 
+ * Return value:
+ *     estimated cost
+ */
+double entryCost(indexEntry *eptr) {
+    return (double) eptr->lines * eptr->columns + SHARD_TREE_WEIGHT * (double) eptr->trees;
+}
@@ -0,0 +1,100 @@
+/**
+ * Filename: mapindex.h
+ * 
+ * Description: Sidecar index of the maps of a file (offset, size and trees of every map), for
+ *              jumping to a map and splitting a file into shards
+ */
+
+#ifndef MAPINDEX_H
+#define MAPINDEX_H
+
+#include <stdio.h>
+
+/** bytes of a record of an index file, records have a fixed width so map n is found by a seek */
+#define INDEX_RECORD 64
+
+typedef struct {
+    long long offset;
+    int lines;
+    int columns;
+    long long trees;
+} indexEntry;
+
+/**
+ * Function: buildMapIndex
+ * 
+ * Description: scans every map of a file, without keeping them, and writes a record
+ *              "offset lines columns trees" per map
+ * 
+ * Arguments:
+ *     FILE *fpIn - file with the maps (must be seekable)
+ *     FILE *fpIndex - file where records are written
+ * 
+ * Return value:
+ *     number of maps indexed
+ *     READ_ERROR - if input is malformed or can't tell offsets
+ */
+long long buildMapIndex(FILE *fpIn, FILE *fpIndex);
+
+/**
+ * Function: countIndexEntries
+ * 
+ * Description: gets the number of maps of an index file
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ * 
+ * Return value:
+ *     number of maps
+ */
+long long countIndexEntries(FILE *fpIndex);
+
+/**
+ * Function: readIndexEntry
+ * 
+ * Description: reads the record of a map, seeking straight to it
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ *     long long number - number of map (from 0)
+ *     indexEntry *eptr - returns record of map
+ * 
+ * Return value:
+ *     1 - if record was read
+ *     0 - if there is no such map
+ */
+int readIndexEntry(FILE *fpIndex, long long number, indexEntry *eptr);
+
+/**
+ * Function: findShard
+ * 
+ * Description: finds the maps of a shard of a file split in shards of consecutive maps with
+ *              about the same estimated cost (cells plus weighted trees)
+ * 
+ * Arguments:
+ *     FILE *fpIndex - index file
+ *     int shard - number of shard (from 0)
+ *     int shards - number of shards
+ *     long long *first - returns number of first map of shard
+ *     long long *end - returns number of first map after shard
+ * 
+ * Return value: none
+ */
+void findShard(FILE *fpIndex, int shard, int shards, long long *first, long long *end);
+
+/**
+ * Function: appendFile
+ * 
+ * Description: copies a whole file (decompressed if it is gzip or zstd) at the end of another
+ * 
+ * Arguments:
+ *     FILE *fpOut - file where bytes are written
+ *     char *filename - name of file to be copied
+ * 
+ * Return value:
+ *     1 - if file was copied
+ *     0 - if it can't be opened or read
+ */
+int appendFile(FILE *fpOut, char *filename);
+
+#endif
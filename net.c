@@ -0,0 +1,153 @@
+/**
+ * Filename: net.c
+ * 
+ * Description: Unix domain socket helpers shared by daemon, client and benchmark
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "net.h"
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#define LISTEN_BACKLOG 128
+#define RESPONSE_CHUNK 65536
+
+/**
+ * Function: fillAddress
+ * 
+ * Description: writes socket address for path
+ * 
+ * Arguments:
+ *     struct sockaddr_un *address - address to be filled
+ *     char *path - socket path
+ * 
+ * Return value:
+ *     1 - if path fits in address
+ *     0 - if path is too long
+ */
+int fillAddress(struct sockaddr_un *address, char *path) {
+    if (strlen(path) >= sizeof(address->sun_path)) return 0;
+    memset(address, 0, sizeof(struct sockaddr_un));
+    address->sun_family = AF_UNIX;
+    strcpy(address->sun_path, path);
+    return 1;
+}
+
+/**
+ * Function: listenSocket
+ * 
+ * Description: creates a Unix domain socket bound to path, replacing a stale one
+ * 
+ * Arguments:
+ *     char *path - socket path
+ * 
+ * Return value:
+ *     listening file descriptor if successful
+ *     -1 if error ocurred
+ */
+int listenSocket(char *path) {
+    struct sockaddr_un address;
+    int fd;
+
+    if (!fillAddress(&address, path)) return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    unlink(path);
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) || listen(fd, LISTEN_BACKLOG)) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Function: connectSocket
+ * 
+ * Description: connects to the Unix domain socket at path
+ * 
+ * Arguments:
+ *     char *path - socket path
+ * 
+ * Return value:
+ *     connected file descriptor if successful
+ *     -1 if error ocurred
+ */
+int connectSocket(char *path) {
+    struct sockaddr_un address;
+    int fd;
+
+    if (!fillAddress(&address, path)) return -1;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    if (connect(fd, (struct sockaddr *) &address, sizeof(address))) {
+        close(fd);
+        return -1;
+    }
+
+    return fd;
+}
+
+/**
+ * Function: exchangeRequest
+ * 
+ * Description: sends a whole request and closes the sending side while reading the response,
+ *              so that results streamed back by the daemon never block a large request
+ * 
+ * Arguments:
+ *     int fd - connected file descriptor
+ *     char *request - request bytes (.camp text or binary maps)
+ *     size_t length - number of request bytes
+ *     FILE *out - where response is copied to (NULL to discard it)
+ * 
+ * Return value:
+ *     number of response bytes if successful
+ *     -1 if error ocurred
+ */
+long exchangeRequest(int fd, char *request, size_t length, FILE *out) {
+    char buffer[RESPONSE_CHUNK];
+    struct pollfd events;
+    size_t sent = 0;
+    long received = 0;
+    ssize_t n;
+
+    if (length == 0) shutdown(fd, SHUT_WR);
+
+    events.fd = fd;
+    while (1) {
+        events.events = POLLIN | (sent < length ? POLLOUT : 0);
+        if (poll(&events, 1, -1) < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+
+        if (events.revents & POLLOUT) {
+            n = write(fd, request + sent, length - sent);
+            if (n < 0) return -1;
+            sent += n;
+            if (sent == length) shutdown(fd, SHUT_WR);
+        }
+
+        if (events.revents & (POLLIN | POLLHUP)) {
+            n = read(fd, buffer, RESPONSE_CHUNK);
+            if (n < 0) return -1;
+            if (n == 0) break;
+            if (out != NULL && fwrite(buffer, 1, n, out) != (size_t) n) return -1;
+            received += n;
+        } else if (events.revents & POLLERR) {
+            return -1;
+        }
+    }
+
+    return sent == length ? received : -1;
+}
@@ -0,0 +1,58 @@
+/**
+ * Filename: net.h
+ * 
+ * Description: functions for talking to the solver daemon over a Unix domain socket
+ */
+
+#ifndef NET_H
+#define NET_H
+
+#include <stdio.h>
+
+/**
+ * Function: listenSocket
+ * 
+ * Description: creates a Unix domain socket bound to path, replacing a stale one
+ * 
+ * Arguments:
+ *     char *path - socket path
+ * 
+ * Return value:
+ *     listening file descriptor if successful
+ *     -1 if error ocurred
+ */
+int listenSocket(char *path);
+
+/**
+ * Function: connectSocket
+ * 
+ * Description: connects to the Unix domain socket at path
+ * 
+ * Arguments:
+ *     char *path - socket path
+ * 
+ * Return value:
+ *     connected file descriptor if successful
+ *     -1 if error ocurred
+ */
+int connectSocket(char *path);
+
+/**
+ * Function: exchangeRequest
+ * 
+ * Description: sends a whole request and closes the sending side while reading the response,
+ *              so that results streamed back by the daemon never block a large request
+ * 
+ * Arguments:
+ *     int fd - connected file descriptor
+ *     char *request - request bytes (.camp text or binary maps)
+ *     size_t length - number of request bytes
+ *     FILE *out - where response is copied to (NULL to discard it)
+ * 
+ * Return value:
+ *     number of response bytes if successful
+ *     -1 if error ocurred
+ */
+long exchangeRequest(int fd, char *request, size_t length, FILE *out);
+
+#endif
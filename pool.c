@@ -0,0 +1,216 @@
+/**
+ * Filename: pool.c
+ * 
+ * Description: Implementation of fixed size pool of worker threads
+ */
+
+#include "pool.h"
+#include <pthread.h>
+#include <stdlib.h>
+
+typedef struct taskStruct {
+    void (*function)(void *, int);
+    void *arg;
+    struct taskStruct *next;
+} task;
+
+typedef struct {
+    pool *pptr;
+    int index;
+} worker;
+
+struct poolStruct {
+    int workers;
+    pthread_t *threads;
+    worker *workerInfo;
+    task *head;
+    task *tail;
+    int pending;
+    int stopping;
+    pthread_mutex_t lock;
+    pthread_cond_t taskAvailable;
+    pthread_cond_t allDone;
+};
+
+void *workerLoop(void *arg);
+
+/**
+ * Function: newPool
+ * 
+ * Description: starts a pool of worker threads
+ * 
+ * Arguments:
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     pointer to new pool if successful
+ *     NULL if error ocurred
+ */
+pool *newPool(int workers) {
+    pool *pptr;
+
+    if (workers < 1) workers = 1;
+
+    pptr = (pool *) malloc(sizeof(pool));
+    if (pptr == NULL) return NULL;
+
+    pptr->workers = workers;
+    pptr->head = NULL;
+    pptr->tail = NULL;
+    pptr->pending = 0;
+    pptr->stopping = 0;
+    pthread_mutex_init(&pptr->lock, NULL);
+    pthread_cond_init(&pptr->taskAvailable, NULL);
+    pthread_cond_init(&pptr->allDone, NULL);
+
+    pptr->threads = (pthread_t *) malloc(workers * sizeof(pthread_t));
+    if (pptr->threads == NULL) return NULL;
+
+    pptr->workerInfo = (worker *) malloc(workers * sizeof(worker));
+    if (pptr->workerInfo == NULL) return NULL;
+
+    for (int i = 0; i < workers; i++) {
+        pptr->workerInfo[i].pptr = pptr;
+        pptr->workerInfo[i].index = i;
+        if (pthread_create(&pptr->threads[i], NULL, workerLoop, &pptr->workerInfo[i])) return NULL;
+    }
+
+    return pptr;
+}
+
+/**
+ * Function: deletePool
+ * 
+ * Description: waits for every queued task, stops the workers and deletes the pool
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool to be deleted
+ * 
+ * Return value: none
+ */
+void deletePool(pool *pptr) {
+    if (pptr == NULL) return;
+
+    waitPool(pptr);
+
+    pthread_mutex_lock(&pptr->lock);
+    pptr->stopping = 1;
+    pthread_cond_broadcast(&pptr->taskAvailable);
+    pthread_mutex_unlock(&pptr->lock);
+
+    for (int i = 0; i < pptr->workers; i++) {
+        pthread_join(pptr->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pptr->lock);
+    pthread_cond_destroy(&pptr->taskAvailable);
+    pthread_cond_destroy(&pptr->allDone);
+    free(pptr->threads);
+    free(pptr->workerInfo);
+    free(pptr);
+}
+
+/**
+ * Function: getPoolWorkers
+ * 
+ * Description: gets number of worker threads
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool
+ * 
+ * Return value:
+ *     number of worker threads
+ */
+int getPoolWorkers(pool *pptr) {
+    return pptr->workers;
+}
+
+/**
+ * Function: submitTask
+ * 
+ * Description: queues a task, it is run by the first idle worker as function(arg, worker)
+ *              where worker is the index (0 to workers - 1) of the thread running it
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool
+ *     void (*function)(void *, int) - task function
+ *     void *arg - argument passed to function
+ * 
+ * Return value: none
+ */
+void submitTask(pool *pptr, void (*function)(void *, int), void *arg) {
+    task *tptr;
+
+    tptr = (task *) malloc(sizeof(task));
+    if (tptr == NULL) exit(EXIT_FAILURE);
+    tptr->function = function;
+    tptr->arg = arg;
+    tptr->next = NULL;
+
+    pthread_mutex_lock(&pptr->lock);
+    if (pptr->tail == NULL)
+        pptr->head = tptr;
+    else
+        pptr->tail->next = tptr;
+    pptr->tail = tptr;
+    pptr->pending++;
+    pthread_cond_signal(&pptr->taskAvailable);
+    pthread_mutex_unlock(&pptr->lock);
+}
+
+/**
+ * Function: waitPool
+ * 
+ * Description: blocks until every queued task has finished
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool
+ * 
+ * Return value: none
+ */
+void waitPool(pool *pptr) {
+    pthread_mutex_lock(&pptr->lock);
+    while (pptr->pending > 0) {
+        pthread_cond_wait(&pptr->allDone, &pptr->lock);
+    }
+    pthread_mutex_unlock(&pptr->lock);
+}
+
+/**
+ * Function: workerLoop
+ * 
+ * Description: body of every worker thread, runs queued tasks until the pool is stopping
+ * 
+ * Arguments:
+ *     void *arg - pointer to worker information
+ * 
+ * Return value: NULL
+ */
+void *workerLoop(void *arg) {
+    worker *wptr = (worker *) arg;
+    pool *pptr = wptr->pptr;
+    task *tptr;
+
+    pthread_mutex_lock(&pptr->lock);
+    while (1) {
+        while (pptr->head == NULL && !pptr->stopping) {
+            pthread_cond_wait(&pptr->taskAvailable, &pptr->lock);
+        }
+        if (pptr->head == NULL) break;
+
+        tptr = pptr->head;
+        pptr->head = tptr->next;
+        if (pptr->head == NULL) pptr->tail = NULL;
+        pthread_mutex_unlock(&pptr->lock);
+
+        tptr->function(tptr->arg, wptr->index);
+        free(tptr);
+
+        pthread_mutex_lock(&pptr->lock);
+        pptr->pending--;
+        if (pptr->pending == 0) pthread_cond_broadcast(&pptr->allDone);
+    }
+    pthread_mutex_unlock(&pptr->lock);
+
+    return NULL;
+}
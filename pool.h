@@ -0,0 +1,78 @@
+/**
+ * Filename: pool.h
+ * 
+ * Description: fixed size pool of worker threads fed by a task queue
+ */
+
+#ifndef POOL_H
+#define POOL_H
+
+typedef struct poolStruct pool;
+
+/**
+ * Function: newPool
+ * 
+ * Description: starts a pool of worker threads
+ * 
+ * Arguments:
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     pointer to new pool if successful
+ *     NULL if error ocurred
+ */
+pool *newPool(int workers);
+
+/**
+ * Function: deletePool
+ * 
+ * Description: waits for every queued task, stops the workers and deletes the pool
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool to be deleted
+ * 
+ * Return value: none
+ */
+void deletePool(pool *pptr);
+
+/**
+ * Function: getPoolWorkers
+ * 
+ * Description: gets number of worker threads
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool
+ * 
+ * Return value:
+ *     number of worker threads
+ */
+int getPoolWorkers(pool *pptr);
+
+/**
+ * Function: submitTask
+ * 
+ * Description: queues a task, it is run by the first idle worker as function(arg, worker)
+ *              where worker is the index (0 to workers - 1) of the thread running it
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool
+ *     void (*function)(void *, int) - task function
+ *     void *arg - argument passed to function
+ * 
+ * Return value: none
+ */
+void submitTask(pool *pptr, void (*function)(void *, int), void *arg);
+
+/**
+ * Function: waitPool
+ * 
+ * Description: blocks until every queued task has finished
+ * 
+ * Arguments:
+ *     pool *pptr - pointer to pool
+ * 
+ * Return value: none
+ */
+void waitPool(pool *pptr);
+
+#endif
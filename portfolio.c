@@ -0,0 +1,262 @@
+/**
+ * Filename: portfolio.c
+ * 
+ * Description: Portfolio of solver strategies racing on the same map
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "portfolio.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "map.h"
+#include "pool.h"
+#include "profile.h"
+#include "solver.h"
+
+#define STRATEGY_COUNT 7
+#define SIZE_CLASSES 64
+
+typedef struct {
+    char *name;
+    int engine;
+    int order;
+    unsigned int seed;
+    int restarts;
+} strategy;
+
+strategy strategies[STRATEGY_COUNT] = {
+    {"auto", ENGINE_AUTO, ORDER_LINES, 1, 0},
+    {"lines", ENGINE_BACKTRACKING, ORDER_LINES, 1, 0},
+    {"columns", ENGINE_BACKTRACKING, ORDER_COLUMNS, 1, 0},
+    {"constrained", ENGINE_BACKTRACKING, ORDER_CONSTRAINED, 1, 0},
+    {"random1", ENGINE_BACKTRACKING, ORDER_RANDOM, 1, 0},
+    {"random2", ENGINE_BACKTRACKING, ORDER_RANDOM, 2, 0},
+    {"restarts", ENGINE_BACKTRACKING, ORDER_LINES, 1, 1}
+};
+
+typedef struct {
+    portfolio *pfptr;
+    int index;
+    map *mptr;
+    int result;
+    double seconds;
+} entry;
+
+struct portfolioStruct {
+    pool *pptr;
+    workspace *workspaces[STRATEGY_COUNT];
+    entry entries[STRATEGY_COUNT];
+    struct timespec start;
+    int cancel;
+    int winner;
+    long wins[SIZE_CLASSES][STRATEGY_COUNT];
+};
+
+void runStrategy(void *arg, int worker);
+int sizeClass(map *mptr);
+
+/**
+ * Function: newPortfolio
+ * 
+ * Description: allocates a portfolio running its strategies on a pool of workers, every
+ *              strategy keeping its own warm workspace
+ * 
+ * Arguments:
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     pointer to new portfolio if successful
+ *     NULL if error ocurred
+ */
+portfolio *newPortfolio(int workers) {
+    portfolio *pfptr;
+
+    pfptr = (portfolio *) calloc(1, sizeof(portfolio));
+    if (pfptr == NULL) return NULL;
+
+    /** calloc leaves the pool and workspaces not yet created NULL, so a partial portfolio can be deleted */
+    pfptr->pptr = newPool(workers);
+    if (pfptr->pptr == NULL) {
+        deletePortfolio(pfptr);
+        return NULL;
+    }
+
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        pfptr->workspaces[i] = newWorkspace();
+        if (pfptr->workspaces[i] == NULL) {
+            deletePortfolio(pfptr);
+            return NULL;
+        }
+        /** strategies already race on the workers, each preprocesses on its own one */
+        setWorkspaceThreads(pfptr->workspaces[i], 1);
+        pfptr->entries[i].pfptr = pfptr;
+        pfptr->entries[i].index = i;
+    }
+
+    return pfptr;
+}
+
+/**
+ * Function: deletePortfolio
+ * 
+ * Description: deletes a portfolio and its pool of workers
+ * 
+ * Arguments:
+ *     portfolio *pfptr - pointer to portfolio to be deleted
+ * 
+ * Return value: none
+ */
+void deletePortfolio(portfolio *pfptr) {
+    if (pfptr == NULL) return;
+
+    deletePool(pfptr->pptr);
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        deleteWorkspace(pfptr->workspaces[i]);
+    }
+
+    free(pfptr);
+}
+
+/**
+ * Function: racePortfolio
+ * 
+ * Description: solves a map with every strategy of the portfolio at once, each on its own copy
+ *              of the map. The first strategy to finish wins and the others are cancelled, the
+ *              winner is logged and counted for the size class of the map
+ * 
+ * Side-effects: replaces *mptr with the map solved by the winner
+ * 
+ * Arguments:
+ *     portfolio *pfptr - portfolio pointer
+ *     map **mptr - map pointer
+ *     FILE *log - file where a line "lines columns result strategy seconds" is written (or NULL)
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int racePortfolio(portfolio *pfptr, map **mptr, FILE *log) {
+    entry *winner;
+    int result;
+
+    pfptr->cancel = 0;
+    pfptr->winner = -1;
+    clock_gettime(CLOCK_MONOTONIC, &pfptr->start);
+
+    for (int i = 0; i < STRATEGY_COUNT; i++) {
+        pfptr->entries[i].mptr = NULL;
+        pfptr->entries[i].result = SOLVE_CANCELLED;
+
+        /** without the profile engine, auto already searches lines in order */
+        if (strategies[i].engine == ENGINE_BACKTRACKING && strategies[i].order == ORDER_LINES && !profileFits(*mptr)) continue;
+
+        pfptr->entries[i].mptr = i == 0 ? *mptr : copyMap(*mptr);
+        if (pfptr->entries[i].mptr == NULL) exit(EXIT_FAILURE);
+        submitTask(pfptr->pptr, runStrategy, &pfptr->entries[i]);
+    }
+    waitPool(pfptr->pptr);
+
+    winner = &pfptr->entries[pfptr->winner];
+    result = winner->result;
+    pfptr->wins[sizeClass(*mptr)][winner->index]++;
+
+    if (log != NULL) fprintf(log, "%d %d %d %s %.6f\n", getMapLines(*mptr), getMapColumns(*mptr), result, strategies[winner->index].name, winner->seconds);
+
+    for (int i = 1; i < STRATEGY_COUNT; i++) {
+        if (i != winner->index) deleteMap(pfptr->entries[i].mptr);
+    }
+    if (winner->index != 0) {
+        deleteMap(*mptr);
+        *mptr = winner->mptr;
+    }
+
+    return result;
+}
+
+/**
+ * Function: runStrategy
+ * 
+ * Description: pool task solving the map of an entry with its strategy, the first entry to
+ *              finish becomes the winner and cancels the others
+ * 
+ * Arguments:
+ *     void *arg - pointer to entry
+ *     int worker - index of worker running the task
+ * 
+ * Return value: none
+ */
+void runStrategy(void *arg, int worker) {
+    entry *eptr = (entry *) arg;
+    portfolio *pfptr = eptr->pfptr;
+    solverOptions options;
+    struct timespec end;
+    int expected = -1;
+
+    if (__atomic_load_n(&pfptr->cancel, __ATOMIC_RELAXED)) return;
+
+    defaultSolverOptions(&options);
+    options.engine = strategies[eptr->index].engine;
+    options.order = strategies[eptr->index].order;
+    options.seed = strategies[eptr->index].seed;
+    options.restarts = strategies[eptr->index].restarts;
+    options.cancel = &pfptr->cancel;
+
+    eptr->result = solveMapWithOptions(eptr->mptr, pfptr->workspaces[eptr->index], &options);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    eptr->seconds = (end.tv_sec - pfptr->start.tv_sec) + (end.tv_nsec - pfptr->start.tv_nsec) / 1e9;
+
+    if (eptr->result == SOLVE_CANCELLED) return;
+    if (__atomic_compare_exchange_n(&pfptr->winner, &expected, eptr->index, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST)) {
+        __atomic_store_n(&pfptr->cancel, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/**
+ * Function: sizeClass
+ * 
+ * Description: gets size class of a map, the number of bits of its number of cells
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value: size class
+ */
+int sizeClass(map *mptr) {
+    long long cells = (long long) getMapLines(mptr) * getMapColumns(mptr);
+    int bits = 0;
+
+    while (cells >> bits && bits < SIZE_CLASSES - 1) bits++;
+
+    return bits;
+}
+
+/**
+ * Function: writePortfolioSummary
+ * 
+ * Description: writes how many races every strategy won per size class (maps with less than
+ *              2^k cells and at least 2^(k-1)), as comment lines starting with '#'
+ * 
+ * Arguments:
+ *     portfolio *pfptr - portfolio pointer
+ *     FILE *log - file pointer
+ * 
+ * Return value: none
+ */
+void writePortfolioSummary(portfolio *pfptr, FILE *log) {
+    long races;
+
+    for (int k = 0; k < SIZE_CLASSES; k++) {
+        races = 0;
+        for (int i = 0; i < STRATEGY_COUNT; i++) races += pfptr->wins[k][i];
+        if (races == 0) continue;
+
+        fprintf(log, "# cells < 2^%d (%ld maps):", k, races);
+        for (int i = 0; i < STRATEGY_COUNT; i++) {
+            if (pfptr->wins[k][i]) fprintf(log, " %s %ld", strategies[i].name, pfptr->wins[k][i]);
+        }
+        fprintf(log, "\n");
+    }
+}
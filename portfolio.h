@@ -0,0 +1,76 @@
+/**
+ * Filename: portfolio.h
+ * 
+ * Description: Portfolio of solver strategies racing on the same map
+ */
+
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <stdio.h>
+#include "map.h"
+
+typedef struct portfolioStruct portfolio;
+
+/**
+ * Function: newPortfolio
+ * 
+ * Description: allocates a portfolio running its strategies on a pool of workers, every
+ *              strategy keeping its own warm workspace
+ * 
+ * Arguments:
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     pointer to new portfolio if successful
+ *     NULL if error ocurred
+ */
+portfolio *newPortfolio(int workers);
+
+/**
+ * Function: deletePortfolio
+ * 
+ * Description: deletes a portfolio and its pool of workers
+ * 
+ * Arguments:
+ *     portfolio *pfptr - pointer to portfolio to be deleted
+ * 
+ * Return value: none
+ */
+void deletePortfolio(portfolio *pfptr);
+
+/**
+ * Function: racePortfolio
+ * 
+ * Description: solves a map with every strategy of the portfolio at once, each on its own copy
+ *              of the map. The first strategy to finish wins and the others are cancelled, the
+ *              winner is logged and counted for the size class of the map
+ * 
+ * Side-effects: replaces *mptr with the map solved by the winner
+ * 
+ * Arguments:
+ *     portfolio *pfptr - portfolio pointer
+ *     map **mptr - map pointer
+ *     FILE *log - file where a line "lines columns result strategy seconds" is written (or NULL)
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int racePortfolio(portfolio *pfptr, map **mptr, FILE *log);
+
+/**
+ * Function: writePortfolioSummary
+ * 
+ * Description: writes how many races every strategy won per size class (maps with less than
+ *              2^k cells and at least 2^(k-1)), as comment lines starting with '#'
+ * 
+ * Arguments:
+ *     portfolio *pfptr - portfolio pointer
+ *     FILE *log - file pointer
+ * 
+ * Return value: none
+ */
+void writePortfolioSummary(portfolio *pfptr, FILE *log);
+
+#endif
@@ -0,0 +1,414 @@
+/**
+ * Filename: profile.c
+ * 
+ * Description: Profile dynamic programming engine for narrow maps
+ */
+
+#include "profile.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "map.h"
+#include "table.h"
+
+#define PROFILE_MAX_LAYER_STATES (1 << 15)
+#define PROFILE_MAX_HINT 65535
+
+typedef struct {
+    map *mptr;
+    int transposed;
+    int length;
+    int width;
+    int highSeason;
+    uint32_t *trees;
+    uint32_t *candidates;
+    int *lineHints;
+    int *columnHints;
+    int *capacity;
+    int keySize;
+    table *current;
+    table *next;
+    int *parents;
+    uint32_t *tentHistory;
+    long historySize;
+    long historyCapacity;
+    int overflow;
+} profile;
+
+typedef struct {
+    int row;
+    int parent;
+    uint32_t tents;
+    uint32_t freeTrees;
+    unsigned short *counts;
+    uint32_t available;
+    uint32_t newTents;
+    uint32_t newPending;
+    uint32_t usedTrees;
+    uint32_t usedAbove;
+    int placed;
+    unsigned char *key;
+} transition;
+
+char profileContent(profile *pptr, int row, int column);
+void buildProfile(profile *pptr);
+void deleteProfile(profile *pptr);
+void extendLine(profile *pptr, transition *tptr, int column);
+void storeState(profile *pptr, transition *tptr);
+int bitCount(uint32_t bits);
+
+/**
+ * Function: profileFits
+ * 
+ * Description: checks if map is narrow enough (in lines or in columns) for the profile engine,
+ *              sparse maps are not, sweeping them would cost their whole area
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if profile engine may be used
+ *     0 - otherwise
+ */
+int profileFits(map *mptr) {
+    if (getMapLines(mptr) == 0 || getMapColumns(mptr) == 0 || isSparseMap(mptr)) return 0;
+    return getMapColumns(mptr) <= PROFILE_MAX_WIDTH || getMapLines(mptr) <= PROFILE_MAX_WIDTH;
+}
+
+/**
+ * Function: profileSolve
+ * 
+ * Description: solves a preprocessed map (uncertains marked) sweeping it line by line along
+ *              its longest dimension. A state holds the tents of the last line, the ones still
+ *              waiting for a tree in the next line, the trees of the last line still free and
+ *              the tents placed so far per column; equal states are merged and states that can
+ *              no longer meet the column hints are pruned. Only two lines of states are kept,
+ *              plus a parent link per state to rebuild the solution
+ * 
+ * Side-effects: writes solution for mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     int *cancel - search stops once it is set by another thread (NULL if never)
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     0 - if map is impossible
+ *     PROFILE_GAVE_UP - if map is too wide, has too many states or search was cancelled
+ */
+int profileSolve(map *mptr, int *cancel) {
+    profile prof;
+    transition trans;
+    table *swap;
+    long *layerStart;
+    unsigned char *key;
+    uint32_t pending;
+    int index, found = -1;
+
+    if (!profileFits(mptr)) return PROFILE_GAVE_UP;
+
+    prof.mptr = mptr;
+    prof.transposed = getMapColumns(mptr) > PROFILE_MAX_WIDTH || getMapLines(mptr) < getMapColumns(mptr);
+    buildProfile(&prof);
+    for (int j = 0; j < prof.width; j++) {
+        if (prof.columnHints[j] > PROFILE_MAX_HINT) {
+            deleteProfile(&prof);
+            return PROFILE_GAVE_UP;
+        }
+    }
+
+    layerStart = (long *) malloc((prof.length + 1) * sizeof(long));
+    trans.key = (unsigned char *) malloc(prof.keySize);
+    trans.counts = (unsigned short *) malloc(prof.width * sizeof(unsigned short));
+    if (layerStart == NULL || trans.key == NULL || trans.counts == NULL) exit(EXIT_FAILURE);
+
+    /** initial state: no line above, no tents placed */
+    memset(trans.key, 0, prof.keySize);
+    insertKey(prof.current, trans.key, &index);
+
+    for (int row = 0; row < prof.length && !prof.overflow; row++) {
+        if (cancel != NULL && __atomic_load_n(cancel, __ATOMIC_RELAXED)) {
+            prof.overflow = 1;
+            break;
+        }
+        layerStart[row] = prof.historySize;
+        clearTable(prof.next);
+        for (int s = 0; s < getTableSize(prof.current) && !prof.overflow; s++) {
+            key = (unsigned char *) getKey(prof.current, s);
+            memcpy(&trans.tents, key, sizeof(uint32_t));
+            memcpy(&pending, key + sizeof(uint32_t), sizeof(uint32_t));
+            memcpy(&trans.freeTrees, key + 2 * sizeof(uint32_t), sizeof(uint32_t));
+            memcpy(trans.counts, key + 3 * sizeof(uint32_t), prof.width * sizeof(unsigned short));
+
+            /** tents waiting for a tree must find it right below */
+            if ((pending & prof.trees[row]) == pending) {
+                trans.row = row;
+                trans.parent = s;
+                trans.available = prof.trees[row] & ~pending;
+                trans.newTents = 0;
+                trans.newPending = 0;
+                trans.usedTrees = 0;
+                trans.usedAbove = 0;
+                trans.placed = 0;
+                extendLine(&prof, &trans, 0);
+            }
+        }
+        swap = prof.current;
+        prof.current = prof.next;
+        prof.next = swap;
+    }
+
+    if (!prof.overflow) {
+        for (int s = 0; s < getTableSize(prof.current) && found == -1; s++) {
+            key = (unsigned char *) getKey(prof.current, s);
+            memcpy(&trans.freeTrees, key + 2 * sizeof(uint32_t), sizeof(uint32_t));
+            if (!prof.highSeason || trans.freeTrees == 0) found = s;
+        }
+        for (int row = prof.length - 1; row >= 0 && found != -1; row--) {
+            for (int j = 0; j < prof.width; j++) {
+                if (!(prof.candidates[row] >> j & 1)) continue;
+                if (prof.transposed)
+                    setContentOfPosition(mptr, j, row, prof.tentHistory[layerStart[row] + found] >> j & 1 ? 'T' : '.');
+                else
+                    setContentOfPosition(mptr, row, j, prof.tentHistory[layerStart[row] + found] >> j & 1 ? 'T' : '.');
+            }
+            found = prof.parents[layerStart[row] + found];
+        }
+    }
+
+    free(layerStart);
+    free(trans.key);
+    free(trans.counts);
+    deleteProfile(&prof);
+
+    if (prof.overflow) return PROFILE_GAVE_UP;
+    return found != -1;
+}
+
+/**
+ * Function: profileContent
+ * 
+ * Description: gets content of map in profile orientation
+ * 
+ * Arguments:
+ *     profile *pptr - profile pointer
+ *     int row - row along the sweep
+ *     int column - position inside row
+ * 
+ * Return value: content of position
+ */
+char profileContent(profile *pptr, int row, int column) {
+    if (pptr->transposed) return getContentOfPosition(pptr->mptr, column, row);
+    return getContentOfPosition(pptr->mptr, row, column);
+}
+
+/**
+ * Function: buildProfile
+ * 
+ * Description: builds tree and candidate masks per row, hints in profile orientation and the
+ *              maximum number of tents each column can still hold from every row down
+ * 
+ * Arguments:
+ *     profile *pptr - profile pointer (mptr and transposed set)
+ * 
+ * Return value: none
+ */
+void buildProfile(profile *pptr) {
+    map *mptr = pptr->mptr;
+    int *capacity;
+    char c;
+
+    pptr->length = pptr->transposed ? getMapColumns(mptr) : getMapLines(mptr);
+    pptr->width = pptr->transposed ? getMapLines(mptr) : getMapColumns(mptr);
+    pptr->highSeason = getTreesNumber(mptr) == getTentsNumber(mptr);
+
+    pptr->trees = (uint32_t *) calloc(pptr->length + 1, sizeof(uint32_t));
+    pptr->candidates = (uint32_t *) calloc(pptr->length + 1, sizeof(uint32_t));
+    pptr->lineHints = (int *) malloc(pptr->length * sizeof(int));
+    pptr->columnHints = (int *) malloc(pptr->width * sizeof(int));
+    pptr->capacity = (int *) calloc((long) (pptr->length + 2) * pptr->width, sizeof(int));
+    if (pptr->trees == NULL || pptr->candidates == NULL || pptr->lineHints == NULL || pptr->columnHints == NULL || pptr->capacity == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < pptr->length; i++) {
+        pptr->lineHints[i] = pptr->transposed ? getTentsInColumn(mptr, i) : getTentsInLine(mptr, i);
+        for (int j = 0; j < pptr->width; j++) {
+            c = profileContent(pptr, i, j);
+            if (c == 'A') pptr->trees[i] |= (uint32_t) 1 << j;
+            if (c == 'U') pptr->candidates[i] |= (uint32_t) 1 << j;
+        }
+    }
+    for (int j = 0; j < pptr->width; j++) {
+        pptr->columnHints[j] = pptr->transposed ? getTentsInLine(mptr, j) : getTentsInColumn(mptr, j);
+    }
+
+    /** capacity[i * width + j]: most tents column j can hold in rows i and below */
+    capacity = pptr->capacity;
+    for (int i = pptr->length - 1; i >= 0; i--) {
+        for (int j = 0; j < pptr->width; j++) {
+            capacity[(long) i * pptr->width + j] = capacity[(long) (i + 1) * pptr->width + j];
+            if (pptr->candidates[i] >> j & 1 && 1 + capacity[(long) (i + 2) * pptr->width + j] > capacity[(long) i * pptr->width + j])
+                capacity[(long) i * pptr->width + j] = 1 + capacity[(long) (i + 2) * pptr->width + j];
+        }
+    }
+
+    pptr->keySize = 3 * sizeof(uint32_t) + pptr->width * sizeof(unsigned short);
+    pptr->current = newTable(pptr->keySize);
+    pptr->next = newTable(pptr->keySize);
+    if (pptr->current == NULL || pptr->next == NULL) exit(EXIT_FAILURE);
+
+    pptr->parents = NULL;
+    pptr->tentHistory = NULL;
+    pptr->historySize = 0;
+    pptr->historyCapacity = 0;
+    pptr->overflow = 0;
+}
+
+/**
+ * Function: deleteProfile
+ * 
+ * Description: frees memory held by profile
+ * 
+ * Arguments:
+ *     profile *pptr - profile pointer
+ * 
+ * Return value: none
+ */
+void deleteProfile(profile *pptr) {
+    free(pptr->trees);
+    free(pptr->candidates);
+    free(pptr->lineHints);
+    free(pptr->columnHints);
+    free(pptr->capacity);
+    free(pptr->parents);
+    free(pptr->tentHistory);
+    deleteTable(pptr->current);
+    deleteTable(pptr->next);
+}
+
+/**
+ * Function: extendLine
+ * 
+ * Description: recursively chooses the tents of a row column by column, and for every tent the
+ *              tree it belongs to (above, left, right or, deferred to next row, below)
+ * 
+ * Arguments:
+ *     profile *pptr - profile pointer
+ *     transition *tptr - transition being built
+ *     int column - column to be decided
+ * 
+ * Return value: none
+ */
+void extendLine(profile *pptr, transition *tptr, int column) {
+    int row = tptr->row, width = pptr->width;
+    uint32_t bit = (uint32_t) 1 << column;
+    uint32_t saved;
+    int count, hint;
+
+    if (pptr->overflow) return;
+    if (tptr->placed > pptr->lineHints[row]) return;
+    if (tptr->placed + bitCount(pptr->candidates[row] >> column) < pptr->lineHints[row]) return;
+
+    if (column == width) {
+        /** in high season every tree of the row above must have got its tent by now */
+        if (pptr->highSeason && (tptr->freeTrees & ~tptr->usedAbove)) return;
+        storeState(pptr, tptr);
+        return;
+    }
+
+    count = tptr->counts[column];
+    hint = pptr->columnHints[column];
+
+    /** no tent in this column */
+    if (count + pptr->capacity[(long) (row + 1) * width + column] >= hint) extendLine(pptr, tptr, column + 1);
+
+    if (!(pptr->candidates[row] & bit)) return;
+    if (tptr->newTents & bit >> 1) return;
+    if (tptr->tents & (bit | bit << 1 | bit >> 1)) return;
+    if (count + 1 > hint || count + 1 + pptr->capacity[(long) (row + 2) * width + column] < hint) return;
+
+    tptr->newTents |= bit;
+    tptr->placed++;
+
+    if (tptr->freeTrees & bit) {
+        /** a free tree above can only serve this tent, taking it never loses a solution */
+        tptr->usedAbove |= bit;
+        extendLine(pptr, tptr, column + 1);
+        tptr->usedAbove &= ~bit;
+    } else {
+        saved = tptr->usedTrees;
+        if (tptr->available & ~tptr->usedTrees & bit >> 1) {
+            tptr->usedTrees |= bit >> 1;
+            extendLine(pptr, tptr, column + 1);
+            tptr->usedTrees = saved;
+        }
+        if (tptr->available & ~tptr->usedTrees & bit << 1) {
+            tptr->usedTrees |= bit << 1;
+            extendLine(pptr, tptr, column + 1);
+            tptr->usedTrees = saved;
+        }
+        if (row + 1 < pptr->length && pptr->trees[row + 1] & bit) {
+            tptr->newPending |= bit;
+            extendLine(pptr, tptr, column + 1);
+            tptr->newPending &= ~bit;
+        }
+    }
+
+    tptr->newTents &= ~bit;
+    tptr->placed--;
+}
+
+/**
+ * Function: storeState
+ * 
+ * Description: merges state reached by a complete transition into next row states
+ * 
+ * Arguments:
+ *     profile *pptr - profile pointer
+ *     transition *tptr - complete transition
+ * 
+ * Return value: none
+ */
+void storeState(profile *pptr, transition *tptr) {
+    unsigned short *counts;
+    uint32_t freeTrees;
+    int index;
+
+    freeTrees = tptr->available & ~tptr->usedTrees;
+    memcpy(tptr->key, &tptr->newTents, sizeof(uint32_t));
+    memcpy(tptr->key + sizeof(uint32_t), &tptr->newPending, sizeof(uint32_t));
+    memcpy(tptr->key + 2 * sizeof(uint32_t), &freeTrees, sizeof(uint32_t));
+    counts = (unsigned short *) (tptr->key + 3 * sizeof(uint32_t));
+    for (int j = 0; j < pptr->width; j++) {
+        counts[j] = tptr->counts[j] + (tptr->newTents >> j & 1);
+    }
+
+    if (!insertKey(pptr->next, tptr->key, &index)) return;
+    if (index >= PROFILE_MAX_LAYER_STATES) {
+        pptr->overflow = 1;
+        return;
+    }
+
+    if (pptr->historySize == pptr->historyCapacity) {
+        pptr->historyCapacity = pptr->historyCapacity ? 2 * pptr->historyCapacity : 1024;
+        pptr->parents = (int *) realloc(pptr->parents, pptr->historyCapacity * sizeof(int));
+        pptr->tentHistory = (uint32_t *) realloc(pptr->tentHistory, pptr->historyCapacity * sizeof(uint32_t));
+        if (pptr->parents == NULL || pptr->tentHistory == NULL) exit(EXIT_FAILURE);
+    }
+    pptr->parents[pptr->historySize] = tptr->parent;
+    pptr->tentHistory[pptr->historySize] = tptr->newTents;
+    pptr->historySize++;
+}
+
+/**
+ * Function: bitCount
+ * 
+ * Description: counts bits set
+ * 
+ * Arguments:
+ *     uint32_t bits - bits to be counted
+ * 
+ * Return value: number of bits set
+ */
+int bitCount(uint32_t bits) {
+    return __builtin_popcount(bits);
+}
@@ -0,0 +1,53 @@
+/**
+ * Filename: profile.h
+ * 
+ * Description: line by line profile dynamic programming engine for narrow maps
+ */
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include "map.h"
+
+#define PROFILE_MAX_WIDTH 20
+#define PROFILE_GAVE_UP -1
+
+/**
+ * Function: profileFits
+ * 
+ * Description: checks if map is narrow enough (in lines or in columns) for the profile engine,
+ *              sparse maps are not, sweeping them would cost their whole area
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if profile engine may be used
+ *     0 - otherwise
+ */
+int profileFits(map *mptr);
+
+/**
+ * Function: profileSolve
+ * 
+ * Description: solves a preprocessed map (uncertains marked) sweeping it line by line along
+ *              its longest dimension. A state holds the tents of the last line, the ones still
+ *              waiting for a tree in the next line, the trees of the last line still free and
+ *              the tents placed so far per column; equal states are merged and states that can
+ *              no longer meet the column hints are pruned. Only two lines of states are kept,
+ *              plus a parent link per state to rebuild the solution
+ * 
+ * Side-effects: writes solution for mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     int *cancel - search stops once it is set by another thread (NULL if never)
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     0 - if map is impossible
+ *     PROFILE_GAVE_UP - if map is too wide, has too many states or search was cancelled
+ */
+int profileSolve(map *mptr, int *cancel);
+
+#endif
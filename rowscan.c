@@ -0,0 +1,249 @@
+/**
+ * Filename: rowscan.c
+ * 
+ * Description: Vectorised scanning of grid lines into tree (and tent) bitmasks
+ */
+
+#include "rowscan.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#define ROWSCAN_X86
+#include <immintrin.h>
+#endif
+
+typedef uint64_t (*wordScanner)(const char *, int, uint64_t *, uint64_t *);
+
+wordScanner pickScanner(void);
+uint64_t scanWord(const char *bytes, int count, uint64_t *tents, uint64_t *others);
+#ifdef ROWSCAN_X86
+uint64_t scanWordSSE2(const char *bytes, int count, uint64_t *tents, uint64_t *others);
+uint64_t scanWordAVX2(const char *bytes, int count, uint64_t *tents, uint64_t *others) __attribute__((target("avx2")));
+#endif
+
+/**
+ * Function: scanRow
+ * 
+ * Description: turns a grid line into a tree bitmask in a single pass, 16 or 32 bytes at a
+ *              time with SSE2 or AVX2 (picked at run time) and byte by byte elsewhere
+ * 
+ * Arguments:
+ *     const char *row - line of grid (at least columns bytes)
+ *     int columns - number of columns
+ *     uint64_t *trees - returns bit j % 64 of word j / 64 set for a tree ('A') in column j,
+ *                       ROW_WORDS(columns) words with the bits past the last column clear
+ *     int *others - returns number of bytes that are neither 'A' nor '.' (or NULL)
+ * 
+ * Return value:
+ *     number of trees in line
+ */
+int scanRow(const char *row, int columns, uint64_t *trees, int *others) {
+    wordScanner scanner = pickScanner();
+    uint64_t tentBits, otherBits;
+    int treeCount = 0, otherCount = 0, count;
+
+    for (int w = 0; w < ROW_WORDS(columns); w++) {
+        count = columns - 64 * w < 64 ? columns - 64 * w : 64;
+        trees[w] = scanner(row + 64 * w, count, &tentBits, &otherBits);
+        treeCount += __builtin_popcountll(trees[w]);
+        otherCount += __builtin_popcountll(otherBits | tentBits);
+    }
+
+    if (others != NULL) *others = otherCount;
+
+    return treeCount;
+}
+
+/**
+ * Function: scanSolutionRow
+ * 
+ * Description: turns a solved grid line into tree and tent bitmasks in a single pass, like
+ *              scanRow
+ * 
+ * Arguments:
+ *     const char *row - line of solved grid (at least columns bytes)
+ *     int columns - number of columns
+ *     uint64_t *trees - returns ROW_WORDS(columns) words with the bits of trees ('A')
+ *     uint64_t *tents - returns ROW_WORDS(columns) words with the bits of tents ('T')
+ *     int *others - returns number of bytes that are neither 'A', 'T' nor '.' (or NULL)
+ * 
+ * Return value:
+ *     number of tents in line
+ */
+int scanSolutionRow(const char *row, int columns, uint64_t *trees, uint64_t *tents, int *others) {
+    wordScanner scanner = pickScanner();
+    uint64_t otherBits;
+    int tentCount = 0, otherCount = 0, count;
+
+    for (int w = 0; w < ROW_WORDS(columns); w++) {
+        count = columns - 64 * w < 64 ? columns - 64 * w : 64;
+        trees[w] = scanner(row + 64 * w, count, &tents[w], &otherBits);
+        tentCount += __builtin_popcountll(tents[w]);
+        otherCount += __builtin_popcountll(otherBits);
+    }
+
+    if (others != NULL) *others = otherCount;
+
+    return tentCount;
+}
+
+/**
+ * Function: readGridLine
+ * 
+ * Description: reads a line of a text grid i.e. skips whitespace and reads exactly columns
+ *              bytes, which must be followed by whitespace or end of file
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     char *lineString - returns line (columns + 1 bytes, '\0' terminated)
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     1 - if a line of columns bytes was read
+ *     0 - if input ended or the line has another length
+ */
+int readGridLine(FILE *fp, char *lineString, int columns) {
+    int c;
+
+    lineString[columns] = '\0';
+    if (columns == 0) return 1;
+
+    while ((c = getc(fp)) != EOF && isspace(c))
+        ;
+    if (c == EOF) return 0;
+
+    /** bytes of a short line run into the next one, which scanRow reports as others */
+    lineString[0] = (char) c;
+    if (fread(lineString + 1, sizeof(char), columns - 1, fp) != (size_t) (columns - 1)) return 0;
+
+    c = getc(fp);
+    return c == EOF || isspace(c);
+}
+
+/**
+ * Function: pickScanner
+ * 
+ * Description: picks the widest word scanner the processor supports
+ * 
+ * Arguments: none
+ * 
+ * Return value:
+ *     word scanner
+ */
+wordScanner pickScanner(void) {
+#ifdef ROWSCAN_X86
+    return __builtin_cpu_supports("avx2") ? scanWordAVX2 : scanWordSSE2;
+#else
+    return scanWord;
+#endif
+}
+
+/**
+ * Function: scanWord
+ * 
+ * Description: scans up to 64 bytes of a line byte by byte
+ * 
+ * Arguments:
+ *     const char *bytes - first byte
+ *     int count - number of bytes (1 to 64)
+ *     uint64_t *tents - returns bits of tents ('T')
+ *     uint64_t *others - returns bits of bytes that are neither 'A', 'T' nor '.'
+ * 
+ * Return value:
+ *     bits of trees
+ */
+uint64_t scanWord(const char *bytes, int count, uint64_t *tents, uint64_t *others) {
+    uint64_t trees = 0, grass = 0;
+
+    *tents = 0;
+    for (int j = 0; j < count; j++) {
+        trees |= (uint64_t) (bytes[j] == 'A') << j;
+        *tents |= (uint64_t) (bytes[j] == 'T') << j;
+        grass |= (uint64_t) (bytes[j] == '.') << j;
+    }
+    *others = ~(trees | *tents | grass) & (count == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << count) - 1);
+
+    return trees;
+}
+
+#ifdef ROWSCAN_X86
+
+/**
+ * Function: scanWordSSE2
+ * 
+ * Description: scans up to 64 bytes of a line 16 at a time, the last few byte by byte
+ * 
+ * Arguments:
+ *     const char *bytes - first byte
+ *     int count - number of bytes (1 to 64)
+ *     uint64_t *tents - returns bits of tents ('T')
+ *     uint64_t *others - returns bits of bytes that are neither 'A', 'T' nor '.'
+ * 
+ * Return value:
+ *     bits of trees
+ */
+uint64_t scanWordSSE2(const char *bytes, int count, uint64_t *tents, uint64_t *others) {
+    const __m128i tree = _mm_set1_epi8('A'), tent = _mm_set1_epi8('T'), grass = _mm_set1_epi8('.');
+    uint64_t trees = 0, grasses = 0, tailTents, tailOthers;
+    __m128i chunk;
+    int j = 0;
+
+    *tents = 0;
+    for (; j + 16 <= count; j += 16) {
+        chunk = _mm_loadu_si128((const __m128i *) (bytes + j));
+        trees |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, tree)) << j;
+        *tents |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, tent)) << j;
+        grasses |= (uint64_t) (uint16_t) _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, grass)) << j;
+    }
+    *others = j == 0 ? 0 : ~(trees | *tents | grasses) & (j == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << j) - 1);
+
+    if (j < count) {
+        trees |= scanWord(bytes + j, count - j, &tailTents, &tailOthers) << j;
+        *tents |= tailTents << j;
+        *others |= tailOthers << j;
+    }
+
+    return trees;
+}
+
+/**
+ * Function: scanWordAVX2
+ * 
+ * Description: scans up to 64 bytes of a line 32 at a time, the rest like scanWordSSE2
+ * 
+ * Arguments:
+ *     const char *bytes - first byte
+ *     int count - number of bytes (1 to 64)
+ *     uint64_t *tents - returns bits of tents ('T')
+ *     uint64_t *others - returns bits of bytes that are neither 'A', 'T' nor '.'
+ * 
+ * Return value:
+ *     bits of trees
+ */
+uint64_t scanWordAVX2(const char *bytes, int count, uint64_t *tents, uint64_t *others) {
+    const __m256i tree = _mm256_set1_epi8('A'), tent = _mm256_set1_epi8('T'), grass = _mm256_set1_epi8('.');
+    uint64_t trees = 0, grasses = 0, tailTents, tailOthers;
+    __m256i chunk;
+    int j = 0;
+
+    *tents = 0;
+    for (; j + 32 <= count; j += 32) {
+        chunk = _mm256_loadu_si256((const __m256i *) (bytes + j));
+        trees |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, tree)) << j;
+        *tents |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, tent)) << j;
+        grasses |= (uint64_t) (uint32_t) _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, grass)) << j;
+    }
+    *others = j == 0 ? 0 : ~(trees | *tents | grasses) & (j == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << j) - 1);
+
+    if (j < count) {
+        trees |= scanWordSSE2(bytes + j, count - j, &tailTents, &tailOthers) << j;
+        *tents |= tailTents << j;
+        *others |= tailOthers << j;
+    }
+
+    return trees;
+}
+
+#endif
@@ -0,0 +1,69 @@
+/**
+ * Filename: rowscan.h
+ * 
+ * Description: Vectorised scanning of grid lines into tree (and tent) bitmasks
+ */
+
+#ifndef ROWSCAN_H
+#define ROWSCAN_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** number of 64 bit words of a tree bitmask for a line of this many columns */
+#define ROW_WORDS(columns) (((columns) + 63) / 64)
+
+/**
+ * Function: scanRow
+ * 
+ * Description: turns a grid line into a tree bitmask in a single pass, 16 or 32 bytes at a
+ *              time with SSE2 or AVX2 (picked at run time) and byte by byte elsewhere
+ * 
+ * Arguments:
+ *     const char *row - line of grid (at least columns bytes)
+ *     int columns - number of columns
+ *     uint64_t *trees - returns bit j % 64 of word j / 64 set for a tree ('A') in column j,
+ *                       ROW_WORDS(columns) words with the bits past the last column clear
+ *     int *others - returns number of bytes that are neither 'A' nor '.' (or NULL)
+ * 
+ * Return value:
+ *     number of trees in line
+ */
+int scanRow(const char *row, int columns, uint64_t *trees, int *others);
+
+/**
+ * Function: scanSolutionRow
+ * 
+ * Description: turns a solved grid line into tree and tent bitmasks in a single pass, like
+ *              scanRow
+ * 
+ * Arguments:
+ *     const char *row - line of solved grid (at least columns bytes)
+ *     int columns - number of columns
+ *     uint64_t *trees - returns ROW_WORDS(columns) words with the bits of trees ('A')
+ *     uint64_t *tents - returns ROW_WORDS(columns) words with the bits of tents ('T')
+ *     int *others - returns number of bytes that are neither 'A', 'T' nor '.' (or NULL)
+ * 
+ * Return value:
+ *     number of tents in line
+ */
+int scanSolutionRow(const char *row, int columns, uint64_t *trees, uint64_t *tents, int *others);
+
+/**
+ * Function: readGridLine
+ * 
+ * Description: reads a line of a text grid i.e. skips whitespace and reads exactly columns
+ *              bytes, which must be followed by whitespace or end of file
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     char *lineString - returns line (columns + 1 bytes, '\0' terminated)
+ *     int columns - number of columns
+ * 
+ * Return value:
+ *     1 - if a line of columns bytes was read
+ *     0 - if input ended or the line has another length
+ */
+int readGridLine(FILE *fp, char *lineString, int columns);
+
+#endif
@@ -0,0 +1,296 @@
+/**
+ * Filename: screen.c
+ * 
+ * Description: Linear screening of maps before solving
+ */
+
+#include "screen.h"
+#include <stdlib.h>
+#include "map.h"
+
+int isCandidate(map *mptr, char *above, char *line, char *below, int i, int j);
+int closeRun(int *run);
+
+/**
+ * Screening of a map line by line: per column trees and runs of candidate cells (and of
+ * candidate pairs of columns) still open, candidates of the last line screened, trees in the
+ * lines around the next line to screen, and whether the map still might have solution
+ */
+struct screenStruct {
+    map *mptr;
+    int *columnTrees;
+    int *columnRun;
+    int *columnCapacity;
+    int *pairRun;
+    int *pairCapacity;
+    char *candidateBuffer;
+    char *candidates;
+    char *previousCandidates;
+    int treesAbove;
+    int treesHere;
+    int trees;
+    int possible;
+};
+
+/**
+ * Function: screenMap
+ * 
+ * Description: checks in a single pass over the grid (trees only, no uncertains marked yet)
+ *              capacity bounds that every solvable map meets:
+ *              - a line (column) can hold at most ceil(run / 2) tents per run of consecutive
+ *                candidate cells
+ *              - a 2x2 block holds at most one tent, so two adjacent lines (columns) can hold
+ *                at most ceil(run / 2) tents per run of consecutive candidate column (line) pairs
+ *              - every tent of a line (column) needs its own tree in that line (column) or in
+ *                one of its neighbours
+ *              - there are at least as many trees as tents
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int screenMap(map *mptr) {
+    screen *sptr;
+    int possible;
+
+    if (!screenHints(mptr)) return 0;
+
+    sptr = startScreen(mptr);
+    for (int i = 0; i < getMapLines(mptr) && screenLine(sptr, i); i++)
+        ;
+    possible = finishScreen(sptr);
+    deleteScreen(sptr);
+
+    return possible;
+}
+
+/**
+ * Function: screenHints
+ * 
+ * Description: checks the bounds of screenMap that hold whatever the grid, so that a map is
+ *              rejected from its header: a line (column) holds at most ceil(columns / 2)
+ *              (ceil(lines / 2)) tents, and so do two adjacent lines (columns)
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (hints set)
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int screenHints(map *mptr) {
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr);
+
+    for (int i = 0; i < lines; i++) {
+        if (getTentsInLine(mptr, i) + (i > 0 ? getTentsInLine(mptr, i - 1) : 0) > (columns + 1) / 2) return 0;
+    }
+    for (int j = 0; j < columns; j++) {
+        if (getTentsInColumn(mptr, j) + (j > 0 ? getTentsInColumn(mptr, j - 1) : 0) > (lines + 1) / 2) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: startScreen
+ * 
+ * Description: starts screening a map line by line, which may begin before its lines are read
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (hints set)
+ * 
+ * Return value: pointer to new screening
+ */
+screen *startScreen(map *mptr) {
+    int columns = getMapColumns(mptr);
+    screen *sptr;
+
+    sptr = (screen *) malloc(sizeof(screen));
+    if (sptr == NULL) exit(EXIT_FAILURE);
+
+    sptr->mptr = mptr;
+    sptr->columnTrees = (int *) calloc(5 * ((size_t) columns + 1), sizeof(int));
+    sptr->candidateBuffer = (char *) calloc(2 * ((size_t) columns + 1), sizeof(char));
+    if (sptr->columnTrees == NULL || sptr->candidateBuffer == NULL) exit(EXIT_FAILURE);
+    sptr->columnRun = sptr->columnTrees + columns + 1;
+    sptr->columnCapacity = sptr->columnRun + columns + 1;
+    sptr->pairRun = sptr->columnCapacity + columns + 1;
+    sptr->pairCapacity = sptr->pairRun + columns + 1;
+    sptr->candidates = sptr->candidateBuffer;
+    sptr->previousCandidates = sptr->candidateBuffer + columns + 1;
+    sptr->treesAbove = 0;
+    sptr->treesHere = 0;
+    sptr->trees = 0;
+    sptr->possible = 1;
+
+    return sptr;
+}
+
+/**
+ * Function: screenLine
+ * 
+ * Description: checks the bounds of screenMap for the next line of a map (lines are screened
+ *              in order) and adds it to the column counts. Only trees are looked at, so lines
+ *              before it may already hold uncertains
+ * 
+ * Arguments:
+ *     screen *sptr - screening pointer
+ *     int i - number of line (the line below it already read)
+ * 
+ * Return value:
+ *     1 - if map might have solution so far
+ *     0 - if map is impossible
+ */
+int screenLine(screen *sptr, int i) {
+    map *mptr = sptr->mptr;
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr);
+    char *above, *line, *below, *candidates = sptr->candidates, *previousCandidates = sptr->previousCandidates;
+    int treesBelow = 0, run = 0, capacity = 0, pairLineRun = 0, pairLineCapacity = 0;
+
+    if (!sptr->possible) return 0;
+
+    above = i > 0 ? getMapLine(mptr, i - 1) : NULL;
+    line = getMapLine(mptr, i);
+    below = i + 1 < lines ? getMapLine(mptr, i + 1) : NULL;
+
+    for (int j = 0; j < columns && i == 0; j++) {
+        if (line[j] == 'A') sptr->treesHere++;
+    }
+    for (int j = 0; j < columns && below != NULL; j++) {
+        if (below[j] == 'A') treesBelow++;
+    }
+    sptr->trees += sptr->treesHere;
+    if (getTentsInLine(mptr, i) > sptr->treesAbove + sptr->treesHere + treesBelow) sptr->possible = 0;
+
+    for (int j = 0; j < columns; j++) {
+        candidates[j] = isCandidate(mptr, above, line, below, i, j);
+        if (line[j] == 'A') sptr->columnTrees[j]++;
+
+        if (candidates[j])
+            run++;
+        else
+            capacity += closeRun(&run);
+
+        if (candidates[j] || previousCandidates[j])
+            pairLineRun++;
+        else
+            pairLineCapacity += closeRun(&pairLineRun);
+
+        if (candidates[j])
+            sptr->columnRun[j]++;
+        else
+            sptr->columnCapacity[j] += closeRun(&sptr->columnRun[j]);
+
+        if (j > 0 && (candidates[j] || candidates[j - 1]))
+            sptr->pairRun[j]++;
+        else if (j > 0)
+            sptr->pairCapacity[j] += closeRun(&sptr->pairRun[j]);
+    }
+    capacity += closeRun(&run);
+    pairLineCapacity += closeRun(&pairLineRun);
+    if (capacity < getTentsInLine(mptr, i)) sptr->possible = 0;
+    if (i > 0 && pairLineCapacity < getTentsInLine(mptr, i - 1) + getTentsInLine(mptr, i)) sptr->possible = 0;
+
+    sptr->previousCandidates = candidates;
+    sptr->candidates = previousCandidates;
+    sptr->treesAbove = sptr->treesHere;
+    sptr->treesHere = treesBelow;
+
+    return sptr->possible;
+}
+
+/**
+ * Function: finishScreen
+ * 
+ * Description: checks the bounds of screenMap on columns and on the whole map once every line
+ *              was screened
+ * 
+ * Arguments:
+ *     screen *sptr - screening pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int finishScreen(screen *sptr) {
+    map *mptr = sptr->mptr;
+    int columns = getMapColumns(mptr);
+
+    for (int j = 0; j < columns && sptr->possible; j++) {
+        sptr->columnCapacity[j] += closeRun(&sptr->columnRun[j]);
+        if (sptr->columnCapacity[j] < getTentsInColumn(mptr, j)) sptr->possible = 0;
+        if (getTentsInColumn(mptr, j) > (j > 0 ? sptr->columnTrees[j - 1] : 0) + sptr->columnTrees[j] + (j + 1 < columns ? sptr->columnTrees[j + 1] : 0)) sptr->possible = 0;
+        if (j > 0) {
+            sptr->pairCapacity[j] += closeRun(&sptr->pairRun[j]);
+            if (sptr->pairCapacity[j] < getTentsInColumn(mptr, j - 1) + getTentsInColumn(mptr, j)) sptr->possible = 0;
+        }
+    }
+
+    if (sptr->possible && sptr->trees < getTentsNumber(mptr)) sptr->possible = 0;
+
+    return sptr->possible;
+}
+
+/**
+ * Function: deleteScreen
+ * 
+ * Description: deletes a screening (but not its map)
+ * 
+ * Arguments:
+ *     screen *sptr - pointer to screening to be deleted
+ * 
+ * Return value: none
+ */
+void deleteScreen(screen *sptr) {
+    if (sptr == NULL) return;
+
+    free(sptr->columnTrees);
+    free(sptr->candidateBuffer);
+    free(sptr);
+}
+
+/**
+ * Function: isCandidate
+ * 
+ * Description: checks if cell might support a tent i.e. ortogonal to tree and not in a zero row/collumn
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     char *above - line above (NULL if none)
+ *     char *line - line of cell
+ *     char *below - line below (NULL if none)
+ *     int i - line of cell
+ *     int j - column of cell
+ * 
+ * Return value:
+ *     1 - if cell is a candidate
+ *     0 - otherwise
+ */
+int isCandidate(map *mptr, char *above, char *line, char *below, int i, int j) {
+    if (line[j] == 'A' || !getTentsInLine(mptr, i) || !getTentsInColumn(mptr, j)) return 0;
+    if (above != NULL && above[j] == 'A') return 1;
+    if (below != NULL && below[j] == 'A') return 1;
+    if (j > 0 && line[j - 1] == 'A') return 1;
+    if (j + 1 < getMapColumns(mptr) && line[j + 1] == 'A') return 1;
+    return 0;
+}
+
+/**
+ * Function: closeRun
+ * 
+ * Description: ends a run of consecutive candidates
+ * 
+ * Arguments:
+ *     int *run - run length (reset to zero)
+ * 
+ * Return value:
+ *     maximum number of non adjacent tents in the run
+ */
+int closeRun(int *run) {
+    int capacity = (*run + 1) / 2;
+    *run = 0;
+    return capacity;
+}
@@ -0,0 +1,108 @@
+/**
+ * Filename: screen.h
+ * 
+ * Description: cheap necessary conditions checked before any solver state is built
+ */
+
+#ifndef SCREEN_H
+#define SCREEN_H
+
+#include "map.h"
+
+typedef struct screenStruct screen;
+
+/**
+ * Function: screenMap
+ * 
+ * Description: checks in a single pass over the grid (trees only, no uncertains marked yet)
+ *              capacity bounds that every solvable map meets:
+ *              - a line (column) can hold at most ceil(run / 2) tents per run of consecutive
+ *                candidate cells
+ *              - a 2x2 block holds at most one tent, so two adjacent lines (columns) can hold
+ *                at most ceil(run / 2) tents per run of consecutive candidate column (line) pairs
+ *              - every tent of a line (column) needs its own tree in that line (column) or in
+ *                one of its neighbours
+ *              - there are at least as many trees as tents
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int screenMap(map *mptr);
+
+/**
+ * Function: screenHints
+ * 
+ * Description: checks the bounds of screenMap that hold whatever the grid, so that a map is
+ *              rejected from its header: a line (column) holds at most ceil(columns / 2)
+ *              (ceil(lines / 2)) tents, and so do two adjacent lines (columns)
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (hints set)
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int screenHints(map *mptr);
+
+/**
+ * Function: startScreen
+ * 
+ * Description: starts screening a map line by line, which may begin before its lines are read
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (hints set)
+ * 
+ * Return value: pointer to new screening
+ */
+screen *startScreen(map *mptr);
+
+/**
+ * Function: screenLine
+ * 
+ * Description: checks the bounds of screenMap for the next line of a map (lines are screened
+ *              in order) and adds it to the column counts. Only trees are looked at, so lines
+ *              before it may already hold uncertains
+ * 
+ * Arguments:
+ *     screen *sptr - screening pointer
+ *     int i - number of line (the line below it already read)
+ * 
+ * Return value:
+ *     1 - if map might have solution so far
+ *     0 - if map is impossible
+ */
+int screenLine(screen *sptr, int i);
+
+/**
+ * Function: finishScreen
+ * 
+ * Description: checks the bounds of screenMap on columns and on the whole map once every line
+ *              was screened
+ * 
+ * Arguments:
+ *     screen *sptr - screening pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int finishScreen(screen *sptr);
+
+/**
+ * Function: deleteScreen
+ * 
+ * Description: deletes a screening (but not its map)
+ * 
+ * Arguments:
+ *     screen *sptr - pointer to screening to be deleted
+ * 
+ * Return value: none
+ */
+void deleteScreen(screen *sptr);
+
+#endif
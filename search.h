@@ -0,0 +1,415 @@
+/**
+ * Filename: search.h
+ * 
+ * Description: Solver state shared between the backtracker and its width specialised kernels
+ */
+
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include "map.h"
+#include "screen.h"
+#include "solver.h"
+
+typedef struct kernelsStruct kernels;
+
+typedef struct {
+    int line;
+    int column;
+} cell;
+
+/**
+ * Cell a tree is matched to by the matching of trees to cells that may still hold their tent
+ * (line -1 for none), and mark of the last augmenting path search that visited the tree.
+ */
+typedef struct {
+    cell Cell;
+    int mark;
+} support;
+
+/**
+ * Counts of preprocessing that marks uncertain cells line by line, either while a map is read
+ * or by stripes of lines in parallel. Next uncertain and next tree are the positions where the
+ * cells of the next line are written in the uncertain and tree arrays.
+ */
+typedef struct {
+    int trees;
+    int uncertains;
+    int isolatedTree;
+    int linesFit;
+    int *columnCounts;
+    int nextUncertain;
+    int nextTree;
+} lineScan;
+
+/**
+ * Boards keep one word per line for trees, tents and uncertains, the number of trees before each
+ * line and one word per line for cells matched to a tree, with an empty line before the first and
+ * after the last so that neighbours never need bounds checks. Line and column counters keep tents
+ * and uncertains per line and column.
+ * Boards are only used by width specialised kernels, counters also by sparse kernels. Trail
+ * keeps trees visited by an injectivity check, so that visited can be cleared without a scan.
+ * Streamed is the map preprocessed while its lines were read, with result streamedResult.
+ * Supports, gained and freed keep the matching of trees to cells during search.
+ * Feature scratch keeps uncertains per line and column and groups of trees while the features
+ * of a map are extracted.
+ */
+struct workspaceStruct {
+    cell *uncertainArray;
+    int uncertainCapacity;
+    cell *treeArray;
+    cell *links;
+    char *visited;
+    int *trail;
+    support *supports;
+    cell *gained;
+    int *freed;
+    int treeCapacity;
+    const kernels *kernel;
+    uint64_t *boards;
+    int boardCapacity;
+    int *lineCounters;
+    int lineCapacity;
+    int *columnCounters;
+    int columnCapacity;
+    map *streamed;
+    screen *screening;
+    int streamedResult;
+    lineScan scan;
+    int threads;
+    int *featureScratch;
+    long long featureCapacity;
+};
+
+typedef struct {
+    pthread_mutex_t lock;
+    long long count;
+    long long limit;
+    int stop;
+} sharedCount;
+
+/**
+ * When phase is set, backtracking tries first the value each cell last took. With a failure
+ * limit, backtracking stops (setting restart) after that many dead ends. Spare trees is the
+ * number of trees beyond tents (low season when positive). In low season every kernel keeps a
+ * matching of trees to different tent or uncertain cells next to them, supported is its size.
+ * Any augmenting path starts at a freed tree or ends at a gained cell (unless stale), so the
+ * matching is only made maximum when it gets smaller than the number of tents. Support mark
+ * tells the trees visited by the current augmenting path search.
+ */
+typedef struct {
+    const kernels *kernel;
+    cell *uncertainArray;
+    cell *treeArray;
+    cell *links;
+    char *visited;
+    int *trail;
+    int trailLength;
+    int uncertainCount;
+    uint64_t *boards;
+    int boardSize;
+    int *lineTents;
+    int *lineUncertain;
+    int *columnTents;
+    int *columnUncertain;
+    long long limit;
+    long long count;
+    char *firstSolution;
+    int splitDepth;
+    char *prefixes;
+    int prefixCount;
+    int prefixCapacity;
+    sharedCount *shared;
+    int *cancel;
+    char *phase;
+    long long failures;
+    long long failureLimit;
+    int restart;
+    int spareTrees;
+    support *supports;
+    cell *gained;
+    int *freed;
+    int gainedCount;
+    int freedCount;
+    int supportsStale;
+    int supportMark;
+    int supported;
+} search;
+
+/**
+ * Function: reserveArrays
+ * 
+ * Description: grows uncertain array and the tree array, links, visited, trail and supports
+ *              (with gained and freed) of a workspace so that they hold uncertain and tree cells
+ *              of a map
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int uncertainCount - number of uncertain cells
+ *     int treesNumber - number of trees
+ * 
+ * Return value: none
+ */
+void reserveArrays(workspace *wptr, int uncertainCount, int treesNumber);
+
+/**
+ * Function: reserveBoards
+ * 
+ * Description: grows boards of a workspace for a map and clears them
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int lines - number of lines of map
+ * 
+ * Return value: none
+ */
+void reserveBoards(workspace *wptr, int lines);
+
+/**
+ * Function: reserveCounters
+ * 
+ * Description: grows line and column counters of a workspace for a map and clears them
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int lines - number of lines of map
+ *     int columns - number of columns of map
+ * 
+ * Return value: none
+ */
+void reserveCounters(workspace *wptr, int lines, int columns);
+
+/**
+ * Function: initSearch
+ * 
+ * Description: prepares search over all uncertain cells of a preprocessed map
+ * 
+ * Arguments:
+ *     search *sptr - search to be initialized
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace with uncertain array, tree array, links and visited
+ *     long long limit - stop after this many solutions (0 for no limit)
+ * 
+ * Return value: none
+ */
+void initSearch(search *sptr, map *mptr, workspace *wptr, long long limit);
+
+/**
+ * Function: backtrackingSolve
+ * 
+ * Description: recursively try to solve map using backtracking
+ * 
+ * Side-effects: writes solution to mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with uncertain array, tree array, links (init to -1) and visited arrays
+ *     int current - current position of uncertainArary that backtraking is working (should be called with 0)
+ * 
+ * Return value:
+ *     1 - if search should stop (solution limit reached)
+ *     0 - if every possibility below current was explored
+ */
+int backtrackingSolve(map *mptr, search *sptr, int current);
+
+/**
+ * Function: findTreeIndex
+ * 
+ * Description: finds where a cell is or would be in a tree array sorted in line order
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace with tree array
+ *     int treesNumber - number of trees in tree array
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     index of first tree not before cell
+ */
+int findTreeIndex(workspace *wptr, int treesNumber, int line, int column);
+
+/**
+ * Function: findTree
+ * 
+ * Description: finds index of a tree in tree array by binary search
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array sorted in line order
+ *     int line - line of tree
+ *     int column - column of tree
+ * 
+ * Return value:
+ *     index of tree in tree array
+ *     -1 if there is no tree there
+ */
+int findTree(map *mptr, search *sptr, int line, int column);
+
+/**
+ * Function: startSupports
+ * 
+ * Description: matches trees to different tent or uncertain cells next to them, greedily and
+ *              then along augmenting paths until the matching is maximum
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ * 
+ * Return value: none
+ */
+void startSupports(map *mptr, search *sptr);
+
+/**
+ * Function: loseSupport
+ * 
+ * Description: frees the tree matched to a cell that can no longer hold a tent, any new
+ *              augmenting path starts at that tree
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (cell already set)
+ *     search *sptr - search with tree array and supports
+ *     cell Cell - cell that stopped holding a tent
+ * 
+ * Return value: none
+ */
+void loseSupport(map *mptr, search *sptr, cell Cell);
+
+/**
+ * Function: gainSupport
+ * 
+ * Description: keeps a cell that may hold a tent again, any new augmenting path ends at it
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (cell already set)
+ *     search *sptr - search with tree array and supports
+ *     cell Cell - cell that may hold a tent again
+ * 
+ * Return value: none
+ */
+void gainSupport(map *mptr, search *sptr, cell Cell);
+
+/**
+ * Function: settleSupports
+ * 
+ * Description: checks that trees can still be matched to as many cells as there are tents,
+ *              looking for augmenting paths from freed trees and gained cells only while the
+ *              matching is smaller, which leaves it maximum when the check fails
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ * 
+ * Return value:
+ *     1 - if every tent might still get a tree
+ *     0 - otherwise
+ */
+int settleSupports(map *mptr, search *sptr);
+
+/**
+ * Function: localInjectivity
+ * 
+ * Description: checks tent-tree injectivity i.e. theres a unique tree for a tent (locally)
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell tent - tent to be validated
+ *     search *sptr - search with tree array, links (init to -1) and visited arrays
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int localInjectivity(map *mptr, cell tent, search *sptr);
+
+/**
+ * Function: treesAround
+ * 
+ * Description: generic kernel that finds the trees next to a cell by binary search in tree array
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array sorted in line order
+ *     cell Cell - cell
+ *     int *around - returns indexes of trees in tree array order: above, left, right and below
+ * 
+ * Return value:
+ *     number of trees next to cell
+ */
+int treesAround(map *mptr, search *sptr, cell Cell, int *around);
+
+/**
+ * Function: preprocessCells
+ * 
+ * Description: generic kernel that counts trees, marks uncertain cells, builds uncertain and
+ *              tree arrays and checks hints consistency scanning the map cell by cell
+ * 
+ * Side-effects: writes trees number and uncertains in mptr, fills wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int preprocessCells(map *mptr, workspace *wptr);
+
+/**
+ * Function: setCell
+ * 
+ * Description: generic kernel that sets content of an uncertain cell during search
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search pointer
+ *     cell Cell - cell to be set
+ *     char value - 'T', '.' or 'U'
+ * 
+ * Return value: none
+ */
+void setCell(map *mptr, search *sptr, cell Cell, char value);
+
+/**
+ * Function: validTent
+ * 
+ * Description: generic kernel that checks if tent is valid
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell Cell - tent to be validated
+ *     search *sptr - search with tree array, links (init to -1) and visited arrays
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int validTent(map *mptr, cell Cell, search *sptr);
+
+/**
+ * Function: validGrass
+ * 
+ * Description: generic kernel that checks if grass is valid
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell Cell - grass to be validated
+ *     search *sptr - search pointer
+ * 
+ * Return value:
+ *     1 - if grass is valid
+ *     0 - if grass is invalid
+ */
+int validGrass(map *mptr, cell Cell, search *sptr);
+
+#endif
@@ -4,9 +4,35 @@
  * Description: Solver for tents and trees games
  */
 
+#define _POSIX_C_SOURCE 200809L
+
+#include "solver.h"
+#include <errno.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "decomposition.h"
+#include "difficulty.h"
+#include "kernels.h"
 #include "map.h"
+#include "pool.h"
+#include "profile.h"
+#include "screen.h"
+#include "search.h"
+#include "trace.h"
+
+#define SPLIT_MIN_UNCERTAIN 32
+#define SPLIT_EXTRA_DEPTH 4
+
+/** maps with this many cells are preprocessed by the threads of their workspace, one stripe of lines each */
+#define STRIPE_MIN_CELLS (1 << 22)
+
+/** dead ends allowed to the first run of a search with restarts, later runs get Luby multiples */
+#define RESTART_UNIT 256
 
 struct {
     int dx;
@@ -19,18 +45,233 @@ struct {
 } ortogonals[] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
 
 typedef struct {
-    int line;
-    int column;
-} cell;
+    long key;
+    cell Cell;
+} ranked;
+
+typedef struct {
+    long key;
+    cell Cell;
+    char phase;
+} restartCell;
+
+typedef struct {
+    map *mptr;
+    workspace *wptr;
+    int first;
+    int last;
+    lineScan scan;
+} stripe;
 
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    int finished;
+    int cancel;
+} watchdog;
+
+typedef struct {
+    map *source;
+    cell *sourceLinks;
+    support *sourceSupports;
+    search search;
+    char *prefix;
+    int depth;
+} subtree;
+
+int runEngines(map *mptr, workspace *wptr, solverOptions *optr);
+int forcedRoute(map *mptr, solverOptions *optr);
+void extractFeatures(map *mptr, workspace *wptr, mapFeatures *fptr);
+int findTreeGroup(int *parent, int t);
+int timeRoute(map *mptr, workspace *wptr, solverOptions *optr, double *seconds);
+void *watchRoute(void *arg);
+int preprocessMap(map *mptr, workspace *wptr);
 void countNumberOfTrees(map *mptr);
 int markUncertainCells(map *mptr);
-void buildUncertainAndTreeArray(map *mptr, cell **uncertainArray, cell **treeArray);
+void buildUncertainAndTreeArray(map *mptr, workspace *wptr);
 int checkHintsConsistency(map *mptr);
-int backtrackingSolve(map *mptr, cell *uncertainArray, cell *treeArray, cell *links, char *visited, int current);
-int validTent(map *mptr, cell Cell, cell *treeArray, cell *links, char *visited);
-int validGrass(map *mptr, cell Cell);
-int localInjectivity(map *mptr, cell tent, cell *treeArray, cell *links, char *visited);
+void reserveArrays(workspace *wptr, int uncertainCount, int treesNumber);
+void reserveBoards(workspace *wptr, int lines);
+void reserveCounters(workspace *wptr, int lines, int columns);
+void orderUncertainCells(map *mptr, workspace *wptr, solverOptions *optr);
+int compareByColumn(const void *a, const void *b);
+int compareRanked(const void *a, const void *b);
+uint64_t nextRandom(uint64_t *state);
+void restartSearch(map *mptr, search *sptr, unsigned int seed);
+long sweepKey(map *mptr, cell Cell, int sweep);
+long lubyTerm(int run);
+int compareRestartCells(const void *a, const void *b);
+void initSearch(search *sptr, map *mptr, workspace *wptr, long long limit);
+long long countInParallel(map *mptr, workspace *wptr, long long limit, int workers, char *firstSolution);
+void countSubtree(void *arg, int worker);
+int backtrackingSolve(map *mptr, search *sptr, int current);
+int foundSolution(map *mptr, search *sptr);
+int recordPrefix(map *mptr, search *sptr);
+int preprocessCells(map *mptr, workspace *wptr);
+int stripeWorkers(map *mptr, workspace *wptr);
+int preprocessInStripes(map *mptr, workspace *wptr, int workers);
+void markStripe(void *arg, int worker);
+void fillStripe(void *arg, int worker);
+void streamLine(map *mptr, workspace *wptr, int line);
+void startScan(lineScan *scan, int *columnCounts);
+void markLine(map *mptr, int line, lineScan *scan);
+void fillLine(map *mptr, workspace *wptr, int line, lineScan *scan);
+int checkScan(map *mptr, lineScan *scan);
+void setCell(map *mptr, search *sptr, cell Cell, char value);
+int validTent(map *mptr, cell Cell, search *sptr);
+int validGrass(map *mptr, cell Cell, search *sptr);
+int localInjectivity(map *mptr, cell tent, search *sptr);
+int treesAround(map *mptr, search *sptr, cell Cell, int *around);
+int countDeadTrees(map *mptr, workspace *wptr);
+int isDeadTree(map *mptr, int line, int column);
+void matchFreeTrees(map *mptr, search *sptr);
+int supportOwner(map *mptr, search *sptr, cell Cell);
+int augmentSupport(map *mptr, search *sptr, int tree);
+int reachFreeTree(map *mptr, search *sptr, cell Cell);
+void matchSupport(search *sptr, int tree, cell Cell);
+void nextSupportMark(map *mptr, search *sptr);
+
+/**
+ * Function: newWorkspace
+ * 
+ * Description: allocates an empty solver workspace, its buffers grow on demand and are kept
+ *              between calls so that a long lived thread solves every map with warm memory
+ * 
+ * Arguments: none
+ * 
+ * Return value:
+ *     pointer to new workspace if successful
+ *     NULL if error ocurred
+ */
+workspace *newWorkspace(void) {
+    workspace *wptr;
+
+    wptr = (workspace *) malloc(sizeof(workspace));
+    if (wptr == NULL) return NULL;
+
+    wptr->uncertainArray = NULL;
+    wptr->uncertainCapacity = 0;
+    wptr->treeArray = NULL;
+    wptr->links = NULL;
+    wptr->visited = NULL;
+    wptr->trail = NULL;
+    wptr->supports = NULL;
+    wptr->gained = NULL;
+    wptr->freed = NULL;
+    wptr->treeCapacity = 0;
+    wptr->kernel = NULL;
+    wptr->boards = NULL;
+    wptr->boardCapacity = 0;
+    wptr->lineCounters = NULL;
+    wptr->lineCapacity = 0;
+    wptr->columnCounters = NULL;
+    wptr->columnCapacity = 0;
+    wptr->streamed = NULL;
+    wptr->screening = NULL;
+    wptr->threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    wptr->featureScratch = NULL;
+    wptr->featureCapacity = 0;
+
+    return wptr;
+}
+
+/**
+ * Function: setWorkspaceThreads
+ * 
+ * Description: sets how many threads preprocessing of a huge map solved in a workspace may use
+ *              (every core by default), so that workers solving maps side by side share the
+ *              cores instead of each starting one thread per core
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int threads - number of threads (at least 1)
+ * 
+ * Return value: none
+ */
+void setWorkspaceThreads(workspace *wptr, int threads) {
+    wptr->threads = threads > 1 ? threads : 1;
+}
+
+/**
+ * Function: deleteWorkspace
+ * 
+ * Description: deletes a solver workspace
+ * 
+ * Arguments:
+ *     workspace *wptr - pointer to workspace to be deleted
+ * 
+ * Return value: none
+ */
+void deleteWorkspace(workspace *wptr) {
+    if (wptr == NULL) return;
+
+    free(wptr->uncertainArray);
+    free(wptr->treeArray);
+    free(wptr->links);
+    free(wptr->visited);
+    free(wptr->trail);
+    free(wptr->supports);
+    free(wptr->gained);
+    free(wptr->freed);
+    free(wptr->boards);
+    free(wptr->lineCounters);
+    free(wptr->columnCounters);
+    free(wptr->featureScratch);
+    deleteScreen(wptr->screening);
+
+    free(wptr);
+}
+
+/**
+ * Function: estimateSolveBytes
+ * 
+ * Description: estimates bytes of workspace needed to solve a map of a given size and number
+ *              of trees (with room for buffers grown while lines are read)
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     long long trees - number of trees
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long estimateSolveBytes(int lines, int columns, long long trees) {
+    long long cells = (long long) lines * columns;
+    long long uncertains = 4 * trees < cells - trees ? 4 * trees : cells - trees;
+    long long bytes = sizeof(workspace);
+
+    /** uncertain cells are the neighbours of trees, buffers may double while lines are read */
+    if (uncertains < 0) uncertains = 0;
+    bytes += 2 * (uncertains * sizeof(cell) + trees * (3 * sizeof(cell) + sizeof(char) + 2 * sizeof(int) + sizeof(support)));
+    bytes += 2 * ((long long) lines + columns) * sizeof(int) + 5 * ((long long) lines + 2) * sizeof(uint64_t);
+    bytes += ((long long) lines + columns + 3 * trees) * sizeof(int);
+
+    return bytes;
+}
+
+/**
+ * Function: getWorkspaceBytes
+ * 
+ * Description: gets bytes held by the buffers of a workspace
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long getWorkspaceBytes(workspace *wptr) {
+    long long bytes = sizeof(workspace);
+
+    bytes += (long long) wptr->uncertainCapacity * sizeof(cell);
+    bytes += (long long) wptr->treeCapacity * (2 * sizeof(cell) + sizeof(char) + sizeof(int));
+    bytes += (long long) wptr->boardCapacity * sizeof(uint64_t);
+    bytes += ((long long) wptr->lineCapacity + wptr->columnCapacity) * sizeof(int);
+    bytes += wptr->featureCapacity * sizeof(int);
+
+    return bytes;
+}
 
 /**
  * Function: solveMap
@@ -47,235 +288,1781 @@ int localInjectivity(map *mptr, cell tent, cell *treeArray, cell *links, char *v
  *     -1 - if map is impossible
  */
 int solveMap(map *mptr) {
-    int possible;
-    cell *uncertainArray = NULL;
-    cell *treeArray = NULL;
-    cell *links = NULL;
-    char *visited = NULL;
+    workspace *wptr;
+    int result;
 
-    countNumberOfTrees(mptr);
-    if (getTreesNumber(mptr) < getTentsNumber(mptr)) return -1;
+    wptr = newWorkspace();
+    if (wptr == NULL) exit(EXIT_FAILURE);
 
-    possible = markUncertainCells(mptr);
-    if (!possible) return -1;
+    result = solveMapInWorkspace(mptr, wptr);
 
-    buildUncertainAndTreeArray(mptr, &uncertainArray, &treeArray);
+    deleteWorkspace(wptr);
 
-    possible = checkHintsConsistency(mptr);
-    if (!possible) {
-        free(uncertainArray);
-        return -1;
+    return result;
+}
+
+/**
+ * Function: solveMapInWorkspace
+ * 
+ * Description: solves tents and trees map reusing the buffers of a workspace
+ * 
+ * Side-effects: writes solution for mptr, grows wptr buffers
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int solveMapInWorkspace(map *mptr, workspace *wptr) {
+    solverOptions options;
+
+    defaultSolverOptions(&options);
+
+    return solveMapWithOptions(mptr, wptr, &options);
+}
+
+/**
+ * Function: defaultSolverOptions
+ * 
+ * Description: fills solver options with the configuration used by solveMap
+ * 
+ * Arguments:
+ *     solverOptions *optr - options to be filled
+ * 
+ * Return value: none
+ */
+void defaultSolverOptions(solverOptions *optr) {
+    optr->engine = ENGINE_AUTO;
+    optr->order = ORDER_LINES;
+    optr->seed = 1;
+    optr->restarts = 0;
+    optr->cancel = NULL;
+    optr->memoryBudget = 0;
+    optr->model = NULL;
+    optr->features = NULL;
+}
+
+/**
+ * Function: solveMapWithOptions
+ * 
+ * Description: solves tents and trees map with a given engine and order of decisions, giving
+ *              up as soon as *optr->cancel is set by another thread
+ * 
+ * Side-effects: writes solution for mptr (undefined if cancelled), grows wptr buffers
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ *     SOLVE_CANCELLED - if search was cancelled
+ */
+int solveMapWithOptions(map *mptr, workspace *wptr, solverOptions *optr) {
+    int result;
+
+    TRACE_COUNTERS_BEGIN("solve");
+    result = runEngines(mptr, wptr, optr);
+    TRACE_COUNTERS_END("solve");
+
+    return result;
+}
+
+/**
+ * Function: runEngines
+ * 
+ * Description: preprocesses map and runs the engines picked by solveMapWithOptions
+ * 
+ * Side-effects: writes solution for mptr (undefined if cancelled), grows wptr buffers
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ *     SOLVE_CANCELLED - if search was cancelled
+ */
+int runEngines(map *mptr, workspace *wptr, solverOptions *optr) {
+    solverOptions routed = *optr;
+    mapFeatures features;
+    search search;
+    int possible, route;
+
+    TRACE_BEGIN("preprocess");
+    possible = preprocessMap(mptr, wptr);
+    TRACE_END("preprocess");
+    if (!possible) return -1;
+
+    if (optr->engine == ENGINE_AUTO || optr->features != NULL) {
+        TRACE_BEGIN("features");
+        extractFeatures(mptr, wptr, &features);
+        TRACE_END("features");
+        if (optr->features != NULL) *optr->features = features;
     }
+    route = optr->engine == ENGINE_AUTO ? cheapestRoute(optr->model, &features) : forcedRoute(mptr, optr);
 
-    links = (cell *) malloc(getTreesNumber(mptr) * sizeof(cell));
-    if (links == NULL) exit(EXIT_FAILURE);
-    for (int i = 0; i < getTreesNumber(mptr); i++) {
-        links[i].line = -1;
-        links[i].column = -1;
+    /** a dynamic programming engine that gives up leaves the map to the next cheapest route */
+    while (route == ROUTE_PROFILE || route == ROUTE_DECOMPOSITION) {
+        if (route == ROUTE_PROFILE) {
+            TRACE_BEGIN("profile");
+            possible = profileSolve(mptr, optr->cancel);
+            TRACE_END("profile");
+            if (possible != PROFILE_GAVE_UP) return possible ? 1 : -1;
+        } else {
+            TRACE_BEGIN("decomposition");
+            possible = decompositionSolve(mptr, wptr, optr->cancel);
+            TRACE_END("decomposition");
+            if (possible != DECOMPOSITION_GAVE_UP) return possible ? 1 : -1;
+        }
+
+        features.fits[route] = 0;
+        route = optr->engine == ENGINE_AUTO ? cheapestRoute(optr->model, &features) : ROUTE_LINES;
     }
+    if (route == ROUTE_CONSTRAINED) routed.order = ORDER_CONSTRAINED;
 
-    visited = (char *) malloc(getTreesNumber(mptr) * sizeof(char));
-    if (visited == NULL) exit(EXIT_FAILURE);
+    TRACE_BEGIN("search");
+    orderUncertainCells(mptr, wptr, &routed);
+    initSearch(&search, mptr, wptr, 1);
+    search.cancel = optr->cancel;
+    if (optr->restarts)
+        restartSearch(mptr, &search, optr->seed);
+    else
+        backtrackingSolve(mptr, &search, 0);
+    TRACE_END("search");
 
-    possible = backtrackingSolve(mptr, uncertainArray, treeArray, links, visited, 0);
+    if (search.count > 0) return 1;
+    if (optr->cancel != NULL && __atomic_load_n(optr->cancel, __ATOMIC_RELAXED)) return SOLVE_CANCELLED;
+    return -1;
+}
 
-    free(uncertainArray);
-    free(treeArray);
-    free(links);
-    free(visited);
-    if (!possible) return -1;
+/**
+ * Function: forcedRoute
+ * 
+ * Description: gets the route of an engine other than auto, the profile and decomposition
+ *              engines only when the map fits them
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (preprocessed)
+ *     solverOptions *optr - options pointer
+ * 
+ * Return value: route
+ */
+int forcedRoute(map *mptr, solverOptions *optr) {
+    if (optr->engine == ENGINE_PROFILE && profileFits(mptr)) return ROUTE_PROFILE;
+    if (optr->engine == ENGINE_DECOMPOSITION && decompositionFits(mptr)) return ROUTE_DECOMPOSITION;
 
-    return 1;
+    return ROUTE_LINES;
 }
 
 /**
- * Function: countNumberOfTrees
+ * Function: extractFeatures
  * 
- * Description: counts number of trees inside map
+ * Description: measures a preprocessed map for the cost model in time linear in its uncertain
+ *              cells (times the log of its trees): size, candidate cells per tree and trees
+ *              with a single one, slack of lines and columns (candidates beyond their hints),
+ *              season, and groups of trees linked by shared candidates with the largest of them
  * 
- * Side-effects: writes number of trees in mptr
+ * Side-effects: grows feature scratch of wptr
  * 
  * Arguments:
- *     map *mptr - map pointer
+ *     map *mptr - map pointer (preprocessed)
+ *     workspace *wptr - workspace with uncertain and tree arrays
+ *     mapFeatures *fptr - returns features and routes that fit the map
  * 
  * Return value: none
  */
-void countNumberOfTrees(map *mptr) {
-    int treeCount = 0;
-    for (int i = 0; i < getMapLines(mptr); i++) {
-        for (int j = 0; j < getMapColumns(mptr); j++) {
-            if (getContentOfPosition(mptr, i, j) == 'A') treeCount++;
+void extractFeatures(map *mptr, workspace *wptr, mapFeatures *fptr) {
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr);
+    int trees = getTreesNumber(mptr), uncertains = getUncertainCount(mptr);
+    int *lineUncertain, *columnUncertain, *parent, *candidates, *groupSize;
+    int t, first, line, column, forced = 0, groups = 0, largest = 0;
+    long long slack = 0, links = 0;
+    double cells = (double) lines * columns;
+    cell u;
+
+    if ((long long) lines + columns + 3LL * trees > wptr->featureCapacity) {
+        free(wptr->featureScratch);
+        wptr->featureCapacity = (long long) lines + columns + 3LL * trees;
+        wptr->featureScratch = (int *) malloc(wptr->featureCapacity * sizeof(int));
+        if (wptr->featureScratch == NULL) exit(EXIT_FAILURE);
+    }
+    lineUncertain = wptr->featureScratch;
+    columnUncertain = lineUncertain + lines;
+    parent = columnUncertain + columns;
+    candidates = parent + trees;
+    groupSize = candidates + trees;
+
+    memset(lineUncertain, 0, ((long long) lines + columns) * sizeof(int));
+    for (int i = 0; i < trees; i++) {
+        parent[i] = i;
+        candidates[i] = 0;
+        groupSize[i] = 0;
+    }
+
+    for (int i = 0; i < uncertains; i++) {
+        u = wptr->uncertainArray[i];
+        lineUncertain[u.line]++;
+        columnUncertain[u.column]++;
+
+        first = -1;
+        for (int k = 0; k < 4; k++) {
+            line = u.line + ortogonals[k].dx;
+            column = u.column + ortogonals[k].dy;
+            t = findTreeIndex(wptr, trees, line, column);
+            if (t == trees || wptr->treeArray[t].line != line || wptr->treeArray[t].column != column) continue;
+            candidates[t]++;
+            links++;
+            if (first == -1)
+                first = t;
+            else
+                parent[findTreeGroup(parent, t)] = findTreeGroup(parent, first);
         }
     }
-    setTreesNumber(mptr, treeCount);
+
+    for (int i = 0; i < lines; i++) slack += lineUncertain[i] - getTentsInLine(mptr, i);
+    for (int j = 0; j < columns; j++) slack += columnUncertain[j] - getTentsInColumn(mptr, j);
+
+    /** trees left without candidate (spare ones in low season) belong to no group */
+    for (int i = 0; i < trees; i++) {
+        if (candidates[i] == 1) forced++;
+        if (candidates[i] > 0) groupSize[findTreeGroup(parent, i)]++;
+    }
+    for (int i = 0; i < trees; i++) {
+        if (groupSize[i] > 0) groups++;
+        if (groupSize[i] > largest) largest = groupSize[i];
+    }
+
+    fptr->values[FEATURE_BIAS] = 1;
+    fptr->values[FEATURE_CELLS] = log2(cells + 1);
+    fptr->values[FEATURE_TREES] = log2(trees + 1.0);
+    fptr->values[FEATURE_UNCERTAINS] = log2(uncertains + 1.0);
+    fptr->values[FEATURE_CANDIDATES] = trees > 0 ? (double) links / trees : 0;
+    fptr->values[FEATURE_FORCED] = trees > 0 ? (double) forced / trees : 0;
+    fptr->values[FEATURE_SLACK] = uncertains > 0 ? (double) slack / (2.0 * uncertains) : 0;
+    fptr->values[FEATURE_LOW_SEASON] = trees > getTentsNumber(mptr);
+    fptr->values[FEATURE_COMPONENTS] = log2(groups + 1.0);
+    fptr->values[FEATURE_LARGEST] = log2(largest + 1.0);
+    fptr->values[FEATURE_DENSITY] = cells > 0 ? trees / cells : 0;
+    fptr->values[FEATURE_WIDTH] = log2((lines < columns ? lines : columns) + 1.0);
+
+    fptr->fits[ROUTE_PROFILE] = profileFits(mptr);
+    fptr->fits[ROUTE_DECOMPOSITION] = decompositionFits(mptr);
+    fptr->fits[ROUTE_LINES] = 1;
+    fptr->fits[ROUTE_CONSTRAINED] = 1;
 }
 
 /**
- * Function: markUncertainCells
+ * Function: findTreeIndex
  * 
- * Description: marks in map cells that might support tents i.e. ortogonal to tree and not in a zero row/collumn
+ * Description: finds where a cell is or would be in a tree array sorted in line order
  * 
- * Side-effects: writes uncertains in mptr
+ * Arguments:
+ *     workspace *wptr - workspace with tree array
+ *     int treesNumber - number of trees in tree array
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     index of first tree not before cell
+ */
+int findTreeIndex(workspace *wptr, int treesNumber, int line, int column) {
+    int low = 0, high = treesNumber, middle;
+    cell tree;
+
+    while (low < high) {
+        middle = low + (high - low) / 2;
+        tree = wptr->treeArray[middle];
+        if (tree.line < line || (tree.line == line && tree.column < column))
+            low = middle + 1;
+        else
+            high = middle;
+    }
+
+    return low;
+}
+
+/**
+ * Function: findTreeGroup
+ * 
+ * Description: finds root of a tree in union find, halving the path
+ * 
+ * Arguments:
+ *     int *parent - parent of every tree
+ *     int t - tree
+ * 
+ * Return value: root of t
+ */
+int findTreeGroup(int *parent, int t) {
+    while (parent[t] != t) {
+        parent[t] = parent[parent[t]];
+        t = parent[t];
+    }
+
+    return t;
+}
+
+/**
+ * Function: countSolutions
+ * 
+ * Description: counts solutions of tents and trees map, stopping once limit is reached.
+ *              Preprocessing is done once and, with more than one worker, the search tree is
+ *              split at a small depth and its subtrees are counted in parallel
+ * 
+ * Side-effects: writes first solution found (in search order) for mptr
  * 
  * Arguments:
  *     map *mptr - map pointer
+ *     long long limit - stop after this many solutions (0 for no limit)
+ *     int workers - number of threads
  * 
  * Return value:
- *     1 - if map might have solution
- *     0 - if map is impossible
+ *     number of solutions (at most limit)
  */
-int markUncertainCells(map *mptr) {
-    int isolatedTree;
-    char c;
-    for (int i = 0; i < getMapLines(mptr); i++) {
-        for (int j = 0; j < getMapColumns(mptr); j++) {
-            if (getContentOfPosition(mptr, i, j) == 'A') {
-                isolatedTree = 1;
-                for (int k = 0; k < 4; k++) {
-                    if (i + ortogonals[k].dx < 0 || i + ortogonals[k].dx >= getMapLines(mptr)) continue;
-                    if (j + ortogonals[k].dy < 0 || j + ortogonals[k].dy >= getMapColumns(mptr)) continue;
-                    if (((c = getContentOfPosition(mptr, i + ortogonals[k].dx, j + ortogonals[k].dy)) != 'A') && getTentsInLine(mptr, i + ortogonals[k].dx) && getTentsInColumn(mptr, j + ortogonals[k].dy)) {
-                        if (c != 'U') {
-                            setContentOfPosition(mptr, i + ortogonals[k].dx, j + ortogonals[k].dy, 'U');
-                            incrementUncertainCount(mptr);
-                        }
-                        isolatedTree = 0;
-                    }
-                }
-                if (isolatedTree && getTreesNumber(mptr) == getTentsNumber(mptr)) return 0;
-            }
+long long countSolutions(map *mptr, long long limit, int workers) {
+    workspace *wptr;
+    search search;
+    char *firstSolution;
+    long long count;
+    int possible;
+
+    wptr = newWorkspace();
+    if (wptr == NULL) exit(EXIT_FAILURE);
+    setWorkspaceThreads(wptr, workers);
+
+    TRACE_BEGIN("preprocess");
+    possible = preprocessMap(mptr, wptr);
+    TRACE_END("preprocess");
+    if (!possible) {
+        deleteWorkspace(wptr);
+        return 0;
+    }
+
+    firstSolution = (char *) malloc(getUncertainCount(mptr) * sizeof(char) + 1);
+    if (firstSolution == NULL) exit(EXIT_FAILURE);
+
+    TRACE_BEGIN("search");
+    if (workers > 1 && getUncertainCount(mptr) >= SPLIT_MIN_UNCERTAIN) {
+        count = countInParallel(mptr, wptr, limit, workers, firstSolution);
+    } else {
+        initSearch(&search, mptr, wptr, limit);
+        search.firstSolution = firstSolution;
+        backtrackingSolve(mptr, &search, 0);
+        count = search.count;
+    }
+    TRACE_END("search");
+
+    if (count > 0) {
+        for (int i = 0; i < getUncertainCount(mptr); i++) {
+            setContentOfPosition(mptr, wptr->uncertainArray[i].line, wptr->uncertainArray[i].column, firstSolution[i]);
         }
     }
-    if (getUncertainCount(mptr) < getTreesNumber(mptr) && getTreesNumber(mptr) == getTentsNumber(mptr)) return 0;
-    return 1;
+
+    free(firstSolution);
+    deleteWorkspace(wptr);
+
+    return count;
+}
+
+/**
+ * Function: benchmarkRoutes
+ * 
+ * Description: solves a map with every route that fits it, one after another on copies of the
+ *              map, and writes the features of the map with the time of every route as a line
+ *              of stats. A route still running after BENCHMARK_SECONDS is cancelled and that
+ *              time is written instead, a map no route solves in time is then solved without
+ *              deadline
+ * 
+ * Side-effects: replaces *mptr with the map solved by the fastest route (or solves it), grows
+ *               wptr buffers
+ * 
+ * Arguments:
+ *     map **mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer (engine and order are set by every route)
+ *     FILE *log - file where the stats line is written
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int benchmarkRoutes(map **mptr, workspace *wptr, solverOptions *optr, FILE *log) {
+    int engines[ROUTE_COUNT] = {ENGINE_PROFILE, ENGINE_DECOMPOSITION, ENGINE_BACKTRACKING, ENGINE_BACKTRACKING};
+    solverOptions options = *optr;
+    mapFeatures features;
+    map *copies[ROUTE_COUNT] = {NULL};
+    double seconds[ROUTE_COUNT];
+    int results[ROUTE_COUNT], fastest = -1, r;
+
+    /** lines go first, they fit every map and tell which other routes fit it */
+    memset(&features, 0, sizeof(mapFeatures));
+    features.fits[ROUTE_LINES] = 1;
+    for (int k = 0; k < ROUTE_COUNT; k++) {
+        r = (ROUTE_LINES + k) % ROUTE_COUNT;
+        if (!features.fits[r]) continue;
+
+        copies[r] = copyMap(*mptr);
+        if (copies[r] == NULL) exit(EXIT_FAILURE);
+        options.engine = engines[r];
+        options.order = r == ROUTE_CONSTRAINED ? ORDER_CONSTRAINED : ORDER_LINES;
+        options.features = k == 0 ? &features : NULL;
+
+        results[r] = timeRoute(copies[r], wptr, &options, &seconds[r]);
+        if (results[r] != SOLVE_CANCELLED && (fastest == -1 || seconds[r] < seconds[fastest])) fastest = r;
+    }
+
+    /** maps found impossible by preprocessing never get features, every route is the same for them */
+    if (features.values[FEATURE_BIAS] != 0) writeStats(log, getMapLines(*mptr), getMapColumns(*mptr), fastest == -1 ? SOLVE_CANCELLED : results[fastest], &features, seconds);
+
+    for (r = 0; r < ROUTE_COUNT; r++) {
+        if (r != fastest) deleteMap(copies[r]);
+    }
+
+    /** stats keep a map no route solved in time, its solution still needs a search without a deadline */
+    if (fastest == -1) return solveMapWithOptions(*mptr, wptr, optr);
+
+    deleteMap(*mptr);
+    *mptr = copies[fastest];
+
+    return results[fastest];
+}
+
+/**
+ * Function: timeRoute
+ * 
+ * Description: solves a map while a watchdog thread cancels the search once BENCHMARK_SECONDS
+ *              have passed
+ * 
+ * Side-effects: writes solution for mptr (undefined if cancelled), sets optr->cancel
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer
+ *     double *seconds - returns seconds taken
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ *     SOLVE_CANCELLED - if search was cancelled
+ */
+int timeRoute(map *mptr, workspace *wptr, solverOptions *optr, double *seconds) {
+    watchdog watch;
+    pthread_t thread;
+    struct timespec start, end;
+    int result;
+
+    pthread_mutex_init(&watch.lock, NULL);
+    pthread_cond_init(&watch.wake, NULL);
+    watch.finished = 0;
+    watch.cancel = 0;
+    optr->cancel = &watch.cancel;
+    if (pthread_create(&thread, NULL, watchRoute, &watch)) exit(EXIT_FAILURE);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    result = solveMapWithOptions(mptr, wptr, optr);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    *seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    pthread_mutex_lock(&watch.lock);
+    watch.finished = 1;
+    pthread_cond_signal(&watch.wake);
+    pthread_mutex_unlock(&watch.lock);
+    pthread_join(thread, NULL);
+
+    pthread_mutex_destroy(&watch.lock);
+    pthread_cond_destroy(&watch.wake);
+
+    return result;
+}
+
+/**
+ * Function: watchRoute
+ * 
+ * Description: thread that sets the cancel flag of a watchdog unless the route finishes
+ *              within BENCHMARK_SECONDS
+ * 
+ * Arguments:
+ *     void *arg - pointer to watchdog
+ * 
+ * Return value: NULL
+ */
+void *watchRoute(void *arg) {
+    watchdog *watch = (watchdog *) arg;
+    struct timespec deadline;
+    int timedOut = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += BENCHMARK_SECONDS;
+
+    pthread_mutex_lock(&watch->lock);
+    while (!watch->finished && !timedOut) timedOut = pthread_cond_timedwait(&watch->wake, &watch->lock, &deadline) == ETIMEDOUT;
+    if (!watch->finished) __atomic_store_n(&watch->cancel, 1, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&watch->lock);
+
+    return NULL;
+}
+
+/**
+ * Function: preprocessMap
+ * 
+ * Description: finds cells that might support tents and discards maps that are impossible
+ *              before any search is done, cheap screening runs first so that most impossible
+ *              maps never reach the full preprocessing. The rest is done by the kernels picked
+ *              for the width of the map, which are kept in wptr for the search, unless it was
+ *              already done while the map was read (screening included)
+ * 
+ * Side-effects: writes uncertains in mptr, fills wptr arrays and resets links
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int preprocessMap(map *mptr, workspace *wptr) {
+    int streamed = wptr->streamed == mptr;
+
+    wptr->streamed = NULL;
+
+    if (streamed) {
+        wptr->kernel = &genericKernels;
+        if (!wptr->streamedResult) return 0;
+    } else {
+        /** screening scans the grid, sparse kernels are linear in the number of trees anyway */
+        if (!isSparseMap(mptr) && !screenMap(mptr)) return 0;
+        wptr->kernel = selectKernels(mptr);
+        if (!wptr->kernel->preprocess(mptr, wptr)) return 0;
+    }
+
+    /** width kernels count dead trees on their boards, sparse kernels leave them out */
+    if (wptr->kernel == &genericKernels && !countDeadTrees(mptr, wptr)) return 0;
+
+    for (int i = 0; i < getTreesNumber(mptr); i++) {
+        wptr->links[i].line = -1;
+        wptr->links[i].column = -1;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: preprocessCells
+ * 
+ * Description: generic kernel that counts trees, marks uncertain cells, builds uncertain and
+ *              tree arrays and checks hints consistency scanning the map cell by cell
+ * 
+ * Side-effects: writes trees number and uncertains in mptr, fills wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int preprocessCells(map *mptr, workspace *wptr) {
+    int workers = stripeWorkers(mptr, wptr);
+
+    if (workers > 1) return preprocessInStripes(mptr, wptr, workers);
+
+    countNumberOfTrees(mptr);
+    if (getTreesNumber(mptr) < getTentsNumber(mptr)) return 0;
+
+    if (!markUncertainCells(mptr)) return 0;
+
+    buildUncertainAndTreeArray(mptr, wptr);
+
+    return checkHintsConsistency(mptr);
+}
+
+/**
+ * Function: stripeWorkers
+ * 
+ * Description: tells how many threads preprocessCells uses for a map, at most the threads
+ *              of the workspace
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     number of stripes of lines (1 if map is preprocessed by a single thread)
+ */
+int stripeWorkers(map *mptr, workspace *wptr) {
+    int workers;
+
+    if (isSparseMap(mptr) || (long long) getMapLines(mptr) * getMapColumns(mptr) < STRIPE_MIN_CELLS) return 1;
+
+    workers = wptr->threads;
+    if (workers > getMapLines(mptr)) workers = getMapLines(mptr);
+
+    return workers > 1 ? workers : 1;
+}
+
+/**
+ * Function: streamPreprocessing
+ * 
+ * Description: starts preprocessing a map while its lines are read, so that it is done when
+ *              the last line arrives. Only maps of the generic kernels that are not split in
+ *              stripes are preprocessed this way, the rest when they are solved. Maps whose
+ *              hints alone fail screening are not streamed, the rest are screened line by line
+ *              ahead of their preprocessing, which stops at the first line failing it
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (hints already set, no line read yet)
+ *     workspace *wptr - workspace later used to solve mptr
+ * 
+ * Return value: none
+ */
+void streamPreprocessing(map *mptr, workspace *wptr) {
+    wptr->streamed = NULL;
+    deleteScreen(wptr->screening);
+    wptr->screening = NULL;
+    if (getMapLines(mptr) == 0 || getMapColumns(mptr) == 0) return;
+    if (selectKernels(mptr) != &genericKernels || stripeWorkers(mptr, wptr) > 1) return;
+    if (!screenHints(mptr)) return;
+
+    wptr->screening = startScreen(mptr);
+    reserveCounters(wptr, getMapLines(mptr), getMapColumns(mptr));
+    startScan(&wptr->scan, wptr->columnCounters);
+    wptr->streamed = mptr;
+}
+
+/**
+ * Function: preprocessReadLine
+ * 
+ * Description: screens and preprocesses what a new line of a map completes, the line before
+ *              it has all its neighbours now and the last line completes the whole map
+ * 
+ * Side-effects: writes uncertains in mptr, fills wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     int line - line just read (lines are read in order)
+ * 
+ * Return value: none
+ */
+void preprocessReadLine(map *mptr, workspace *wptr, int line) {
+    int possible;
+
+    if (wptr->streamed != mptr) return;
+
+    if (line > 0 && screenLine(wptr->screening, line - 1)) streamLine(mptr, wptr, line - 1);
+
+    if (line + 1 == getMapLines(mptr)) {
+        possible = screenLine(wptr->screening, line) && finishScreen(wptr->screening);
+        deleteScreen(wptr->screening);
+        wptr->screening = NULL;
+        if (possible) streamLine(mptr, wptr, line);
+        wptr->streamedResult = possible && checkScan(mptr, &wptr->scan);
+    }
+}
+
+/**
+ * Function: streamLine
+ * 
+ * Description: marks a line of a map being read and appends its cells to the workspace
+ *              arrays, which double when the line might not fit
+ * 
+ * Side-effects: writes uncertains in the line, fills wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     int line - number of line (its neighbours already read)
+ * 
+ * Return value: none
+ */
+void streamLine(map *mptr, workspace *wptr, int line) {
+    int uncertainNeed = wptr->scan.nextUncertain + getMapColumns(mptr);
+    int treeNeed = wptr->scan.nextTree + getMapColumns(mptr);
+
+    markLine(mptr, line, &wptr->scan);
+
+    reserveArrays(wptr, uncertainNeed > wptr->uncertainCapacity ? 2 * uncertainNeed : 0, treeNeed > wptr->treeCapacity ? 2 * treeNeed : 0);
+    fillLine(mptr, wptr, line, &wptr->scan);
+}
+
+/**
+ * Function: preprocessInStripes
+ * 
+ * Description: does the work of preprocessCells with a thread per stripe of lines. A cell
+ *              is marked uncertain by its own stripe when some ortogonal neighbour is a tree.
+ *              The first line of every stripe is read by the stripe before it, so threads mark
+ *              the other lines and first lines are marked once they are done, giving the same
+ *              marks as markUncertainCells without a line written while another thread reads
+ *              it. Stripes count their trees and
+ *              uncertains, then a prefix sum of the counts tells where each stripe writes its
+ *              cells, which keeps uncertain and tree arrays in line by line order
+ * 
+ * Side-effects: writes trees number and uncertains in mptr, fills wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (not sparse)
+ *     workspace *wptr - workspace pointer
+ *     int workers - number of threads (at most number of lines)
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int preprocessInStripes(map *mptr, workspace *wptr, int workers) {
+    stripe *stripes;
+    pool *pptr;
+    lineScan total;
+    int *columnCounts;
+    int possible;
+
+    stripes = (stripe *) malloc(workers * sizeof(stripe));
+    columnCounts = (int *) calloc((size_t) (workers + 1) * getMapColumns(mptr), sizeof(int));
+    if (stripes == NULL || columnCounts == NULL) exit(EXIT_FAILURE);
+
+    pptr = newPool(workers);
+    if (pptr == NULL) exit(EXIT_FAILURE);
+
+    for (int k = 0; k < workers; k++) {
+        stripes[k].mptr = mptr;
+        stripes[k].wptr = wptr;
+        stripes[k].first = (int) ((long long) getMapLines(mptr) * k / workers);
+        stripes[k].last = (int) ((long long) getMapLines(mptr) * (k + 1) / workers);
+        startScan(&stripes[k].scan, columnCounts + (size_t) (k + 1) * getMapColumns(mptr));
+        submitTask(pptr, markStripe, &stripes[k]);
+    }
+    waitPool(pptr);
+    for (int k = 0; k < workers; k++) markLine(mptr, stripes[k].first, &stripes[k].scan);
+
+    startScan(&total, columnCounts);
+    for (int k = 0; k < workers; k++) {
+        stripes[k].scan.nextTree = total.trees;
+        stripes[k].scan.nextUncertain = total.uncertains;
+        total.trees += stripes[k].scan.trees;
+        total.uncertains += stripes[k].scan.uncertains;
+        if (stripes[k].scan.isolatedTree) total.isolatedTree = 1;
+        if (!stripes[k].scan.linesFit) total.linesFit = 0;
+        for (int j = 0; j < getMapColumns(mptr); j++) total.columnCounts[j] += stripes[k].scan.columnCounts[j];
+    }
+
+    possible = checkScan(mptr, &total);
+    if (possible) {
+        reserveArrays(wptr, getUncertainCount(mptr), total.trees);
+        for (int k = 0; k < workers; k++) submitTask(pptr, fillStripe, &stripes[k]);
+    }
+
+    deletePool(pptr);
+    free(columnCounts);
+    free(stripes);
+
+    return possible;
+}
+
+/**
+ * Function: markStripe
+ * 
+ * Description: pool task marking uncertain cells of a stripe but its first line and counting
+ *              their trees and uncertains per line and per column
+ * 
+ * Side-effects: writes uncertains in the lines of the stripe (but the first)
+ * 
+ * Arguments:
+ *     void *arg - stripe pointer
+ *     int worker - index of worker thread (unused)
+ * 
+ * Return value: none
+ */
+void markStripe(void *arg, int worker) {
+    stripe *stptr = (stripe *) arg;
+
+    for (int i = stptr->first + 1; i < stptr->last; i++) markLine(stptr->mptr, i, &stptr->scan);
+}
+
+/**
+ * Function: fillStripe
+ * 
+ * Description: pool task writing uncertain and tree cells of a stripe to its part of the
+ *              workspace arrays
+ * 
+ * Side-effects: fills part of wptr arrays
+ * 
+ * Arguments:
+ *     void *arg - stripe pointer
+ *     int worker - index of worker thread (unused)
+ * 
+ * Return value: none
+ */
+void fillStripe(void *arg, int worker) {
+    stripe *stptr = (stripe *) arg;
+
+    for (int i = stptr->first; i < stptr->last; i++) fillLine(stptr->mptr, stptr->wptr, i, &stptr->scan);
+}
+
+/**
+ * Function: startScan
+ * 
+ * Description: clears counts of a line scan
+ * 
+ * Arguments:
+ *     lineScan *scan - scan pointer
+ *     int *columnCounts - uncertains per column of scan (already zeroed)
+ * 
+ * Return value: none
+ */
+void startScan(lineScan *scan, int *columnCounts) {
+    scan->trees = 0;
+    scan->uncertains = 0;
+    scan->isolatedTree = 0;
+    scan->linesFit = 1;
+    scan->columnCounts = columnCounts;
+    scan->nextUncertain = 0;
+    scan->nextTree = 0;
+}
+
+/**
+ * Function: markLine
+ * 
+ * Description: marks uncertain cells of a line i.e. ortogonal to a tree and not in a zero
+ *              line/column, reading the lines next to it but writing only its own. Counts its
+ *              trees, its uncertains per line and per column and notes isolated trees
+ * 
+ * Side-effects: writes uncertains in the line
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (not sparse)
+ *     int line - number of line
+ *     lineScan *scan - scan pointer
+ * 
+ * Return value: none
+ */
+void markLine(map *mptr, int line, lineScan *scan) {
+    int columns = getMapColumns(mptr);
+    char *above = line > 0 ? getMapLine(mptr, line - 1) : NULL;
+    char *row = getMapLine(mptr, line);
+    char *below = line + 1 < getMapLines(mptr) ? getMapLine(mptr, line + 1) : NULL;
+    int lineCount = 0, supported;
+
+    for (int j = 0; j < columns; j++) {
+        if (row[j] == 'A') {
+            scan->trees++;
+            /** a tree is isolated if no ortogonal cell could support its tent */
+            supported = 0;
+            if (above != NULL && above[j] != 'A' && getTentsInLine(mptr, line - 1) && getTentsInColumn(mptr, j)) supported = 1;
+            if (below != NULL && below[j] != 'A' && getTentsInLine(mptr, line + 1) && getTentsInColumn(mptr, j)) supported = 1;
+            if (getTentsInLine(mptr, line) && j > 0 && row[j - 1] != 'A' && getTentsInColumn(mptr, j - 1)) supported = 1;
+            if (getTentsInLine(mptr, line) && j + 1 < columns && row[j + 1] != 'A' && getTentsInColumn(mptr, j + 1)) supported = 1;
+            if (!supported) scan->isolatedTree = 1;
+            continue;
+        }
+
+        if (row[j] != 'U') {
+            if (!getTentsInLine(mptr, line) || !getTentsInColumn(mptr, j)) continue;
+            if ((above == NULL || above[j] != 'A') && (below == NULL || below[j] != 'A') && (j == 0 || row[j - 1] != 'A') && (j + 1 == columns || row[j + 1] != 'A')) continue;
+            row[j] = 'U';
+            scan->uncertains++;
+        }
+
+        lineCount++;
+        scan->columnCounts[j]++;
+    }
+
+    if (lineCount < getTentsInLine(mptr, line)) scan->linesFit = 0;
+}
+
+/**
+ * Function: fillLine
+ * 
+ * Description: writes uncertain and tree cells of a marked line to the workspace arrays, at
+ *              the next positions of a scan
+ * 
+ * Side-effects: fills part of wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (not sparse)
+ *     workspace *wptr - workspace pointer (arrays large enough)
+ *     int line - number of line
+ *     lineScan *scan - scan pointer
+ * 
+ * Return value: none
+ */
+void fillLine(map *mptr, workspace *wptr, int line, lineScan *scan) {
+    char *row = getMapLine(mptr, line);
+
+    for (int j = 0; j < getMapColumns(mptr); j++) {
+        if (row[j] == 'U') {
+            wptr->uncertainArray[scan->nextUncertain].line = line;
+            wptr->uncertainArray[scan->nextUncertain].column = j;
+            scan->nextUncertain++;
+        } else if (row[j] == 'A') {
+            wptr->treeArray[scan->nextTree].line = line;
+            wptr->treeArray[scan->nextTree].column = j;
+            scan->nextTree++;
+        }
+    }
+}
+
+/**
+ * Function: checkScan
+ * 
+ * Description: stores counts of a scan of the whole map and does the checks of
+ *              countNumberOfTrees, markUncertainCells and checkHintsConsistency with them
+ * 
+ * Side-effects: writes trees number and uncertain count in mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     lineScan *scan - scan of every line of mptr
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int checkScan(map *mptr, lineScan *scan) {
+    setTreesNumber(mptr, scan->trees);
+    setUncertainCount(mptr, getUncertainCount(mptr) + scan->uncertains);
+
+    if (!scan->linesFit || scan->trees < getTentsNumber(mptr)) return 0;
+    if (scan->trees == getTentsNumber(mptr) && (scan->isolatedTree || getUncertainCount(mptr) < scan->trees)) return 0;
+
+    for (int j = 0; j < getMapColumns(mptr); j++) {
+        if (scan->columnCounts[j] < getTentsInColumn(mptr, j)) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: countNumberOfTrees
+ * 
+ * Description: counts number of trees inside map
+ * 
+ * Side-effects: writes number of trees in mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value: none
+ */
+void countNumberOfTrees(map *mptr) {
+    int treeCount = 0;
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) == 'A') treeCount++;
+        }
+    }
+    setTreesNumber(mptr, treeCount);
+}
+
+/**
+ * Function: markUncertainCells
+ * 
+ * Description: marks in map cells that might support tents i.e. ortogonal to tree and not in a zero row/collumn
+ * 
+ * Side-effects: writes uncertains in mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int markUncertainCells(map *mptr) {
+    int isolatedTree;
+    char c;
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) == 'A') {
+                isolatedTree = 1;
+                for (int k = 0; k < 4; k++) {
+                    if (i + ortogonals[k].dx < 0 || i + ortogonals[k].dx >= getMapLines(mptr)) continue;
+                    if (j + ortogonals[k].dy < 0 || j + ortogonals[k].dy >= getMapColumns(mptr)) continue;
+                    if (((c = getContentOfPosition(mptr, i + ortogonals[k].dx, j + ortogonals[k].dy)) != 'A') && getTentsInLine(mptr, i + ortogonals[k].dx) && getTentsInColumn(mptr, j + ortogonals[k].dy)) {
+                        if (c != 'U') {
+                            setContentOfPosition(mptr, i + ortogonals[k].dx, j + ortogonals[k].dy, 'U');
+                            incrementUncertainCount(mptr);
+                        }
+                        isolatedTree = 0;
+                    }
+                }
+                if (isolatedTree && getTreesNumber(mptr) == getTentsNumber(mptr)) return 0;
+            }
+        }
+    }
+    if (getUncertainCount(mptr) < getTreesNumber(mptr) && getTreesNumber(mptr) == getTentsNumber(mptr)) return 0;
+    return 1;
+}
+
+/**
+ * Function: buildUncertainAndTreeArray
+ * 
+ * Description: writes arrays with all uncertain cells and tree cells, growing workspace buffers if needed
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace where uncertain array, tree array, links and visited are kept
+ * 
+ * Return value: none
+ */
+void buildUncertainAndTreeArray(map *mptr, workspace *wptr) {
+    int u = 0, t = 0;
+
+    reserveArrays(wptr, getUncertainCount(mptr), getTreesNumber(mptr));
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) == 'U') {
+                wptr->uncertainArray[u].line = i;
+                wptr->uncertainArray[u].column = j;
+                u++;
+            } else if (getContentOfPosition(mptr, i, j) == 'A') {
+                wptr->treeArray[t].line = i;
+                wptr->treeArray[t].column = j;
+                t++;
+            }
+        }
+    }
+}
+
+/**
+ * Function: checkHintsConsistency
+ * 
+ * Description: checks that all tents in row/column requirements are possible
+ * 
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int checkHintsConsistency(map *mptr) {
+    int uncertainCount;
+
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        uncertainCount = 0;
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) == 'U') uncertainCount++;
+        }
+        if (uncertainCount < getTentsInLine(mptr, i)) return 0;
+    }
+
+    for (int i = 0; i < getMapColumns(mptr); i++) {
+        uncertainCount = 0;
+        for (int j = 0; j < getMapLines(mptr); j++) {
+            if (getContentOfPosition(mptr, j, i) == 'U') uncertainCount++;
+        }
+        if (uncertainCount < getTentsInColumn(mptr, i)) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: reserveArrays
+ * 
+ * Description: grows uncertain array and the tree array, links, visited, trail and supports
+ *              (with gained and freed) of a workspace so that they hold uncertain and tree cells
+ *              of a map, keeping the cells already in uncertain and tree arrays
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int uncertainCount - number of uncertain cells
+ *     int treesNumber - number of trees
+ * 
+ * Return value: none
+ */
+void reserveArrays(workspace *wptr, int uncertainCount, int treesNumber) {
+    if (uncertainCount > wptr->uncertainCapacity) {
+        wptr->uncertainArray = (cell *) realloc(wptr->uncertainArray, uncertainCount * sizeof(cell));
+        if (wptr->uncertainArray == NULL) exit(EXIT_FAILURE);
+        wptr->uncertainCapacity = uncertainCount;
+    }
+
+    if (treesNumber > wptr->treeCapacity) {
+        free(wptr->links);
+        free(wptr->visited);
+        free(wptr->trail);
+        free(wptr->supports);
+        free(wptr->gained);
+        free(wptr->freed);
+        wptr->treeArray = (cell *) realloc(wptr->treeArray, treesNumber * sizeof(cell));
+        wptr->links = (cell *) malloc(treesNumber * sizeof(cell));
+        wptr->visited = (char *) malloc(treesNumber * sizeof(char));
+        wptr->trail = (int *) malloc(treesNumber * sizeof(int));
+        wptr->supports = (support *) malloc(treesNumber * sizeof(support));
+        wptr->gained = (cell *) malloc(treesNumber * sizeof(cell));
+        wptr->freed = (int *) malloc(treesNumber * sizeof(int));
+        if (wptr->treeArray == NULL || wptr->links == NULL || wptr->visited == NULL || wptr->trail == NULL || wptr->supports == NULL || wptr->gained == NULL || wptr->freed == NULL) exit(EXIT_FAILURE);
+        wptr->treeCapacity = treesNumber;
+    }
+}
+
+/**
+ * Function: reserveBoards
+ * 
+ * Description: grows boards of a workspace for a map and clears them
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int lines - number of lines of map
+ * 
+ * Return value: none
+ */
+void reserveBoards(workspace *wptr, int lines) {
+    if (5 * (lines + 2) > wptr->boardCapacity) {
+        free(wptr->boards);
+        wptr->boards = (uint64_t *) malloc(5 * (lines + 2) * sizeof(uint64_t));
+        if (wptr->boards == NULL) exit(EXIT_FAILURE);
+        wptr->boardCapacity = 5 * (lines + 2);
+    }
+
+    memset(wptr->boards, 0, 5 * (lines + 2) * sizeof(uint64_t));
+}
+
+/**
+ * Function: reserveCounters
+ * 
+ * Description: grows line and column counters of a workspace for a map and clears them
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int lines - number of lines of map
+ *     int columns - number of columns of map
+ * 
+ * Return value: none
+ */
+void reserveCounters(workspace *wptr, int lines, int columns) {
+    if (2 * lines > wptr->lineCapacity) {
+        free(wptr->lineCounters);
+        wptr->lineCounters = (int *) malloc(2 * lines * sizeof(int));
+        if (wptr->lineCounters == NULL) exit(EXIT_FAILURE);
+        wptr->lineCapacity = 2 * lines;
+    }
+
+    if (2 * columns > wptr->columnCapacity) {
+        free(wptr->columnCounters);
+        wptr->columnCounters = (int *) malloc(2 * columns * sizeof(int));
+        if (wptr->columnCounters == NULL) exit(EXIT_FAILURE);
+        wptr->columnCapacity = 2 * columns;
+    }
+
+    memset(wptr->lineCounters, 0, 2 * lines * sizeof(int));
+    memset(wptr->columnCounters, 0, 2 * columns * sizeof(int));
+}
+
+/**
+ * Function: orderUncertainCells
+ * 
+ * Description: reorders uncertain array, i.e. the order in which backtracking decides cells:
+ *              - ORDER_LINES keeps line by line order
+ *              - ORDER_COLUMNS goes column by column
+ *              - ORDER_CONSTRAINED starts with cells whose line and column have the fewest
+ *                uncertains to spare over their hints (line order breaks ties)
+ *              - ORDER_RANDOM shuffles cells, the same seed giving the same order
+ * 
+ * Arguments:
+ *     map *mptr - preprocessed map pointer
+ *     workspace *wptr - workspace with uncertain array
+ *     solverOptions *optr - options pointer
+ * 
+ * Return value: none
+ */
+void orderUncertainCells(map *mptr, workspace *wptr, solverOptions *optr) {
+    int count = getUncertainCount(mptr), lines = getMapLines(mptr), other;
+    int *lineSpare, *columnSpare;
+    uint64_t state;
+    ranked *ranks;
+    cell swap;
+
+    if (optr->order == ORDER_COLUMNS) {
+        qsort(wptr->uncertainArray, count, sizeof(cell), compareByColumn);
+    } else if (optr->order == ORDER_RANDOM) {
+        state = optr->seed * 0x9E3779B97F4A7C15ULL + 1;
+        for (int i = count - 1; i > 0; i--) {
+            other = (int) (nextRandom(&state) % (uint64_t) (i + 1));
+            swap = wptr->uncertainArray[i];
+            wptr->uncertainArray[i] = wptr->uncertainArray[other];
+            wptr->uncertainArray[other] = swap;
+        }
+    } else if (optr->order == ORDER_CONSTRAINED) {
+        lineSpare = (int *) calloc(lines + getMapColumns(mptr) + 1, sizeof(int));
+        ranks = (ranked *) malloc(count * sizeof(ranked) + 1);
+        if (lineSpare == NULL || ranks == NULL) exit(EXIT_FAILURE);
+        columnSpare = lineSpare + lines;
+
+        for (int i = 0; i < count; i++) {
+            lineSpare[wptr->uncertainArray[i].line]++;
+            columnSpare[wptr->uncertainArray[i].column]++;
+        }
+        for (int i = 0; i < count; i++) {
+            ranks[i].Cell = wptr->uncertainArray[i];
+            ranks[i].key = (long) (lineSpare[ranks[i].Cell.line] - getTentsInLine(mptr, ranks[i].Cell.line) + columnSpare[ranks[i].Cell.column] - getTentsInColumn(mptr, ranks[i].Cell.column)) * count + i;
+        }
+        qsort(ranks, count, sizeof(ranked), compareRanked);
+        for (int i = 0; i < count; i++) {
+            wptr->uncertainArray[i] = ranks[i].Cell;
+        }
+
+        free(lineSpare);
+        free(ranks);
+    }
+}
+
+/**
+ * Function: compareByColumn
+ * 
+ * Description: orders cells by column and then by line
+ * 
+ * Arguments:
+ *     const void *a - pointer to first cell
+ *     const void *b - pointer to second cell
+ * 
+ * Return value:
+ *     negative, zero or positive as first cell comes before, is or comes after second cell
+ */
+int compareByColumn(const void *a, const void *b) {
+    const cell *first = (const cell *) a, *second = (const cell *) b;
+
+    if (first->column != second->column) return first->column < second->column ? -1 : 1;
+    if (first->line != second->line) return first->line < second->line ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Function: compareRanked
+ * 
+ * Description: orders ranked cells by key
+ * 
+ * Arguments:
+ *     const void *a - pointer to first ranked cell
+ *     const void *b - pointer to second ranked cell
+ * 
+ * Return value:
+ *     negative, zero or positive as first key is smaller, equal or greater than second key
+ */
+int compareRanked(const void *a, const void *b) {
+    const ranked *first = (const ranked *) a, *second = (const ranked *) b;
+
+    if (first->key != second->key) return first->key < second->key ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Function: nextRandom
+ * 
+ * Description: xorshift64* pseudo random generator, reproducible for a given initial state
+ * 
+ * Arguments:
+ *     uint64_t *state - generator state (never 0)
+ * 
+ * Return value: next pseudo random number
+ */
+uint64_t nextRandom(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ULL;
+}
+
+/**
+ * Function: initSearch
+ * 
+ * Description: prepares search over all uncertain cells of a preprocessed map
+ * 
+ * Arguments:
+ *     search *sptr - search to be initialized
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace with uncertain array, tree array, links and visited
+ *     long long limit - stop after this many solutions (0 for no limit)
+ * 
+ * Return value: none
+ */
+void initSearch(search *sptr, map *mptr, workspace *wptr, long long limit) {
+    sptr->kernel = wptr->kernel;
+    sptr->uncertainArray = wptr->uncertainArray;
+    sptr->treeArray = wptr->treeArray;
+    sptr->links = wptr->links;
+    sptr->visited = wptr->visited;
+    sptr->trail = wptr->trail;
+    sptr->trailLength = 0;
+    sptr->uncertainCount = getUncertainCount(mptr);
+    sptr->boards = NULL;
+    sptr->boardSize = getMapLines(mptr) + 2;
+    sptr->lineTents = NULL;
+    sptr->lineUncertain = NULL;
+    sptr->columnTents = NULL;
+    sptr->columnUncertain = NULL;
+    if (sptr->kernel->boards) sptr->boards = wptr->boards;
+    if (sptr->kernel->counters) {
+        sptr->lineTents = wptr->lineCounters;
+        sptr->lineUncertain = wptr->lineCounters + getMapLines(mptr);
+        sptr->columnTents = wptr->columnCounters;
+        sptr->columnUncertain = wptr->columnCounters + getMapColumns(mptr);
+    }
+    sptr->limit = limit;
+    sptr->count = 0;
+    sptr->firstSolution = NULL;
+    sptr->splitDepth = -1;
+    sptr->prefixes = NULL;
+    sptr->prefixCount = 0;
+    sptr->prefixCapacity = 0;
+    sptr->shared = NULL;
+    sptr->cancel = NULL;
+    sptr->phase = NULL;
+    sptr->failures = 0;
+    sptr->failureLimit = 0;
+    sptr->restart = 0;
+    sptr->spareTrees = getTreesNumber(mptr) - getTentsNumber(mptr);
+    sptr->supports = wptr->supports;
+    sptr->gained = wptr->gained;
+    sptr->freed = wptr->freed;
+    sptr->gainedCount = 0;
+    sptr->freedCount = 0;
+    sptr->supportsStale = 0;
+    sptr->supportMark = 0;
+    sptr->supported = 0;
+    if (sptr->spareTrees) startSupports(mptr, sptr);
+}
+
+/**
+ * Function: countInParallel
+ * 
+ * Description: enumerates the valid decisions for the first uncertain cells and counts the
+ *              subtree below each of them on a pool of workers, every subtree with its own
+ *              copy of the map, links and visited
+ * 
+ * Arguments:
+ *     map *mptr - preprocessed map pointer
+ *     workspace *wptr - workspace with uncertain array, tree array, links and visited
+ *     long long limit - stop after this many solutions (0 for no limit)
+ *     int workers - number of threads
+ *     char *firstSolution - returns values of uncertain cells in first solution
+ * 
+ * Return value:
+ *     number of solutions (at most limit)
+ */
+long long countInParallel(map *mptr, workspace *wptr, long long limit, int workers, char *firstSolution) {
+    sharedCount shared;
+    search splitter;
+    subtree *subtrees;
+    pool *pptr;
+    int depth = SPLIT_EXTRA_DEPTH, first = -1;
+    long long count;
+
+    for (int i = workers; i > 1; i /= 2) depth++;
+    if (depth >= getUncertainCount(mptr)) depth = getUncertainCount(mptr) - 1;
+
+    initSearch(&splitter, mptr, wptr, 0);
+    splitter.splitDepth = depth;
+    backtrackingSolve(mptr, &splitter, 0);
+
+    pthread_mutex_init(&shared.lock, NULL);
+    shared.count = 0;
+    shared.limit = limit;
+    shared.stop = 0;
+
+    subtrees = (subtree *) malloc((splitter.prefixCount + 1) * sizeof(subtree));
+    if (subtrees == NULL) exit(EXIT_FAILURE);
+
+    /** initSearch rebuilds the supports of the workspace, so no subtree may copy them yet */
+    for (int i = 0; i < splitter.prefixCount; i++) {
+        subtrees[i].source = mptr;
+        subtrees[i].sourceLinks = wptr->links;
+        subtrees[i].sourceSupports = wptr->supports;
+        initSearch(&subtrees[i].search, mptr, wptr, limit);
+        subtrees[i].search.shared = &shared;
+        subtrees[i].prefix = splitter.prefixes + (long) i * depth;
+        subtrees[i].depth = depth;
+    }
+
+    pptr = newPool(workers);
+    if (pptr == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < splitter.prefixCount; i++) {
+        submitTask(pptr, countSubtree, &subtrees[i]);
+    }
+    deletePool(pptr);
+
+    for (int i = 0; i < splitter.prefixCount; i++) {
+        if (first == -1 && subtrees[i].search.count > 0) {
+            first = i;
+            memcpy(firstSolution, subtrees[i].search.firstSolution, getUncertainCount(mptr));
+        }
+        free(subtrees[i].search.firstSolution);
+    }
+
+    count = shared.count;
+    if (limit && count > limit) count = limit;
+
+    pthread_mutex_destroy(&shared.lock);
+    free(subtrees);
+    free(splitter.prefixes);
+
+    return count;
+}
+
+/**
+ * Function: countSubtree
+ * 
+ * Description: replays the decisions of a prefix on a private copy of the map (and of the
+ *              boards and counters kernels keep) and counts the solutions below it
+ * 
+ * Arguments:
+ *     void *arg - pointer to subtree
+ *     int worker - index of worker running the task
+ * 
+ * Return value: none
+ */
+void countSubtree(void *arg, int worker) {
+    subtree *tptr = (subtree *) arg;
+    search *sptr = &tptr->search;
+    map *mptr;
+    uint64_t *boards = NULL;
+    int *counters = NULL;
+    int possible = 1, lines, columns;
+
+    mptr = copyMap(tptr->source);
+    sptr->links = (cell *) malloc(getTreesNumber(mptr) * sizeof(cell) + 1);
+    sptr->visited = (char *) calloc(getTreesNumber(mptr) + 1, sizeof(char));
+    sptr->trail = (int *) malloc(getTreesNumber(mptr) * sizeof(int) + 1);
+    sptr->supports = (support *) malloc(getTreesNumber(mptr) * sizeof(support) + 1);
+    sptr->gained = (cell *) malloc(getTreesNumber(mptr) * sizeof(cell) + 1);
+    sptr->freed = (int *) malloc(getTreesNumber(mptr) * sizeof(int) + 1);
+    sptr->firstSolution = (char *) malloc(sptr->uncertainCount * sizeof(char) + 1);
+    if (mptr == NULL || sptr->links == NULL || sptr->visited == NULL || sptr->trail == NULL || sptr->supports == NULL || sptr->gained == NULL || sptr->freed == NULL || sptr->firstSolution == NULL) exit(EXIT_FAILURE);
+    memcpy(sptr->links, tptr->sourceLinks, getTreesNumber(mptr) * sizeof(cell));
+    memcpy(sptr->supports, tptr->sourceSupports, getTreesNumber(mptr) * sizeof(support));
+
+    if (sptr->kernel->boards) {
+        boards = (uint64_t *) malloc(5 * sptr->boardSize * sizeof(uint64_t));
+        if (boards == NULL) exit(EXIT_FAILURE);
+        memcpy(boards, sptr->boards, 5 * sptr->boardSize * sizeof(uint64_t));
+        sptr->boards = boards;
+    }
+
+    if (sptr->kernel->counters) {
+        lines = getMapLines(mptr);
+        columns = getMapColumns(mptr);
+        counters = (int *) malloc(2 * (lines + columns) * sizeof(int) + 1);
+        if (counters == NULL) exit(EXIT_FAILURE);
+        memcpy(counters, sptr->lineTents, 2 * lines * sizeof(int));
+        memcpy(counters + 2 * lines, sptr->columnTents, 2 * columns * sizeof(int));
+        sptr->lineTents = counters;
+        sptr->lineUncertain = counters + lines;
+        sptr->columnTents = counters + 2 * lines;
+        sptr->columnUncertain = counters + 2 * lines + columns;
+    }
+
+    for (int i = 0; i < tptr->depth && possible; i++) {
+        sptr->kernel->setCell(mptr, sptr, sptr->uncertainArray[i], tptr->prefix[i]);
+        if (tptr->prefix[i] == 'T') possible = sptr->kernel->validTent(mptr, sptr->uncertainArray[i], sptr);
+    }
+    if (possible) backtrackingSolve(mptr, sptr, tptr->depth);
+
+    deleteMap(mptr);
+    free(sptr->links);
+    free(sptr->visited);
+    free(sptr->trail);
+    free(sptr->supports);
+    free(sptr->gained);
+    free(sptr->freed);
+    free(boards);
+    free(counters);
+}
+
+/**
+ * Function: backtrackingSolve
+ * 
+ * Description: recursively try to solve map using backtracking
+ * 
+ * Side-effects: writes solution to mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with uncertain array, tree array, links (init to -1) and visited arrays
+ *     int current - current position of uncertainArary that backtraking is working (should be called with 0)
+ * 
+ * Return value:
+ *     1 - if search should stop (solution limit reached)
+ *     0 - if every possibility below current was explored
+ */
+int backtrackingSolve(map *mptr, search *sptr, int current) {
+    const kernels *kernel = sptr->kernel;
+    char values[2] = {'T', '.'};
+    cell Cell;
+    int valid;
+
+    if (sptr->shared != NULL && __atomic_load_n(&sptr->shared->stop, __ATOMIC_RELAXED)) return 1;
+    if (sptr->cancel != NULL && __atomic_load_n(sptr->cancel, __ATOMIC_RELAXED)) return 1;
+    if (current == sptr->uncertainCount) return foundSolution(mptr, sptr);
+    if (current == sptr->splitDepth) return recordPrefix(mptr, sptr);
+
+    Cell = sptr->uncertainArray[current];
+    if (sptr->phase != NULL && sptr->phase[current] == '.') {
+        values[0] = '.';
+        values[1] = 'T';
+    }
+
+    for (int i = 0; i < 2; i++) {
+        kernel->setCell(mptr, sptr, Cell, values[i]);
+        if (values[i] == 'T')
+            valid = kernel->validTent(mptr, Cell, sptr);
+        else
+            valid = kernel->validGrass(mptr, Cell, sptr);
+        if (!valid) continue;
+        if (sptr->phase != NULL) sptr->phase[current] = values[i];
+        if (backtrackingSolve(mptr, sptr, current + 1)) return 1;
+    }
+    kernel->setCell(mptr, sptr, Cell, 'U');
+
+    if (sptr->failureLimit && ++sptr->failures >= sptr->failureLimit) {
+        sptr->restart = 1;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Function: restartSearch
+ * 
+ * Description: backtracking with restarts. Every run stops after a number of dead ends that
+ *              grows as the Luby sequence (so some run is eventually complete), the next one
+ *              decides cells in a sweep of the map picked at random (lines or columns, from
+ *              either end) so that early decisions differ while checks stay local, trying
+ *              first for every cell the value it last took. Runs are reproducible for a seed
+ * 
+ * Side-effects: writes solution to mptr, reorders uncertain array of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search over uncertain cells of a preprocessed map
+ *     unsigned int seed - seed of sweeps
+ * 
+ * Return value: none
+ */
+void restartSearch(map *mptr, search *sptr, unsigned int seed) {
+    int count = sptr->uncertainCount, sweep;
+    uint64_t state = seed * 0x9E3779B97F4A7C15ULL + 1;
+    restartCell *cells;
+    cell Cell;
+
+    cells = (restartCell *) malloc(count * sizeof(restartCell) + 1);
+    sptr->phase = (char *) malloc(count * sizeof(char) + 1);
+    if (cells == NULL || sptr->phase == NULL) exit(EXIT_FAILURE);
+    memset(sptr->phase, 'T', count);
+
+    for (int run = 1;; run++) {
+        sptr->failures = 0;
+        sptr->failureLimit = RESTART_UNIT * lubyTerm(run);
+        sptr->restart = 0;
+
+        backtrackingSolve(mptr, sptr, 0);
+        if (!sptr->restart) break;
+
+        sweep = (int) (nextRandom(&state) >> 32 & 3);
+        for (int i = 0; i < count; i++) {
+            Cell = sptr->uncertainArray[i];
+            if (getContentOfPosition(mptr, Cell.line, Cell.column) != 'U') sptr->kernel->setCell(mptr, sptr, Cell, 'U');
+            cells[i].key = sweepKey(mptr, Cell, sweep);
+            cells[i].Cell = Cell;
+            cells[i].phase = sptr->phase[i];
+        }
+        qsort(cells, count, sizeof(restartCell), compareRestartCells);
+        for (int i = 0; i < count; i++) {
+            sptr->uncertainArray[i] = cells[i].Cell;
+            sptr->phase[i] = cells[i].phase;
+        }
+    }
+
+    free(cells);
+    free(sptr->phase);
+    sptr->phase = NULL;
+    sptr->failureLimit = 0;
+}
+
+/**
+ * Function: sweepKey
+ * 
+ * Description: gets place of a cell in a sweep of the map
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell Cell - cell
+ *     int sweep - 0 (lines from top), 1 (lines from bottom), 2 (columns from left) or
+ *                 3 (columns from right)
+ * 
+ * Return value: place of cell
+ */
+long sweepKey(map *mptr, cell Cell, int sweep) {
+    long lines = getMapLines(mptr), columns = getMapColumns(mptr);
+
+    if (sweep == 0) return Cell.line * columns + Cell.column;
+    if (sweep == 1) return (lines - 1 - Cell.line) * columns + (columns - 1 - Cell.column);
+    if (sweep == 2) return Cell.column * lines + Cell.line;
+    return (columns - 1 - Cell.column) * lines + (lines - 1 - Cell.line);
+}
+
+/**
+ * Function: lubyTerm
+ * 
+ * Description: gets a term of the Luby sequence 1 1 2 1 1 2 4 1 1 2 1 1 2 4 8 ...
+ * 
+ * Arguments:
+ *     int run - index of term (from 1)
+ * 
+ * Return value: term of the sequence
+ */
+long lubyTerm(int run) {
+    long size = 1, index = run - 1;
+    int power = 0;
+
+    while (size < index + 1) {
+        size = 2 * size + 1;
+        power++;
+    }
+    while (size - 1 != index) {
+        size = (size - 1) / 2;
+        power--;
+        index %= size;
+    }
+
+    return 1L << power;
+}
+
+/**
+ * Function: compareRestartCells
+ * 
+ * Description: orders cells of a search with restarts by key
+ * 
+ * Arguments:
+ *     const void *a - pointer to first cell
+ *     const void *b - pointer to second cell
+ * 
+ * Return value:
+ *     negative, zero or positive as first key is smaller, equal or greater than second key
+ */
+int compareRestartCells(const void *a, const void *b) {
+    const restartCell *first = (const restartCell *) a, *second = (const restartCell *) b;
+
+    if (first->key != second->key) return first->key < second->key ? -1 : 1;
+    return 0;
 }
 
 /**
- * Function: buildUncertainAndTreeArray
+ * Function: foundSolution
  * 
- * Description: writes arrays with all uncertain cells and tree cells
+ * Description: accounts for a solution reached by backtracking, saving it if it is the first
  * 
  * Arguments:
  *     map *mptr - map pointer
- *     cell **uncertainArray - returns uncertain array
- *     cell **treeArray - returns tree array
+ *     search *sptr - search pointer
  * 
- * Return value: none
+ * Return value:
+ *     1 - if search should stop (solution limit reached)
+ *     0 - if search should go on
  */
-void buildUncertainAndTreeArray(map *mptr, cell **uncertainArray, cell **treeArray) {
-    int u = 0, t = 0;
+int foundSolution(map *mptr, search *sptr) {
+    int stop;
 
-    *uncertainArray = (cell *) malloc(getUncertainCount(mptr) * sizeof(cell));
-    if (*uncertainArray == NULL) exit(EXIT_FAILURE);
-    *treeArray = (cell *) malloc(getTreesNumber(mptr) * sizeof(cell));
-    if (*treeArray == NULL) exit(EXIT_FAILURE);
-
-    for (int i = 0; i < getMapLines(mptr); i++) {
-        for (int j = 0; j < getMapColumns(mptr); j++) {
-            if (getContentOfPosition(mptr, i, j) == 'U') {
-                (*uncertainArray)[u].line = i;
-                (*uncertainArray)[u].column = j;
-                u++;
-            } else if (getContentOfPosition(mptr, i, j) == 'A') {
-                (*treeArray)[t].line = i;
-                (*treeArray)[t].column = j;
-                t++;
-            }
+    sptr->count++;
+    if (sptr->count == 1 && sptr->firstSolution != NULL) {
+        for (int i = 0; i < sptr->uncertainCount; i++) {
+            sptr->firstSolution[i] = getContentOfPosition(mptr, sptr->uncertainArray[i].line, sptr->uncertainArray[i].column);
         }
     }
+
+    if (sptr->shared == NULL) return sptr->limit && sptr->count >= sptr->limit;
+
+    pthread_mutex_lock(&sptr->shared->lock);
+    sptr->shared->count++;
+    if (sptr->shared->limit && sptr->shared->count >= sptr->shared->limit) __atomic_store_n(&sptr->shared->stop, 1, __ATOMIC_RELAXED);
+    stop = sptr->shared->stop;
+    pthread_mutex_unlock(&sptr->shared->lock);
+
+    return stop;
 }
 
 /**
- * Function: checkHintsConsistency
- * 
- * Description: checks that all tents in row/column requirements are possible
+ * Function: recordPrefix
  * 
+ * Description: saves decisions taken for uncertain cells before split depth, so that the
+ *              subtree below them can be searched on its own
  * 
  * Arguments:
  *     map *mptr - map pointer
+ *     search *sptr - search pointer
  * 
- * Return value:
- *     1 - if map might have solution
- *     0 - if map is impossible
+ * Return value: 0 (search goes on with next prefix)
  */
-int checkHintsConsistency(map *mptr) {
-    int uncertainCount;
+int recordPrefix(map *mptr, search *sptr) {
+    char *prefix;
 
-    for (int i = 0; i < getMapLines(mptr); i++) {
-        uncertainCount = 0;
-        for (int j = 0; j < getMapColumns(mptr); j++) {
-            if (getContentOfPosition(mptr, i, j) == 'U') uncertainCount++;
-        }
-        if (uncertainCount < getTentsInLine(mptr, i)) return 0;
+    if (sptr->prefixCount == sptr->prefixCapacity) {
+        sptr->prefixCapacity = sptr->prefixCapacity ? 2 * sptr->prefixCapacity : 64;
+        sptr->prefixes = (char *) realloc(sptr->prefixes, (long) sptr->prefixCapacity * sptr->splitDepth);
+        if (sptr->prefixes == NULL) exit(EXIT_FAILURE);
     }
 
-    for (int i = 0; i < getMapColumns(mptr); i++) {
-        uncertainCount = 0;
-        for (int j = 0; j < getMapLines(mptr); j++) {
-            if (getContentOfPosition(mptr, j, i) == 'U') uncertainCount++;
-        }
-        if (uncertainCount < getTentsInColumn(mptr, i)) return 0;
+    prefix = sptr->prefixes + (long) sptr->prefixCount * sptr->splitDepth;
+    for (int i = 0; i < sptr->splitDepth; i++) {
+        prefix[i] = getContentOfPosition(mptr, sptr->uncertainArray[i].line, sptr->uncertainArray[i].column);
     }
+    sptr->prefixCount++;
 
-    return 1;
+    return 0;
 }
 
 /**
- * Function: backtrackingSolve
+ * Function: setCell
  * 
- * Description: recursively try to solve map using backtracking
- * 
- * Side-effects: writes solution to mptr
+ * Description: generic kernel that sets content of an uncertain cell during search, keeping
+ *              the matching of trees to cells up to date
  * 
  * Arguments:
  *     map *mptr - map pointer
- *     cell *uncertainArray - array with cells that might support a tent
- *     cell *treeArray - array with all trees
- *     cell *links - array with linked tent coordinates for every tree (should be init to -1)
- *     char *visited - array with boolean values for visited trees
- *     int current - current position of uncertainArary that backtraking is working (should be called with 0)
+ *     search *sptr - search pointer
+ *     cell Cell - cell to be set
+ *     char value - 'T', '.' or 'U'
  * 
- * Return value:
- *     1 - if map is possible
- *     0 - if map is impossible
+ * Return value: none
  */
-int backtrackingSolve(map *mptr, cell *uncertainArray, cell *treeArray, cell *links, char *visited, int current) {
-    int line, column;
-
-    if (current == getUncertainCount(mptr)) return 1;
+void setCell(map *mptr, search *sptr, cell Cell, char value) {
+    char old = getContentOfPosition(mptr, Cell.line, Cell.column);
+    int wasSupport = old == 'T' || old == 'U', isSupport = value == 'T' || value == 'U';
 
-    line = uncertainArray[current].line;
-    column = uncertainArray[current].column;
+    setContentOfPosition(mptr, Cell.line, Cell.column, value);
 
-    setContentOfPosition(mptr, line, column, 'T');
-    if (validTent(mptr, uncertainArray[current], treeArray, links, visited)) {
-        if (backtrackingSolve(mptr, uncertainArray, treeArray, links, visited, current + 1)) return 1;
-    }
-    setContentOfPosition(mptr, line, column, '.');
-    if (validGrass(mptr, uncertainArray[current])) {
-        if (backtrackingSolve(mptr, uncertainArray, treeArray, links, visited, current + 1)) return 1;
-    }
-    setContentOfPosition(mptr, line, column, 'U');
-    return 0;
+    /** in low season the tree matched to a cell that stops supporting a tent looks for another */
+    if (sptr->spareTrees && wasSupport && !isSupport) loseSupport(mptr, sptr, Cell);
+    if (sptr->spareTrees && isSupport && !wasSupport) gainSupport(mptr, sptr, Cell);
 }
 
 /**
  * Function: validTent
  * 
- * Description: checks if Tent is valid
+ * Description: generic kernel that checks if Tent is valid
  * 
  * Arguments:
  *     map *mptr - map pointer
  *     cell Cell - tent to be validated
- *     cell *treeArray - array with all trees
- *     cell *links - array with linked tent coordinates for every tree (should be init to -1)
- *     char *visited - array with boolean values for visited trees
+ *     search *sptr - search with tree array, links (init to -1) and visited arrays
  * 
  * Return value:
  *     1 - if tent is valid
  *     0 - if tent is invalid
  */
-int validTent(map *mptr, cell Cell, cell *treeArray, cell *links, char *visited) {
+int validTent(map *mptr, cell Cell, search *sptr) {
     int tentSum;
 
     for (int i = 0; i < 8; i++) {
@@ -295,8 +2082,8 @@ int validTent(map *mptr, cell Cell, cell *treeArray, cell *links, char *visited)
     }
     if (tentSum > getTentsInColumn(mptr, Cell.column)) return 0;
 
-    memset(visited, 0, getTreesNumber(mptr));
-    if (!localInjectivity(mptr, Cell, treeArray, links, visited)) return 0;
+    memset(sptr->visited, 0, getTreesNumber(mptr));
+    if (!localInjectivity(mptr, Cell, sptr)) return 0;
 
     return 1;
 }
@@ -304,18 +2091,19 @@ int validTent(map *mptr, cell Cell, cell *treeArray, cell *links, char *visited)
 /**
  * Function: validGrass
  * 
- * Description: checks if grass is valid
+ * Description: generic kernel that checks if grass is valid
  * 
  * Arguments:
  *     map *mptr - map pointer
  *     cell Cell - tent to be validated
+ *     search *sptr - search pointer
  * 
  * Return value:
  *     1 - if tent is valid
  *     0 - if tent is invalid
  */
-int validGrass(map *mptr, cell Cell) {
-    int tentSum, uncertainSum;
+int validGrass(map *mptr, cell Cell, search *sptr) {
+    int tentSum, uncertainSum, room, run;
     char c;
     int isolated;
 
@@ -335,25 +2123,89 @@ int validGrass(map *mptr, cell Cell) {
         }
     }
 
+    /** tents of a line take at most half of each run of tents and uncertain cells */
     tentSum = 0;
     uncertainSum = 0;
+    room = 0;
+    run = 0;
     for (int i = 0; i < getMapColumns(mptr); i++) {
-        if (getContentOfPosition(mptr, Cell.line, i) == 'T')
+        if ((c = getContentOfPosition(mptr, Cell.line, i)) == 'T')
             tentSum++;
-        else if (getContentOfPosition(mptr, Cell.line, i) == 'U')
+        else if (c == 'U')
             uncertainSum++;
+        run = c == 'T' || c == 'U' ? run + 1 : 0;
+        if (run % 2) room++;
     }
     if (uncertainSum < getTentsInLine(mptr, Cell.line) - tentSum) return 0;
+    if (sptr->spareTrees && room < getTentsInLine(mptr, Cell.line)) return 0;
 
     tentSum = 0;
     uncertainSum = 0;
+    room = 0;
+    run = 0;
     for (int i = 0; i < getMapLines(mptr); i++) {
-        if (getContentOfPosition(mptr, i, Cell.column) == 'T')
+        if ((c = getContentOfPosition(mptr, i, Cell.column)) == 'T')
             tentSum++;
-        else if (getContentOfPosition(mptr, i, Cell.column) == 'U')
+        else if (c == 'U')
             uncertainSum++;
+        run = c == 'T' || c == 'U' ? run + 1 : 0;
+        if (run % 2) room++;
     }
     if (uncertainSum < getTentsInColumn(mptr, Cell.column) - tentSum) return 0;
+    if (sptr->spareTrees && room < getTentsInColumn(mptr, Cell.column)) return 0;
+
+    /** In low season each tent needs its own tree, matched to a tent or uncertain cell next to it */
+    if (sptr->spareTrees && !settleSupports(mptr, sptr)) return 0;
+
+    return 1;
+}
+
+/**
+ * Function: countDeadTrees
+ * 
+ * Description: generic kernel that counts trees with no uncertain cell around, each of them
+ *              leaves a tent without tree so there can't be more than trees beyond tents
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (preprocessed)
+ *     workspace *wptr - workspace with tree array
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int countDeadTrees(map *mptr, workspace *wptr) {
+    int deadTrees = 0;
+
+    if (getTreesNumber(mptr) == getTentsNumber(mptr)) return 1;
+
+    for (int i = 0; i < getTreesNumber(mptr); i++) {
+        if (isDeadTree(mptr, wptr->treeArray[i].line, wptr->treeArray[i].column)) deadTrees++;
+    }
+
+    return deadTrees <= getTreesNumber(mptr) - getTentsNumber(mptr);
+}
+
+/**
+ * Function: isDeadTree
+ * 
+ * Description: checks if a tree has no tent or uncertain cell around
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     int line - line of tree
+ *     int column - column of tree
+ * 
+ * Return value:
+ *     1 - if tree is dead
+ *     0 - otherwise
+ */
+int isDeadTree(map *mptr, int line, int column) {
+    char c;
+
+    for (int i = 0; i < 4; i++) {
+        if ((c = getContentOfPosition(mptr, line + ortogonals[i].dx, column + ortogonals[i].dy)) == 'T' || c == 'U') return 0;
+    }
 
     return 1;
 }
@@ -366,15 +2218,16 @@ int validGrass(map *mptr, cell Cell) {
  * Arguments:
  *     map *mptr - map pointer
  *     cell tent - tent to be validated
- *     cell *treeArray - array with all trees
- *     cell *links - array with linked tent coordinates for every tree (should be init to -1)
- *     char *visited - array with boolean values for visited trees
+ *     search *sptr - search with tree array, links (init to -1) and visited arrays
  * 
  * Return value:
  *     1 - if tent is valid
  *     0 - if tent is invalid
  */
-int localInjectivity(map *mptr, cell tent, cell *treeArray, cell *links, char *visited) {
+int localInjectivity(map *mptr, cell tent, search *sptr) {
+    cell *treeArray = sptr->treeArray;
+    cell *links = sptr->links;
+    char *visited = sptr->visited;
     int adjacent;
     char c;
     for (int i = 0; i < getTreesNumber(mptr); i++) {
@@ -388,11 +2241,380 @@ int localInjectivity(map *mptr, cell tent, cell *treeArray, cell *links, char *v
 
             if (links[i].line == tent.line && links[i].column == tent.column) return 1;
 
-            if (links[i].line == -1 || (c = getContentOfPosition(mptr, links[i].line, links[i].column)) == 'U' || c == '.' || localInjectivity(mptr, links[i], treeArray, links, visited)) {
+            if (links[i].line == -1 || (c = getContentOfPosition(mptr, links[i].line, links[i].column)) == 'U' || c == '.' || localInjectivity(mptr, links[i], sptr)) {
                 links[i] = tent;
                 return 1;
             }
         }
     }
     return 0;
-}
\ No newline at end of file
+}
+
+/**
+ * Function: treesAround
+ * 
+ * Description: generic kernel that finds the trees next to a cell by binary search in tree array
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array sorted in line order
+ *     cell Cell - cell
+ *     int *around - returns indexes of trees in tree array order: above, left, right and below
+ * 
+ * Return value:
+ *     number of trees next to cell
+ */
+int treesAround(map *mptr, search *sptr, cell Cell, int *around) {
+    int line, column, count = 0;
+
+    for (int k = 0; k < 4; k++) {
+        line = Cell.line + ortogonals[k].dx;
+        column = Cell.column + ortogonals[k].dy;
+        if (getContentOfPosition(mptr, line, column) == 'A' && (around[count] = findTree(mptr, sptr, line, column)) != -1) count++;
+    }
+    return count;
+}
+
+/**
+ * Function: startSupports
+ * 
+ * Description: matches trees to different tent or uncertain cells next to them, greedily and
+ *              then along augmenting paths until the matching is maximum
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ * 
+ * Return value: none
+ */
+void startSupports(map *mptr, search *sptr) {
+    support *supports = sptr->supports;
+    cell around;
+    char c;
+
+    for (int t = 0; t < getTreesNumber(mptr); t++) {
+        supports[t].Cell.line = -1;
+        supports[t].Cell.column = -1;
+        supports[t].mark = 0;
+    }
+    sptr->supportMark = 0;
+    sptr->supported = 0;
+    if (sptr->kernel->boards) memset(sptr->boards + 4 * sptr->boardSize, 0, sptr->boardSize * sizeof(uint64_t));
+
+    /** each tree takes the first free cell around it */
+    for (int t = 0; t < getTreesNumber(mptr); t++) {
+        for (int k = 0; k < 4; k++) {
+            around.line = sptr->treeArray[t].line + ortogonals[k].dx;
+            around.column = sptr->treeArray[t].column + ortogonals[k].dy;
+            if ((c = getContentOfPosition(mptr, around.line, around.column)) != 'T' && c != 'U') continue;
+            if (supportOwner(mptr, sptr, around) != -1) continue;
+            matchSupport(sptr, t, around);
+            sptr->supported++;
+            break;
+        }
+    }
+
+    matchFreeTrees(mptr, sptr);
+}
+
+/**
+ * Function: matchFreeTrees
+ * 
+ * Description: looks for augmenting paths from every tree without cell until a whole pass
+ *              finds none, so the matching is maximum
+ * 
+ * Side-effects: writes supports of sptr, forgets freed trees and gained cells
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ * 
+ * Return value: none
+ */
+void matchFreeTrees(map *mptr, search *sptr) {
+    support *supports = sptr->supports;
+    int augmented = 1;
+
+    while (augmented && sptr->supported < getTreesNumber(mptr)) {
+        augmented = 0;
+        nextSupportMark(mptr, sptr);
+        for (int t = 0; t < getTreesNumber(mptr); t++) {
+            if (supports[t].Cell.line != -1 || supports[t].mark == sptr->supportMark) continue;
+            supports[t].mark = sptr->supportMark;
+            if (augmentSupport(mptr, sptr, t)) {
+                sptr->supported++;
+                augmented = 1;
+                nextSupportMark(mptr, sptr);
+            }
+        }
+    }
+
+    sptr->gainedCount = 0;
+    sptr->freedCount = 0;
+    sptr->supportsStale = 0;
+}
+
+/**
+ * Function: loseSupport
+ * 
+ * Description: frees the tree matched to a cell that can no longer hold a tent, any new
+ *              augmenting path starts at that tree
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (cell already set)
+ *     search *sptr - search with tree array and supports
+ *     cell Cell - cell that stopped holding a tent
+ * 
+ * Return value: none
+ */
+void loseSupport(map *mptr, search *sptr, cell Cell) {
+    int tree = supportOwner(mptr, sptr, Cell);
+
+    if (tree == -1) return;
+
+    sptr->supports[tree].Cell.line = -1;
+    sptr->supports[tree].Cell.column = -1;
+    if (sptr->kernel->boards) sptr->boards[4 * sptr->boardSize + Cell.line + 1] &= ~((uint64_t) 1 << Cell.column);
+    sptr->supported--;
+
+    /** past one entry per tree settling would cost more than matching every free tree again */
+    if (sptr->freedCount == getTreesNumber(mptr))
+        sptr->supportsStale = 1;
+    else if (!sptr->supportsStale)
+        sptr->freed[sptr->freedCount++] = tree;
+}
+
+/**
+ * Function: gainSupport
+ * 
+ * Description: keeps a cell that may hold a tent again, any new augmenting path ends at it
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (cell already set)
+ *     search *sptr - search with tree array and supports
+ *     cell Cell - cell that may hold a tent again
+ * 
+ * Return value: none
+ */
+void gainSupport(map *mptr, search *sptr, cell Cell) {
+    if (sptr->gainedCount == getTreesNumber(mptr))
+        sptr->supportsStale = 1;
+    else if (!sptr->supportsStale)
+        sptr->gained[sptr->gainedCount++] = Cell;
+}
+
+/**
+ * Function: settleSupports
+ * 
+ * Description: checks that trees can still be matched to as many cells as there are tents,
+ *              looking for augmenting paths from freed trees and gained cells only while the
+ *              matching is smaller, which leaves it maximum when the check fails
+ * 
+ * Side-effects: writes supports of sptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ * 
+ * Return value:
+ *     1 - if every tent might still get a tree
+ *     0 - otherwise
+ */
+int settleSupports(map *mptr, search *sptr) {
+    int tents = getTentsNumber(mptr), tree;
+    cell gained;
+    char c;
+
+    if (sptr->supported >= tents) return 1;
+
+    if (sptr->supportsStale) {
+        matchFreeTrees(mptr, sptr);
+        return sptr->supported >= tents;
+    }
+
+    /** a search that failed from a tree (or a cell) never succeeds after other augmentations */
+    nextSupportMark(mptr, sptr);
+    while (sptr->freedCount && sptr->supported < tents) {
+        tree = sptr->freed[--sptr->freedCount];
+        if (sptr->supports[tree].Cell.line != -1 || sptr->supports[tree].mark == sptr->supportMark) continue;
+        sptr->supports[tree].mark = sptr->supportMark;
+        if (augmentSupport(mptr, sptr, tree)) {
+            sptr->supported++;
+            nextSupportMark(mptr, sptr);
+        }
+    }
+
+    nextSupportMark(mptr, sptr);
+    while (sptr->gainedCount && sptr->supported < tents) {
+        gained = sptr->gained[--sptr->gainedCount];
+        if ((c = getContentOfPosition(mptr, gained.line, gained.column)) != 'T' && c != 'U') continue;
+        if (supportOwner(mptr, sptr, gained) != -1) continue;
+        if (reachFreeTree(mptr, sptr, gained)) {
+            sptr->supported++;
+            nextSupportMark(mptr, sptr);
+        }
+    }
+
+    return sptr->supported >= tents;
+}
+
+/**
+ * Function: supportOwner
+ * 
+ * Description: finds the tree matched to a cell among the trees around it
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ *     cell Cell - cell
+ * 
+ * Return value:
+ *     index of tree matched to cell
+ *     -1 if cell is free
+ */
+int supportOwner(map *mptr, search *sptr, cell Cell) {
+    int around[4], count;
+    cell matched;
+
+    if (sptr->kernel->boards && !(sptr->boards[4 * sptr->boardSize + Cell.line + 1] & ((uint64_t) 1 << Cell.column))) return -1;
+
+    count = sptr->kernel->treesAround(mptr, sptr, Cell, around);
+    for (int k = 0; k < count; k++) {
+        matched = sptr->supports[around[k]].Cell;
+        if (matched.line == Cell.line && matched.column == Cell.column) return around[k];
+    }
+    return -1;
+}
+
+/**
+ * Function: augmentSupport
+ * 
+ * Description: gives a tree without cell a free tent or uncertain cell around it, moving the
+ *              trees of the cells on its way along an augmenting path if needed
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports (tree already marked)
+ *     int tree - index of tree
+ * 
+ * Return value:
+ *     1 - if tree got a cell
+ *     0 - otherwise
+ */
+int augmentSupport(map *mptr, search *sptr, int tree) {
+    support *supports = sptr->supports;
+    cell around[4];
+    int owners[4];
+    char c;
+
+    for (int k = 0; k < 4; k++) {
+        around[k].line = sptr->treeArray[tree].line + ortogonals[k].dx;
+        around[k].column = sptr->treeArray[tree].column + ortogonals[k].dy;
+        owners[k] = tree;
+        if ((c = getContentOfPosition(mptr, around[k].line, around[k].column)) != 'T' && c != 'U') continue;
+        owners[k] = supportOwner(mptr, sptr, around[k]);
+        if (owners[k] == -1) {
+            matchSupport(sptr, tree, around[k]);
+            return 1;
+        }
+    }
+
+    for (int k = 0; k < 4; k++) {
+        if (owners[k] == tree || supports[owners[k]].mark == sptr->supportMark) continue;
+        supports[owners[k]].mark = sptr->supportMark;
+        if (augmentSupport(mptr, sptr, owners[k])) {
+            matchSupport(sptr, tree, around[k]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function: reachFreeTree
+ * 
+ * Description: gives an unmatched tent or uncertain cell to a tree around it, moving that tree
+ *              off its cell along an augmenting path if needed
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array and supports
+ *     cell Cell - unmatched cell
+ * 
+ * Return value:
+ *     1 - if cell got a tree
+ *     0 - otherwise
+ */
+int reachFreeTree(map *mptr, search *sptr, cell Cell) {
+    support *supports = sptr->supports;
+    int around[4], count;
+
+    count = sptr->kernel->treesAround(mptr, sptr, Cell, around);
+    for (int k = 0; k < count; k++) {
+        if (supports[around[k]].Cell.line == -1) {
+            matchSupport(sptr, around[k], Cell);
+            return 1;
+        }
+    }
+
+    for (int k = 0; k < count; k++) {
+        if (supports[around[k]].mark == sptr->supportMark) continue;
+        supports[around[k]].mark = sptr->supportMark;
+        if (reachFreeTree(mptr, sptr, supports[around[k]].Cell)) {
+            matchSupport(sptr, around[k], Cell);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * Function: matchSupport
+ * 
+ * Description: matches a tree to a cell, width kernels also mark the cell on the board of
+ *              matched cells so that free cells are told without looking for their tree
+ * 
+ * Side-effects: writes supports (and boards) of sptr
+ * 
+ * Arguments:
+ *     search *sptr - search with supports
+ *     int tree - index of tree
+ *     cell Cell - tent or uncertain cell next to tree
+ * 
+ * Return value: none
+ */
+void matchSupport(search *sptr, int tree, cell Cell) {
+    sptr->supports[tree].Cell = Cell;
+    if (sptr->kernel->boards) sptr->boards[4 * sptr->boardSize + Cell.line + 1] |= (uint64_t) 1 << Cell.column;
+}
+
+/**
+ * Function: nextSupportMark
+ * 
+ * Description: starts a new augmenting path search, so that trees visited by earlier ones
+ *              count as unvisited without clearing their marks
+ * 
+ * Side-effects: writes support mark of sptr (and clears marks when it wraps around)
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with supports
+ * 
+ * Return value: none
+ */
+void nextSupportMark(map *mptr, search *sptr) {
+    if (sptr->supportMark == INT_MAX) {
+        for (int t = 0; t < getTreesNumber(mptr); t++) {
+            sptr->supports[t].mark = 0;
+        }
+        sptr->supportMark = 0;
+    }
+    sptr->supportMark++;
+}
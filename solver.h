@@ -7,8 +7,152 @@
 #ifndef SOLVER_H
 #define SOLVER_H
 
+#include <stdio.h>
+#include "difficulty.h"
 #include "map.h"
 
+#define SOLVE_CANCELLED 0
+/** result of a map whose estimated memory exceeds the budget, it is not solved */
+#define SOLVE_OVER_BUDGET -2
+
+/** engines: the route the cost model expects to be fastest, always backtracking, or the profile or decomposition engine when the map fits it (backtracking otherwise) */
+#define ENGINE_AUTO 0
+#define ENGINE_BACKTRACKING 1
+#define ENGINE_PROFILE 2
+#define ENGINE_DECOMPOSITION 3
+
+/** seconds a route may take on a map while benchmarked before it is cancelled */
+#define BENCHMARK_SECONDS 10
+
+/** orders in which backtracking decides uncertain cells */
+#define ORDER_LINES 0
+#define ORDER_COLUMNS 1
+#define ORDER_CONSTRAINED 2
+#define ORDER_RANDOM 3
+
+typedef struct workspaceStruct workspace;
+
+/**
+ * Options: engine, order of decisions, seed of random orders and restarts, restarts (when set
+ * backtracking gives up after a number of dead ends growing as the Luby sequence and starts
+ * again in another order, keeping the value each cell last took), cancel (search gives up
+ * once *cancel is set, unless NULL), memory budget (bytes a map may take when it is read
+ * and solved, 0 for no limit), cost model routing the auto engine (NULL for the built-in one)
+ * and features (filled once the map is preprocessed, unless NULL)
+ */
+typedef struct {
+    int engine;
+    int order;
+    unsigned int seed;
+    int restarts;
+    int *cancel;
+    long long memoryBudget;
+    const costModel *model;
+    mapFeatures *features;
+} solverOptions;
+
+/**
+ * Function: newWorkspace
+ * 
+ * Description: allocates an empty solver workspace, its buffers grow on demand and are kept
+ *              between calls so that a long lived thread solves every map with warm memory
+ * 
+ * Arguments: none
+ * 
+ * Return value:
+ *     pointer to new workspace if successful
+ *     NULL if error ocurred
+ */
+workspace *newWorkspace(void);
+
+/**
+ * Function: setWorkspaceThreads
+ * 
+ * Description: sets how many threads preprocessing of a huge map solved in a workspace may use
+ *              (every core by default), so that workers solving maps side by side share the
+ *              cores instead of each starting one thread per core
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ *     int threads - number of threads (at least 1)
+ * 
+ * Return value: none
+ */
+void setWorkspaceThreads(workspace *wptr, int threads);
+
+/**
+ * Function: deleteWorkspace
+ * 
+ * Description: deletes a solver workspace
+ * 
+ * Arguments:
+ *     workspace *wptr - pointer to workspace to be deleted
+ * 
+ * Return value: none
+ */
+void deleteWorkspace(workspace *wptr);
+
+/**
+ * Function: estimateSolveBytes
+ * 
+ * Description: estimates bytes of workspace needed to solve a map of a given size and number
+ *              of trees (with room for buffers grown while lines are read)
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ *     long long trees - number of trees
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long estimateSolveBytes(int lines, int columns, long long trees);
+
+/**
+ * Function: getWorkspaceBytes
+ * 
+ * Description: gets bytes held by the buffers of a workspace
+ * 
+ * Arguments:
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long getWorkspaceBytes(workspace *wptr);
+
+/**
+ * Function: streamPreprocessing
+ * 
+ * Description: starts preprocessing a map while its lines are read, so that it is done when
+ *              the last line arrives. Only maps of the generic kernels that are not split in
+ *              stripes are preprocessed this way, the rest when they are solved
+ * 
+ * Arguments:
+ *     map *mptr - map pointer (hints already set, no line read yet)
+ *     workspace *wptr - workspace later used to solve mptr
+ * 
+ * Return value: none
+ */
+void streamPreprocessing(map *mptr, workspace *wptr);
+
+/**
+ * Function: preprocessReadLine
+ * 
+ * Description: preprocesses what a new line of a map completes, the line before it has all
+ *              its neighbours now and the last line completes the whole map
+ * 
+ * Side-effects: writes uncertains in mptr, fills wptr arrays
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     int line - line just read (lines are read in order)
+ * 
+ * Return value: none
+ */
+void preprocessReadLine(map *mptr, workspace *wptr, int line);
+
 /**
  * Function: solveMap
  * 
@@ -25,4 +169,96 @@
  */
 int solveMap(map *mptr);
 
+/**
+ * Function: solveMapInWorkspace
+ * 
+ * Description: solves tents and trees map reusing the buffers of a workspace
+ * 
+ * Side-effects: writes solution for mptr, grows wptr buffers
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int solveMapInWorkspace(map *mptr, workspace *wptr);
+
+/**
+ * Function: defaultSolverOptions
+ * 
+ * Description: fills solver options with the configuration used by solveMap
+ * 
+ * Arguments:
+ *     solverOptions *optr - options to be filled
+ * 
+ * Return value: none
+ */
+void defaultSolverOptions(solverOptions *optr);
+
+/**
+ * Function: solveMapWithOptions
+ * 
+ * Description: solves tents and trees map with a given engine and order of decisions, giving
+ *              up as soon as *optr->cancel is set by another thread
+ * 
+ * Side-effects: writes solution for mptr (undefined if cancelled), grows wptr buffers
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ *     SOLVE_CANCELLED - if search was cancelled
+ */
+int solveMapWithOptions(map *mptr, workspace *wptr, solverOptions *optr);
+
+/**
+ * Function: benchmarkRoutes
+ * 
+ * Description: solves a map with every route that fits it, one after another on copies of the
+ *              map, and writes the features of the map with the time of every route as a line
+ *              of stats. A route still running after BENCHMARK_SECONDS is cancelled and that
+ *              time is written instead, a map no route solves in time is then solved without
+ *              deadline
+ * 
+ * Side-effects: replaces *mptr with the map solved by the fastest route (or solves it), grows
+ *               wptr buffers
+ * 
+ * Arguments:
+ *     map **mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ *     solverOptions *optr - options pointer (engine and order are set by every route)
+ *     FILE *log - file where the stats line is written
+ * 
+ * Return value:
+ *     1 - if map has solution
+ *     -1 - if map is impossible
+ */
+int benchmarkRoutes(map **mptr, workspace *wptr, solverOptions *optr, FILE *log);
+
+/**
+ * Function: countSolutions
+ * 
+ * Description: counts solutions of tents and trees map, stopping once limit is reached.
+ *              Preprocessing is done once and, with more than one worker, the search tree is
+ *              split at a small depth and its subtrees are counted in parallel
+ * 
+ * Side-effects: writes first solution found (in search order) for mptr
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     long long limit - stop after this many solutions (0 for no limit)
+ *     int workers - number of threads
+ * 
+ * Return value:
+ *     number of solutions (at most limit)
+ */
+long long countSolutions(map *mptr, long long limit, int workers);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,324 @@
+/**
+ * Filename: sparse.c
+ * 
+ * Description: Solver kernels for sparse maps, linear in the number of trees
+ */
+
+#include "sparse.h"
+#include <stdlib.h>
+#include <string.h>
+#include "map.h"
+#include "search.h"
+
+struct {
+    int dx;
+    int dy;
+} sparseOrtogonals[] = {{-1, 0}, {0, -1}, {0, 1}, {1, 0}};
+
+int compareCells(const void *a, const void *b);
+int sparseInjectivity(map *mptr, cell tent, search *sptr);
+int isolatedSparseTree(map *mptr, int line, int column);
+
+/**
+ * Function: preprocessSparse
+ * 
+ * Description: counts trees, marks cells around them that might support tents, builds uncertain
+ *              and tree arrays (sorted in line order) and checks hints consistency, visiting
+ *              trees and their neighbours only. Leaves line and column counters of wptr ready
+ *              for search
+ * 
+ * Side-effects: writes trees number and uncertains in mptr, fills wptr arrays and counters
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int preprocessSparse(map *mptr, workspace *wptr) {
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr);
+    int *lineUncertain, *columnUncertain;
+    int treeCount = 0, stored = getStoredCells(mptr), line, column, u = 0, isolatedTree;
+    char c;
+
+    for (int i = 0; i < stored; i++) {
+        if (getStoredCell(mptr, i, &line, &column) == 'A') treeCount++;
+    }
+    setTreesNumber(mptr, treeCount);
+    if (treeCount < getTentsNumber(mptr)) return 0;
+
+    reserveCounters(wptr, lines, columns);
+    lineUncertain = wptr->lineCounters + lines;
+    columnUncertain = wptr->columnCounters + columns;
+
+    reserveArrays(wptr, 0, treeCount);
+    for (int i = 0, t = 0; i < stored; i++) {
+        if (getStoredCell(mptr, i, &line, &column) != 'A') continue;
+        wptr->treeArray[t].line = line;
+        wptr->treeArray[t].column = column;
+        t++;
+    }
+    qsort(wptr->treeArray, treeCount, sizeof(cell), compareCells);
+
+    for (int i = 0; i < treeCount; i++) {
+        isolatedTree = 1;
+        for (int k = 0; k < 4; k++) {
+            line = wptr->treeArray[i].line + sparseOrtogonals[k].dx;
+            column = wptr->treeArray[i].column + sparseOrtogonals[k].dy;
+            if (line < 0 || line >= lines || column < 0 || column >= columns) continue;
+            if ((c = getContentOfPosition(mptr, line, column)) != 'A' && getTentsInLine(mptr, line) && getTentsInColumn(mptr, column)) {
+                if (c != 'U') {
+                    setContentOfPosition(mptr, line, column, 'U');
+                    incrementUncertainCount(mptr);
+                    lineUncertain[line]++;
+                    columnUncertain[column]++;
+                }
+                isolatedTree = 0;
+            }
+        }
+        if (isolatedTree && getTreesNumber(mptr) == getTentsNumber(mptr)) return 0;
+    }
+    if (getUncertainCount(mptr) < getTreesNumber(mptr) && getTreesNumber(mptr) == getTentsNumber(mptr)) return 0;
+
+    reserveArrays(wptr, getUncertainCount(mptr), treeCount);
+    stored = getStoredCells(mptr);
+    for (int i = 0; i < stored; i++) {
+        if (getStoredCell(mptr, i, &line, &column) != 'U') continue;
+        wptr->uncertainArray[u].line = line;
+        wptr->uncertainArray[u].column = column;
+        u++;
+    }
+    qsort(wptr->uncertainArray, u, sizeof(cell), compareCells);
+    memset(wptr->visited, 0, treeCount);
+
+    for (int i = 0; i < lines; i++) {
+        if (lineUncertain[i] < getTentsInLine(mptr, i)) return 0;
+    }
+    for (int i = 0; i < columns; i++) {
+        if (columnUncertain[i] < getTentsInColumn(mptr, i)) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: compareCells
+ * 
+ * Description: orders cells by line and then by column, as a scan of the map would find them
+ * 
+ * Arguments:
+ *     const void *a - pointer to first cell
+ *     const void *b - pointer to second cell
+ * 
+ * Return value:
+ *     negative, zero or positive as first cell comes before, is or comes after second cell
+ */
+int compareCells(const void *a, const void *b) {
+    const cell *first = (const cell *) a, *second = (const cell *) b;
+
+    if (first->line != second->line) return first->line < second->line ? -1 : 1;
+    if (first->column != second->column) return first->column < second->column ? -1 : 1;
+    return 0;
+}
+
+/**
+ * Function: setSparseCell
+ * 
+ * Description: sets content of an uncertain cell during search, keeping line and column
+ *              counters and the matching of trees to cells up to date
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     search *sptr - search pointer
+ *     cell Cell - cell to be set
+ *     char value - 'T', '.' or 'U'
+ * 
+ * Return value: none
+ */
+void setSparseCell(map *mptr, search *sptr, cell Cell, char value) {
+    char previous = getContentOfPosition(mptr, Cell.line, Cell.column);
+    int wasSupport = previous == 'T' || previous == 'U', isSupport = value == 'T' || value == 'U';
+
+    if (previous == 'T') {
+        sptr->lineTents[Cell.line]--;
+        sptr->columnTents[Cell.column]--;
+    } else if (previous == 'U') {
+        sptr->lineUncertain[Cell.line]--;
+        sptr->columnUncertain[Cell.column]--;
+    }
+
+    if (value == 'T') {
+        sptr->lineTents[Cell.line]++;
+        sptr->columnTents[Cell.column]++;
+    } else if (value == 'U') {
+        sptr->lineUncertain[Cell.line]++;
+        sptr->columnUncertain[Cell.column]++;
+    }
+
+    setContentOfPosition(mptr, Cell.line, Cell.column, value);
+
+    /** in low season the tree matched to a cell that stops supporting a tent looks for another */
+    if (sptr->spareTrees && wasSupport && !isSupport) loseSupport(mptr, sptr, Cell);
+    if (sptr->spareTrees && isSupport && !wasSupport) gainSupport(mptr, sptr, Cell);
+}
+
+/**
+ * Function: validSparseTent
+ * 
+ * Description: checks if tent is valid
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     cell Cell - tent to be validated
+ *     search *sptr - search with tree array, links (init to -1), visited (init to 0), trail
+ *                    and counters
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int validSparseTent(map *mptr, cell Cell, search *sptr) {
+    int injective;
+
+    for (int dx = -1; dx <= 1; dx++) {
+        for (int dy = -1; dy <= 1; dy++) {
+            if ((dx || dy) && getContentOfPosition(mptr, Cell.line + dx, Cell.column + dy) == 'T') return 0;
+        }
+    }
+
+    if (sptr->lineTents[Cell.line] > getTentsInLine(mptr, Cell.line)) return 0;
+    if (sptr->columnTents[Cell.column] > getTentsInColumn(mptr, Cell.column)) return 0;
+
+    sptr->trailLength = 0;
+    injective = sparseInjectivity(mptr, Cell, sptr);
+    for (int i = 0; i < sptr->trailLength; i++) {
+        sptr->visited[sptr->trail[i]] = 0;
+    }
+
+    return injective;
+}
+
+/**
+ * Function: findTree
+ * 
+ * Description: finds index of a tree in tree array by binary search
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with tree array sorted in line order
+ *     int line - line of tree
+ *     int column - column of tree
+ * 
+ * Return value:
+ *     index of tree in tree array
+ *     -1 if there is no tree there
+ */
+int findTree(map *mptr, search *sptr, int line, int column) {
+    cell key;
+    cell *found;
+
+    key.line = line;
+    key.column = column;
+    found = (cell *) bsearch(&key, sptr->treeArray, getTreesNumber(mptr), sizeof(cell), compareCells);
+
+    return found == NULL ? -1 : (int) (found - sptr->treeArray);
+}
+
+/**
+ * Function: sparseInjectivity
+ * 
+ * Description: checks tent-tree injectivity i.e. theres a unique tree for a tent (locally),
+ *              looking only at the trees around the tent and recording visited trees in trail
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     cell tent - tent to be validated
+ *     search *sptr - search with tree array, links, visited and trail
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int sparseInjectivity(map *mptr, cell tent, search *sptr) {
+    cell *links = sptr->links;
+    int i;
+    char c;
+
+    /** trees around a tent in tree array order: above, left, right and below */
+    for (int k = 0; k < 4; k++) {
+        if (getContentOfPosition(mptr, tent.line + sparseOrtogonals[k].dx, tent.column + sparseOrtogonals[k].dy) != 'A') continue;
+        i = findTree(mptr, sptr, tent.line + sparseOrtogonals[k].dx, tent.column + sparseOrtogonals[k].dy);
+        if (i == -1 || sptr->visited[i]) continue;
+
+        sptr->visited[i] = 1;
+        sptr->trail[sptr->trailLength++] = i;
+
+        if (links[i].line == tent.line && links[i].column == tent.column) return 1;
+
+        if (links[i].line == -1 || (c = getContentOfPosition(mptr, links[i].line, links[i].column)) == 'U' || c == '.' || sparseInjectivity(mptr, links[i], sptr)) {
+            links[i] = tent;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function: validSparseGrass
+ * 
+ * Description: checks if grass is valid
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     cell Cell - grass to be validated
+ *     search *sptr - search with counters and supports
+ * 
+ * Return value:
+ *     1 - if grass is valid
+ *     0 - if grass is invalid
+ */
+int validSparseGrass(map *mptr, cell Cell, search *sptr) {
+    int line, column;
+
+    /** When in high season check if theres an isolated tree */
+    if (getTentsNumber(mptr) == getTreesNumber(mptr)) {
+        for (int k = 0; k < 4; k++) {
+            line = Cell.line + sparseOrtogonals[k].dx;
+            column = Cell.column + sparseOrtogonals[k].dy;
+            if (getContentOfPosition(mptr, line, column) == 'A' && isolatedSparseTree(mptr, line, column)) return 0;
+        }
+    }
+
+    if (sptr->lineUncertain[Cell.line] < getTentsInLine(mptr, Cell.line) - sptr->lineTents[Cell.line]) return 0;
+    if (sptr->columnUncertain[Cell.column] < getTentsInColumn(mptr, Cell.column) - sptr->columnTents[Cell.column]) return 0;
+
+    /** In low season each tent needs its own tree, matched to a tent or uncertain cell next to it */
+    if (sptr->spareTrees && !settleSupports(mptr, sptr)) return 0;
+
+    return 1;
+}
+
+/**
+ * Function: isolatedSparseTree
+ * 
+ * Description: checks if a tree has no tent or uncertain cell left around it
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     int line - line of tree
+ *     int column - column of tree
+ * 
+ * Return value:
+ *     1 - if tree is isolated
+ *     0 - otherwise
+ */
+int isolatedSparseTree(map *mptr, int line, int column) {
+    char c;
+
+    for (int k = 0; k < 4; k++) {
+        if ((c = getContentOfPosition(mptr, line + sparseOrtogonals[k].dx, column + sparseOrtogonals[k].dy)) == 'T' || c == 'U') return 0;
+    }
+    return 1;
+}
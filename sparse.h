@@ -0,0 +1,82 @@
+/**
+ * Filename: sparse.h
+ * 
+ * Description: Solver kernels for sparse maps, linear in the number of trees
+ */
+
+#ifndef SPARSE_H
+#define SPARSE_H
+
+#include "map.h"
+#include "search.h"
+
+/**
+ * Function: preprocessSparse
+ * 
+ * Description: counts trees, marks cells around them that might support tents, builds uncertain
+ *              and tree arrays (sorted in line order) and checks hints consistency, visiting
+ *              trees and their neighbours only. Leaves line and column counters of wptr ready
+ *              for search
+ * 
+ * Side-effects: writes trees number and uncertains in mptr, fills wptr arrays and counters
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int preprocessSparse(map *mptr, workspace *wptr);
+
+/**
+ * Function: setSparseCell
+ * 
+ * Description: sets content of an uncertain cell during search, keeping line and column
+ *              counters up to date
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     search *sptr - search pointer
+ *     cell Cell - cell to be set
+ *     char value - 'T', '.' or 'U'
+ * 
+ * Return value: none
+ */
+void setSparseCell(map *mptr, search *sptr, cell Cell, char value);
+
+/**
+ * Function: validSparseTent
+ * 
+ * Description: checks if tent is valid
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     cell Cell - tent to be validated
+ *     search *sptr - search with tree array, links (init to -1), visited (init to 0), trail
+ *                    and counters
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int validSparseTent(map *mptr, cell Cell, search *sptr);
+
+/**
+ * Function: validSparseGrass
+ * 
+ * Description: checks if grass is valid
+ * 
+ * Arguments:
+ *     map *mptr - sparse map pointer
+ *     cell Cell - grass to be validated
+ *     search *sptr - search with counters
+ * 
+ * Return value:
+ *     1 - if grass is valid
+ *     0 - if grass is invalid
+ */
+int validSparseGrass(map *mptr, cell Cell, search *sptr);
+
+#endif
@@ -0,0 +1,563 @@
+/**
+ * Filename: stream.c
+ * 
+ * Description: Files read and written through gzip or zstd compression, in a thread of their
+ *              own so that (de)compression overlaps with solving
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "stream.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+/** bytes moved through a pipe at a time */
+#define STREAM_CHUNK (1 << 16)
+
+/** first byte of a gzip member ("\x1f\x8b") and of a zstd frame ("\x28\xb5\x2f\xfd") */
+#define GZIP_MAGIC 0x1f
+#define ZSTD_MAGIC 0x28
+
+/**
+ * A compressed stream hands out one end of a pipe, its thread moves bytes between the other
+ * end and the compressed file. Neither a .camp nor a binary map starts with a magic byte
+ */
+struct streamStruct {
+    FILE *fp;
+    FILE *file;
+    int pipe;
+    int compression;
+    int failed;
+    pthread_t thread;
+};
+
+void *decompressStream(void *arg);
+void *compressStream(void *arg);
+int writeAll(int fd, const unsigned char *bytes, size_t count);
+ssize_t readSome(int fd, unsigned char *bytes, size_t count);
+int gunzipFile(stream *sptr);
+int gzipFile(stream *sptr);
+int unzstdFile(stream *sptr);
+int zstdFile(stream *sptr);
+
+/**
+ * Function: streamSupports
+ * 
+ * Description: checks if a compression was built in (zlib and zstd are linked when installed)
+ * 
+ * Arguments:
+ *     int compression - STREAM_PLAIN, STREAM_GZIP or STREAM_ZSTD
+ * 
+ * Return value:
+ *     1 - if streams can use it
+ *     0 - otherwise
+ */
+int streamSupports(int compression) {
+    switch (compression) {
+        case STREAM_PLAIN:
+            return 1;
+#ifdef HAVE_ZLIB
+        case STREAM_GZIP:
+            return 1;
+#endif
+#ifdef HAVE_ZSTD
+        case STREAM_ZSTD:
+            return 1;
+#endif
+        default:
+            return 0;
+    }
+}
+
+/**
+ * Function: fileCompression
+ * 
+ * Description: tells the compression of a file by its magic bytes, like openInputStream
+ * 
+ * Arguments:
+ *     char *filename - name of file
+ * 
+ * Return value:
+ *     STREAM_GZIP or STREAM_ZSTD - if file is compressed
+ *     STREAM_PLAIN - if it is not or can't be opened
+ */
+int fileCompression(char *filename) {
+    FILE *file;
+    int c;
+
+    file = fopen(filename, "r");
+    if (file == NULL) return STREAM_PLAIN;
+    c = getc(file);
+    fclose(file);
+
+    return c == GZIP_MAGIC ? STREAM_GZIP : c == ZSTD_MAGIC ? STREAM_ZSTD : STREAM_PLAIN;
+}
+
+/**
+ * Function: openInputStream
+ * 
+ * Description: opens a file for reading, telling gzip and zstd files by their magic bytes and
+ *              decompressing them in a thread that feeds the stream through a pipe
+ * 
+ * Arguments:
+ *     char *filename - name of file
+ * 
+ * Return value:
+ *     pointer to new stream if successful
+ *     NULL if file can't be opened or its compression was not built in
+ */
+stream *openInputStream(char *filename) {
+    stream *sptr;
+    FILE *file;
+    int c, fds[2];
+
+    file = fopen(filename, "r");
+    if (file == NULL) return NULL;
+
+    c = getc(file);
+    ungetc(c, file);
+
+    sptr = (stream *) malloc(sizeof(stream));
+    if (sptr == NULL) exit(EXIT_FAILURE);
+
+    sptr->compression = c == GZIP_MAGIC ? STREAM_GZIP : c == ZSTD_MAGIC ? STREAM_ZSTD : STREAM_PLAIN;
+    sptr->failed = 0;
+
+    if (!streamSupports(sptr->compression) || (sptr->compression != STREAM_PLAIN && pipe(fds))) {
+        fclose(file);
+        free(sptr);
+        return NULL;
+    }
+
+    if (sptr->compression == STREAM_PLAIN) {
+        sptr->fp = file;
+        sptr->file = NULL;
+        return sptr;
+    }
+
+    /** the reader may stop before the end, the thread then sees EPIPE */
+    signal(SIGPIPE, SIG_IGN);
+
+    sptr->fp = fdopen(fds[0], "r");
+    if (sptr->fp == NULL) exit(EXIT_FAILURE);
+    sptr->file = file;
+    sptr->pipe = fds[1];
+
+    if (pthread_create(&sptr->thread, NULL, decompressStream, sptr)) exit(EXIT_FAILURE);
+
+    return sptr;
+}
+
+/**
+ * Function: openOutputStream
+ * 
+ * Description: opens a file for writing, compressed in a thread that drains the stream
+ *              through a pipe unless compression is STREAM_PLAIN. Appending to a compressed
+ *              file adds a gzip member or zstd frame, which decompress as one stream
+ * 
+ * Arguments:
+ *     char *filename - name of file
+ *     char *mode - "w" or "a"
+ *     int compression - STREAM_PLAIN, STREAM_GZIP or STREAM_ZSTD
+ * 
+ * Return value:
+ *     pointer to new stream if successful
+ *     NULL if file can't be opened or compression was not built in
+ */
+stream *openOutputStream(char *filename, char *mode, int compression) {
+    stream *sptr;
+    FILE *file;
+    int fds[2];
+
+    if (!streamSupports(compression)) return NULL;
+
+    file = fopen(filename, mode);
+    if (file == NULL) return NULL;
+
+    if (compression != STREAM_PLAIN && pipe(fds)) {
+        fclose(file);
+        return NULL;
+    }
+
+    sptr = (stream *) malloc(sizeof(stream));
+    if (sptr == NULL) exit(EXIT_FAILURE);
+
+    sptr->compression = compression;
+    sptr->failed = 0;
+
+    if (compression == STREAM_PLAIN) {
+        sptr->fp = file;
+        sptr->file = NULL;
+        return sptr;
+    }
+
+    sptr->fp = fdopen(fds[1], "w");
+    if (sptr->fp == NULL) exit(EXIT_FAILURE);
+    sptr->file = file;
+    sptr->pipe = fds[0];
+
+    if (pthread_create(&sptr->thread, NULL, compressStream, sptr)) exit(EXIT_FAILURE);
+
+    return sptr;
+}
+
+/**
+ * Function: getStreamFile
+ * 
+ * Description: gets the file to read or write a stream with (a pipe when compressed, so it
+ *              can't seek and ftell fails on it)
+ * 
+ * Arguments:
+ *     stream *sptr - stream pointer
+ * 
+ * Return value:
+ *     file pointer
+ */
+FILE *getStreamFile(stream *sptr) {
+    return sptr->fp;
+}
+
+/**
+ * Function: closeStream
+ * 
+ * Description: closes a stream, waiting for its thread to (de)compress everything written
+ *              or to stop reading
+ * 
+ * Arguments:
+ *     stream *sptr - pointer to stream to be closed
+ * 
+ * Return value:
+ *     1 - if every byte was (de)compressed
+ *     0 - if compressed data was corrupt or a file could not be read or written
+ */
+int closeStream(stream *sptr) {
+    int ok;
+
+    /** closing the pipe ends the input of a compressing thread */
+    ok = fclose(sptr->fp) == 0;
+
+    if (sptr->file != NULL) {
+        pthread_join(sptr->thread, NULL);
+        ok = fclose(sptr->file) == 0 && ok && !sptr->failed;
+    }
+    free(sptr);
+
+    return ok;
+}
+
+/**
+ * Function: decompressStream
+ * 
+ * Description: thread decompressing a file into the pipe of a stream
+ * 
+ * Arguments:
+ *     void *arg - stream pointer
+ * 
+ * Return value:
+ *     NULL
+ */
+void *decompressStream(void *arg) {
+    stream *sptr = (stream *) arg;
+
+    sptr->failed = sptr->compression == STREAM_GZIP ? !gunzipFile(sptr) : !unzstdFile(sptr);
+    close(sptr->pipe);
+
+    return NULL;
+}
+
+/**
+ * Function: compressStream
+ * 
+ * Description: thread compressing what is written to the pipe of a stream into its file.
+ *              After a failure the pipe is still drained, so that writers never block
+ * 
+ * Arguments:
+ *     void *arg - stream pointer
+ * 
+ * Return value:
+ *     NULL
+ */
+void *compressStream(void *arg) {
+    stream *sptr = (stream *) arg;
+    unsigned char bytes[512];
+
+    sptr->failed = sptr->compression == STREAM_GZIP ? !gzipFile(sptr) : !zstdFile(sptr);
+    if (sptr->failed) {
+        while (readSome(sptr->pipe, bytes, sizeof(bytes)) > 0)
+            ;
+    }
+    close(sptr->pipe);
+
+    return NULL;
+}
+
+/**
+ * Function: writeAll
+ * 
+ * Description: writes every byte of a buffer to a file descriptor
+ * 
+ * Arguments:
+ *     int fd - file descriptor
+ *     const unsigned char *bytes - buffer
+ *     size_t count - number of bytes
+ * 
+ * Return value:
+ *     1 - if every byte was written
+ *     0 - otherwise (e.g. the reader of a pipe stopped)
+ */
+int writeAll(int fd, const unsigned char *bytes, size_t count) {
+    ssize_t written;
+
+    while (count > 0) {
+        written = write(fd, bytes, count);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) return 0;
+        bytes += written;
+        count -= written;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: readSome
+ * 
+ * Description: reads from a file descriptor, retrying if interrupted
+ * 
+ * Arguments:
+ *     int fd - file descriptor
+ *     unsigned char *bytes - returns bytes read
+ *     size_t count - size of buffer
+ * 
+ * Return value:
+ *     number of bytes read (0 at end of file, negative on error)
+ */
+ssize_t readSome(int fd, unsigned char *bytes, size_t count) {
+    ssize_t got;
+
+    while ((got = read(fd, bytes, count)) < 0 && errno == EINTR)
+        ;
+
+    return got;
+}
+
+/**
+ * Function: gunzipFile
+ * 
+ * Description: decompresses a gzip file (every member of it) into the pipe of a stream
+ * 
+ * Arguments:
+ *     stream *sptr - stream pointer
+ * 
+ * Return value:
+ *     1 - if the whole file was decompressed
+ *     0 - if it is corrupt or truncated, or the pipe was closed
+ */
+int gunzipFile(stream *sptr) {
+#ifdef HAVE_ZLIB
+    unsigned char *in, *out;
+    z_stream z;
+    int ret = Z_OK, ok = 1;
+    size_t count;
+
+    in = (unsigned char *) malloc(2 * STREAM_CHUNK);
+    if (in == NULL) exit(EXIT_FAILURE);
+    out = in + STREAM_CHUNK;
+
+    memset(&z, 0, sizeof(z));
+    if (inflateInit2(&z, 15 + 16) != Z_OK) exit(EXIT_FAILURE);
+
+    while (ok && (count = fread(in, 1, STREAM_CHUNK, sptr->file)) > 0) {
+        z.next_in = in;
+        z.avail_in = (uInt) count;
+        do {
+            if (ret == Z_STREAM_END && z.avail_in > 0) inflateReset(&z);
+            z.next_out = out;
+            z.avail_out = STREAM_CHUNK;
+            ret = inflate(&z, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) ok = 0;
+            if (ok) ok = writeAll(sptr->pipe, out, STREAM_CHUNK - z.avail_out);
+        } while (ok && (z.avail_in > 0 || z.avail_out == 0));
+    }
+    ok = ok && ret == Z_STREAM_END && !ferror(sptr->file);
+
+    inflateEnd(&z);
+    free(in);
+
+    return ok;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Function: gzipFile
+ * 
+ * Description: compresses what is written to the pipe of a stream into a gzip member
+ * 
+ * Arguments:
+ *     stream *sptr - stream pointer
+ * 
+ * Return value:
+ *     1 - if everything was compressed and written
+ *     0 - otherwise
+ */
+int gzipFile(stream *sptr) {
+#ifdef HAVE_ZLIB
+    unsigned char *in, *out;
+    z_stream z;
+    int ret = Z_OK, ok = 1, flush = Z_NO_FLUSH;
+    ssize_t count;
+
+    in = (unsigned char *) malloc(2 * STREAM_CHUNK);
+    if (in == NULL) exit(EXIT_FAILURE);
+    out = in + STREAM_CHUNK;
+
+    memset(&z, 0, sizeof(z));
+    if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) exit(EXIT_FAILURE);
+
+    while (ok && flush != Z_FINISH) {
+        count = readSome(sptr->pipe, in, STREAM_CHUNK);
+        if (count < 0) ok = 0;
+        if (count <= 0) flush = Z_FINISH;
+        z.next_in = in;
+        z.avail_in = count > 0 ? (uInt) count : 0;
+        do {
+            z.next_out = out;
+            z.avail_out = STREAM_CHUNK;
+            ret = deflate(&z, flush);
+            if (ret == Z_STREAM_ERROR) ok = 0;
+            if (ok) ok = fwrite(out, 1, STREAM_CHUNK - z.avail_out, sptr->file) == STREAM_CHUNK - z.avail_out;
+        } while (ok && z.avail_out == 0);
+    }
+    ok = ok && ret == Z_STREAM_END;
+
+    deflateEnd(&z);
+    free(in);
+
+    return ok;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Function: unzstdFile
+ * 
+ * Description: decompresses a zstd file (every frame of it) into the pipe of a stream
+ * 
+ * Arguments:
+ *     stream *sptr - stream pointer
+ * 
+ * Return value:
+ *     1 - if the whole file was decompressed
+ *     0 - if it is corrupt or truncated, or the pipe was closed
+ */
+int unzstdFile(stream *sptr) {
+#ifdef HAVE_ZSTD
+    size_t inSize = ZSTD_DStreamInSize(), outSize = ZSTD_DStreamOutSize(), count, ret = 1;
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    ZSTD_DStream *dstream;
+    unsigned char *in, *out;
+    int ok = 1;
+
+    in = (unsigned char *) malloc(inSize + outSize);
+    if (in == NULL) exit(EXIT_FAILURE);
+    out = in + inSize;
+
+    dstream = ZSTD_createDStream();
+    if (dstream == NULL) exit(EXIT_FAILURE);
+
+    while (ok && (count = fread(in, 1, inSize, sptr->file)) > 0) {
+        input.src = in;
+        input.size = count;
+        input.pos = 0;
+        /** a full output buffer may leave bytes inside the decoder */
+        do {
+            output.dst = out;
+            output.size = outSize;
+            output.pos = 0;
+            ret = ZSTD_decompressStream(dstream, &output, &input);
+            if (ZSTD_isError(ret)) ok = 0;
+            if (ok) ok = writeAll(sptr->pipe, out, output.pos);
+        } while (ok && (input.pos < input.size || output.pos == output.size));
+    }
+    ok = ok && ret == 0 && !ferror(sptr->file);
+
+    ZSTD_freeDStream(dstream);
+    free(in);
+
+    return ok;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Function: zstdFile
+ * 
+ * Description: compresses what is written to the pipe of a stream into a zstd frame
+ * 
+ * Arguments:
+ *     stream *sptr - stream pointer
+ * 
+ * Return value:
+ *     1 - if everything was compressed and written
+ *     0 - otherwise
+ */
+int zstdFile(stream *sptr) {
+#ifdef HAVE_ZSTD
+    size_t inSize = ZSTD_CStreamInSize(), outSize = ZSTD_CStreamOutSize(), remaining = 1;
+    ZSTD_EndDirective mode = ZSTD_e_continue;
+    ZSTD_inBuffer input;
+    ZSTD_outBuffer output;
+    ZSTD_CCtx *cctx;
+    unsigned char *in, *out;
+    ssize_t count;
+    int ok = 1, finished = 0;
+
+    in = (unsigned char *) malloc(inSize + outSize);
+    if (in == NULL) exit(EXIT_FAILURE);
+    out = in + inSize;
+
+    cctx = ZSTD_createCCtx();
+    if (cctx == NULL) exit(EXIT_FAILURE);
+
+    while (ok && !finished) {
+        count = readSome(sptr->pipe, in, inSize);
+        if (count < 0) ok = 0;
+        if (count <= 0) mode = ZSTD_e_end;
+        input.src = in;
+        input.size = count > 0 ? (size_t) count : 0;
+        input.pos = 0;
+        do {
+            output.dst = out;
+            output.size = outSize;
+            output.pos = 0;
+            remaining = ZSTD_compressStream2(cctx, &output, &input, mode);
+            if (ZSTD_isError(remaining)) ok = 0;
+            if (ok) ok = fwrite(out, 1, output.pos, sptr->file) == output.pos;
+            finished = mode == ZSTD_e_end && remaining == 0;
+        } while (ok && (mode == ZSTD_e_end ? !finished : input.pos < input.size));
+    }
+
+    ZSTD_freeCCtx(cctx);
+    free(in);
+
+    return ok;
+#else
+    return 0;
+#endif
+}
@@ -0,0 +1,110 @@
+/**
+ * Filename: stream.h
+ * 
+ * Description: Files read and written through gzip or zstd compression, in a thread of their
+ *              own so that (de)compression overlaps with solving
+ */
+
+#ifndef STREAM_H
+#define STREAM_H
+
+#include <stdio.h>
+
+/** compression of a stream */
+#define STREAM_PLAIN 0
+#define STREAM_GZIP 1
+#define STREAM_ZSTD 2
+
+typedef struct streamStruct stream;
+
+/**
+ * Function: streamSupports
+ * 
+ * Description: checks if a compression was built in (zlib and zstd are linked when installed)
+ * 
+ * Arguments:
+ *     int compression - STREAM_PLAIN, STREAM_GZIP or STREAM_ZSTD
+ * 
+ * Return value:
+ *     1 - if streams can use it
+ *     0 - otherwise
+ */
+int streamSupports(int compression);
+
+/**
+ * Function: fileCompression
+ * 
+ * Description: tells the compression of a file by its magic bytes, like openInputStream
+ * 
+ * Arguments:
+ *     char *filename - name of file
+ * 
+ * Return value:
+ *     STREAM_GZIP or STREAM_ZSTD - if file is compressed
+ *     STREAM_PLAIN - if it is not or can't be opened
+ */
+int fileCompression(char *filename);
+
+/**
+ * Function: openInputStream
+ * 
+ * Description: opens a file for reading, telling gzip and zstd files by their magic bytes and
+ *              decompressing them in a thread that feeds the stream through a pipe
+ * 
+ * Arguments:
+ *     char *filename - name of file
+ * 
+ * Return value:
+ *     pointer to new stream if successful
+ *     NULL if file can't be opened or its compression was not built in
+ */
+stream *openInputStream(char *filename);
+
+/**
+ * Function: openOutputStream
+ * 
+ * Description: opens a file for writing, compressed in a thread that drains the stream
+ *              through a pipe unless compression is STREAM_PLAIN. Appending to a compressed
+ *              file adds a gzip member or zstd frame, which decompress as one stream
+ * 
+ * Arguments:
+ *     char *filename - name of file
+ *     char *mode - "w" or "a"
+ *     int compression - STREAM_PLAIN, STREAM_GZIP or STREAM_ZSTD
+ * 
+ * Return value:
+ *     pointer to new stream if successful
+ *     NULL if file can't be opened or compression was not built in
+ */
+stream *openOutputStream(char *filename, char *mode, int compression);
+
+/**
+ * Function: getStreamFile
+ * 
+ * Description: gets the file to read or write a stream with (a pipe when compressed, so it
+ *              can't seek and ftell fails on it)
+ * 
+ * Arguments:
+ *     stream *sptr - stream pointer
+ * 
+ * Return value:
+ *     file pointer
+ */
+FILE *getStreamFile(stream *sptr);
+
+/**
+ * Function: closeStream
+ * 
+ * Description: closes a stream, waiting for its thread to (de)compress everything written
+ *              or to stop reading
+ * 
+ * Arguments:
+ *     stream *sptr - pointer to stream to be closed
+ * 
+ * Return value:
+ *     1 - if every byte was (de)compressed
+ *     0 - if compressed data was corrupt or a file could not be read or written
+ */
+int closeStream(stream *sptr);
+
+#endif
@@ -0,0 +1,252 @@
+/**
+ * Filename: table.c
+ * 
+ * Description: Implementation of open addressing hash table of fixed size keys
+ */
+
+#include "table.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_SLOTS 1024
+
+struct tableStruct {
+    int keySize;
+    int size;
+    int capacity;
+    char *keys;
+    int *slots;
+    int slotCount;
+};
+
+uint64_t hashKey(void *key, int keySize);
+void growSlots(table *tptr);
+
+/**
+ * Function: newTable
+ * 
+ * Description: allocates new empty table
+ * 
+ * Arguments:
+ *     int keySize - size of every key in bytes
+ * 
+ * Return value:
+ *     pointer to new table if successful
+ *     NULL if error ocurred
+ */
+table *newTable(int keySize) {
+    table *tptr;
+
+    tptr = (table *) malloc(sizeof(table));
+    if (tptr == NULL) return NULL;
+
+    tptr->keySize = keySize;
+    tptr->size = 0;
+    tptr->capacity = INITIAL_SLOTS / 2;
+    tptr->slotCount = INITIAL_SLOTS;
+
+    tptr->keys = (char *) malloc((long) tptr->capacity * keySize);
+    if (tptr->keys == NULL) return NULL;
+
+    tptr->slots = (int *) malloc(tptr->slotCount * sizeof(int));
+    if (tptr->slots == NULL) return NULL;
+    memset(tptr->slots, -1, tptr->slotCount * sizeof(int));
+
+    return tptr;
+}
+
+/**
+ * Function: deleteTable
+ * 
+ * Description: deletes a table
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table to be deleted
+ * 
+ * Return value: none
+ */
+void deleteTable(table *tptr) {
+    if (tptr == NULL) return;
+
+    free(tptr->keys);
+    free(tptr->slots);
+    free(tptr);
+}
+
+/**
+ * Function: clearTable
+ * 
+ * Description: removes every key of a table, keeping its memory for reuse
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value: none
+ */
+void clearTable(table *tptr) {
+    tptr->size = 0;
+    memset(tptr->slots, -1, tptr->slotCount * sizeof(int));
+}
+
+/**
+ * Function: insertKey
+ * 
+ * Description: inserts key if not present, keys are numbered from 0 in insertion order
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ *     void *key - key to be inserted
+ *     int *index - returns number of key
+ * 
+ * Return value:
+ *     1 - if key was inserted
+ *     0 - if key was already present
+ */
+int insertKey(table *tptr, void *key, int *index) {
+    int slot, mask;
+
+    if (tptr->size == tptr->capacity) growSlots(tptr);
+
+    mask = tptr->slotCount - 1;
+    slot = (int) (hashKey(key, tptr->keySize) & mask);
+    while (tptr->slots[slot] != -1) {
+        if (!memcmp(tptr->keys + (long) tptr->slots[slot] * tptr->keySize, key, tptr->keySize)) {
+            *index = tptr->slots[slot];
+            return 0;
+        }
+        slot = (slot + 1) & mask;
+    }
+
+    memcpy(tptr->keys + (long) tptr->size * tptr->keySize, key, tptr->keySize);
+    tptr->slots[slot] = tptr->size;
+    *index = tptr->size++;
+
+    return 1;
+}
+
+/**
+ * Function: findKey
+ * 
+ * Description: looks a key up without inserting it
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ *     void *key - key to be looked up
+ * 
+ * Return value:
+ *     number of key if present
+ *     -1 if key is not present
+ */
+int findKey(table *tptr, void *key) {
+    int slot, mask;
+
+    mask = tptr->slotCount - 1;
+    slot = (int) (hashKey(key, tptr->keySize) & mask);
+    while (tptr->slots[slot] != -1) {
+        if (!memcmp(tptr->keys + (long) tptr->slots[slot] * tptr->keySize, key, tptr->keySize)) return tptr->slots[slot];
+        slot = (slot + 1) & mask;
+    }
+
+    return -1;
+}
+
+/**
+ * Function: getKey
+ * 
+ * Description: gets key by number
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ *     int index - number of key
+ * 
+ * Return value: pointer to key stored in table (valid until next insertion)
+ */
+void *getKey(table *tptr, int index) {
+    return tptr->keys + (long) index * tptr->keySize;
+}
+
+/**
+ * Function: getTableSize
+ * 
+ * Description: gets number of keys
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value:
+ *     number of keys
+ */
+int getTableSize(table *tptr) {
+    return tptr->size;
+}
+
+/**
+ * Function: getTableBytes
+ * 
+ * Description: gets number of bytes held by a table (keys and slots, used or not)
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long getTableBytes(table *tptr) {
+    return (long long) sizeof(table) + (long long) tptr->capacity * tptr->keySize + (long long) tptr->slotCount * sizeof(int);
+}
+
+/**
+ * Function: hashKey
+ * 
+ * Description: FNV-1a hash of key bytes
+ * 
+ * Arguments:
+ *     void *key - key
+ *     int keySize - size of key in bytes
+ * 
+ * Return value: hash of key
+ */
+uint64_t hashKey(void *key, int keySize) {
+    unsigned char *bytes = (unsigned char *) key;
+    uint64_t hash = 14695981039346656037ULL;
+
+    for (int i = 0; i < keySize; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash ^ (hash >> 29);
+}
+
+/**
+ * Function: growSlots
+ * 
+ * Description: doubles capacity of table and rehashes every key
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value: none
+ */
+void growSlots(table *tptr) {
+    int slot, mask;
+
+    tptr->capacity *= 2;
+    tptr->slotCount *= 2;
+
+    tptr->keys = (char *) realloc(tptr->keys, (long) tptr->capacity * tptr->keySize);
+    free(tptr->slots);
+    tptr->slots = (int *) malloc(tptr->slotCount * sizeof(int));
+    if (tptr->keys == NULL || tptr->slots == NULL) exit(EXIT_FAILURE);
+    memset(tptr->slots, -1, tptr->slotCount * sizeof(int));
+
+    mask = tptr->slotCount - 1;
+    for (int i = 0; i < tptr->size; i++) {
+        slot = (int) (hashKey(tptr->keys + (long) i * tptr->keySize, tptr->keySize) & mask);
+        while (tptr->slots[slot] != -1) {
+            slot = (slot + 1) & mask;
+        }
+        tptr->slots[slot] = i;
+    }
+}
@@ -0,0 +1,120 @@
+/**
+ * Filename: table.h
+ * 
+ * Description: hash table of fixed size keys, used to merge equal states of dynamic programming engines
+ */
+
+#ifndef TABLE_H
+#define TABLE_H
+
+typedef struct tableStruct table;
+
+/**
+ * Function: newTable
+ * 
+ * Description: allocates new empty table
+ * 
+ * Arguments:
+ *     int keySize - size of every key in bytes
+ * 
+ * Return value:
+ *     pointer to new table if successful
+ *     NULL if error ocurred
+ */
+table *newTable(int keySize);
+
+/**
+ * Function: deleteTable
+ * 
+ * Description: deletes a table
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table to be deleted
+ * 
+ * Return value: none
+ */
+void deleteTable(table *tptr);
+
+/**
+ * Function: clearTable
+ * 
+ * Description: removes every key of a table, keeping its memory for reuse
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value: none
+ */
+void clearTable(table *tptr);
+
+/**
+ * Function: insertKey
+ * 
+ * Description: inserts key if not present, keys are numbered from 0 in insertion order
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ *     void *key - key to be inserted
+ *     int *index - returns number of key
+ * 
+ * Return value:
+ *     1 - if key was inserted
+ *     0 - if key was already present
+ */
+int insertKey(table *tptr, void *key, int *index);
+
+/**
+ * Function: findKey
+ * 
+ * Description: looks a key up without inserting it
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ *     void *key - key to be looked up
+ * 
+ * Return value:
+ *     number of key if present
+ *     -1 if key is not present
+ */
+int findKey(table *tptr, void *key);
+
+/**
+ * Function: getKey
+ * 
+ * Description: gets key by number
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ *     int index - number of key
+ * 
+ * Return value: pointer to key stored in table (valid until next insertion)
+ */
+void *getKey(table *tptr, int index);
+
+/**
+ * Function: getTableSize
+ * 
+ * Description: gets number of keys
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value:
+ *     number of keys
+ */
+int getTableSize(table *tptr);
+
+/**
+ * Function: getTableBytes
+ * 
+ * Description: gets number of bytes held by a table (keys and slots, used or not)
+ * 
+ * Arguments:
+ *     table *tptr - pointer to table
+ * 
+ * Return value:
+ *     number of bytes
+ */
+long long getTableBytes(table *tptr);
+
+#endif
@@ -0,0 +1,346 @@
+/**
+ * Filename: testedit.c
+ * 
+ * Description: Checks incremental re-solving against a fresh solveMap on random maps and edits
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "edit.h"
+#include "map.h"
+#include "solver.h"
+
+/** random maps checked and edits made on each of them */
+#define TEST_MAPS 300
+#define TEST_EDITS 40
+
+/** largest number of lines or columns of a random map */
+#define TEST_MAX_SIDE 12
+
+map *randomMap(int lines, int columns);
+map *freshCopy(map *mptr);
+int validSolution(map *mptr);
+int matchTree(map *mptr, int line, int column, int *used, char *visited);
+int sameGrid(map *mptr, char *grid);
+void saveCells(map *mptr, char *grid);
+int checkEdit(editor *eptr, map *mptr, int result, char *before, const char *edit, int line, int column);
+
+int failures = 0;
+
+/**
+ * Function: main
+ * 
+ * Description: edits random maps with addTree, removeTree, changeLineHint and changeColumnHint
+ *              and checks every result and solution against a fresh solveMap of the edited map
+ * 
+ * Arguments: none
+ * 
+ * Return value:
+ *     EXIT_SUCCESS - if every edit agrees with a fresh solve
+ *     EXIT_FAILURE - otherwise
+ */
+int main(void) {
+    int lines, columns, result, line, column, tents, edits = 0;
+    char *before;
+    editor *eptr;
+    map *mptr;
+
+    srand(20240517);
+    before = (char *) malloc(TEST_MAX_SIDE * TEST_MAX_SIDE * sizeof(char));
+    if (before == NULL) exit(EXIT_FAILURE);
+
+    for (int m = 0; m < TEST_MAPS; m++) {
+        lines = 2 + rand() % (TEST_MAX_SIDE - 1);
+        columns = 2 + rand() % (TEST_MAX_SIDE - 1);
+        mptr = randomMap(lines, columns);
+        result = solveMap(mptr);
+        eptr = newEditor(mptr, result);
+        if (eptr == NULL) exit(EXIT_FAILURE);
+
+        for (int e = 0; e < TEST_EDITS; e++, edits++) {
+            line = rand() % lines;
+            column = rand() % columns;
+            saveCells(mptr, before);
+            switch (rand() % 4) {
+                case 0:
+                    checkEdit(eptr, mptr, addTree(eptr, line, column), before, "addTree", line, column);
+                    break;
+                case 1:
+                    checkEdit(eptr, mptr, removeTree(eptr, line, column), before, "removeTree", line, column);
+                    break;
+                default:
+                    /** the same change to a line and a column keeps the hints adding up */
+                    tents = rand() % 3 - 1;
+                    if (getTentsInLine(mptr, line) + tents < 0 || getTentsInColumn(mptr, column) + tents < 0) tents = 1;
+                    changeLineHint(eptr, line, getTentsInLine(mptr, line) + tents);
+                    saveCells(mptr, before);
+                    checkEdit(eptr, mptr, changeColumnHint(eptr, column, getTentsInColumn(mptr, column) + tents), before, "changeHint", line, column);
+                    break;
+            }
+        }
+
+        /** hints out of the map are refused and change nothing */
+        saveCells(mptr, before);
+        tents = getTentsNumber(mptr);
+        if (changeLineHint(eptr, lines, 0) != -1 || changeLineHint(eptr, -1, 0) != -1 || changeColumnHint(eptr, columns, 0) != -1 || changeColumnHint(eptr, -1, 0) != -1 || getTentsNumber(mptr) != tents || !sameGrid(mptr, before)) {
+            printf("map %d: hint out of the map was applied\n", m);
+            failures++;
+        }
+
+        deleteEditor(eptr);
+        deleteMap(mptr);
+    }
+
+    free(before);
+    printf("edits %d failures %d\n", edits, failures);
+
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/**
+ * Function: randomMap
+ * 
+ * Description: builds a map with trees and hints taken from a random placement of tents, so
+ *              most maps have a solution
+ * 
+ * Arguments:
+ *     int lines - number of lines
+ *     int columns - number of columns
+ * 
+ * Return value: pointer to new map
+ */
+map *randomMap(int lines, int columns) {
+    int lineHints[TEST_MAX_SIDE] = {0}, columnHints[TEST_MAX_SIDE] = {0}, tents = 0, open, line, column;
+    char grid[TEST_MAX_SIDE][TEST_MAX_SIDE + 1];
+    int dx[] = {-1, 0, 0, 1}, dy[] = {0, -1, 1, 0};
+    map *mptr;
+
+    for (int i = 0; i < lines; i++) {
+        memset(grid[i], '.', columns);
+        grid[i][columns] = '\0';
+    }
+
+    for (int k = 0; k < lines * columns / 5; k++) {
+        line = rand() % lines;
+        column = rand() % columns;
+        open = grid[line][column] == '.';
+        for (int i = line - 1; i <= line + 1 && open; i++) {
+            for (int j = column - 1; j <= column + 1; j++) {
+                if (i >= 0 && i < lines && j >= 0 && j < columns && grid[i][j] == 'T') open = 0;
+            }
+        }
+        if (!open) continue;
+        for (int t = 0, d = rand() % 4; t < 4; t++, d = (d + 1) % 4) {
+            if (line + dx[d] < 0 || line + dx[d] >= lines || column + dy[d] < 0 || column + dy[d] >= columns) continue;
+            if (grid[line + dx[d]][column + dy[d]] != '.') continue;
+            grid[line][column] = 'T';
+            grid[line + dx[d]][column + dy[d]] = 'A';
+            lineHints[line]++;
+            columnHints[column]++;
+            tents++;
+            break;
+        }
+    }
+
+    mptr = newMap(lines, columns);
+    if (mptr == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < lines; i++) {
+        for (int j = 0; j < columns; j++) {
+            if (grid[i][j] == 'T') grid[i][j] = '.';
+        }
+        setMapLine(mptr, i, grid[i]);
+    }
+    setTentsInfo(mptr, lineHints, columnHints);
+    setTentsNumber(mptr, tents);
+
+    return mptr;
+}
+
+/**
+ * Function: freshCopy
+ * 
+ * Description: copies a map keeping only its trees and hints, as if it had just been read
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value: pointer to new map
+ */
+map *freshCopy(map *mptr) {
+    map *copy;
+
+    copy = copyMap(mptr);
+    if (copy == NULL) exit(EXIT_FAILURE);
+    for (int i = 0; i < getMapLines(copy); i++) {
+        for (int j = 0; j < getMapColumns(copy); j++) {
+            if (getContentOfPosition(copy, i, j) != 'A') setContentOfPosition(copy, i, j, '.');
+        }
+    }
+    setTreesNumber(copy, 0);
+    setUncertainCount(copy, 0);
+
+    return copy;
+}
+
+/**
+ * Function: validSolution
+ * 
+ * Description: checks that the tents of a map meet every hint, do not touch each other and
+ *              each have a tree of their own next to them
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ * 
+ * Return value:
+ *     1 - if map holds a solution
+ *     0 - otherwise
+ */
+int validSolution(map *mptr) {
+    int lines = getMapLines(mptr), columns = getMapColumns(mptr), count;
+    int used[TEST_MAX_SIDE * TEST_MAX_SIDE] = {0};
+    char visited[TEST_MAX_SIDE * TEST_MAX_SIDE];
+
+    for (int i = 0; i < lines; i++) {
+        count = 0;
+        for (int j = 0; j < columns; j++) count += getContentOfPosition(mptr, i, j) == 'T';
+        if (count != getTentsInLine(mptr, i)) return 0;
+    }
+    for (int j = 0; j < columns; j++) {
+        count = 0;
+        for (int i = 0; i < lines; i++) count += getContentOfPosition(mptr, i, j) == 'T';
+        if (count != getTentsInColumn(mptr, j)) return 0;
+    }
+
+    for (int i = 0; i < lines; i++) {
+        for (int j = 0; j < columns; j++) {
+            if (getContentOfPosition(mptr, i, j) != 'T') continue;
+            for (int di = -1; di <= 1; di++) {
+                for (int dj = -1; dj <= 1; dj++) {
+                    if ((di || dj) && getContentOfPosition(mptr, i + di, j + dj) == 'T') return 0;
+                }
+            }
+            memset(visited, 0, sizeof(visited));
+            if (!matchTree(mptr, i, j, used, visited)) return 0;
+        }
+    }
+
+    return 1;
+}
+
+/**
+ * Function: matchTree
+ * 
+ * Description: gives a tent a tree next to it, moving trees given to other tents along an
+ *              augmenting path if needed
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     int line - line of tent
+ *     int column - column of tent
+ *     int *used - tent each tree was given to plus one (0 for none), by cell index
+ *     char *visited - trees already tried, by cell index
+ * 
+ * Return value:
+ *     1 - if tent got a tree
+ *     0 - otherwise
+ */
+int matchTree(map *mptr, int line, int column, int *used, char *visited) {
+    int dx[] = {-1, 0, 0, 1}, dy[] = {0, -1, 1, 0}, columns = getMapColumns(mptr), tree, tent;
+
+    for (int d = 0; d < 4; d++) {
+        if (getContentOfPosition(mptr, line + dx[d], column + dy[d]) != 'A') continue;
+        tree = (line + dx[d]) * columns + column + dy[d];
+        if (visited[tree]) continue;
+        visited[tree] = 1;
+        tent = used[tree] - 1;
+        if (tent < 0 || matchTree(mptr, tent / columns, tent % columns, used, visited)) {
+            used[tree] = line * columns + column + 1;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Function: sameGrid
+ * 
+ * Description: compares the cells of a map with cells saved by saveCells
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     char *grid - saved cells
+ * 
+ * Return value:
+ *     1 - if every cell is the same
+ *     0 - otherwise
+ */
+int sameGrid(map *mptr, char *grid) {
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            if (getContentOfPosition(mptr, i, j) != grid[i * getMapColumns(mptr) + j]) return 0;
+        }
+    }
+    return 1;
+}
+
+/**
+ * Function: saveCells
+ * 
+ * Description: saves the cells of a map
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     char *grid - buffer of lines * columns cells
+ * 
+ * Return value: none
+ */
+void saveCells(map *mptr, char *grid) {
+    for (int i = 0; i < getMapLines(mptr); i++) {
+        for (int j = 0; j < getMapColumns(mptr); j++) {
+            grid[i * getMapColumns(mptr) + j] = getContentOfPosition(mptr, i, j);
+        }
+    }
+}
+
+/**
+ * Function: checkEdit
+ * 
+ * Description: compares the result of an edit with a fresh solveMap of the edited map. A
+ *              solution must be valid, an impossible map must keep the cells it had before the
+ *              edit (but the edited cell)
+ * 
+ * Arguments:
+ *     editor *eptr - editor pointer
+ *     map *mptr - edited map
+ *     int result - value returned by the edit
+ *     char *before - cells of map before the edit
+ *     const char *edit - name of edit, for failures
+ *     int line - line edited
+ *     int column - column edited
+ * 
+ * Return value:
+ *     1 - if edit agrees with a fresh solve
+ *     0 - otherwise
+ */
+int checkEdit(editor *eptr, map *mptr, int result, char *before, const char *edit, int line, int column) {
+    int expected, columns = getMapColumns(mptr);
+    map *fresh;
+
+    fresh = freshCopy(mptr);
+    expected = solveMap(fresh);
+    if (expected != 1) expected = -1;
+
+    if (result == -1) before[line * columns + column] = getContentOfPosition(mptr, line, column);
+    if (result != expected || (result == 1 && !validSolution(mptr)) || (result == -1 && !sameGrid(mptr, before))) {
+        printf("%s %d %d on %dx%d map: result %d, fresh solve %d%s\n", edit, line, column, getMapLines(mptr), columns, result, expected,
+               result == 1 && !validSolution(mptr) ? ", solution not valid" : result == -1 && !sameGrid(mptr, before) ? ", grid changed" : "");
+        failures++;
+        deleteMap(fresh);
+        return 0;
+    }
+
+    deleteMap(fresh);
+    return 1;
+}
@@ -0,0 +1,249 @@
+/**
+ * Filename: trace.c
+ * 
+ * Description: Optional tracing of solver phases as Chrome trace events, with hardware counters
+ *              around every solve. Empty unless compiled with TRACE defined
+ */
+
+#define _GNU_SOURCE
+
+#include "trace.h"
+
+#ifdef TRACE
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#define COUNTERS 4
+#define COUNTERS_UNOPENED 0
+#define COUNTERS_OPEN 1
+#define COUNTERS_UNAVAILABLE -1
+
+struct {
+    uint64_t config;
+    char *name;
+} counterEvents[COUNTERS] = {
+    {PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+    {PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+    {PERF_COUNT_HW_CACHE_MISSES, "cacheMisses"},
+    {PERF_COUNT_HW_BRANCH_MISSES, "branchMisses"}
+};
+
+FILE *traceFile = NULL;
+pthread_mutex_t traceLock = PTHREAD_MUTEX_INITIALIZER;
+struct timespec traceStart;
+long traceEvents = 0;
+
+/**
+ * Counters of a thread are one perf event group led by the first counter that opened, counters
+ * the hardware lacks are left out (counterFds[i] is -1) and read as a group in opening order.
+ */
+__thread int counterState = COUNTERS_UNOPENED;
+__thread int counterFds[COUNTERS];
+__thread int counterLeader;
+
+void closeTrace(void);
+void writeEvent(const char *name, char phase, const char *args);
+void openCounters(void);
+
+/**
+ * Function: openTrace
+ * 
+ * Description: starts writing trace events (a JSON array for chrome://tracing or Perfetto) to a
+ *              file, which is closed at exit
+ * 
+ * Arguments:
+ *     char *filename - name of trace file
+ * 
+ * Return value:
+ *     1 - if trace file was opened
+ *     0 - otherwise
+ */
+int openTrace(char *filename) {
+    traceFile = fopen(filename, "w");
+    if (traceFile == NULL) return 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &traceStart);
+    fprintf(traceFile, "[\n");
+    atexit(closeTrace);
+
+    return 1;
+}
+
+/**
+ * Function: closeTrace
+ * 
+ * Description: ends the JSON array of trace events and closes trace file
+ * 
+ * Arguments: none
+ * 
+ * Return value: none
+ */
+void closeTrace(void) {
+    pthread_mutex_lock(&traceLock);
+    fprintf(traceFile, "\n]\n");
+    fclose(traceFile);
+    traceFile = NULL;
+    pthread_mutex_unlock(&traceLock);
+}
+
+/**
+ * Function: traceBegin
+ * 
+ * Description: opens a span of the calling thread
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceBegin(const char *name) {
+    writeEvent(name, 'B', "");
+}
+
+/**
+ * Function: traceEnd
+ * 
+ * Description: closes the last span opened by the calling thread
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceEnd(const char *name) {
+    writeEvent(name, 'E', "");
+}
+
+/**
+ * Function: traceCountersBegin
+ * 
+ * Description: opens a span of the calling thread and starts its hardware counters (cycles,
+ *              instructions, cache misses, branch misses), opened on first use. Without
+ *              permission for perf_event_open spans are still written, without counters
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceCountersBegin(const char *name) {
+    if (traceFile == NULL) return;
+
+    writeEvent(name, 'B', "");
+
+    if (counterState == COUNTERS_UNOPENED) openCounters();
+    if (counterState == COUNTERS_OPEN) {
+        ioctl(counterLeader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(counterLeader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+}
+
+/**
+ * Function: traceCountersEnd
+ * 
+ * Description: stops the hardware counters of the calling thread and closes its last span
+ *              with their values as arguments
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceCountersEnd(const char *name) {
+    uint64_t values[COUNTERS + 1];
+    char args[256];
+    int length, k = 1;
+
+    if (traceFile == NULL) return;
+
+    if (counterState != COUNTERS_OPEN) {
+        writeEvent(name, 'E', ",\"args\":{\"counters\":\"unavailable\"}");
+        return;
+    }
+
+    ioctl(counterLeader, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+    if (read(counterLeader, values, sizeof(values)) < (ssize_t) (2 * sizeof(uint64_t))) {
+        writeEvent(name, 'E', ",\"args\":{\"counters\":\"unavailable\"}");
+        return;
+    }
+
+    length = sprintf(args, ",\"args\":{");
+    for (int i = 0; i < COUNTERS; i++) {
+        if (counterFds[i] == -1) continue;
+        length += sprintf(args + length, "%s\"%s\":%llu", k > 1 ? "," : "", counterEvents[i].name, (unsigned long long) values[k]);
+        k++;
+    }
+    sprintf(args + length, "}");
+
+    writeEvent(name, 'E', args);
+}
+
+/**
+ * Function: writeEvent
+ * 
+ * Description: writes a trace event of the calling thread, timed from the opening of the trace
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ *     char phase - 'B' (begin) or 'E' (end)
+ *     const char *args - extra JSON members of event (starting with a comma) or ""
+ * 
+ * Return value: none
+ */
+void writeEvent(const char *name, char phase, const char *args) {
+    struct timespec now;
+    double microseconds;
+
+    if (traceFile == NULL) return;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    microseconds = (now.tv_sec - traceStart.tv_sec) * 1e6 + (now.tv_nsec - traceStart.tv_nsec) / 1e3;
+
+    pthread_mutex_lock(&traceLock);
+    if (traceFile != NULL) {
+        fprintf(traceFile, "%s{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%ld%s}", traceEvents++ ? ",\n" : "", name, phase, microseconds, (int) getpid(), (long) syscall(SYS_gettid), args);
+    }
+    pthread_mutex_unlock(&traceLock);
+}
+
+/**
+ * Function: openCounters
+ * 
+ * Description: opens hardware counters of the calling thread (user space only, so that a
+ *              restrictive perf_event_paranoid still allows them), disabled until a span starts
+ * 
+ * Arguments: none
+ * 
+ * Return value: none
+ */
+void openCounters(void) {
+    struct perf_event_attr attr;
+
+    counterLeader = -1;
+    for (int i = 0; i < COUNTERS; i++) {
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = counterEvents[i].config;
+        attr.disabled = counterLeader == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP;
+
+        counterFds[i] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, counterLeader, 0);
+        if (counterFds[i] != -1 && counterLeader == -1) counterLeader = counterFds[i];
+    }
+
+    counterState = counterLeader == -1 ? COUNTERS_UNAVAILABLE : COUNTERS_OPEN;
+}
+
+#endif
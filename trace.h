@@ -0,0 +1,94 @@
+/**
+ * Filename: trace.h
+ * 
+ * Description: Optional tracing of solver phases as Chrome trace events, with hardware counters
+ *              around every solve. Only compiled in when TRACE is defined ("make trace"), the
+ *              TRACE_ macros expand to nothing otherwise
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#ifdef TRACE
+
+#define TRACE_BEGIN(name) traceBegin(name)
+#define TRACE_END(name) traceEnd(name)
+#define TRACE_COUNTERS_BEGIN(name) traceCountersBegin(name)
+#define TRACE_COUNTERS_END(name) traceCountersEnd(name)
+
+/**
+ * Function: openTrace
+ * 
+ * Description: starts writing trace events (a JSON array for chrome://tracing or Perfetto) to a
+ *              file, which is closed at exit
+ * 
+ * Arguments:
+ *     char *filename - name of trace file
+ * 
+ * Return value:
+ *     1 - if trace file was opened
+ *     0 - otherwise
+ */
+int openTrace(char *filename);
+
+/**
+ * Function: traceBegin
+ * 
+ * Description: opens a span of the calling thread
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceBegin(const char *name);
+
+/**
+ * Function: traceEnd
+ * 
+ * Description: closes the last span opened by the calling thread
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceEnd(const char *name);
+
+/**
+ * Function: traceCountersBegin
+ * 
+ * Description: opens a span of the calling thread and starts its hardware counters (cycles,
+ *              instructions, cache misses, branch misses), opened on first use. Without
+ *              permission for perf_event_open spans are still written, without counters
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceCountersBegin(const char *name);
+
+/**
+ * Function: traceCountersEnd
+ * 
+ * Description: stops the hardware counters of the calling thread and closes its last span
+ *              with their values as arguments
+ * 
+ * Arguments:
+ *     const char *name - name of span
+ * 
+ * Return value: none
+ */
+void traceCountersEnd(const char *name);
+
+#else
+
+#define TRACE_BEGIN(name)
+#define TRACE_END(name)
+#define TRACE_COUNTERS_BEGIN(name)
+#define TRACE_COUNTERS_END(name)
+
+#endif
+
+#endif
@@ -0,0 +1,566 @@
+/**
+ * Filename: verify.c
+ * 
+ * Description: Linear time checking of the solutions of a .tents file against its maps
+ */
+
+#include "verify.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "io.h"
+#include "map.h"
+#include "pool.h"
+#include "rowscan.h"
+
+/** maps read before waiting for the workers, and words of solution bitmasks read before it */
+#define VERIFY_BATCH 1024
+#define VERIFY_BATCH_WORDS (1L << 24)
+
+/**
+ * A solution is kept as tree and tent bitmasks of ROW_WORDS(columns) words per line, so that
+ * hints, touching tents and tents away from trees are checked a word at a time. The matching
+ * of tents to trees first takes every tent (tree) with a single free tree (tent) around it,
+ * which some maximum matching always does, and only searches augmenting paths among what is
+ * left, mostly even cycles of tents and trees where the first path found closes
+ */
+typedef struct {
+    map *mptr;
+    int lines;
+    int columns;
+    int result;
+    uint64_t *trees;
+    uint64_t *tents;
+    const char *verdict;
+} check;
+
+typedef struct {
+    int tentsNumber;
+    int treesNumber;
+    int *tentTrees;
+    int *tentFree;
+    int *tentMatch;
+    int *treeTents;
+    int *treeDegree;
+    int *treeFree;
+    int *treeMatch;
+    int *treeSeen;
+    char *treeFixed;
+    int *queue;
+    int *stack;
+    int *via;
+    int *next;
+} matching;
+
+int readSolution(FILE *fp, check *cptr);
+void checkTask(void *arg, int worker);
+const char *checkSolution(check *cptr);
+uint64_t shiftedUp(uint64_t *row, int w);
+uint64_t shiftedDown(uint64_t *row, int w, int words);
+int matchSolutionTents(check *cptr, int *treeStart, int treesNumber, int tentsNumber);
+int treeIndex(check *cptr, int *treeStart, int line, int column);
+void pairTent(matching *mt, int tent, int tree, int *tail, int *possible);
+int augmentTent(matching *mt, int tent, int stamp);
+void writeChecks(check *checks, int count, FILE *log, long long *verdicts);
+
+/**
+ * Function: runVerify
+ * 
+ * Description: checks every solution of a .tents file against the map of a .camp file it
+ *              answers, on a pool of workers, without solving any map. A solution must keep
+ *              the trees of its map, meet the hints of every line and column, have no two
+ *              tents touching (not even diagonally) and give every tent a different tree next
+ *              to it. Maps claimed impossible are only confirmed when their hints already make
+ *              them impossible, otherwise they are left unchecked
+ * 
+ * Arguments:
+ *     FILE *fpMaps - file with the maps
+ *     FILE *fpSolutions - file with the solutions
+ *     FILE *log - file where a line "lines columns verdict" is written per map, in input
+ *                 order, with the number of maps of every verdict at the end
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     1 - if no solution is wrong
+ *     0 - if some solution is wrong, malformed or missing
+ *     READ_ERROR - if the maps are malformed (maps before them are checked)
+ */
+int runVerify(FILE *fpMaps, FILE *fpSolutions, FILE *log, int workers) {
+    check *checks, *cptr;
+    pool *pptr;
+    long long words = 0, verdicts[3] = {0, 0, 0};
+    int count = 0, ret, lines, columns, result, solutions = 1;
+
+    checks = (check *) malloc(VERIFY_BATCH * sizeof(check));
+    if (checks == NULL) exit(EXIT_FAILURE);
+
+    pptr = newPool(workers);
+    if (pptr == NULL) exit(EXIT_FAILURE);
+
+    while ((ret = readMap(fpMaps, &checks[count].mptr, &lines, &columns, &result)) == 1) {
+        cptr = &checks[count++];
+        cptr->trees = cptr->tents = NULL;
+        cptr->verdict = NULL;
+
+        /** solutions after a malformed one can't be told apart */
+        if (solutions) solutions = readSolution(fpSolutions, cptr);
+        if (solutions == READ_ERROR) cptr->verdict = "malformed";
+        else if (!solutions) cptr->verdict = "missing";
+        else if (cptr->lines != lines || cptr->columns != columns) cptr->verdict = "size";
+        if (solutions == READ_ERROR) solutions = 0;
+
+        cptr->lines = lines;
+        cptr->columns = columns;
+        if (cptr->verdict == NULL) submitTask(pptr, checkTask, cptr);
+
+        if (cptr->trees != NULL) words += (long long) lines * ROW_WORDS(columns);
+        if (count == VERIFY_BATCH || words >= VERIFY_BATCH_WORDS) {
+            waitPool(pptr);
+            writeChecks(checks, count, log, verdicts);
+            count = 0;
+            words = 0;
+        }
+    }
+    waitPool(pptr);
+    writeChecks(checks, count, log, verdicts);
+    fprintf(log, "# maps %lld ok %lld unchecked %lld wrong %lld\n", verdicts[0] + verdicts[1] + verdicts[2], verdicts[0], verdicts[1], verdicts[2]);
+
+    deletePool(pptr);
+    free(checks);
+
+    if (ret == READ_ERROR) return READ_ERROR;
+    return verdicts[2] == 0;
+}
+
+/**
+ * Function: readSolution
+ * 
+ * Description: reads the next solution of a .tents file (the number of solutions a header may
+ *              carry is skipped), turning its lines into bitmasks
+ * 
+ * Arguments:
+ *     FILE *fp - file pointer
+ *     check *cptr - returns lines, columns and result of solution and, if result is 1, its
+ *                   tree and tent bitmasks
+ * 
+ * Return value:
+ *     1 - if a solution was read
+ *     0 - if EOF
+ *     READ_ERROR - if solution is malformed
+ */
+int readSolution(FILE *fp, check *cptr) {
+    int ret, c, words, others, wellFormed = 1;
+    long long count;
+    char *lineString;
+
+    ret = fscanf(fp, "%d %d %d", &cptr->lines, &cptr->columns, &cptr->result);
+    if (ret == EOF) return 0;
+    if (ret != 3 || cptr->lines < 0 || cptr->columns < 0) return READ_ERROR;
+
+    while ((c = getc(fp)) == ' ' || c == '\t')
+        ;
+    ungetc(c, fp);
+    if ((isdigit(c) || c == '-') && fscanf(fp, "%lld", &count) != 1) return READ_ERROR;
+
+    if (cptr->result != 1) return 1;
+
+    words = ROW_WORDS(cptr->columns);
+    cptr->trees = (uint64_t *) malloc(((long) cptr->lines * words + 1) * sizeof(uint64_t));
+    if (cptr->trees == NULL) exit(EXIT_FAILURE);
+
+    cptr->tents = (uint64_t *) malloc(((long) cptr->lines * words + 1) * sizeof(uint64_t));
+    if (cptr->tents == NULL) exit(EXIT_FAILURE);
+
+    lineString = (char *) malloc((cptr->columns + 1) * sizeof(char));
+    if (lineString == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < cptr->lines && wellFormed; i++) {
+        wellFormed = readGridLine(fp, lineString, cptr->columns);
+        if (wellFormed) scanSolutionRow(lineString, cptr->columns, cptr->trees + (long) i * words, cptr->tents + (long) i * words, &others);
+        wellFormed = wellFormed && others == 0;
+    }
+    free(lineString);
+
+    return wellFormed ? 1 : READ_ERROR;
+}
+
+/**
+ * Function: checkTask
+ * 
+ * Description: pool task giving the verdict of a solution
+ * 
+ * Arguments:
+ *     void *arg - check of solution
+ *     int worker - number of worker running the task
+ * 
+ * Return value: none
+ */
+void checkTask(void *arg, int worker) {
+    check *cptr = (check *) arg;
+
+    if (cptr->result != 1)
+        cptr->verdict = cptr->result == -1 && cptr->mptr == NULL ? "ok" : "unchecked";
+    else if (cptr->mptr == NULL)
+        cptr->verdict = "hints";
+    else
+        cptr->verdict = checkSolution(cptr);
+}
+
+/**
+ * Function: checkSolution
+ * 
+ * Description: checks a solution against its map line by line, a word of 64 cells at a time,
+ *              then matches its tents to trees
+ * 
+ * Arguments:
+ *     check *cptr - check of solution, with the map and the bitmasks of the solution
+ * 
+ * Return value:
+ *     verdict of solution
+ */
+const char *checkSolution(check *cptr) {
+    map *mptr = cptr->mptr;
+    int lines = cptr->lines, columns = cptr->columns, words = ROW_WORDS(columns);
+    int treesNumber = 0, tentsNumber = 0, lineTents, possible;
+    int *columnTents, *treeStart;
+    uint64_t *row, *tents, *trees, tent, near, bits;
+    const char *verdict = NULL;
+
+    row = (uint64_t *) malloc((words + 1) * sizeof(uint64_t));
+    if (row == NULL) exit(EXIT_FAILURE);
+
+    columnTents = (int *) calloc(columns + 1, sizeof(int));
+    if (columnTents == NULL) exit(EXIT_FAILURE);
+
+    /** number of trees before every word, so that trees are numbered in constant time */
+    treeStart = (int *) malloc(((long) lines * words + 1) * sizeof(int));
+    if (treeStart == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < lines && verdict == NULL; i++) {
+        trees = cptr->trees + (long) i * words;
+        tents = cptr->tents + (long) i * words;
+        scanRow(getMapLine(mptr, i), columns, row, NULL);
+
+        lineTents = 0;
+        for (int w = 0; w < words && verdict == NULL; w++) {
+            tent = tents[w];
+            near = shiftedUp(trees, w) | shiftedDown(trees, w, words);
+            if (i > 0) near |= trees[w - words];
+            if (i + 1 < lines) near |= trees[w + words];
+
+            /** a tent to the left of a tent, or in any of the three cells above it */
+            if (trees[w] != row[w])
+                verdict = "trees";
+            else if (tent & shiftedUp(tents, w))
+                verdict = "touching";
+            else if (i > 0 && tent & (tents[w - words] | shiftedUp(tents - words, w) | shiftedDown(tents - words, w, words)))
+                verdict = "touching";
+            else if (tent & ~near)
+                verdict = "unmatched";
+
+            for (bits = tent; bits; bits &= bits - 1) columnTents[64 * w + __builtin_ctzll(bits)]++;
+            lineTents += __builtin_popcountll(tent);
+            treeStart[(long) i * words + w] = treesNumber;
+            treesNumber += __builtin_popcountll(trees[w]);
+        }
+        if (verdict == NULL && lineTents != getTentsInLine(mptr, i)) verdict = "lines";
+        tentsNumber += lineTents;
+    }
+
+    for (int j = 0; j < columns && verdict == NULL; j++) {
+        if (columnTents[j] != getTentsInColumn(mptr, j)) verdict = "columns";
+    }
+
+    if (verdict == NULL) {
+        possible = tentsNumber <= treesNumber && matchSolutionTents(cptr, treeStart, treesNumber, tentsNumber);
+        verdict = possible ? "ok" : "unmatched";
+    }
+
+    free(row);
+    free(columnTents);
+    free(treeStart);
+
+    return verdict;
+}
+
+/**
+ * Function: shiftedUp
+ * 
+ * Description: gets a word of a line bitmask moved one column to the right, i.e. the bits of
+ *              the cells to the left of every cell of the word
+ * 
+ * Arguments:
+ *     uint64_t *row - line bitmask
+ *     int w - index of word
+ * 
+ * Return value:
+ *     shifted word
+ */
+uint64_t shiftedUp(uint64_t *row, int w) {
+    return row[w] << 1 | (w > 0 ? row[w - 1] >> 63 : 0);
+}
+
+/**
+ * Function: shiftedDown
+ * 
+ * Description: gets a word of a line bitmask moved one column to the left, i.e. the bits of
+ *              the cells to the right of every cell of the word
+ * 
+ * Arguments:
+ *     uint64_t *row - line bitmask
+ *     int w - index of word
+ *     int words - number of words of line
+ * 
+ * Return value:
+ *     shifted word
+ */
+uint64_t shiftedDown(uint64_t *row, int w, int words) {
+    return row[w] >> 1 | (w + 1 < words ? row[w + 1] << 63 : 0);
+}
+
+/**
+ * Function: matchSolutionTents
+ * 
+ * Description: checks if every tent of a solution can get a different tree next to it
+ * 
+ * Arguments:
+ *     check *cptr - check of solution
+ *     int *treeStart - number of trees before every word of the tree bitmasks
+ *     int treesNumber - number of trees
+ *     int tentsNumber - number of tents
+ * 
+ * Return value:
+ *     1 - if every tent gets a tree
+ *     0 - otherwise
+ */
+int matchSolutionTents(check *cptr, int *treeStart, int treesNumber, int tentsNumber) {
+    int words = ROW_WORDS(cptr->columns), tent = 0, tree, line, column, head = 0, tail = 0, possible = 1;
+    int dl[4] = {-1, 1, 0, 0}, dc[4] = {0, 0, -1, 1};
+    uint64_t bits;
+    matching mt;
+
+    mt.tentsNumber = tentsNumber;
+    mt.treesNumber = treesNumber;
+    mt.tentTrees = (int *) malloc((4L * tentsNumber + 1) * sizeof(int));
+    mt.tentFree = (int *) calloc(tentsNumber + 1, sizeof(int));
+    mt.tentMatch = (int *) malloc((tentsNumber + 1) * sizeof(int));
+    mt.treeTents = (int *) malloc((4L * treesNumber + 1) * sizeof(int));
+    mt.treeDegree = (int *) calloc(treesNumber + 1, sizeof(int));
+    mt.treeFree = (int *) malloc((treesNumber + 1) * sizeof(int));
+    mt.treeMatch = (int *) malloc((treesNumber + 1) * sizeof(int));
+    mt.treeSeen = (int *) calloc(treesNumber + 1, sizeof(int));
+    mt.treeFixed = (char *) calloc(treesNumber + 1, sizeof(char));
+    mt.queue = (int *) malloc(((long) tentsNumber + treesNumber + 1) * sizeof(int));
+    mt.stack = (int *) malloc((tentsNumber + 1) * sizeof(int));
+    mt.via = (int *) malloc((tentsNumber + 1) * sizeof(int));
+    mt.next = (int *) malloc((tentsNumber + 1) * sizeof(int));
+    if (mt.tentTrees == NULL || mt.tentFree == NULL || mt.tentMatch == NULL || mt.treeTents == NULL || mt.treeDegree == NULL || mt.treeFree == NULL || mt.treeMatch == NULL || mt.treeSeen == NULL || mt.treeFixed == NULL || mt.queue == NULL || mt.stack == NULL || mt.via == NULL || mt.next == NULL) exit(EXIT_FAILURE);
+
+    for (int i = 0; i < cptr->lines; i++) {
+        for (int w = 0; w < words; w++) {
+            for (bits = cptr->tents[(long) i * words + w]; bits; bits &= bits - 1) {
+                for (int k = 0; k < 4; k++) {
+                    line = i + dl[k];
+                    column = 64 * w + __builtin_ctzll(bits) + dc[k];
+                    tree = treeIndex(cptr, treeStart, line, column);
+                    mt.tentTrees[4 * tent + k] = tree;
+                    if (tree < 0) continue;
+                    mt.treeTents[4 * tree + mt.treeDegree[tree]++] = tent;
+                    mt.tentFree[tent]++;
+                }
+                mt.tentMatch[tent] = -1;
+                if (mt.tentFree[tent] == 0) possible = 0;
+                if (mt.tentFree[tent] == 1) mt.queue[tail++] = tent;
+                tent++;
+            }
+        }
+    }
+    for (int r = 0; r < treesNumber; r++) {
+        mt.treeMatch[r] = -1;
+        mt.treeFree[r] = mt.treeDegree[r];
+        if (mt.treeFree[r] == 1) mt.queue[tail++] = tentsNumber + r;
+    }
+
+    /** a tent (tree) with a single free tree (tent) left takes it */
+    while (head < tail && possible) {
+        tent = mt.queue[head++];
+        if (tent < tentsNumber) {
+            if (mt.tentMatch[tent] >= 0) continue;
+            for (int k = 0; k < 4; k++) {
+                tree = mt.tentTrees[4 * tent + k];
+                if (tree >= 0 && mt.treeMatch[tree] < 0) break;
+            }
+        } else {
+            tree = tent - tentsNumber;
+            if (mt.treeMatch[tree] >= 0 || mt.treeFree[tree] == 0) continue;
+            for (int k = 0; k < mt.treeDegree[tree]; k++) {
+                tent = mt.treeTents[4 * tree + k];
+                if (mt.tentMatch[tent] < 0) break;
+            }
+        }
+        mt.treeFixed[tree] = 1;
+        pairTent(&mt, tent, tree, &tail, &possible);
+    }
+
+    for (int t = 0; t < tentsNumber && possible; t++) {
+        if (mt.tentMatch[t] < 0) possible = augmentTent(&mt, t, t + 1);
+    }
+
+    free(mt.tentTrees);
+    free(mt.tentFree);
+    free(mt.tentMatch);
+    free(mt.treeTents);
+    free(mt.treeDegree);
+    free(mt.treeFree);
+    free(mt.treeMatch);
+    free(mt.treeSeen);
+    free(mt.treeFixed);
+    free(mt.queue);
+    free(mt.stack);
+    free(mt.via);
+    free(mt.next);
+
+    return possible;
+}
+
+/**
+ * Function: treeIndex
+ * 
+ * Description: numbers the tree on a cell, trees being numbered in line order
+ * 
+ * Arguments:
+ *     check *cptr - check of solution
+ *     int *treeStart - number of trees before every word of the tree bitmasks
+ *     int line - line of cell
+ *     int column - column of cell
+ * 
+ * Return value:
+ *     number of tree
+ *     -1 if cell is outside the map or not a tree
+ */
+int treeIndex(check *cptr, int *treeStart, int line, int column) {
+    int words = ROW_WORDS(cptr->columns);
+    uint64_t word;
+
+    if (line < 0 || line >= cptr->lines || column < 0 || column >= cptr->columns) return -1;
+
+    word = cptr->trees[(long) line * words + column / 64];
+    if (!(word >> (column % 64) & 1)) return -1;
+
+    return treeStart[(long) line * words + column / 64] + __builtin_popcountll(word & (((uint64_t) 1 << (column % 64)) - 1));
+}
+
+/**
+ * Function: pairTent
+ * 
+ * Description: matches a tent to a tree, queueing the tents and trees around them left with a
+ *              single free tree or tent
+ * 
+ * Arguments:
+ *     matching *mt - matching of solution
+ *     int tent - number of tent
+ *     int tree - number of tree
+ *     int *tail - end of queue
+ *     int *possible - set to 0 if a tent is left without free trees
+ * 
+ * Return value: none
+ */
+void pairTent(matching *mt, int tent, int tree, int *tail, int *possible) {
+    int other;
+
+    mt->tentMatch[tent] = tree;
+    mt->treeMatch[tree] = tent;
+
+    for (int k = 0; k < 4; k++) {
+        other = mt->tentTrees[4 * tent + k];
+        if (other < 0 || mt->treeMatch[other] >= 0) continue;
+        if (--mt->treeFree[other] == 1) mt->queue[(*tail)++] = mt->tentsNumber + other;
+    }
+
+    for (int k = 0; k < mt->treeDegree[tree]; k++) {
+        other = mt->treeTents[4 * tree + k];
+        if (mt->tentMatch[other] >= 0) continue;
+        if (--mt->tentFree[other] == 0) *possible = 0;
+        else if (mt->tentFree[other] == 1) mt->queue[(*tail)++] = other;
+    }
+}
+
+/**
+ * Function: augmentTent
+ * 
+ * Description: looks for an augmenting path from a free tent through trees not fixed by the
+ *              single choices, with an explicit stack, and flips the matching along it
+ * 
+ * Arguments:
+ *     matching *mt - matching of solution
+ *     int tent - number of free tent
+ *     int stamp - mark of trees visited by this search (different for every search)
+ * 
+ * Return value:
+ *     1 - if tent got a tree
+ *     0 - otherwise
+ */
+int augmentTent(matching *mt, int tent, int stamp) {
+    int depth = 1, current, tree;
+
+    mt->stack[0] = tent;
+    mt->next[tent] = 0;
+
+    while (depth > 0) {
+        current = mt->stack[depth - 1];
+        if (mt->next[current] == 4) {
+            depth--;
+            continue;
+        }
+
+        tree = mt->tentTrees[4 * current + mt->next[current]++];
+        if (tree < 0 || mt->treeFixed[tree] || mt->treeSeen[tree] == stamp) continue;
+        mt->treeSeen[tree] = stamp;
+        mt->via[depth - 1] = tree;
+
+        if (mt->treeMatch[tree] < 0) {
+            for (int d = 0; d < depth; d++) {
+                mt->tentMatch[mt->stack[d]] = mt->via[d];
+                mt->treeMatch[mt->via[d]] = mt->stack[d];
+            }
+            return 1;
+        }
+
+        current = mt->treeMatch[tree];
+        mt->next[current] = 0;
+        mt->stack[depth++] = current;
+    }
+
+    return 0;
+}
+
+/**
+ * Function: writeChecks
+ * 
+ * Description: writes the verdicts of a batch of solutions and frees them
+ * 
+ * Arguments:
+ *     check *checks - checks of batch, in input order
+ *     int count - number of checks
+ *     FILE *log - file where verdicts are written
+ *     long long *verdicts - number of solutions ok, unchecked and wrong so far (updated)
+ * 
+ * Return value: none
+ */
+void writeChecks(check *checks, int count, FILE *log, long long *verdicts) {
+    for (int i = 0; i < count; i++) {
+        fprintf(log, "%d %d %s\n", checks[i].lines, checks[i].columns, checks[i].verdict);
+        if (!strcmp(checks[i].verdict, "ok"))
+            verdicts[0]++;
+        else if (!strcmp(checks[i].verdict, "unchecked"))
+            verdicts[1]++;
+        else
+            verdicts[2]++;
+
+        deleteMap(checks[i].mptr);
+        free(checks[i].trees);
+        free(checks[i].tents);
+    }
+}
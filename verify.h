@@ -0,0 +1,36 @@
+/**
+ * Filename: verify.h
+ * 
+ * Description: Linear time checking of the solutions of a .tents file against its maps
+ */
+
+#ifndef VERIFY_H
+#define VERIFY_H
+
+#include <stdio.h>
+
+/**
+ * Function: runVerify
+ * 
+ * Description: checks every solution of a .tents file against the map of a .camp file it
+ *              answers, on a pool of workers, without solving any map. A solution must keep
+ *              the trees of its map, meet the hints of every line and column, have no two
+ *              tents touching (not even diagonally) and give every tent a different tree next
+ *              to it. Maps claimed impossible are only confirmed when their hints already make
+ *              them impossible, otherwise they are left unchecked
+ * 
+ * Arguments:
+ *     FILE *fpMaps - file with the maps
+ *     FILE *fpSolutions - file with the solutions
+ *     FILE *log - file where a line "lines columns verdict" is written per map, in input
+ *                 order, with the number of maps of every verdict at the end
+ *     int workers - number of worker threads
+ * 
+ * Return value:
+ *     1 - if no solution is wrong
+ *     0 - if some solution is wrong, malformed or missing
+ *     READ_ERROR - if the maps are malformed (maps before them are checked)
+ */
+int runVerify(FILE *fpMaps, FILE *fpSolutions, FILE *log, int workers);
+
+#endif
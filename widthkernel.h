@@ -0,0 +1,402 @@
+/**
+ * Filename: widthkernel.h
+ * 
+ * Description: Solver kernels for maps whose lines fit exactly one word. This file has no
+ *              include guard on purpose, kernels.c includes it once per width after defining:
+ *              - KERNEL_WIDTH - number of columns handled
+ *              - ROW_TYPE - unsigned integer type with exactly KERNEL_WIDTH bits
+ *              - KERNEL(name) - name of a kernel function for this width
+ * 
+ *              Column j of a line is bit j of its word, every loop over columns has
+ *              KERNEL_WIDTH iterations known at compile time.
+ */
+
+#define ROW(board, line) ((ROW_TYPE) (board)[(line) + 1])
+#define BIT(column) ((ROW_TYPE) 1 << (column))
+#define BESIDE(row) ((ROW_TYPE) ((ROW_TYPE) ((row) << 1) | (ROW_TYPE) ((row) >> 1)))
+
+int KERNEL(preprocess)(map *mptr, workspace *wptr);
+void KERNEL(setCell)(map *mptr, search *sptr, cell Cell, char value);
+int KERNEL(validTent)(map *mptr, cell Cell, search *sptr);
+int KERNEL(localInjectivity)(map *mptr, cell tent, search *sptr);
+int KERNEL(treesAround)(map *mptr, search *sptr, cell Cell, int *around);
+int KERNEL(isolatedTree)(search *sptr, int line, ROW_TYPE bit);
+int KERNEL(validGrass)(map *mptr, cell Cell, search *sptr);
+int KERNEL(capacity)(ROW_TYPE cells);
+ROW_TYPE KERNEL(room)(search *sptr, int line);
+int KERNEL(lineFits)(map *mptr, search *sptr, int line);
+
+/**
+ * Function: preprocess
+ * 
+ * Description: counts trees, marks uncertain cells, builds uncertain and tree arrays and checks
+ *              hints consistency with whole line operations, leaving boards and column counters
+ *              of wptr ready for search
+ * 
+ * Side-effects: writes trees number and uncertains in mptr, fills wptr arrays and boards
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     workspace *wptr - workspace pointer
+ * 
+ * Return value:
+ *     1 - if map might have solution
+ *     0 - if map is impossible
+ */
+int KERNEL(preprocess)(map *mptr, workspace *wptr) {
+    int lines = getMapLines(mptr);
+    int boardSize = lines + 2;
+    uint64_t *trees, *uncertains, *treesBefore;
+    int *columnUncertain;
+    ROW_TYPE hinted = 0, row, bits, reach;
+    int treeCount = 0, uncertainCount = 0, deadTrees = 0, u = 0, t = 0, j;
+    char *line;
+
+    reserveBoards(wptr, lines);
+    reserveCounters(wptr, lines, KERNEL_WIDTH);
+    trees = wptr->boards;
+    uncertains = wptr->boards + 2 * boardSize;
+    treesBefore = wptr->boards + 3 * boardSize;
+    columnUncertain = wptr->columnCounters + KERNEL_WIDTH;
+
+    for (int i = 0; i < lines; i++) {
+        treesBefore[i + 1] = treeCount;
+        treeCount += scanRow(getMapLine(mptr, i), KERNEL_WIDTH, &trees[i + 1], NULL);
+    }
+    setTreesNumber(mptr, treeCount);
+    if (treeCount < getTentsNumber(mptr)) return 0;
+
+#pragma GCC unroll 64
+    for (j = 0; j < KERNEL_WIDTH; j++) {
+        if (getTentsInColumn(mptr, j)) hinted |= BIT(j);
+    }
+
+    for (int i = 0; i < lines; i++) {
+        if (!getTentsInLine(mptr, i)) continue;
+        row = (ROW(trees, i - 1) | ROW(trees, i + 1) | BESIDE(ROW(trees, i))) & (ROW_TYPE) ~ROW(trees, i) & hinted;
+        uncertains[i + 1] = row;
+        uncertainCount += __builtin_popcountll(row);
+        if (__builtin_popcountll(row) < getTentsInLine(mptr, i)) return 0;
+    }
+
+    if (treeCount == getTentsNumber(mptr) && uncertainCount < treeCount) return 0;
+
+    /** trees without uncertain cell around are dead, there is one spare tree for each */
+    for (int i = 0; i < lines; i++) {
+        reach = ROW(uncertains, i - 1) | ROW(uncertains, i + 1) | BESIDE(ROW(uncertains, i));
+        deadTrees += __builtin_popcountll(ROW(trees, i) & (ROW_TYPE) ~reach);
+    }
+    if (deadTrees > treeCount - getTentsNumber(mptr)) return 0;
+
+    reserveArrays(wptr, uncertainCount, treeCount);
+
+    for (int i = 0; i < lines; i++) {
+        line = getMapLine(mptr, i);
+        bits = ROW(trees, i) | ROW(uncertains, i);
+        while (bits) {
+            j = __builtin_ctzll(bits);
+            bits &= bits - 1;
+            if (line[j] == 'A') {
+                wptr->treeArray[t].line = i;
+                wptr->treeArray[t].column = j;
+                t++;
+            } else {
+                line[j] = 'U';
+                incrementUncertainCount(mptr);
+                columnUncertain[j]++;
+                wptr->uncertainArray[u].line = i;
+                wptr->uncertainArray[u].column = j;
+                u++;
+            }
+        }
+    }
+
+#pragma GCC unroll 64
+    for (j = 0; j < KERNEL_WIDTH; j++) {
+        if (columnUncertain[j] < getTentsInColumn(mptr, j)) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: setCell
+ * 
+ * Description: sets content of an uncertain cell during search, keeping boards, column
+ *              counters and the matching of trees to cells up to date
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search pointer
+ *     cell Cell - cell to be set
+ *     char value - 'T', '.' or 'U'
+ * 
+ * Return value: none
+ */
+void KERNEL(setCell)(map *mptr, search *sptr, cell Cell, char value) {
+    uint64_t *tents = sptr->boards + sptr->boardSize + Cell.line + 1;
+    uint64_t *uncertains = sptr->boards + 2 * sptr->boardSize + Cell.line + 1;
+    char *position = getMapLine(mptr, Cell.line) + Cell.column;
+    int wasSupport = *position == 'T' || *position == 'U', isSupport = value == 'T' || value == 'U';
+
+    if (*position == 'T') {
+        *tents &= ~BIT(Cell.column);
+        sptr->columnTents[Cell.column]--;
+    } else if (*position == 'U') {
+        *uncertains &= ~BIT(Cell.column);
+        sptr->columnUncertain[Cell.column]--;
+    }
+
+    if (value == 'T') {
+        *tents |= BIT(Cell.column);
+        sptr->columnTents[Cell.column]++;
+    } else if (value == 'U') {
+        *uncertains |= BIT(Cell.column);
+        sptr->columnUncertain[Cell.column]++;
+    }
+
+    *position = value;
+
+    /** in low season the tree matched to a cell that stops supporting a tent looks for another */
+    if (sptr->spareTrees && wasSupport && !isSupport) loseSupport(mptr, sptr, Cell);
+    if (sptr->spareTrees && isSupport && !wasSupport) gainSupport(mptr, sptr, Cell);
+}
+
+/**
+ * Function: validTent
+ * 
+ * Description: checks if tent is valid
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell Cell - tent to be validated
+ *     search *sptr - search with tree array, links (init to -1), visited arrays and boards
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int KERNEL(validTent)(map *mptr, cell Cell, search *sptr) {
+    uint64_t *tents = sptr->boards + sptr->boardSize;
+    ROW_TYPE bit = BIT(Cell.column);
+
+    if ((ROW(tents, Cell.line - 1) | ROW(tents, Cell.line + 1)) & (bit | BESIDE(bit))) return 0;
+    if (ROW(tents, Cell.line) & BESIDE(bit)) return 0;
+
+    if (__builtin_popcountll(ROW(tents, Cell.line)) > getTentsInLine(mptr, Cell.line)) return 0;
+    if (sptr->columnTents[Cell.column] > getTentsInColumn(mptr, Cell.column)) return 0;
+
+    /** in low season a tent also takes room from the lines around it */
+    if (sptr->spareTrees) {
+        for (int i = Cell.line - 1; i <= Cell.line + 1; i++) {
+            if (!KERNEL(lineFits)(mptr, sptr, i)) return 0;
+        }
+    }
+
+    memset(sptr->visited, 0, getTreesNumber(mptr));
+    if (!KERNEL(localInjectivity)(mptr, Cell, sptr)) return 0;
+
+    return 1;
+}
+
+/**
+ * Function: localInjectivity
+ * 
+ * Description: checks tent-tree injectivity i.e. theres a unique tree for a tent (locally)
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell tent - tent to be validated
+ *     search *sptr - search with tree array, links (init to -1), visited arrays and boards
+ * 
+ * Return value:
+ *     1 - if tent is valid
+ *     0 - if tent is invalid
+ */
+int KERNEL(localInjectivity)(map *mptr, cell tent, search *sptr) {
+    cell *links = sptr->links;
+    char *visited = sptr->visited;
+    int around[4], count, i;
+    char c;
+
+    count = KERNEL(treesAround)(mptr, sptr, tent, around);
+    for (int k = 0; k < count; k++) {
+        i = around[k];
+        if (!visited[i]) {
+            visited[i] = 1;
+
+            if (links[i].line == tent.line && links[i].column == tent.column) return 1;
+
+            if (links[i].line == -1 || (c = getContentOfPosition(mptr, links[i].line, links[i].column)) == 'U' || c == '.' || KERNEL(localInjectivity)(mptr, links[i], sptr)) {
+                links[i] = tent;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+/**
+ * Function: treesAround
+ * 
+ * Description: finds the trees next to a cell on the tree board, the index of a tree in tree
+ *              array is the number of trees before its line plus the trees on its left
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with boards
+ *     cell Cell - cell
+ *     int *around - returns indexes of trees in tree array order: above, left, right and below
+ * 
+ * Return value:
+ *     number of trees next to cell
+ */
+int KERNEL(treesAround)(map *mptr, search *sptr, cell Cell, int *around) {
+    uint64_t *trees = sptr->boards;
+    uint64_t *treesBefore = sptr->boards + 3 * sptr->boardSize;
+    ROW_TYPE bit = BIT(Cell.column), row;
+    int count = 0;
+
+    if ((row = ROW(trees, Cell.line - 1)) & bit) around[count++] = treesBefore[Cell.line] + __builtin_popcountll(row & (ROW_TYPE) (bit - 1));
+    row = ROW(trees, Cell.line);
+    if (row & (ROW_TYPE) (bit >> 1)) around[count++] = treesBefore[Cell.line + 1] + __builtin_popcountll(row & (ROW_TYPE) ((bit >> 1) - 1));
+    if (row & (ROW_TYPE) (bit << 1)) around[count++] = treesBefore[Cell.line + 1] + __builtin_popcountll(row & (ROW_TYPE) (bit - 1));
+    if ((row = ROW(trees, Cell.line + 1)) & bit) around[count++] = treesBefore[Cell.line + 2] + __builtin_popcountll(row & (ROW_TYPE) (bit - 1));
+
+    return count;
+}
+
+/**
+ * Function: isolatedTree
+ * 
+ * Description: checks if a tree has no tent or uncertain cell left around it
+ * 
+ * Arguments:
+ *     search *sptr - search with boards
+ *     int line - line of tree
+ *     ROW_TYPE bit - bit of column of tree
+ * 
+ * Return value:
+ *     1 - if tree is isolated
+ *     0 - otherwise
+ */
+int KERNEL(isolatedTree)(search *sptr, int line, ROW_TYPE bit) {
+    uint64_t *tents = sptr->boards + sptr->boardSize;
+    uint64_t *uncertains = sptr->boards + 2 * sptr->boardSize;
+
+    if ((ROW(tents, line - 1) | ROW(uncertains, line - 1) | ROW(tents, line + 1) | ROW(uncertains, line + 1)) & bit) return 0;
+    if ((ROW(tents, line) | ROW(uncertains, line)) & BESIDE(bit)) return 0;
+
+    return 1;
+}
+
+/**
+ * Function: validGrass
+ * 
+ * Description: checks if grass is valid
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     cell Cell - grass to be validated
+ *     search *sptr - search with boards
+ * 
+ * Return value:
+ *     1 - if grass is valid
+ *     0 - if grass is invalid
+ */
+int KERNEL(validGrass)(map *mptr, cell Cell, search *sptr) {
+    uint64_t *trees = sptr->boards;
+    uint64_t *tents = sptr->boards + sptr->boardSize;
+    uint64_t *uncertains = sptr->boards + 2 * sptr->boardSize;
+    ROW_TYPE bit = BIT(Cell.column), left = (ROW_TYPE) (bit >> 1), right = (ROW_TYPE) (bit << 1);
+
+    /** When in high season check if theres an isolated tree */
+    if (getTentsNumber(mptr) == getTreesNumber(mptr)) {
+        if ((ROW(trees, Cell.line - 1) & bit) && KERNEL(isolatedTree)(sptr, Cell.line - 1, bit)) return 0;
+        if ((ROW(trees, Cell.line + 1) & bit) && KERNEL(isolatedTree)(sptr, Cell.line + 1, bit)) return 0;
+        if ((ROW(trees, Cell.line) & left) && KERNEL(isolatedTree)(sptr, Cell.line, left)) return 0;
+        if ((ROW(trees, Cell.line) & right) && KERNEL(isolatedTree)(sptr, Cell.line, right)) return 0;
+    }
+
+    if (__builtin_popcountll(ROW(uncertains, Cell.line)) < getTentsInLine(mptr, Cell.line) - __builtin_popcountll(ROW(tents, Cell.line))) return 0;
+    if (sptr->columnUncertain[Cell.column] < getTentsInColumn(mptr, Cell.column) - sptr->columnTents[Cell.column]) return 0;
+
+    /** In low season check the matching of trees to cells and room left in the line */
+    if (sptr->spareTrees) {
+        if (!settleSupports(mptr, sptr)) return 0;
+        if (!KERNEL(lineFits)(mptr, sptr, Cell.line)) return 0;
+    }
+
+    return 1;
+}
+
+/**
+ * Function: capacity
+ * 
+ * Description: finds the most tents a line holds on some cells, no two of them side by side
+ *              i.e. half of every run of consecutive cells, rounded up
+ * 
+ * Arguments:
+ *     ROW_TYPE cells - cells of line
+ * 
+ * Return value:
+ *     maximum number of tents
+ */
+int KERNEL(capacity)(ROW_TYPE cells) {
+    ROW_TYPE starts;
+    int count = 0;
+
+    /** every pass takes the first cell of each run and drops the cell after it */
+    while (cells) {
+        starts = cells & (ROW_TYPE) ~(cells << 1);
+        count += __builtin_popcountll(starts);
+        cells &= (ROW_TYPE) ~(starts | (ROW_TYPE) (starts << 1));
+    }
+
+    return count;
+}
+
+/**
+ * Function: room
+ * 
+ * Description: finds cells of a line that hold or might still hold a tent i.e. tents and
+ *              uncertain cells with no tent around
+ * 
+ * Arguments:
+ *     search *sptr - search with boards
+ *     int line - number of line (inside map)
+ * 
+ * Return value:
+ *     cells of line
+ */
+ROW_TYPE KERNEL(room)(search *sptr, int line) {
+    uint64_t *tents = sptr->boards + sptr->boardSize;
+    uint64_t *uncertains = sptr->boards + 2 * sptr->boardSize;
+    ROW_TYPE near = ROW(tents, line - 1) | ROW(tents, line) | ROW(tents, line + 1);
+
+    return ROW(tents, line) | (ROW(uncertains, line) & (ROW_TYPE) ~(near | BESIDE(near)));
+}
+
+/**
+ * Function: lineFits
+ * 
+ * Description: checks that the tents of a line still fit in its room
+ * 
+ * Arguments:
+ *     map *mptr - map pointer
+ *     search *sptr - search with boards
+ *     int line - number of line (lines outside map always fit)
+ * 
+ * Return value:
+ *     1 - if tents might fit
+ *     0 - otherwise
+ */
+int KERNEL(lineFits)(map *mptr, search *sptr, int line) {
+    if (line < 0 || line >= sptr->boardSize - 2) return 1;
+
+    return KERNEL(capacity)(KERNEL(room)(sptr, line)) >= getTentsInLine(mptr, line);
+}
+
+#undef ROW
+#undef BIT
+#undef BESIDE